@@ -33,6 +33,10 @@ android {
     kotlinOptions {
         jvmTarget = "17"
     }
+    androidResources {
+        // Point stores are read in place from the APK, see MappedFile::openAsset
+        noCompress += "ezpts"
+    }
 }
 
 dependencies {
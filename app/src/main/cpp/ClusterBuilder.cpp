@@ -0,0 +1,88 @@
+#include "ClusterBuilder.h"
+
+ClusterBuilder::ClusterBuilder(const ClusterTreeOptions &options, std::function<void()> onBuilt) :
+        options_(options),
+        onBuilt_(std::move(onBuilt)),
+        changed_(false),
+        building_(false),
+        quit_(false),
+        generation_(0) {
+    worker_ = std::thread(&ClusterBuilder::workerMain, this);
+}
+
+ClusterBuilder::~ClusterBuilder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    condition_.notify_all();
+    worker_.join();
+}
+
+void ClusterBuilder::setStore(const PointStore *store) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        points_ = ClusterPoints(store);
+        changed_ = true;
+    }
+    condition_.notify_all();
+}
+
+void ClusterBuilder::setPoints(std::vector<GeoPoint> points) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        points_ = ClusterPoints();
+        points_.add(std::move(points));
+        changed_ = true;
+    }
+    condition_.notify_all();
+}
+
+void ClusterBuilder::addPoints(std::vector<GeoPoint> points) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        points_.add(std::move(points));
+        changed_ = true;
+    }
+    condition_.notify_all();
+}
+
+std::shared_ptr<const ClusterTree> ClusterBuilder::getTree() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tree_;
+}
+
+void ClusterBuilder::waitUntilBuilt() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return (!changed_ && !building_) || quit_; });
+}
+
+void ClusterBuilder::workerMain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this]() { return changed_ || quit_; });
+        if (quit_) {
+            return;
+        }
+
+        // Build from a snapshot, the points can change again meanwhile. It shares them.
+        auto snapshot = points_;
+        changed_ = false;
+        building_ = true;
+        lock.unlock();
+
+        auto tree = std::make_shared<const ClusterTree>(
+                ClusterTree::build(std::move(snapshot), options_));
+
+        lock.lock();
+        tree_ = std::move(tree);
+        building_ = false;
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        condition_.notify_all();
+        if (onBuilt_) {
+            lock.unlock();
+            onBuilt_();
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef ANDROIDGLINVESTIGATIONS_CLUSTERBUILDER_H
+#define ANDROIDGLINVESTIGATIONS_CLUSTERBUILDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ClusterTree.h"
+
+/*!
+ * Keeps a @a ClusterTree of a changing set of points up to date without blocking the caller.
+ * Changes are applied to the builder's @a ClusterPoints right away, a worker thread then builds
+ * a new tree from a snapshot and swaps it in. The points aren't copied for that, a snapshot
+ * shares the store and the added batches. Changes that arrive while a build is running are
+ * folded into the next one, so a burst of them costs at most two builds.
+ *
+ * Readers hold on to the tree they got for as long as they use it, a newer one never changes it
+ * under them. Platform independent, the caller decides how it's told about new trees.
+ */
+class ClusterBuilder {
+public:
+    /*!
+     * Starts the worker.
+     *
+     * @param onBuilt if set, called on the worker after every new tree is swapped in, e.g. to
+     *     wake up the thread that draws them
+     */
+    explicit ClusterBuilder(
+            const ClusterTreeOptions &options = ClusterTreeOptions(),
+            std::function<void()> onBuilt = nullptr);
+
+    /*!
+     * Stops the worker, a build that's running is finished first.
+     */
+    ~ClusterBuilder();
+
+    ClusterBuilder(const ClusterBuilder &) = delete;
+    ClusterBuilder &operator=(const ClusterBuilder &) = delete;
+
+    /*!
+     * Replaces every point with those of @a store and schedules a build.
+     *
+     * @param store must outlive the builder and every tree it built
+     */
+    void setStore(const PointStore *store);
+
+    /*!
+     * Replaces every point and schedules a build.
+     */
+    void setPoints(std::vector<GeoPoint> points);
+
+    /*!
+     * Adds to the points and schedules a build. Only @a points are kept, not another copy of
+     * those before them.
+     */
+    void addPoints(std::vector<GeoPoint> points);
+
+    /*!
+     * @return the newest tree, null until the first build finished
+     */
+    std::shared_ptr<const ClusterTree> getTree() const;
+
+    /*!
+     * @return how many trees were built so far, to tell cheaply whether @a getTree changed
+     */
+    inline uint64_t getGeneration() const { return generation_.load(std::memory_order_acquire); }
+
+    /*!
+     * Blocks until every change made so far is in the tree @a getTree returns.
+     */
+    void waitUntilBuilt();
+
+private:
+    void workerMain();
+
+    const ClusterTreeOptions options_;
+    const std::function<void()> onBuilt_;
+
+    // shared with the worker
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    ClusterPoints points_;
+    bool changed_;
+    bool building_;
+    bool quit_;
+    std::shared_ptr<const ClusterTree> tree_;
+    std::atomic<uint64_t> generation_;
+
+    std::thread worker_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_CLUSTERBUILDER_H
@@ -0,0 +1,406 @@
+#include "ClusterTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CubeSphere.h"
+#include "GeoCoordinates.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+//! bits of a face coordinate at the finest addressable level
+constexpr int kCoordinateBits = ClusterTree::kMaxLevel;
+
+/*!
+ * @return @a value with a zero bit inserted above each of its bits
+ */
+uint64_t spreadBits(uint32_t value) {
+    uint64_t bits = value;
+    bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+    bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFull;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    bits = (bits | (bits << 2)) & 0x3333333333333333ull;
+    bits = (bits | (bits << 1)) & 0x5555555555555555ull;
+    return bits;
+}
+
+//! the inverse of @a spreadBits, every other bit of @a bits
+uint32_t compactBits(uint64_t bits) {
+    bits &= 0x5555555555555555ull;
+    bits = (bits | (bits >> 1)) & 0x3333333333333333ull;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFull;
+    bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFull;
+    bits = (bits | (bits >> 16)) & 0x00000000FFFFFFFFull;
+    return static_cast<uint32_t>(bits);
+}
+
+Vec3 getFaceVector(const float *axis) {
+    return {axis[0], axis[1], axis[2]};
+}
+
+/*!
+ * @return the point of a face at equal-angle coordinates (s, t) in [0, 1]^2 on the unit sphere
+ */
+Vec3 getFacePoint(int face, float s, float t) {
+    const auto &axes = CubeSphere::getFace(face);
+    auto a = std::tan((s * 2.f - 1.f) * kPi * 0.25f);
+    auto b = std::tan((t * 2.f - 1.f) * kPi * 0.25f);
+    return normalize(getFaceVector(axes.center)
+                     + getFaceVector(axes.u) * a
+                     + getFaceVector(axes.v) * b);
+}
+
+float angleBetween(const Vec3 &a, const Vec3 &b) {
+    return std::acos(std::clamp(dot(a, b), -1.f, 1.f));
+}
+
+/*!
+ * A point on its way into the tree.
+ */
+struct SortEntry {
+    uint64_t key;
+    uint32_t index;
+    float direction[3];
+};
+
+} // namespace
+
+ClusterPoints::ClusterPoints() : ClusterPoints(nullptr) {}
+
+ClusterPoints::ClusterPoints(const PointStore *store) :
+        store_(store),
+        count_(store ? store->getPointCount() : 0) {}
+
+void ClusterPoints::add(std::vector<GeoPoint> batch) {
+    if (batch.empty()) {
+        return;
+    }
+    batchStarts_.push_back(count_);
+    count_ += batch.size();
+    batches_.push_back(std::make_shared<const std::vector<GeoPoint>>(std::move(batch)));
+}
+
+GeoPoint ClusterPoints::get(size_t index) const {
+    auto storeCount = store_ ? store_->getPointCount() : 0;
+    if (index < storeCount) {
+        return store_->getPoint(index);
+    }
+    auto batch = std::upper_bound(batchStarts_.begin(), batchStarts_.end(), index) - 1;
+    return (*batches_[batch - batchStarts_.begin()])[index - *batch];
+}
+
+void ClusterPoints::forEachRun(
+        const std::function<void(size_t first, const GeoPoint *points, size_t count)> &visit)
+        const {
+    if (store_) {
+        // One block at a time, only the block being visited is decoded
+        std::vector<GeoPoint> block;
+        for (size_t i = 0; i < store_->getBlockCount(); ++i) {
+            block.clear();
+            auto first = store_->decodeBlock(i, block);
+            visit(first, block.data(), block.size());
+        }
+    }
+    for (size_t i = 0; i < batches_.size(); ++i) {
+        visit(batchStarts_[i], batches_[i]->data(), batches_[i]->size());
+    }
+}
+
+uint64_t ClusterTree::getCellKey(const Vec3 &direction, int level) {
+    // The face the direction points through most directly
+    int face = 0;
+    float best = -2.f;
+    for (int i = 0; i < CubeSphere::kFaceCount; ++i) {
+        auto alignment = dot(direction, getFaceVector(CubeSphere::getFace(i).center));
+        if (alignment > best) {
+            best = alignment;
+            face = i;
+        }
+    }
+
+    // Angles from the face's centre, so cells of a level span the same angle across the face
+    const auto &axes = CubeSphere::getFace(face);
+    auto a = dot(direction, getFaceVector(axes.u)) / best;
+    auto b = dot(direction, getFaceVector(axes.v)) / best;
+    auto toCoordinate = [](float tangent) {
+        constexpr int64_t kLast = (int64_t(1) << kCoordinateBits) - 1;
+        auto s = (std::atan(static_cast<double>(tangent)) * (4.0 / kPi) + 1.0) * 0.5;
+        auto coordinate = static_cast<int64_t>(s * static_cast<double>(kLast + 1));
+        return static_cast<uint32_t>(std::clamp<int64_t>(coordinate, 0, kLast));
+    };
+    auto key = (static_cast<uint64_t>(face) << (2 * kCoordinateBits))
+               | spreadBits(toCoordinate(a))
+               | (spreadBits(toCoordinate(b)) << 1);
+    return key >> (2 * (kMaxLevel - level));
+}
+
+Vec3 ClusterTree::getCellCenter(int level, uint64_t cell) {
+    auto face = static_cast<int>(cell >> (2 * level));
+    auto position = cell & ((uint64_t(1) << (2 * level)) - 1);
+    auto size = 1.f / static_cast<float>(1u << level);
+    auto s = (static_cast<float>(compactBits(position)) + 0.5f) * size;
+    auto t = (static_cast<float>(compactBits(position >> 1)) + 0.5f) * size;
+    return getFacePoint(face, s, t);
+}
+
+float ClusterTree::getCellRadius(int level, uint64_t cell) {
+    auto face = static_cast<int>(cell >> (2 * level));
+    auto position = cell & ((uint64_t(1) << (2 * level)) - 1);
+    auto size = 1.f / static_cast<float>(1u << level);
+    auto s = static_cast<float>(compactBits(position)) * size;
+    auto t = static_cast<float>(compactBits(position >> 1)) * size;
+    auto center = getCellCenter(level, cell);
+    auto radius = 0.f;
+    for (int corner = 0; corner < 4; ++corner) {
+        auto point = getFacePoint(face,
+                                  s + static_cast<float>(corner & 1) * size,
+                                  t + static_cast<float>(corner >> 1) * size);
+        radius = std::max(radius, angleBetween(center, point));
+    }
+    return radius;
+}
+
+Vec3 ClusterTree::getCentroid(const PointCluster &cluster) {
+    return normalize(Vec3{cluster.sum[0], cluster.sum[1], cluster.sum[2]});
+}
+
+ClusterTree ClusterTree::build(std::vector<GeoPoint> points, const ClusterTreeOptions &options) {
+    ClusterPoints source;
+    source.add(std::move(points));
+    return build(std::move(source), options);
+}
+
+ClusterTree ClusterTree::build(ClusterPoints points, const ClusterTreeOptions &options) {
+    auto maxLevel = std::clamp(options.maxLevel, 0, kMaxLevel);
+
+    // The entries only live while the tree is built, it keeps their indices
+    std::vector<SortEntry> entries(points.getCount());
+    points.forEachRun([&entries](size_t first, const GeoPoint *run, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto direction = directionFromLatLon(run[i].latitude, run[i].longitude);
+            auto &entry = entries[first + i];
+            entry.key = getCellKey(direction, kMaxLevel);
+            entry.index = static_cast<uint32_t>(first + i);
+            entry.direction[0] = direction.x;
+            entry.direction[1] = direction.y;
+            entry.direction[2] = direction.z;
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const SortEntry &a, const SortEntry &b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    });
+
+    ClusterTree tree;
+    tree.points_ = std::move(points);
+    tree.order_.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        tree.order_[i] = entries[i].index;
+    }
+    if (entries.empty()) {
+        return tree;
+    }
+    tree.levels_.resize(static_cast<size_t>(maxLevel) + 1);
+
+    // The finest level groups runs of points, every level above groups runs of the one below.
+    // Sums are accumulated in double, the coarse levels add up millions of points.
+    auto shift = 2 * (kMaxLevel - maxLevel);
+    auto &finest = tree.levels_[maxLevel];
+    for (size_t start = 0; start < entries.size();) {
+        auto cell = entries[start].key >> shift;
+        double sum[3] = {0.0, 0.0, 0.0};
+        auto end = start;
+        for (; end < entries.size() && (entries[end].key >> shift) == cell; ++end) {
+            for (int axis = 0; axis < 3; ++axis) {
+                sum[axis] += entries[end].direction[axis];
+            }
+        }
+        finest.push_back({cell,
+                          {static_cast<float>(sum[0]),
+                           static_cast<float>(sum[1]),
+                           static_cast<float>(sum[2])},
+                          static_cast<uint32_t>(end - start),
+                          static_cast<uint32_t>(start)});
+        start = end;
+    }
+
+    for (auto level = maxLevel - 1; level >= 0; --level) {
+        const auto &children = tree.levels_[level + 1];
+        auto &parents = tree.levels_[level];
+        for (size_t start = 0; start < children.size();) {
+            auto cell = children[start].cell >> 2;
+            double sum[3] = {0.0, 0.0, 0.0};
+            uint32_t count = 0;
+            auto end = start;
+            for (; end < children.size() && (children[end].cell >> 2) == cell; ++end) {
+                for (int axis = 0; axis < 3; ++axis) {
+                    sum[axis] += children[end].sum[axis];
+                }
+                count += children[end].count;
+            }
+            parents.push_back({cell,
+                               {static_cast<float>(sum[0]),
+                                static_cast<float>(sum[1]),
+                                static_cast<float>(sum[2])},
+                               count,
+                               static_cast<uint32_t>(start)});
+            start = end;
+        }
+    }
+    return tree;
+}
+
+ClusterTree::ClusterTree() = default;
+
+int ClusterTree::selectLevel(const TileView &view, float spacingPixels) const {
+    if (levels_.empty()) {
+        return 0;
+    }
+
+    // A cell of level l spans (pi / 2) / 2^l radians, seen from the nearest point of the globe
+    const auto *camera = view.cameraPosition;
+    auto cameraDistance = std::sqrt(
+            camera[0] * camera[0] + camera[1] * camera[1] + camera[2] * camera[2]);
+    auto nearest = std::max(cameraDistance - 1.f, 1e-4f);
+    auto faceSpan = kPi * 0.5f * view.projectionScale / nearest;
+    auto level = std::floor(std::log2(faceSpan / std::max(spacingPixels, 1.f)));
+    return static_cast<int>(std::clamp(level, 0.f, static_cast<float>(levels_.size() - 1)));
+}
+
+void ClusterTree::selectClusters(
+        const TileView &view,
+        float spacingPixels,
+        std::vector<ClusterRef> &outClusters) const {
+    outClusters.clear();
+    if (levels_.empty()) {
+        return;
+    }
+    auto targetLevel = selectLevel(view, spacingPixels);
+    for (uint32_t face = 0; face < levels_[0].size(); ++face) {
+        selectRecursive(view, targetLevel, {0, face}, false, outClusters);
+    }
+}
+
+void ClusterTree::selectRecursive(
+        const TileView &view,
+        int targetLevel,
+        const ClusterRef &cluster,
+        bool inside,
+        std::vector<ClusterRef> &outClusters) const {
+    const auto &node = get(cluster);
+    if (!inside) {
+        auto center = getCellCenter(cluster.level, node.cell);
+        auto angularRadius = getCellRadius(cluster.level, node.cell);
+        auto radius = 2.f * std::sin(angularRadius * 0.5f);
+
+        Vec3 camera{view.cameraPosition[0], view.cameraPosition[1], view.cameraPosition[2]};
+        auto cameraDistance = length(camera);
+
+        // Past the horizon as seen from the camera, like TilePyramid::selectRecursive
+        auto beforeHorizon = true;
+        if (cameraDistance > 1.f) {
+            auto horizonAngle = std::acos(1.f / cameraDistance);
+            auto angle = angleBetween(center, camera / cameraDistance);
+            if (angle > horizonAngle + angularRadius) {
+                return;
+            }
+            beforeHorizon = angle + angularRadius < horizonAngle;
+        }
+
+        // Outside the view cone, the camera always looks at the centre of the globe
+        auto toCell = center - camera;
+        auto cellDistance = std::max(length(toCell), 1e-4f);
+        auto inCone = false;
+        if (cameraDistance > 1e-4f && cellDistance > radius) {
+            auto offAxis = std::acos(std::clamp(
+                    -dot(toCell, camera) / (cellDistance * cameraDistance), -1.f, 1.f));
+            auto spread = std::asin(radius / cellDistance);
+            if (offAxis > view.halfDiagonalFov + spread) {
+                return;
+            }
+            inCone = offAxis + spread < view.halfDiagonalFov;
+        }
+
+        // Everything below a cell that's entirely in sight is too, it needs no more tests
+        inside = beforeHorizon && inCone;
+    }
+
+    if (cluster.level == targetLevel) {
+        outClusters.push_back(cluster);
+        return;
+    }
+    for (auto child = node.first; child < getEnd(cluster); ++child) {
+        selectRecursive(view, targetLevel, {cluster.level + 1, child}, inside, outClusters);
+    }
+}
+
+bool ClusterTree::findCluster(
+        int level,
+        float latitude,
+        float longitude,
+        ClusterRef &outCluster) const {
+    if (level < 0 || level >= getLevelCount()) {
+        return false;
+    }
+    auto cell = getCellKey(directionFromLatLon(latitude, longitude), level);
+    const auto &clusters = levels_[level];
+    auto found = std::lower_bound(
+            clusters.begin(), clusters.end(), cell,
+            [](const PointCluster &cluster, uint64_t key) { return cluster.cell < key; });
+    if (found == clusters.end() || found->cell != cell) {
+        return false;
+    }
+    outCluster = {level, static_cast<uint32_t>(found - clusters.begin())};
+    return true;
+}
+
+void ClusterTree::getChildren(
+        const ClusterRef &cluster,
+        std::vector<ClusterRef> &outChildren) const {
+    if (cluster.level + 1 >= getLevelCount()) {
+        return;
+    }
+    for (auto child = get(cluster).first; child < getEnd(cluster); ++child) {
+        outChildren.push_back({cluster.level + 1, child});
+    }
+}
+
+int ClusterTree::getExpansionLevel(const ClusterRef &cluster) const {
+    auto current = cluster;
+    while (current.level + 1 < getLevelCount()) {
+        auto first = get(current).first;
+        if (getEnd(current) - first > 1) {
+            return current.level + 1;
+        }
+        current = {current.level + 1, first};
+    }
+    return current.level;
+}
+
+size_t ClusterTree::getPointRange(const ClusterRef &cluster, size_t &outFirst) const {
+    // The first point of a cluster is the first point of its first descendant on the finest level,
+    // its points end where the next cluster's begin
+    auto firstPoint = [this](int level, uint32_t index) -> size_t {
+        for (; level < getLevelCount(); ++level) {
+            if (index == levels_[level].size()) {
+                return order_.size();
+            }
+            index = levels_[level][index].first;
+        }
+        return index;
+    };
+    outFirst = firstPoint(cluster.level, cluster.index);
+    return firstPoint(cluster.level, cluster.index + 1) - outFirst;
+}
+
+uint32_t ClusterTree::getEnd(const ClusterRef &cluster) const {
+    const auto &level = levels_[cluster.level];
+    if (cluster.index + 1 < level.size()) {
+        return level[cluster.index + 1].first;
+    }
+    return cluster.level + 1 < getLevelCount()
+           ? static_cast<uint32_t>(levels_[cluster.level + 1].size())
+           : static_cast<uint32_t>(order_.size());
+}
@@ -0,0 +1,231 @@
+#ifndef ANDROIDGLINVESTIGATIONS_CLUSTERTREE_H
+#define ANDROIDGLINVESTIGATIONS_CLUSTERTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "PointStore.h"
+#include "TilePyramid.h"
+#include "VectorMath.h"
+
+/*!
+ * How @a ClusterTree::build builds the hierarchy.
+ */
+struct ClusterTreeOptions {
+    /*!
+     * The finest level, where a cell's edge is 90 / 2^maxLevel degrees. 16 is about 150 m on an
+     * Earth sized globe, at most @a ClusterTree::kMaxLevel.
+     */
+    int maxLevel = 16;
+};
+
+/*!
+ * The points a @a ClusterTree is built from, without a copy of them: those of a @a PointStore
+ * followed by batches added later. A point's index is its place in that order, the store's in
+ * file order first.
+ *
+ * Batches never change once added and copies share them, so a tree keeps the points it was built
+ * from while a copy takes more. Only the batches live on the heap, the store stays mapped.
+ */
+class ClusterPoints {
+public:
+    ClusterPoints();
+
+    /*!
+     * @param store must outlive every copy, null for none
+     */
+    explicit ClusterPoints(const PointStore *store);
+
+    //! Appends @a batch, its points get the next indices
+    void add(std::vector<GeoPoint> batch);
+
+    inline size_t getCount() const { return count_; }
+
+    //! @return the point at @a index, below @a getCount
+    GeoPoint get(size_t index) const;
+
+    /*!
+     * Visits every point in the order of their indices, one run at a time: a block of the store,
+     * which is decoded for it, or a batch.
+     *
+     * @param visit called with the index of the run's first point, the run and its length
+     */
+    void forEachRun(
+            const std::function<void(size_t first, const GeoPoint *points, size_t count)> &visit)
+            const;
+
+private:
+    const PointStore *store_;
+    std::vector<std::shared_ptr<const std::vector<GeoPoint>>> batches_;
+
+    //! the index of each batch's first point
+    std::vector<size_t> batchStarts_;
+    size_t count_;
+};
+
+/*!
+ * All points of one cell of the hierarchy.
+ */
+struct PointCluster {
+    //! the cell at the cluster's level, see @a ClusterTree::getCellKey
+    uint64_t cell;
+
+    //! the sum of the points' directions, normalized it's the centroid on the sphere
+    float sum[3];
+
+    uint32_t count;
+
+    //! the first child on the next level, or on the finest level the first point
+    uint32_t first;
+};
+
+/*!
+ * A cluster of a @a ClusterTree: the level it's on and its index there.
+ */
+struct ClusterRef {
+    int level = 0;
+    uint32_t index = 0;
+
+    inline bool operator==(const ClusterRef &other) const {
+        return level == other.level && index == other.index;
+    }
+};
+
+/*!
+ * Clusters of observation points for every zoom level, so the globe shows a readable number of
+ * markers at any distance.
+ *
+ * The sphere is cut like @a CubeSphere: the six cube faces are the clusters of level 0, each
+ * level splits every cell into 2x2. Cells are equal-angle rather than equal-area, a face's
+ * coordinates are the angles to its centre, so cells of a level are close to the same size
+ * everywhere. A cluster is the non-empty cell of its level with the number and centroid of its
+ * points. Keys of the cells follow the Z-order curve inside each face, so sorting the points by
+ * their finest cell once lays out every level in order: a cluster's children are a run of the
+ * next level and its points a run of the sorted points, and finding the cluster under a point is
+ * a binary search.
+ *
+ * Immutable once built, many threads can query it. Build a new tree when the points change,
+ * @a ClusterBuilder does that in the background. Platform independent.
+ */
+class ClusterTree {
+public:
+    //! the finest level cell keys can address, 29 bits per axis and 3 for the face
+    static constexpr int kMaxLevel = 29;
+
+    /*!
+     * @return the cell of @a level that contains @a direction, unique within the level.
+     *     Level 0 cells are the faces.
+     */
+    static uint64_t getCellKey(const Vec3 &direction, int level);
+
+    /*!
+     * @return the centre of cell @a cell of @a level on the unit sphere. In float, so past about
+     *     level 20 it's only as close as a float direction can be.
+     */
+    static Vec3 getCellCenter(int level, uint64_t cell);
+
+    /*!
+     * @return the largest angle in radians from the centre of the cell to any of its corners
+     */
+    static float getCellRadius(int level, uint64_t cell);
+
+    /*!
+     * @return the centroid of @a cluster's points on the unit sphere
+     */
+    static Vec3 getCentroid(const PointCluster &cluster);
+
+    /*!
+     * Clusters @a points on every level, reading them in one pass. The tree keeps the points and
+     * sorts only their indices, 4 bytes a point.
+     */
+    static ClusterTree build(ClusterPoints points,
+                             const ClusterTreeOptions &options = ClusterTreeOptions());
+
+    //! Clusters a list of points, e.g. in tests
+    static ClusterTree build(std::vector<GeoPoint> points,
+                             const ClusterTreeOptions &options = ClusterTreeOptions());
+
+    ClusterTree();
+
+    //! @return levels of clusters, the faces are level 0
+    inline int getLevelCount() const { return static_cast<int>(levels_.size()); }
+
+    inline const std::vector<PointCluster> &getLevel(int level) const { return levels_[level]; }
+
+    inline const PointCluster &get(const ClusterRef &ref) const {
+        return levels_[ref.level][ref.index];
+    }
+
+    inline size_t getPointCount() const { return order_.size(); }
+
+    /*!
+     * @return point @a index of the tree's order, where the points of a cluster are next to each
+     *     other
+     */
+    inline GeoPoint getPoint(size_t index) const { return points_.get(order_[index]); }
+
+    /*!
+     * @return the level whose cells are at least @a spacingPixels wide on screen where the globe
+     *     is nearest to the camera, so its clusters don't crowd each other
+     */
+    int selectLevel(const TileView &view, float spacingPixels) const;
+
+    /*!
+     * Collects the clusters of @a selectLevel that can be seen: in the view and not behind the
+     * horizon. Walks down from the faces and skips every cell that can't be seen, the cost
+     * grows with what's on screen rather than with the size of the tree.
+     *
+     * @param outClusters receives the clusters, it's cleared first
+     */
+    void selectClusters(const TileView &view, float spacingPixels,
+                        std::vector<ClusterRef> &outClusters) const;
+
+    /*!
+     * Finds the cluster of @a level under a point, e.g. the one that was tapped, with a binary
+     * search.
+     *
+     * @return false if the point's cell of @a level has no points
+     */
+    bool findCluster(int level, float latitude, float longitude, ClusterRef &outCluster) const;
+
+    /*!
+     * Appends the clusters @a cluster splits into on the next level. Nothing on the finest level.
+     */
+    void getChildren(const ClusterRef &cluster, std::vector<ClusterRef> &outChildren) const;
+
+    /*!
+     * @return the first level on which @a cluster splits up, where zooming in on it shows more than
+     *     one marker. The finest level if it never does.
+     */
+    int getExpansionLevel(const ClusterRef &cluster) const;
+
+    /*!
+     * The points of @a cluster, a run of the tree's order, see @a getPoint.
+     *
+     * @param outFirst receives the index of the first point
+     * @return the number of points
+     */
+    size_t getPointRange(const ClusterRef &cluster, size_t &outFirst) const;
+
+private:
+    //! @return one past the last child of @a cluster on the next level, or its last point
+    uint32_t getEnd(const ClusterRef &cluster) const;
+
+    /*!
+     * @param inside true if @a cluster is known to be entirely in sight
+     */
+    void selectRecursive(const TileView &view, int targetLevel, const ClusterRef &cluster,
+                         bool inside, std::vector<ClusterRef> &outClusters) const;
+
+    //! coarsest first
+    std::vector<std::vector<PointCluster>> levels_;
+    ClusterPoints points_;
+
+    //! indices of @a points_, sorted by their finest cell
+    std::vector<uint32_t> order_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_CLUSTERTREE_H
@@ -0,0 +1,160 @@
+#include "Continents.h"
+
+#include <iterator>
+
+namespace {
+
+// The outlines of InteractiveEarthView, as (u, v) of the earth texture
+const float kNorthAmericaOutline[] = {
+        0.0400f, 0.1000f,
+        0.0400f, 0.2000f,
+        0.2600f, 0.4700f,
+        0.4200f, 0.2000f,
+        0.4300f, 0.0000f,
+};
+
+const float kSouthAmericaOutline[] = {
+        0.3194f, 0.4315f,
+        0.2667f, 0.4908f,
+        0.2537f, 0.5555f,
+        0.2850f, 0.6180f,
+        0.2693f, 0.7898f,
+        0.3115f, 0.8309f,
+        0.3206f, 0.8211f,
+        0.3102f, 0.8055f,
+        0.3206f, 0.7352f,
+        0.3883f, 0.6336f,
+        0.4039f, 0.5555f,
+};
+
+const float kEuropeOutline[] = {
+        0.4300f, 0.2000f,
+        0.4650f, 0.1700f,
+        0.5200f, 0.0950f,
+        0.6050f, 0.0950f,
+        0.6050f, 0.2350f,
+        0.5800f, 0.2800f,
+        0.5250f, 0.3050f,
+        0.4650f, 0.3050f,
+        0.4300f, 0.3000f,
+};
+
+const float kAfricaOutline[] = {
+        0.4844f, 0.2202f,
+        0.4632f, 0.2510f,
+        0.4814f, 0.2725f,
+        0.4720f, 0.3032f,
+        0.4570f, 0.3218f,
+        0.4401f, 0.2710f,
+        0.4235f, 0.3047f,
+        0.4521f, 0.3262f,
+        0.4378f, 0.3359f,
+        0.4473f, 0.3599f,
+        0.4255f, 0.3652f,
+        0.4346f, 0.4072f,
+        0.4001f, 0.5117f,
+        0.4271f, 0.5610f,
+        0.4730f, 0.5625f,
+        0.4971f, 0.7500f,
+        0.5260f, 0.7437f,
+        0.5589f, 0.6592f,
+        0.5563f, 0.6055f,
+        0.5895f, 0.5312f,
+        0.5667f, 0.5225f,
+        0.6038f, 0.4961f,
+        0.6012f, 0.4551f,
+        0.6400f, 0.4839f,
+};
+
+const float kAsiaOutline[] = {
+        0.6100f, 0.2000f,
+        0.6300f, 0.1700f,
+        0.6600f, 0.1300f,
+        0.7000f, 0.0900f,
+        0.7500f, 0.1100f,
+        0.8000f, 0.1300f,
+        0.8600f, 0.1500f,
+        0.9100f, 0.1900f,
+        0.9500f, 0.2400f,
+        0.9550f, 0.2800f,
+        0.9400f, 0.3200f,
+        0.9200f, 0.3500f,
+        0.9000f, 0.3800f,
+        0.8800f, 0.4100f,
+        0.8600f, 0.4500f,
+        0.8500f, 0.4900f,
+        0.8300f, 0.5200f,
+        0.8100f, 0.5400f,
+        0.7900f, 0.5700f,
+        0.7700f, 0.6000f,
+        0.7400f, 0.6100f,
+        0.7100f, 0.5900f,
+        0.6900f, 0.5600f,
+        0.6700f, 0.5200f,
+        0.6550f, 0.4800f,
+        0.6450f, 0.4400f,
+        0.6400f, 0.4000f,
+        0.6300f, 0.3400f,
+        0.6200f, 0.2800f,
+};
+
+const float kAustraliaOutline[] = {
+        0.8201f, 0.5628f,
+        0.7620f, 0.6155f,
+        0.7746f, 0.6980f,
+        0.8227f, 0.6883f,
+        0.8618f, 0.7273f,
+        0.8839f, 0.6590f,
+        0.8540f, 0.5628f,
+        0.8462f, 0.5902f,
+};
+
+const float kAntarcticaOutline[] = {
+        0.2507f, 0.8496f,
+        0.2682f, 0.8799f,
+        0.2806f, 0.8711f,
+        0.2715f, 0.8496f,
+};
+
+template<size_t kSize>
+RegionOutline makeOutline(Continent continent, const float (&points)[kSize]) {
+    RegionOutline outline;
+    outline.id = static_cast<uint16_t>(continent);
+    outline.points.assign(std::begin(points), std::end(points));
+    return outline;
+}
+
+} // namespace
+
+const std::vector<RegionOutline> &getContinentOutlines() {
+    static const std::vector<RegionOutline> outlines = {
+            makeOutline(Continent::NorthAmerica, kNorthAmericaOutline),
+            makeOutline(Continent::SouthAmerica, kSouthAmericaOutline),
+            makeOutline(Continent::Europe, kEuropeOutline),
+            makeOutline(Continent::Africa, kAfricaOutline),
+            makeOutline(Continent::Asia, kAsiaOutline),
+            makeOutline(Continent::Australia, kAustraliaOutline),
+            makeOutline(Continent::Antarctica, kAntarcticaOutline),
+    };
+    return outlines;
+}
+
+const char *getContinentName(uint16_t region) {
+    switch (static_cast<Continent>(region)) {
+        case Continent::NorthAmerica:
+            return "North America";
+        case Continent::SouthAmerica:
+            return "South America";
+        case Continent::Europe:
+            return "Europe";
+        case Continent::Africa:
+            return "Africa";
+        case Continent::Asia:
+            return "Asia";
+        case Continent::Australia:
+            return "Australia";
+        case Continent::Antarctica:
+            return "Antarctica";
+    }
+    return nullptr;
+}
@@ -0,0 +1,35 @@
+#ifndef ANDROIDGLINVESTIGATIONS_CONTINENTS_H
+#define ANDROIDGLINVESTIGATIONS_CONTINENTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "RegionRaster.h"
+
+/*!
+ * The continents the app lets the user pick, with region ids from 1 in the order of
+ * InteractiveEarthView's continents. Keep the two in sync.
+ */
+enum class Continent : uint16_t {
+    NorthAmerica = 1,
+    SouthAmerica,
+    Europe,
+    Africa,
+    Asia,
+    Australia,
+    Antarctica,
+};
+
+/*!
+ * @return the outlines of every @a Continent on the equirectangular earth map, the id of each is
+ *     its @a Continent
+ */
+const std::vector<RegionOutline> &getContinentOutlines();
+
+/*!
+ * @return the English name of the continent with region id @a region, or nullptr for
+ *     @a RegionRaster::kNoRegion and unknown ids
+ */
+const char *getContinentName(uint16_t region);
+
+#endif //ANDROIDGLINVESTIGATIONS_CONTINENTS_H
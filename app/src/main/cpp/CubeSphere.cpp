@@ -0,0 +1,258 @@
+#include "CubeSphere.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+//! skirts cover the gap to a neighbour up to this many levels coarser
+constexpr int kSkirtLevels = 3;
+
+//! the six faces, see CubeFace for the orientation
+const CubeFace kFaces[CubeSphere::kFaceCount] = {
+        {{1.f, 0.f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 1.f, 0.f}},
+        {{-1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 1.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 0.f, -1.f}},
+        {{0.f, -1.f, 0.f}, {1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}},
+        {{0.f, 0.f, 1.f}, {1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+        {{0.f, 0.f, -1.f}, {-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}},
+};
+
+float dot(const float *a, const float *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+float length(const float *a) {
+    return std::sqrt(dot(a, a));
+}
+
+float angleBetween(float cosine) {
+    return std::acos(std::clamp(cosine, -1.f, 1.f));
+}
+
+/*!
+ * Grid coordinates of step @a k along the bottom, right, top or left edge of a chunk grid, walking
+ * counter-clockwise around the chunk.
+ */
+void getEdgeVertex(int edge, int k, int gridSize, int &outI, int &outJ) {
+    switch (edge) {
+        case 0:
+            outI = k;
+            outJ = 0;
+            break;
+        case 1:
+            outI = gridSize;
+            outJ = k;
+            break;
+        case 2:
+            outI = gridSize - k;
+            outJ = gridSize;
+            break;
+        default:
+            outI = 0;
+            outJ = gridSize - k;
+            break;
+    }
+}
+
+} // namespace
+
+CubeSphere::CubeSphere(int gridSize, int maxLevel, float maxPixelError) :
+        gridSize_(gridSize),
+        maxLevel_(maxLevel),
+        maxPixelError_(maxPixelError),
+        cellDiagonalAngle_(0.f) {
+    // The mapping stretches cells differently across a face, measure the worst one once. Every
+    // face is the same up to rotation.
+    ChunkId root;
+    auto step = 1.f / static_cast<float>(gridSize_);
+    for (int j = 0; j < gridSize_; ++j) {
+        for (int i = 0; i < gridSize_; ++i) {
+            float corners[4][3];
+            getChunkPoint(root, i * step, j * step, corners[0]);
+            getChunkPoint(root, (i + 1) * step, (j + 1) * step, corners[1]);
+            getChunkPoint(root, (i + 1) * step, j * step, corners[2]);
+            getChunkPoint(root, i * step, (j + 1) * step, corners[3]);
+            cellDiagonalAngle_ = std::max({
+                    cellDiagonalAngle_,
+                    angleBetween(dot(corners[0], corners[1])),
+                    angleBetween(dot(corners[2], corners[3]))});
+        }
+    }
+}
+
+const CubeFace &CubeSphere::getFace(int face) {
+    return kFaces[face];
+}
+
+void CubeSphere::cubeToSphere(const float cube[3], float outSphere[3]) {
+    auto x2 = cube[0] * cube[0];
+    auto y2 = cube[1] * cube[1];
+    auto z2 = cube[2] * cube[2];
+    outSphere[0] = cube[0] * std::sqrt(1.f - y2 * 0.5f - z2 * 0.5f + y2 * z2 / 3.f);
+    outSphere[1] = cube[1] * std::sqrt(1.f - z2 * 0.5f - x2 * 0.5f + z2 * x2 / 3.f);
+    outSphere[2] = cube[2] * std::sqrt(1.f - x2 * 0.5f - y2 * 0.5f + x2 * y2 / 3.f);
+}
+
+void CubeSphere::getChunkPoint(const ChunkId &chunk, float s, float t, float outPoint[3]) {
+    auto size = 1.f / static_cast<float>(1 << chunk.level);
+    auto a = (static_cast<float>(chunk.x) + s) * size * 2.f - 1.f;
+    auto b = (static_cast<float>(chunk.y) + t) * size * 2.f - 1.f;
+
+    const auto &face = kFaces[chunk.face];
+    float cube[3];
+    for (int i = 0; i < 3; ++i) {
+        cube[i] = face.center[i] + a * face.u[i] + b * face.v[i];
+    }
+    cubeToSphere(cube, outPoint);
+}
+
+float CubeSphere::getGeometricError(int level) const {
+    // The sagitta of the longest cell diagonal, the furthest a flat cell gets from the sphere
+    auto angle = cellDiagonalAngle_ / static_cast<float>(1 << level);
+    return 1.f - std::cos(angle * 0.5f);
+}
+
+float CubeSphere::getSkirtDepth(int level) const {
+    return getGeometricError(std::max(level - kSkirtLevels, 0));
+}
+
+void CubeSphere::selectChunks(const TileView &view, std::vector<ChunkId> &outChunks) const {
+    outChunks.clear();
+    for (int face = 0; face < kFaceCount; ++face) {
+        selectRecursive(view, {face, 0, 0, 0}, outChunks);
+    }
+    std::sort(outChunks.begin(), outChunks.end(), [](const ChunkId &a, const ChunkId &b) {
+        return a.getKey() < b.getKey();
+    });
+}
+
+void CubeSphere::selectRecursive(
+        const TileView &view,
+        const ChunkId &chunk,
+        std::vector<ChunkId> &outChunks) const {
+    float center[3];
+    getChunkPoint(chunk, 0.5f, 0.5f, center);
+
+    // Bound the chunk by the cap around its centre that reaches its furthest corner
+    auto angularRadius = 0.f;
+    for (int corner = 0; corner < 4; ++corner) {
+        float point[3];
+        getChunkPoint(chunk, float(corner & 1), float(corner >> 1), point);
+        angularRadius = std::max(angularRadius, angleBetween(dot(center, point)));
+    }
+    auto radius = 2.f * std::sin(angularRadius * 0.5f);
+
+    const auto *camera = view.cameraPosition;
+    auto cameraDistance = length(camera);
+
+    // Past the horizon as seen from the camera
+    if (cameraDistance > 1.f) {
+        auto horizonAngle = std::acos(1.f / cameraDistance);
+        auto chunkAngle = angleBetween(dot(center, camera) / cameraDistance);
+        if (chunkAngle > horizonAngle + angularRadius) {
+            return;
+        }
+    }
+
+    // Outside the view cone, the camera always looks at the centre of the globe
+    float toChunk[3] = {center[0] - camera[0], center[1] - camera[1], center[2] - camera[2]};
+    auto chunkDistance = std::max(length(toChunk), 1e-4f);
+    if (cameraDistance > 1e-4f && chunkDistance > radius) {
+        auto offAxis = angleBetween(-dot(toChunk, camera) / (chunkDistance * cameraDistance));
+        if (offAxis > view.halfDiagonalFov + std::asin(radius / chunkDistance)) {
+            return;
+        }
+    }
+
+    // Project the error at the nearest possible point of the chunk. No facing factor: on the
+    // silhouette the error is seen side-on and shows up in full.
+    auto nearest = std::max(chunkDistance - radius, 1e-4f);
+    auto pixelError = getGeometricError(chunk.level) / nearest * view.projectionScale;
+
+    if (chunk.level >= maxLevel_ || pixelError <= maxPixelError_) {
+        outChunks.push_back(chunk);
+        return;
+    }
+
+    for (int child = 0; child < 4; ++child) {
+        selectRecursive(
+                view,
+                {chunk.face,
+                 chunk.level + 1,
+                 chunk.x * 2 + (child & 1),
+                 chunk.y * 2 + (child >> 1)},
+                outChunks);
+    }
+}
+
+std::vector<std::array<uint16_t, 4>> CubeSphere::buildGridVertices() const {
+    auto toUnorm = [this](int i) {
+        return static_cast<uint16_t>((i * 65535 + gridSize_ / 2) / gridSize_);
+    };
+
+    std::vector<std::array<uint16_t, 4>> vertices;
+    auto edgeVertices = gridSize_ + 1;
+    vertices.reserve(edgeVertices * edgeVertices + 4 * edgeVertices);
+
+    for (int j = 0; j <= gridSize_; ++j) {
+        for (int i = 0; i <= gridSize_; ++i) {
+            vertices.push_back({toUnorm(i), toUnorm(j), 0, 0});
+        }
+    }
+
+    // Skirts of the bottom, right, top and left edges, counter-clockwise around the chunk
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int k = 0; k <= gridSize_; ++k) {
+            int i;
+            int j;
+            getEdgeVertex(edge, k, gridSize_, i, j);
+            vertices.push_back({toUnorm(i), toUnorm(j), 65535, 0});
+        }
+    }
+    return vertices;
+}
+
+std::vector<uint32_t> CubeSphere::buildGridIndices() const {
+    auto edgeVertices = static_cast<uint32_t>(gridSize_ + 1);
+    auto surfaceIndex = [edgeVertices](int i, int j) {
+        return static_cast<uint32_t>(j) * edgeVertices + static_cast<uint32_t>(i);
+    };
+
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(gridSize_) * (gridSize_ + 4) * 6);
+
+    for (int j = 0; j < gridSize_; ++j) {
+        for (int i = 0; i < gridSize_; ++i) {
+            auto v00 = surfaceIndex(i, j);
+            auto v10 = surfaceIndex(i + 1, j);
+            auto v01 = surfaceIndex(i, j + 1);
+            auto v11 = surfaceIndex(i + 1, j + 1);
+            indices.insert(indices.end(), {v00, v10, v11, v00, v11, v01});
+        }
+    }
+
+    // Walking an edge in the same direction as its skirt vertices, the surface is on the left.
+    // The skirt wall faces outwards when wound surface, skirt, next surface.
+    auto skirtBase = edgeVertices * edgeVertices;
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int k = 0; k < gridSize_; ++k) {
+            auto skirt = skirtBase + static_cast<uint32_t>(edge) * edgeVertices + k;
+            auto skirtNext = skirt + 1;
+
+            int i;
+            int j;
+            int iNext;
+            int jNext;
+            getEdgeVertex(edge, k, gridSize_, i, j);
+            getEdgeVertex(edge, k + 1, gridSize_, iNext, jNext);
+            auto surface = surfaceIndex(i, j);
+            auto surfaceNext = surfaceIndex(iNext, jNext);
+
+            indices.insert(
+                    indices.end(),
+                    {surface, skirt, skirtNext, surface, skirtNext, surfaceNext});
+        }
+    }
+    return indices;
+}
@@ -0,0 +1,130 @@
+#ifndef ANDROIDGLINVESTIGATIONS_CUBESPHERE_H
+#define ANDROIDGLINVESTIGATIONS_CUBESPHERE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "TilePyramid.h"
+
+/*!
+ * Identifies one chunk of the cube-sphere. Each of the six cube faces is the root of a quadtree,
+ * a chunk at @a level covers [x, x + 1] x [y, y + 1] / 2^level of its face.
+ */
+struct ChunkId {
+    int face = 0;
+    int level = 0;
+    int x = 0;
+    int y = 0;
+
+    /*!
+     * @return a unique key for hashing and sorting, grouped by face with coarser levels first
+     */
+    inline uint64_t getKey() const {
+        return (static_cast<uint64_t>(face) << 56)
+               | (static_cast<uint64_t>(level) << 48)
+               | (static_cast<uint64_t>(y) << 24)
+               | static_cast<uint64_t>(x);
+    }
+
+    inline bool operator==(const ChunkId &other) const {
+        return face == other.face && level == other.level && x == other.x && y == other.y;
+    }
+};
+
+/*!
+ * The axes of a cube face. The face's points are center + a * u + b * v for a, b in [-1, 1], and
+ * u x v = center so triangles wound counter-clockwise in (a, b) face outwards.
+ */
+struct CubeFace {
+    float center[3];
+    float u[3];
+    float v[3];
+};
+
+/*!
+ * The unit sphere as six cube faces projected outwards, each split into a quadtree of chunks. Every
+ * chunk is drawn with the same grid of (gridSize + 1)^2 vertices, placed by per-chunk parameters
+ * in the vertex shader. Neighbouring chunks of different levels don't share their edge vertices,
+ * each chunk hangs a skirt below its edges that covers the gaps.
+ *
+ * Pure math, no GL. Chunk selection works like @a TilePyramid::selectTiles, with the same camera.
+ */
+class CubeSphere {
+public:
+    static constexpr int kFaceCount = 6;
+
+    /*!
+     * @param gridSize quads along each edge of a chunk
+     * @param maxLevel the finest quadtree level
+     * @param maxPixelError refine while a chunk's distance to the true sphere covers more than
+     * this many pixels
+     */
+    CubeSphere(int gridSize, int maxLevel, float maxPixelError);
+
+    inline int getGridSize() const { return gridSize_; }
+
+    inline int getMaxLevel() const { return maxLevel_; }
+
+    static const CubeFace &getFace(int face);
+
+    /*!
+     * Projects a point of the cube onto the unit sphere. Unlike normalizing, this mapping keeps the
+     * chunks of a face close to the same area, so a level has about the same error everywhere.
+     */
+    static void cubeToSphere(const float cube[3], float outSphere[3]);
+
+    /*!
+     * The point at (s, t) in [0, 1]^2 of @a chunk on the unit sphere, what the vertex shader
+     * computes for grid vertex (s, t).
+     */
+    static void getChunkPoint(const ChunkId &chunk, float s, float t, float outPoint[3]);
+
+    /*!
+     * @return how far the flat triangles of a chunk at @a level are at most from the unit sphere
+     */
+    float getGeometricError(int level) const;
+
+    /*!
+     * @return how deep the skirts of a chunk at @a level hang below the sphere. Deep enough to
+     * cover the gap to a neighbour a few levels coarser.
+     */
+    float getSkirtDepth(int level) const;
+
+    /*!
+     * Walks the quadtrees and collects the chunks to draw: every chunk above the horizon and in the
+     * view, refined until its error is below a pixel budget or the finest level is reached.
+     * Chunks come out sorted by key.
+     *
+     * @param view the camera
+     * @param outChunks receives the selected chunks, it's cleared first
+     */
+    void selectChunks(const TileView &view, std::vector<ChunkId> &outChunks) const;
+
+    /*!
+     * The shared chunk grid: (gridSize + 1)^2 surface vertices followed by the skirt vertices
+     * along the four edges. Each vertex is (s, t, skirt, 0) as unsigned normalized shorts, skirt
+     * is 1 for vertices that hang below the surface and 0 otherwise.
+     */
+    std::vector<std::array<uint16_t, 4>> buildGridVertices() const;
+
+    /*!
+     * @return the triangle list of @a buildGridVertices, surface and skirts
+     */
+    std::vector<uint32_t> buildGridIndices() const;
+
+private:
+    void selectRecursive(
+            const TileView &view,
+            const ChunkId &chunk,
+            std::vector<ChunkId> &outChunks) const;
+
+    int gridSize_;
+    int maxLevel_;
+    float maxPixelError_;
+
+    //! the longest cell diagonal of a level 0 chunk, in radians. Halves with every level.
+    float cellDiagonalAngle_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_CUBESPHERE_H
@@ -0,0 +1,189 @@
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+//! the squared distance of pixels without any site, far beyond any real one
+constexpr double kFar = 1e20;
+
+/*!
+ * The 1D squared distance transform: the lower envelope of the parabolas rooted at every sample.
+ * Reads and writes @a count values @a stride apart in @a values, the other vectors are scratch.
+ */
+void transformLine(float *values, int count, size_t stride, std::vector<double> &input,
+                   std::vector<int> &roots, std::vector<double> &bounds) {
+    for (int i = 0; i < count; ++i) {
+        input[i] = values[i * stride];
+    }
+
+    // roots[k] is the sample of the k-th parabola of the envelope, which is lowest between
+    // bounds[k] and bounds[k + 1]
+    int k = 0;
+    roots[0] = 0;
+    bounds[0] = -std::numeric_limits<double>::infinity();
+    bounds[1] = std::numeric_limits<double>::infinity();
+    auto intersect = [&input](int q, int root) {
+        return ((input[q] + double(q) * q) - (input[root] + double(root) * root))
+               / (2.0 * (q - root));
+    };
+    for (int q = 1; q < count; ++q) {
+        // bounds[0] is -infinity, so this stops at the first parabola at the latest
+        auto intersection = intersect(q, roots[k]);
+        while (intersection <= bounds[k]) {
+            k--;
+            intersection = intersect(q, roots[k]);
+        }
+        k++;
+        roots[k] = q;
+        bounds[k] = intersection;
+        bounds[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    k = 0;
+    for (int q = 0; q < count; ++q) {
+        while (bounds[k + 1] < q) {
+            k++;
+        }
+        auto offset = double(q - roots[k]);
+        values[q * stride] = static_cast<float>(offset * offset + input[roots[k]]);
+    }
+}
+
+/*!
+ * @return the field at a position between pixel centres, clamped to the edges or with @a wrapX
+ *     wrapped around horizontally
+ */
+float sampleBilinear(const std::vector<float> &field, int width, int height, float x, float y,
+                     bool wrapX) {
+    int x0;
+    int x1;
+    float fx;
+    if (wrapX) {
+        auto column = std::floor(x);
+        fx = x - column;
+        x0 = static_cast<int>(column) % width;
+        x0 += x0 < 0 ? width : 0;
+        x1 = (x0 + 1) % width;
+    } else {
+        x = std::clamp(x, 0.f, static_cast<float>(width - 1));
+        x0 = std::max(std::min(static_cast<int>(x), width - 2), 0);
+        x1 = std::min(x0 + 1, width - 1);
+        fx = x - static_cast<float>(x0);
+    }
+    y = std::clamp(y, 0.f, static_cast<float>(height - 1));
+    auto y0 = std::max(std::min(static_cast<int>(y), height - 2), 0);
+    auto y1 = std::min(y0 + 1, height - 1);
+    auto fy = y - static_cast<float>(y0);
+    auto at = [&](int column, int row) { return field[static_cast<size_t>(row) * width + column]; };
+    auto top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+    auto bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+    return top + (bottom - top) * fy;
+}
+
+} // namespace
+
+std::vector<float> DistanceField::computeSquaredDistances(
+        const std::vector<uint8_t> &sites,
+        int width,
+        int height,
+        bool wrapX) {
+    std::vector<float> distances(sites.size());
+    for (size_t i = 0; i < sites.size(); ++i) {
+        distances[i] = sites[i] ? 0.f : static_cast<float>(kFar);
+    }
+
+    // Separable: every column, then every row of the column results. A wrapped row is transformed
+    // as three copies of itself, the nearest site is never more than half a row away.
+    auto rowLength = wrapX ? 3 * width : width;
+    auto longest = static_cast<size_t>(std::max(rowLength, height));
+    std::vector<double> input(longest);
+    std::vector<int> roots(longest);
+    std::vector<double> bounds(longest + 1);
+    for (int x = 0; x < width; ++x) {
+        transformLine(&distances[x], height, static_cast<size_t>(width), input, roots, bounds);
+    }
+    std::vector<float> tiled(wrapX ? static_cast<size_t>(rowLength) : 0);
+    for (int y = 0; y < height; ++y) {
+        auto *row = &distances[static_cast<size_t>(y) * width];
+        if (!wrapX) {
+            transformLine(row, width, 1, input, roots, bounds);
+            continue;
+        }
+        for (int copy = 0; copy < 3; ++copy) {
+            std::copy(row, row + width, tiled.begin() + copy * width);
+        }
+        transformLine(tiled.data(), rowLength, 1, input, roots, bounds);
+        std::copy(tiled.begin() + width, tiled.begin() + 2 * width, row);
+    }
+    return distances;
+}
+
+std::vector<float> DistanceField::computeSignedDistances(
+        const std::vector<uint8_t> &inside,
+        int width,
+        int height,
+        bool wrapX) {
+    std::vector<uint8_t> outside(inside.size());
+    for (size_t i = 0; i < inside.size(); ++i) {
+        outside[i] = inside[i] ? 0 : 1;
+    }
+    auto toInside = computeSquaredDistances(inside, width, height, wrapX);
+    auto toOutside = computeSquaredDistances(outside, width, height, wrapX);
+
+    // Between a pixel's centre and the nearest pixel on the other side the contour is half a pixel
+    // before that pixel's centre
+    std::vector<float> distances(inside.size());
+    for (size_t i = 0; i < inside.size(); ++i) {
+        distances[i] = inside[i]
+                       ? 0.5f - std::sqrt(toOutside[i])
+                       : std::sqrt(toInside[i]) - 0.5f;
+    }
+    return distances;
+}
+
+float DistanceField::estimateHalfStrokeWidth(const std::vector<float> &signedDistances) {
+    // Across a stroke of width w the centres are 0.5 to w / 2 inside, w / 4 on average
+    double depth = 0.0;
+    size_t count = 0;
+    for (auto distance: signedDistances) {
+        if (distance < 0.f) {
+            depth -= distance;
+            count++;
+        }
+    }
+    return count > 0 ? static_cast<float>(2.0 * depth / static_cast<double>(count)) : 0.f;
+}
+
+std::vector<uint8_t> DistanceField::encode(
+        const std::vector<float> &signedDistances,
+        int width,
+        int height,
+        int scale,
+        float offset,
+        int &outWidth,
+        int &outHeight,
+        bool wrapX) {
+    scale = std::max(scale, 1);
+    outWidth = (width + scale - 1) / scale;
+    outHeight = (height + scale - 1) / scale;
+
+    // Each texel takes the field at its centre, distances shrink with the resolution
+    std::vector<uint8_t> encoded(static_cast<size_t>(outWidth) * outHeight);
+    auto fieldScale = static_cast<float>(scale);
+    for (int y = 0; y < outHeight; ++y) {
+        auto sourceY = (static_cast<float>(y) + 0.5f) * fieldScale - 0.5f;
+        for (int x = 0; x < outWidth; ++x) {
+            auto sourceX = (static_cast<float>(x) + 0.5f) * fieldScale - 0.5f;
+            auto distance = (sampleBilinear(signedDistances, width, height, sourceX, sourceY,
+                                            wrapX)
+                             + offset) / fieldScale;
+            auto value = 128.f + distance * 127.f / kSpreadTexels;
+            encoded[static_cast<size_t>(y) * outWidth + x] =
+                    static_cast<uint8_t>(std::clamp(std::round(value), 1.f, 255.f));
+        }
+    }
+    return encoded;
+}
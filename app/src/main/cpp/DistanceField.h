@@ -0,0 +1,86 @@
+#ifndef ANDROIDGLINVESTIGATIONS_DISTANCEFIELD_H
+#define ANDROIDGLINVESTIGATIONS_DISTANCEFIELD_H
+
+#include <cstdint>
+#include <vector>
+
+/*!
+ * Signed distance fields of masks, for outlines that stay sharp at any zoom. The globe's shader
+ * draws an outline wherever the field is close to zero, however far it's magnified, so a field a
+ * quarter the size of a raster mask replaces it.
+ *
+ * Distances are exact Euclidean ones, computed in linear time with the transform of Felzenszwalb
+ * and Huttenlocher (2012). Has no Android or GL dependencies, tools/sdfgen builds the fields the
+ * app loads.
+ *
+ * Masks of the whole globe wrap around horizontally: with @a wrapX a mask's left and right edges
+ * are the antimeridian, and distances are measured across it as if the mask were tiled.
+ */
+class DistanceField {
+public:
+    /*!
+     * How far from the contour, in texels of an encoded field, the 8-bit encoding reaches. Farther
+     * distances are clamped. The shader decodes with the same value.
+     */
+    static constexpr float kSpreadTexels = 4.f;
+
+    /*!
+     * @param sites a pixel per byte, non-zero for the pixels distances are measured to
+     * @param wrapX true if the first and the last column are neighbours
+     * @return the squared distance of every pixel to the nearest site, in pixels. A huge value
+     *     everywhere if there are no sites.
+     */
+    static std::vector<float> computeSquaredDistances(
+            const std::vector<uint8_t> &sites,
+            int width,
+            int height,
+            bool wrapX = false);
+
+    /*!
+     * @param inside a pixel per byte, non-zero inside the shape
+     * @param wrapX true if the first and the last column are neighbours
+     * @return the distance of every pixel's centre to the shape's contour, which runs along the
+     *     edges of its pixels. Positive outside, negative inside.
+     */
+    static std::vector<float> computeSignedDistances(
+            const std::vector<uint8_t> &inside,
+            int width,
+            int height,
+            bool wrapX = false);
+
+    /*!
+     * @return half the typical width of the strokes of a line mask: the distance from a stroke's
+     *     edge to its centre line, in pixels. 0 without strokes.
+     */
+    static float estimateHalfStrokeWidth(
+            const std::vector<float> &signedDistances);
+
+    /*!
+     * Encodes a field at a fraction of its resolution into bytes, 128 on the contour and 1 to 255
+     * for -@a kSpreadTexels to +@a kSpreadTexels.
+     *
+     * @param signedDistances from @a computeSignedDistances, @a width x @a height
+     * @param scale how many pixels of the field make one texel of the encoded one in each direction
+     * @param offset added to every distance, in pixels of the field. Half the stroke width moves
+     *     the contour of a line mask onto the centre of its strokes.
+     * @param outWidth, outHeight receive the size of the encoded field, rounded up
+     * @param wrapX true if the field wraps around horizontally, texels at its left and right
+     *     edges are then interpolated across the seam. Seamless if @a scale divides @a width.
+     */
+    static std::vector<uint8_t> encode(
+            const std::vector<float> &signedDistances,
+            int width,
+            int height,
+            int scale,
+            float offset,
+            int &outWidth,
+            int &outHeight,
+            bool wrapX = false);
+
+    //! @return the distance in texels an encoded byte stands for
+    static inline float decode(uint8_t value) {
+        return (static_cast<float>(value) - 128.f) * kSpreadTexels / 127.f;
+    }
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_DISTANCEFIELD_H
@@ -0,0 +1,132 @@
+#include "FramePacer.h"
+
+#include <android/choreographer.h>
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+
+#include "AndroidOut.h"
+
+//! how much wall time the stats cover before a summary is written to logcat
+static constexpr int64_t kStatsWindowNanos = 5000000000LL;
+
+//! the refresh period assumed before one was measured
+static constexpr int64_t kDefaultVsyncPeriodNanos = 16666667LL;
+
+//! vsync callbacks further apart than this weren't requested back to back
+static constexpr int64_t kMaxVsyncIntervalNanos = 50000000LL;
+
+FramePacer::FramePacer() :
+        choreographer_(AChoreographer_getInstance()),
+        frameScheduled_(false),
+        frameReady_(false),
+        frameTimeNanos_(0),
+        lastVsyncNanos_(0),
+        vsyncPeriodNanos_(kDefaultVsyncPeriodNanos),
+        windowStartNanos_(nowNanos()),
+        firstPresentNanos_(0),
+        lastPresentNanos_(0) {
+    // AChoreographer_getInstance returns null when called on a thread without a looper
+    assert(choreographer_);
+}
+
+void FramePacer::requestFrame() {
+    if (frameScheduled_ || frameReady_) {
+        return;
+    }
+    AChoreographer_postFrameCallback64(choreographer_, onVsync, this);
+    frameScheduled_ = true;
+}
+
+bool FramePacer::consumeFrame(int64_t &outFrameTimeNanos) {
+    if (!frameReady_) {
+        return false;
+    }
+    frameReady_ = false;
+    outFrameTimeNanos = frameTimeNanos_;
+    return true;
+}
+
+void FramePacer::frameRendered(int64_t frameTimeNanos) {
+    auto now = nowNanos();
+
+    stats_.framesRendered++;
+    auto latency = std::max<int64_t>(now - frameTimeNanos, 0);
+    stats_.totalVsyncToPresentNanos += latency;
+    stats_.maxVsyncToPresentNanos = std::max(stats_.maxVsyncToPresentNanos, latency);
+
+    if (firstPresentNanos_ == 0) {
+        firstPresentNanos_ = now;
+    } else {
+        stats_.maxFrameIntervalNanos = std::max(
+                stats_.maxFrameIntervalNanos,
+                now - lastPresentNanos_);
+    }
+    lastPresentNanos_ = now;
+    stats_.activeNanos = lastPresentNanos_ - firstPresentNanos_;
+
+    if (now - windowStartNanos_ >= kStatsWindowNanos) {
+        logAndResetStats();
+    }
+}
+
+int64_t FramePacer::getVsyncPeriodNanos() const {
+    return stats_.minVsyncIntervalNanos > 0 ? stats_.minVsyncIntervalNanos : vsyncPeriodNanos_;
+}
+
+void FramePacer::logAndResetStats() {
+    if (stats_.framesRendered == 0) {
+        vsyncPeriodNanos_ = getVsyncPeriodNanos();
+        stats_.minVsyncIntervalNanos = 0;
+        windowStartNanos_ = nowNanos();
+        return;
+    }
+
+    auto toMillis = [](int64_t nanos) { return static_cast<double>(nanos) / 1e6; };
+    auto frames = static_cast<double>(stats_.framesRendered);
+    auto windowNanos = nowNanos() - windowStartNanos_;
+    auto idlePercent = windowNanos > 0
+                       ? 100.0 * static_cast<double>(stats_.idleNanos) / windowNanos
+                       : 0.0;
+    auto averageFps = stats_.activeNanos > 0 && stats_.framesRendered > 1
+                      ? (frames - 1.0) * 1e9 / static_cast<double>(stats_.activeNanos)
+                      : 0.0;
+
+    aout << "FramePacer: " << stats_.framesRendered << " frames / "
+         << stats_.vsyncCallbacks << " vsyncs, "
+         << averageFps << " fps while active, "
+         << idlePercent << "% idle, "
+         << "vsync->present avg " << toMillis(stats_.totalVsyncToPresentNanos) / frames
+         << "ms max " << toMillis(stats_.maxVsyncToPresentNanos) << "ms, "
+         << "max frame interval " << toMillis(stats_.maxFrameIntervalNanos) << "ms, "
+         << "vsync period " << toMillis(getVsyncPeriodNanos()) << "ms"
+         << std::endl;
+
+    // The next window measures the period again, in case the display changed its refresh rate
+    vsyncPeriodNanos_ = getVsyncPeriodNanos();
+    stats_ = FrameStats();
+    windowStartNanos_ = nowNanos();
+    firstPresentNanos_ = 0;
+    lastPresentNanos_ = 0;
+}
+
+int64_t FramePacer::nowNanos() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+void FramePacer::onVsync(int64_t frameTimeNanos, void *data) {
+    auto *pacer = static_cast<FramePacer *>(data);
+    pacer->frameScheduled_ = false;
+    pacer->frameReady_ = true;
+    pacer->frameTimeNanos_ = frameTimeNanos;
+    pacer->stats_.vsyncCallbacks++;
+
+    auto interval = frameTimeNanos - pacer->lastVsyncNanos_;
+    if (pacer->lastVsyncNanos_ != 0 && interval > 0 && interval < kMaxVsyncIntervalNanos) {
+        auto &shortest = pacer->stats_.minVsyncIntervalNanos;
+        shortest = shortest > 0 ? std::min(shortest, interval) : interval;
+    }
+    pacer->lastVsyncNanos_ = frameTimeNanos;
+}
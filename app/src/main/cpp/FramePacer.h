@@ -0,0 +1,115 @@
+#ifndef ANDROIDGLINVESTIGATIONS_FRAMEPACER_H
+#define ANDROIDGLINVESTIGATIONS_FRAMEPACER_H
+
+#include <cstdint>
+
+struct AChoreographer;
+
+/*!
+ * Counters describing how the on-demand render loop spent its time. Everything is accumulated
+ * over a window of a few seconds, after which @a FramePacer logs a summary and starts over.
+ */
+struct FrameStats {
+    //! number of frames that were actually drawn and presented
+    uint64_t framesRendered = 0;
+
+    //! number of vsync callbacks delivered by the choreographer
+    uint64_t vsyncCallbacks = 0;
+
+    //! time the loop spent blocked in the looper with nothing to draw
+    int64_t idleNanos = 0;
+
+    //! time between the first and the last presented frame of the measured window
+    int64_t activeNanos = 0;
+
+    //! sum and maximum of the time between a vsync and the matching eglSwapBuffers returning
+    int64_t totalVsyncToPresentNanos = 0;
+    int64_t maxVsyncToPresentNanos = 0;
+
+    //! largest gap between two consecutively presented frames
+    int64_t maxFrameIntervalNanos = 0;
+
+    //! shortest gap between two vsync callbacks, i.e. the display's refresh period
+    int64_t minVsyncIntervalNanos = 0;
+};
+
+/*!
+ * Schedules frames for the on-demand render loop. Rather than drawing as fast as possible, the
+ * loop asks the pacer for a frame whenever the scene is dirty. The pacer posts a single
+ * AChoreographer callback, so frames line up with the display's vsync and nothing is drawn at all
+ * while the scene is static.
+ *
+ * The choreographer delivers callbacks through the looper of the thread that created the pacer,
+ * so it must be created and used on a thread with an ALooper (e.g. the android_main thread).
+ */
+class FramePacer {
+public:
+    FramePacer();
+
+    /*!
+     * Asks for a frame on the next vsync. Does nothing if a frame is already scheduled.
+     */
+    void requestFrame();
+
+    /*!
+     * @return true if a vsync callback is pending, meaning the looper will be woken up by it
+     */
+    inline bool isFrameScheduled() const { return frameScheduled_; }
+
+    /*!
+     * Checks whether a vsync arrived since the last call. If one did, the caller should render and
+     * then report it with @a frameRendered.
+     *
+     * @param outFrameTimeNanos receives the vsync timestamp in the CLOCK_MONOTONIC timebase
+     * @return true if a frame should be drawn now
+     */
+    bool consumeFrame(int64_t &outFrameTimeNanos);
+
+    /*!
+     * Records a presented frame. Once the current stats window is long enough, this also logs a
+     * summary via @a logAndResetStats.
+     *
+     * @param frameTimeNanos the vsync timestamp returned by @a consumeFrame
+     */
+    void frameRendered(int64_t frameTimeNanos);
+
+    /*!
+     * @return the display's refresh period, measured from consecutive vsync callbacks. Until
+     *     enough frames were requested back to back this is a 60 Hz guess.
+     */
+    int64_t getVsyncPeriodNanos() const;
+
+    /*!
+     * Adds time spent blocked in the looper waiting for work.
+     */
+    inline void addIdleTime(int64_t nanos) { stats_.idleNanos += nanos; }
+
+    inline const FrameStats &getStats() const { return stats_; }
+
+    /*!
+     * Writes a one line summary of the current stats to logcat and starts a new window.
+     */
+    void logAndResetStats();
+
+    /*!
+     * @return the current CLOCK_MONOTONIC time, the same timebase the choreographer uses
+     */
+    static int64_t nowNanos();
+
+private:
+    static void onVsync(int64_t frameTimeNanos, void *data);
+
+    AChoreographer *choreographer_;
+    bool frameScheduled_;
+    bool frameReady_;
+    int64_t frameTimeNanos_;
+    int64_t lastVsyncNanos_;
+    int64_t vsyncPeriodNanos_;
+
+    int64_t windowStartNanos_;
+    int64_t firstPresentNanos_;
+    int64_t lastPresentNanos_;
+    FrameStats stats_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_FRAMEPACER_H
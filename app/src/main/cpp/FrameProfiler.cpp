@@ -0,0 +1,246 @@
+#include "FrameProfiler.h"
+
+#include <EGL/egl.h>
+#include <vector>
+
+#include "AndroidOut.h"
+#include "Utility.h"
+
+namespace {
+
+PercentileSummary summarize(std::vector<int64_t> &values) {
+    PercentileSummary summary;
+    if (values.empty()) {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+    auto percentile = [&values](double fraction) {
+        auto index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    };
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    summary.max = values.back();
+    return summary;
+}
+
+} // namespace
+
+FrameProfiler::FrameProfiler() :
+        timerQueriesSupported_(false),
+        glGenQueriesEXT_(nullptr),
+        glDeleteQueriesEXT_(nullptr),
+        glBeginQueryEXT_(nullptr),
+        glEndQueryEXT_(nullptr),
+        glGetQueryObjectuivEXT_(nullptr),
+        glGetQueryObjectui64vEXT_(nullptr),
+        nextQuery_(0),
+        activeQuery_(0),
+        gpuTimerRunning_(false),
+        frameNumber_(0),
+        frameStartNanos_(0),
+        stageStartNanos_(0) {
+    if (Utility::hasGlExtension("GL_EXT_disjoint_timer_query")) {
+        glGenQueriesEXT_ = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(
+                eglGetProcAddress("glGenQueriesEXT"));
+        glDeleteQueriesEXT_ = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(
+                eglGetProcAddress("glDeleteQueriesEXT"));
+        glBeginQueryEXT_ = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(
+                eglGetProcAddress("glBeginQueryEXT"));
+        glEndQueryEXT_ = reinterpret_cast<PFNGLENDQUERYEXTPROC>(
+                eglGetProcAddress("glEndQueryEXT"));
+        glGetQueryObjectuivEXT_ = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(
+                eglGetProcAddress("glGetQueryObjectuivEXT"));
+        glGetQueryObjectui64vEXT_ = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+                eglGetProcAddress("glGetQueryObjectui64vEXT"));
+
+        timerQueriesSupported_ = glGenQueriesEXT_
+                                 && glDeleteQueriesEXT_
+                                 && glBeginQueryEXT_
+                                 && glEndQueryEXT_
+                                 && glGetQueryObjectuivEXT_
+                                 && glGetQueryObjectui64vEXT_;
+    }
+
+    if (timerQueriesSupported_) {
+        GLuint ids[kQueryCount];
+        glGenQueriesEXT_(kQueryCount, ids);
+        for (size_t i = 0; i < kQueryCount; ++i) {
+            queries_[i].query = ids[i];
+        }
+
+        // Reading the disjoint flag clears it, start from a clean state
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+
+    aout << "FrameProfiler: GPU timer queries "
+         << (timerQueriesSupported_ ? "available" : "unavailable") << std::endl;
+}
+
+FrameProfiler::~FrameProfiler() {
+    if (timerQueriesSupported_) {
+        GLuint ids[kQueryCount];
+        for (size_t i = 0; i < kQueryCount; ++i) {
+            ids[i] = queries_[i].query;
+        }
+        glDeleteQueriesEXT_(kQueryCount, ids);
+    }
+}
+
+void FrameProfiler::beginFrame() {
+    frameStartNanos_ = nowNanos();
+    stageStartNanos_ = frameStartNanos_;
+
+    // If every query is still waiting on the GPU this frame simply goes without a GPU timing
+    if (timerQueriesSupported_ && !queries_[nextQuery_].inFlight) {
+        activeQuery_ = nextQuery_;
+        glBeginQueryEXT_(GL_TIME_ELAPSED_EXT, queries_[activeQuery_].query);
+        gpuTimerRunning_ = true;
+    }
+}
+
+void FrameProfiler::endGpuWork() {
+    if (gpuTimerRunning_) {
+        glEndQueryEXT_(GL_TIME_ELAPSED_EXT);
+    }
+}
+
+void FrameProfiler::endFrame() {
+    auto record = pendingFrame_;
+    pendingFrame_ = FrameRecord();
+
+    record.frameNumber = ++frameNumber_;
+    record.cpuFrameNanos = (nowNanos() - frameStartNanos_)
+                           + record.cpuStageNanos[static_cast<size_t>(FrameStage::Input)];
+
+    if (gpuTimerRunning_) {
+        auto &pending = queries_[activeQuery_];
+        pending.record = record;
+        pending.inFlight = true;
+        nextQuery_ = (activeQuery_ + 1) % kQueryCount;
+        gpuTimerRunning_ = false;
+    } else {
+        history_.push(record);
+    }
+
+    if (timerQueriesSupported_) {
+        collectGpuResults();
+    }
+}
+
+void FrameProfiler::discardFrame() {
+    pendingFrame_ = FrameRecord();
+
+    // The query has ended, but it's never marked in flight, the next frame begins it again and
+    // that throws away its result
+    gpuTimerRunning_ = false;
+}
+
+void FrameProfiler::collectGpuResults() {
+    // A disjoint event (e.g. a frequency change or context switch) invalidates every query that
+    // was in flight. Keep the CPU timings of those frames but drop their GPU times.
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    // The oldest query in flight is the one that will be reused next
+    for (size_t i = 0; i < kQueryCount; ++i) {
+        auto &pending = queries_[(nextQuery_ + i) % kQueryCount];
+        if (!pending.inFlight) {
+            continue;
+        }
+
+        if (!disjoint) {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuivEXT_(pending.query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (!available) {
+                // Results come back in order, nothing newer is ready either
+                break;
+            }
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64vEXT_(pending.query, GL_QUERY_RESULT_EXT, &elapsed);
+            pending.record.gpuNanos = static_cast<int64_t>(elapsed);
+        } else {
+            pending.record.gpuNanos = -1;
+        }
+
+        history_.push(pending.record);
+        pending.inFlight = false;
+    }
+}
+
+FrameTimingReport FrameProfiler::getReport(int64_t jankThresholdNanos) const {
+    std::vector<FrameRecord> records(kHistorySize);
+    records.resize(history_.snapshot(records.data(), records.size()));
+
+    FrameTimingReport report;
+    report.frameCount = records.size();
+
+    std::vector<int64_t> values;
+    values.reserve(records.size());
+
+    for (auto &record: records) {
+        values.push_back(record.cpuFrameNanos);
+    }
+    report.cpuFrame = summarize(values);
+
+    for (size_t stage = 0; stage < kFrameStageCount; ++stage) {
+        values.clear();
+        for (auto &record: records) {
+            values.push_back(record.cpuStageNanos[stage]);
+        }
+        report.cpuStages[stage] = summarize(values);
+    }
+
+    values.clear();
+    for (auto &record: records) {
+        if (record.gpuNanos >= 0) {
+            values.push_back(record.gpuNanos);
+        }
+        if (record.cpuFrameNanos > jankThresholdNanos || record.gpuNanos > jankThresholdNanos) {
+            report.jankFrames++;
+        }
+    }
+    report.gpuFrameCount = values.size();
+    report.gpu = summarize(values);
+
+    return report;
+}
+
+void FrameProfiler::logReport() const {
+    auto report = getReport();
+    if (report.frameCount == 0) {
+        return;
+    }
+
+    auto toMillis = [](int64_t nanos) { return static_cast<double>(nanos) / 1e6; };
+    auto print = [&toMillis](const char *name, const PercentileSummary &summary) {
+        aout << "  " << name
+             << " p50 " << toMillis(summary.p50)
+             << "ms p95 " << toMillis(summary.p95)
+             << "ms p99 " << toMillis(summary.p99)
+             << "ms max " << toMillis(summary.max) << "ms\n";
+    };
+
+    static constexpr const char *kStageNames[kFrameStageCount] = {
+            "input   ",
+            "upload  ",
+            "matrices",
+            "draw    ",
+            "swap    "
+    };
+
+    aout << "FrameProfiler: last " << report.frameCount << " frames, "
+         << report.jankFrames << " jank\n";
+    print("cpu     ", report.cpuFrame);
+    for (size_t stage = 0; stage < kFrameStageCount; ++stage) {
+        print(kStageNames[stage], report.cpuStages[stage]);
+    }
+    if (report.gpuFrameCount > 0) {
+        print("gpu     ", report.gpu);
+    }
+    aout << std::endl;
+}
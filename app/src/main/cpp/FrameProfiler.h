@@ -0,0 +1,317 @@
+#ifndef ANDROIDGLINVESTIGATIONS_FRAMEPROFILER_H
+#define ANDROIDGLINVESTIGATIONS_FRAMEPROFILER_H
+
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * The CPU phases of a frame that are timed individually.
+ */
+enum class FrameStage : int {
+    Input = 0,
+    Upload,
+    Matrices,
+    Draw,
+    Swap,
+    Count
+};
+
+static constexpr size_t kFrameStageCount = static_cast<size_t>(FrameStage::Count);
+
+/*!
+ * Timings of a single presented frame. All values are in nanoseconds.
+ */
+struct FrameRecord {
+    //! monotonically increasing frame number, starting at 1
+    int64_t frameNumber = 0;
+
+    //! CPU time spent in each @a FrameStage
+    int64_t cpuStageNanos[kFrameStageCount] = {};
+
+    //! CPU time for the whole frame, from the start of input handling until the swap returned
+    int64_t cpuFrameNanos = 0;
+
+    //! GPU time for the frame's commands, or -1 if it couldn't be measured
+    int64_t gpuNanos = -1;
+};
+
+/*!
+ * A fixed-size ring buffer holding the last @a N frame records. There's a single writer (the
+ * render thread) and any number of readers on other threads. Neither side ever takes a lock: each
+ * slot is guarded by a sequence counter, readers retry a slot if the writer touched it while it was
+ * being copied.
+ */
+template<size_t N>
+class FrameRingBuffer {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(sizeof(FrameRecord) % sizeof(int64_t) == 0, "FrameRecord must be int64 words");
+
+    static constexpr size_t kCapacity = N;
+
+    /*!
+     * Appends a record, overwriting the oldest one once the buffer is full. Only call this from
+     * the writer thread.
+     */
+    void push(const FrameRecord &record) {
+        auto index = writeCount_.load(std::memory_order_relaxed);
+        auto &slot = slots_[index & (N - 1)];
+
+        auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const auto *words = reinterpret_cast<const int64_t *>(&record);
+        for (size_t i = 0; i < kWords; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        writeCount_.store(index + 1, std::memory_order_release);
+    }
+
+    /*!
+     * Copies up to @a maxCount of the most recent records into @a outRecords, oldest first. Safe to
+     * call from any thread.
+     *
+     * @return the number of records copied
+     */
+    size_t snapshot(FrameRecord *outRecords, size_t maxCount) const {
+        auto written = writeCount_.load(std::memory_order_acquire);
+        auto count = std::min<uint64_t>(std::min<uint64_t>(written, N), maxCount);
+        auto first = written - count;
+
+        size_t copied = 0;
+        for (auto index = first; index < written; ++index) {
+            if (readSlot(slots_[index & (N - 1)], outRecords[copied])
+                && outRecords[copied].frameNumber > 0) {
+                copied++;
+            }
+        }
+        return copied;
+    }
+
+    /*!
+     * @return how many records were pushed over the lifetime of the buffer
+     */
+    uint64_t totalWritten() const { return writeCount_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t kWords = sizeof(FrameRecord) / sizeof(int64_t);
+
+    //! how often a reader retries a slot that keeps changing under it before skipping it
+    static constexpr int kMaxReadAttempts = 4;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<int64_t> words[kWords]{};
+    };
+
+    static bool readSlot(const Slot &slot, FrameRecord &outRecord) {
+        auto *words = reinterpret_cast<int64_t *>(&outRecord);
+        for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+            auto before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::array<Slot, N> slots_{};
+    std::atomic<uint64_t> writeCount_{0};
+};
+
+/*!
+ * Percentiles of one timing series, in nanoseconds.
+ */
+struct PercentileSummary {
+    int64_t p50 = 0;
+    int64_t p95 = 0;
+    int64_t p99 = 0;
+    int64_t max = 0;
+};
+
+/*!
+ * The result of @a FrameProfiler::getReport over the frames currently held in the history.
+ */
+struct FrameTimingReport {
+    size_t frameCount = 0;
+    PercentileSummary cpuFrame;
+    PercentileSummary cpuStages[kFrameStageCount];
+
+    //! only frames with a valid GPU measurement contribute to @a gpu
+    size_t gpuFrameCount = 0;
+    PercentileSummary gpu;
+
+    //! frames whose CPU or GPU time exceeded the jank threshold
+    size_t jankFrames = 0;
+};
+
+/*!
+ * Collects per-frame CPU timings for each @a FrameStage and, on devices exposing
+ * GL_EXT_disjoint_timer_query, the GPU time of each frame. Finished frames go into a lock-free
+ * history that can be summarised from any thread, cheap enough to leave on in production builds.
+ *
+ * Everything except @a getReport and @a logReport must be called on the thread owning the GL
+ * context.
+ */
+class FrameProfiler {
+public:
+    //! how many frames of history are kept
+    static constexpr size_t kHistorySize = 512;
+
+    //! frames taking longer than this on either the CPU or the GPU count as jank by default
+    static constexpr int64_t kDefaultJankThresholdNanos = 16666667;
+
+    /*!
+     * Times the enclosing scope and adds the result to a stage of the current frame.
+     */
+    class ScopedTimer {
+    public:
+        inline ScopedTimer(FrameProfiler &profiler, FrameStage stage) :
+                profiler_(profiler),
+                stage_(stage),
+                start_(nowNanos()) {}
+
+        inline ~ScopedTimer() {
+            profiler_.addStageTime(stage_, nowNanos() - start_);
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        FrameProfiler &profiler_;
+        FrameStage stage_;
+        int64_t start_;
+    };
+
+    /*!
+     * Creates the profiler. Must be called with a current GL context, it checks for timer query
+     * support and allocates the query objects.
+     */
+    FrameProfiler();
+
+    ~FrameProfiler();
+
+    FrameProfiler(const FrameProfiler &) = delete;
+    FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+    /*!
+     * Adds CPU time to a stage of the frame currently being built. Input handling happens even on
+     * loop iterations that don't render; that time is carried over into the next rendered frame.
+     */
+    inline void addStageTime(FrameStage stage, int64_t nanos) {
+        pendingFrame_.cpuStageNanos[static_cast<size_t>(stage)] += nanos;
+    }
+
+    /*!
+     * Marks the start of a rendered frame and starts the GPU timer if supported.
+     */
+    void beginFrame();
+
+    /*!
+     * Adds the CPU time since @a beginFrame or the previous @a endStage to @a stage. Lets a frame
+     * be split into consecutive stages without nesting scopes.
+     */
+    inline void endStage(FrameStage stage) {
+        auto now = nowNanos();
+        addStageTime(stage, now - stageStartNanos_);
+        stageStartNanos_ = now;
+    }
+
+    /*!
+     * Stops the GPU timer. Call this right before presenting so the swap isn't included.
+     */
+    void endGpuWork();
+
+    /*!
+     * Finishes the current frame after it was presented and collects any GPU results that became
+     * available for earlier frames.
+     */
+    void endFrame();
+
+    /*!
+     * Drops the current frame instead of finishing it, e.g. because it was never presented. Its
+     * stage times and GPU timer don't carry over into the next frame. Call after @a endGpuWork.
+     */
+    void discardFrame();
+
+    /*!
+     * @return true if GPU timings are being collected on this device
+     */
+    inline bool hasGpuTimer() const { return timerQueriesSupported_; }
+
+    /*!
+     * Computes percentiles and jank counts over the frames in the history. Thread safe.
+     *
+     * @param jankThresholdNanos frames slower than this on CPU or GPU are counted as jank
+     */
+    FrameTimingReport getReport(int64_t jankThresholdNanos = kDefaultJankThresholdNanos) const;
+
+    /*!
+     * Writes @a getReport to logcat. Thread safe.
+     */
+    void logReport() const;
+
+    /*!
+     * @return the number of frames recorded so far, including frames still waiting for GPU results
+     */
+    inline int64_t getFrameCount() const { return frameNumber_; }
+
+    static inline int64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    //! GPU results typically arrive a couple of frames late, this is how many can be in flight
+    static constexpr size_t kQueryCount = 4;
+
+    struct PendingQuery {
+        GLuint query = 0;
+        bool inFlight = false;
+        FrameRecord record;
+    };
+
+    /*!
+     * Pushes finished frames whose GPU result is available, oldest first.
+     */
+    void collectGpuResults();
+
+    bool timerQueriesSupported_;
+    PFNGLGENQUERIESEXTPROC glGenQueriesEXT_;
+    PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT_;
+    PFNGLBEGINQUERYEXTPROC glBeginQueryEXT_;
+    PFNGLENDQUERYEXTPROC glEndQueryEXT_;
+    PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT_;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT_;
+
+    std::array<PendingQuery, kQueryCount> queries_;
+    size_t nextQuery_;
+    size_t activeQuery_;
+    bool gpuTimerRunning_;
+
+    int64_t frameNumber_;
+    int64_t frameStartNanos_;
+    int64_t stageStartNanos_;
+    FrameRecord pendingFrame_;
+
+    FrameRingBuffer<kHistorySize> history_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_FRAMEPROFILER_H
@@ -0,0 +1,25 @@
+#include "GeoCoordinates.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr float kDegreesToRadians = 3.14159265358979323846f / 180.f;
+
+} // namespace
+
+Vec3 directionFromLatLon(float latitude, float longitude) {
+    // Longitude 0 is the middle of the map, half a turn from where the sphere's angle starts
+    auto lat = latitude * kDegreesToRadians;
+    auto lon = longitude * kDegreesToRadians;
+    auto cosLat = std::cos(lat);
+    return {-cosLat * std::cos(lon), -std::sin(lat), -cosLat * std::sin(lon)};
+}
+
+void latLonFromDirection(const Vec3 &direction, float &outLatitude, float &outLongitude) {
+    auto horizontal = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+    outLatitude = std::atan2(-direction.y, horizontal) / kDegreesToRadians;
+    outLongitude = horizontal > 0.f
+                   ? std::atan2(-direction.z, -direction.x) / kDegreesToRadians
+                   : 0.f;
+}
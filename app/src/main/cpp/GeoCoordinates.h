@@ -0,0 +1,37 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GEOCOORDINATES_H
+#define ANDROIDGLINVESTIGATIONS_GEOCOORDINATES_H
+
+#include "VectorMath.h"
+
+// Latitude and longitude on the globe, in degrees. The mapping to the unit sphere of the globe's
+// model space follows the imagery: longitude -180 is the map's left edge (u = 0) and the north
+// pole its top row (v = 0), which the globe places at y = -1, see TilePyramid::selectRecursive.
+
+/*!
+ * A latitude and longitude range, e.g. what a viewport shows. If @a west is greater than @a east
+ * the range crosses the antimeridian, so {-10, 170, 10, -170} is 20 degrees wide.
+ */
+struct GeoRect {
+    float south = -90.f;
+    float west = -180.f;
+    float north = 90.f;
+    float east = 180.f;
+};
+
+/*!
+ * @param latitude degrees north, in [-90, 90]
+ * @param longitude degrees east, any value, wraps around
+ * @return the point on the unit sphere
+ */
+Vec3 directionFromLatLon(float latitude, float longitude);
+
+/*!
+ * The inverse of @a directionFromLatLon.
+ *
+ * @param direction a point on the unit sphere, or any vector from the centre towards it
+ * @param outLatitude degrees north, in [-90, 90]
+ * @param outLongitude degrees east, in [-180, 180]
+ */
+void latLonFromDirection(const Vec3 &direction, float &outLatitude, float &outLongitude);
+
+#endif //ANDROIDGLINVESTIGATIONS_GEOCOORDINATES_H
@@ -0,0 +1,351 @@
+#include "GestureEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+//! pinches closer than this (pixels) are too noisy to scale by
+static constexpr float kMinPinchSpan = 20.f;
+
+//! fewer samples than this in the window don't make a velocity
+static constexpr size_t kMinVelocitySamples = 3;
+
+//! once the newest sample is older than this the finger is probably stopping, the prediction
+//! fades out until the finger counts as resting
+static constexpr int64_t kPredictionFadeNanos = 20000000LL;
+
+GestureEngine::GestureEngine() :
+        predictionEnabled_(true),
+        pointers_{},
+        activePointerCount_(0),
+        baselineX_(0.f),
+        baselineY_(0.f),
+        baselineSpan_(0.f),
+        panX_(0.f),
+        panY_(0.f),
+        reportedX_(0.f),
+        reportedY_(0.f),
+        pendingDistanceScale_(1.f),
+        history_{},
+        historyCount_(0),
+        historyNext_(0),
+        newestSampleNanos_(0),
+        samplesSinceUpdate_(0),
+        flinging_(false),
+        flingVx_(0.f),
+        flingVy_(0.f),
+        flingTimeNanos_(0),
+        tapCandidate_(false),
+        tapX_(0.f),
+        tapY_(0.f),
+        tapDownNanos_(0),
+        tapPending_(false) {
+    for (auto &pointer: pointers_) {
+        pointer.id = -1;
+    }
+}
+
+void GestureEngine::onTouchEvent(const TouchEvent &event) {
+    switch (event.action) {
+        case TouchEvent::Action::Down: {
+            if (activePointerCount_ == 0) {
+                // Only a touch on a globe that stands still can tap, one that stops it doesn't
+                tapCandidate_ = !flinging_;
+                tapDownNanos_ = event.timeNanos;
+
+                // A new touch catches a running fling, and the velocity starts from scratch
+                flinging_ = false;
+                historyCount_ = 0;
+                historyNext_ = 0;
+            }
+
+            auto *freeSlot = std::find_if(
+                    std::begin(pointers_), std::end(pointers_),
+                    [](const Pointer &pointer) { return pointer.id == -1; });
+            if (freeSlot == std::end(pointers_)) {
+                break;
+            }
+            freeSlot->id = event.actionPointerId;
+            activePointerCount_++;
+
+            // Take the new finger's position without moving anything
+            for (int i = 0; i < event.pointerCount; ++i) {
+                if (event.pointers[i].id == event.actionPointerId) {
+                    freeSlot->x = event.pointers[i].x;
+                    freeSlot->y = event.pointers[i].y;
+                }
+            }
+            if (activePointerCount_ == 1) {
+                tapX_ = freeSlot->x;
+                tapY_ = freeSlot->y;
+            } else {
+                tapCandidate_ = false;
+            }
+            resetBaseline();
+            addPanSample(event.timeNanos);
+            break;
+        }
+        case TouchEvent::Action::Move:
+            if (activePointerCount_ > 0) {
+                applyPositions(event);
+                addPanSample(event.timeNanos);
+                updateTapCandidate();
+            }
+            break;
+        case TouchEvent::Action::Up: {
+            auto id = event.actionPointerId;
+            auto *slot = std::find_if(
+                    std::begin(pointers_), std::end(pointers_),
+                    [id](const Pointer &pointer) { return pointer.id == id; });
+            if (slot == std::end(pointers_)) {
+                break;
+            }
+
+            // The up event carries the finger's final position
+            applyPositions(event);
+            addPanSample(event.timeNanos);
+            updateTapCandidate();
+            slot->id = -1;
+            activePointerCount_--;
+
+            if (activePointerCount_ > 0) {
+                resetBaseline();
+                break;
+            }
+
+            if (tapCandidate_ && event.timeNanos - tapDownNanos_ <= kTapTimeoutNanos) {
+                tapPending_ = true;
+            }
+            tapCandidate_ = false;
+
+            float vx;
+            float vy;
+            if (estimateVelocity(event.timeNanos, vx, vy)) {
+                auto speed = std::sqrt(vx * vx + vy * vy);
+                if (speed >= kMinFlingVelocity) {
+                    auto clamp = std::min(1.f, kMaxFlingVelocity / speed);
+                    flinging_ = true;
+                    flingVx_ = vx * clamp;
+                    flingVy_ = vy * clamp;
+                    flingTimeNanos_ = event.timeNanos;
+                }
+            }
+            break;
+        }
+        case TouchEvent::Action::Cancel:
+            for (auto &pointer: pointers_) {
+                pointer.id = -1;
+            }
+            activePointerCount_ = 0;
+            flinging_ = false;
+            tapCandidate_ = false;
+            break;
+    }
+}
+
+GestureMotion GestureEngine::update(int64_t frameTimeNanos, int64_t presentTimeNanos) {
+    GestureMotion motion;
+
+    if (flinging_) {
+        // Integrating v * e^(-t / tau) exactly over the frame's time step, instead of stepping
+        // the velocity per frame, makes the travel independent of the frame rate
+        auto dt = static_cast<float>(frameTimeNanos - flingTimeNanos_) * 1e-9f;
+        if (dt > 0.f) {
+            auto decay = std::exp(-dt / kFlingTimeConstantSeconds);
+            auto travel = kFlingTimeConstantSeconds * (1.f - decay);
+            panX_ += flingVx_ * travel;
+            panY_ += flingVy_ * travel;
+            flingVx_ *= decay;
+            flingVy_ *= decay;
+            flingTimeNanos_ = frameTimeNanos;
+
+            if (std::sqrt(flingVx_ * flingVx_ + flingVy_ * flingVy_) < kFlingStopVelocity) {
+                flinging_ = false;
+            }
+        }
+        if (samplesSinceUpdate_ == 0) {
+            stats_.flingFrames++;
+        }
+    }
+
+    // Extrapolate the finger to when this frame is seen. When samples stop coming the finger is
+    // slowing down, the prediction fades out so a stop doesn't overshoot for long. A resting
+    // finger isn't predicted at all, which takes back what the previous frames predicted.
+    auto targetX = panX_;
+    auto targetY = panY_;
+    int64_t predictionNanos = 0;
+    auto sampleAge = frameTimeNanos - newestSampleNanos_;
+    float vx;
+    float vy;
+    if (predictionEnabled_
+        && activePointerCount_ > 0
+        && sampleAge < kRestingNanos
+        && estimateVelocity(newestSampleNanos_, vx, vy)) {
+        auto fade = std::clamp(
+                static_cast<float>(kRestingNanos - sampleAge)
+                / static_cast<float>(kRestingNanos - kPredictionFadeNanos),
+                0.f, 1.f);
+        predictionNanos = static_cast<int64_t>(
+                static_cast<float>(std::clamp<int64_t>(
+                        presentTimeNanos - newestSampleNanos_, 0, kMaxPredictionNanos)) * fade);
+        auto seconds = static_cast<float>(predictionNanos) * 1e-9f;
+        targetX += vx * seconds;
+        targetY += vy * seconds;
+    }
+
+    motion.dx = targetX - reportedX_;
+    motion.dy = targetY - reportedY_;
+    reportedX_ = targetX;
+    reportedY_ = targetY;
+
+    motion.distanceScale = pendingDistanceScale_;
+    pendingDistanceScale_ = 1.f;
+
+    if (samplesSinceUpdate_ > 0) {
+        auto touchToPhoton = std::max<int64_t>(presentTimeNanos - newestSampleNanos_, 0);
+        stats_.samples += samplesSinceUpdate_;
+        stats_.framesWithInput++;
+        stats_.totalTouchToPhotonNanos += touchToPhoton;
+        stats_.maxTouchToPhotonNanos = std::max(stats_.maxTouchToPhotonNanos, touchToPhoton);
+        stats_.totalPredictionNanos += predictionNanos;
+        samplesSinceUpdate_ = 0;
+    }
+    return motion;
+}
+
+bool GestureEngine::needsFrame() const {
+    return samplesSinceUpdate_ > 0
+           || tapPending_
+           || flinging_
+           || pendingDistanceScale_ != 1.f
+           || reportedX_ != panX_
+           || reportedY_ != panY_;
+}
+
+bool GestureEngine::consumeTap(float &outX, float &outY) {
+    if (!tapPending_) {
+        return false;
+    }
+    tapPending_ = false;
+    outX = tapX_;
+    outY = tapY_;
+    return true;
+}
+
+void GestureEngine::updateTapCandidate() {
+    if (tapCandidate_) {
+        for (const auto &pointer: pointers_) {
+            if (pointer.id != -1
+                && std::hypot(pointer.x - tapX_, pointer.y - tapY_) > kTapSlopPixels) {
+                tapCandidate_ = false;
+            }
+        }
+    }
+}
+
+void GestureEngine::applyPositions(const TouchEvent &event) {
+    for (int i = 0; i < event.pointerCount; ++i) {
+        for (auto &pointer: pointers_) {
+            if (pointer.id != -1 && pointer.id == event.pointers[i].id) {
+                pointer.x = event.pointers[i].x;
+                pointer.y = event.pointers[i].y;
+            }
+        }
+    }
+
+    auto previousX = baselineX_;
+    auto previousY = baselineY_;
+    auto previousSpan = baselineSpan_;
+    resetBaseline();
+
+    // The centroid drags, the distance between two fingers zooms
+    panX_ += baselineX_ - previousX;
+    panY_ += baselineY_ - previousY;
+    if (activePointerCount_ == kMaxGesturePointers
+        && previousSpan > kMinPinchSpan
+        && baselineSpan_ > kMinPinchSpan) {
+        pendingDistanceScale_ *= previousSpan / baselineSpan_;
+    }
+}
+
+void GestureEngine::resetBaseline() {
+    auto x = 0.f;
+    auto y = 0.f;
+    for (const auto &pointer: pointers_) {
+        if (pointer.id != -1) {
+            x += pointer.x;
+            y += pointer.y;
+        }
+    }
+    auto count = static_cast<float>(std::max(activePointerCount_, 1));
+    baselineX_ = x / count;
+    baselineY_ = y / count;
+
+    baselineSpan_ = 0.f;
+    if (activePointerCount_ == kMaxGesturePointers) {
+        baselineSpan_ = std::hypot(
+                pointers_[0].x - pointers_[1].x,
+                pointers_[0].y - pointers_[1].y);
+    }
+}
+
+void GestureEngine::addPanSample(int64_t timeNanos) {
+    history_[historyNext_] = {timeNanos, panX_, panY_};
+    historyNext_ = (historyNext_ + 1) % kHistorySize;
+    historyCount_ = std::min(historyCount_ + 1, kHistorySize);
+    newestSampleNanos_ = timeNanos;
+    samplesSinceUpdate_++;
+}
+
+bool GestureEngine::estimateVelocity(int64_t timeNanos, float &outVx, float &outVy) const {
+    outVx = 0.f;
+    outVy = 0.f;
+
+    // Least squares line through the recent samples, relative to the newest to keep the sums small
+    double sumT = 0.0;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    double sumTT = 0.0;
+    double sumTX = 0.0;
+    double sumTY = 0.0;
+    size_t count = 0;
+    int64_t newest = 0;
+    int64_t previous = 0;
+    for (size_t i = 0; i < historyCount_; ++i) {
+        const auto &sample = history_[(historyNext_ + kHistorySize - 1 - i) % kHistorySize];
+        if (i == 0) {
+            newest = sample.timeNanos;
+            previous = newest;
+            if (timeNanos - newest > kRestingNanos) {
+                return false;
+            }
+        }
+
+        // A pause in the samples means the finger rested, what came before it doesn't count
+        if (newest - sample.timeNanos > kVelocityWindowNanos
+            || previous - sample.timeNanos > kRestingNanos) {
+            break;
+        }
+        previous = sample.timeNanos;
+        auto t = static_cast<double>(sample.timeNanos - newest) * 1e-9;
+        sumT += t;
+        sumX += sample.x;
+        sumY += sample.y;
+        sumTT += t * t;
+        sumTX += t * sample.x;
+        sumTY += t * sample.y;
+        count++;
+    }
+    if (count < kMinVelocitySamples) {
+        return false;
+    }
+
+    auto n = static_cast<double>(count);
+    auto denominator = n * sumTT - sumT * sumT;
+    if (denominator <= 0.0) {
+        return false;
+    }
+    outVx = static_cast<float>((n * sumTX - sumT * sumX) / denominator);
+    outVy = static_cast<float>((n * sumTY - sumT * sumY) / denominator);
+    return true;
+}
@@ -0,0 +1,247 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GESTUREENGINE_H
+#define ANDROIDGLINVESTIGATIONS_GESTUREENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+//! the pointers a gesture follows, one drags and two pinch. Further fingers are ignored.
+constexpr int kMaxGesturePointers = 2;
+
+/*!
+ * One finger's position in a @a TouchEvent, in pixels.
+ */
+struct TouchPointer {
+    int32_t id = -1;
+    float x = 0.f;
+    float y = 0.f;
+};
+
+/*!
+ * A single touch sample, independent of the platform's event types. A MOVE event with historical
+ * samples turns into one of these per sample, so every position the touch screen reported reaches
+ * the @a GestureEngine with its own timestamp.
+ */
+struct TouchEvent {
+    enum class Action {
+        //! @a actionPointerId went down, the other pointers didn't move
+        Down,
+        //! the pointers moved
+        Move,
+        //! @a actionPointerId went up at its position in this event
+        Up,
+        //! the gesture was taken away, e.g. by the system, nothing should fling
+        Cancel
+    };
+
+    Action action = Action::Move;
+
+    //! when the sample was taken, in the CLOCK_MONOTONIC timebase like the choreographer's vsync
+    int64_t timeNanos = 0;
+
+    int32_t actionPointerId = -1;
+    int32_t pointerCount = 0;
+    TouchPointer pointers[kMaxGesturePointers];
+};
+
+/*!
+ * What a frame should apply to the camera, see @a GestureEngine::update.
+ */
+struct GestureMotion {
+    //! drag distance in pixels to rotate the globe by
+    float dx = 0.f;
+    float dy = 0.f;
+
+    //! factor to multiply the camera distance with, below 1 when the fingers spread apart
+    float distanceScale = 1.f;
+};
+
+/*!
+ * Counters for how quickly touches reach the screen, kept until @a GestureEngine::resetStats.
+ */
+struct GestureStats {
+    //! touch samples integrated, historical ones included
+    uint64_t samples = 0;
+
+    //! frames that applied at least one new sample
+    uint64_t framesWithInput = 0;
+
+    //! frames that only advanced a fling
+    uint64_t flingFrames = 0;
+
+    //! sum and maximum of the time from the newest sample of a frame to its estimated present time
+    int64_t totalTouchToPhotonNanos = 0;
+    int64_t maxTouchToPhotonNanos = 0;
+
+    //! sum of how far ahead the frames with input were predicted, hidden from the latency above
+    int64_t totalPredictionNanos = 0;
+};
+
+/*!
+ * Turns touch samples into per-frame camera motion.
+ *
+ * Samples are fed in as they arrive with @a onTouchEvent, and @a update is called once per frame
+ * with the frame's vsync. The engine:
+ *  - integrates every sample, including historical ones, into a pan position and an estimate of the
+ *    finger's velocity from their timestamps
+ *  - hands out everything since the last frame as a single @a GestureMotion
+ *  - predicts where the finger will be when the frame reaches the screen, so the globe doesn't
+ *    trail behind it
+ *  - keeps the globe moving after the last finger lifts, decaying exponentially with time so the
+ *    fling travels the same distance at any frame rate
+ *  - scales the camera distance by how much two fingers pinch or spread
+ *
+ * Platform independent and single threaded, the app runs it on the render thread.
+ */
+class GestureEngine {
+public:
+    //! samples this far back from the newest one go into the velocity estimate
+    static constexpr int64_t kVelocityWindowNanos = 100000000LL;
+
+    //! the furthest the pointer is predicted ahead of its newest sample
+    static constexpr int64_t kMaxPredictionNanos = 24000000LL;
+
+    //! a finger with no new samples for this long is resting, its velocity is zero
+    static constexpr int64_t kRestingNanos = 50000000LL;
+
+    //! time constant of the fling's exponential decay
+    static constexpr float kFlingTimeConstantSeconds = 0.325f;
+
+    //! slower releases just stop, faster ones are clamped (pixels per second)
+    static constexpr float kMinFlingVelocity = 50.f;
+    static constexpr float kMaxFlingVelocity = 8000.f;
+
+    //! a fling ends once it's slower than this (pixels per second)
+    static constexpr float kFlingStopVelocity = 5.f;
+
+    //! a single finger that lifts within this time and distance of touching down is a tap
+    static constexpr int64_t kTapTimeoutNanos = 300000000LL;
+    static constexpr float kTapSlopPixels = 16.f;
+
+    GestureEngine();
+
+    /*!
+     * Turns the prediction on or off, e.g. to compare latency with and without it.
+     */
+    inline void setPredictionEnabled(bool enabled) { predictionEnabled_ = enabled; }
+
+    /*!
+     * Integrates one touch sample. Samples must arrive in time order.
+     */
+    void onTouchEvent(const TouchEvent &event);
+
+    /*!
+     * Collects the motion for a frame.
+     *
+     * @param frameTimeNanos the frame's vsync time, flings advance to it
+     * @param presentTimeNanos when the frame is expected to be on screen, the pointer is predicted
+     *     towards it
+     * @return the motion since the previous call
+     */
+    GestureMotion update(int64_t frameTimeNanos, int64_t presentTimeNanos);
+
+    /*!
+     * @return true if the next frame would move the camera even without new samples: new samples
+     *     arrived since the last @a update, a fling is running or a prediction has to be undone
+     */
+    bool needsFrame() const;
+
+    /*!
+     * @return true while at least one finger is down
+     */
+    inline bool isTouching() const { return activePointerCount_ > 0; }
+
+    inline bool isFlinging() const { return flinging_; }
+
+    /*!
+     * Takes the last tap that wasn't consumed yet. Touches that catch a fling don't tap.
+     *
+     * @param outX receives where the finger touched down, in pixels
+     * @return false if there was no tap since the last call
+     */
+    bool consumeTap(float &outX, float &outY);
+
+    inline const GestureStats &getStats() const { return stats_; }
+
+    inline void resetStats() { stats_ = GestureStats(); }
+
+private:
+    static constexpr size_t kHistorySize = 32;
+
+    //! a sample of the pan position for the velocity estimate
+    struct PanSample {
+        int64_t timeNanos;
+        float x;
+        float y;
+    };
+
+    //! a finger the gesture follows, @a id is -1 for a free slot
+    struct Pointer {
+        int32_t id;
+        float x;
+        float y;
+    };
+
+    /*!
+     * Takes the positions of the followed pointers from @a event and moves the pan position and
+     * pinch scale along with them.
+     */
+    void applyPositions(const TouchEvent &event);
+
+    /*!
+     * Restarts the centroid and span the next move is measured against, after the pointers
+     * changed.
+     */
+    void resetBaseline();
+
+    void addPanSample(int64_t timeNanos);
+
+    /*!
+     * Drops the tap once the finger wandered too far from where it touched down.
+     */
+    void updateTapCandidate();
+
+    /*!
+     * Fits a line through the pan samples of the last @a kVelocityWindowNanos before @a timeNanos.
+     *
+     * @return false if there are too few samples, or the finger is resting
+     */
+    bool estimateVelocity(int64_t timeNanos, float &outVx, float &outVy) const;
+
+    bool predictionEnabled_;
+
+    Pointer pointers_[kMaxGesturePointers];
+    int activePointerCount_;
+    float baselineX_;
+    float baselineY_;
+    float baselineSpan_;
+
+    // The pan position integrates every move, the renderer has been handed reportedX_/Y_. They
+    // differ by the motion of the next frame, including any prediction.
+    float panX_;
+    float panY_;
+    float reportedX_;
+    float reportedY_;
+    float pendingDistanceScale_;
+
+    PanSample history_[kHistorySize];
+    size_t historyCount_;
+    size_t historyNext_;
+    int64_t newestSampleNanos_;
+    uint64_t samplesSinceUpdate_;
+
+    bool flinging_;
+    float flingVx_;
+    float flingVy_;
+    int64_t flingTimeNanos_;
+
+    // The touch that may become a tap, and the tap waiting for consumeTap
+    bool tapCandidate_;
+    float tapX_;
+    float tapY_;
+    int64_t tapDownNanos_;
+    bool tapPending_;
+
+    GestureStats stats_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_GESTUREENGINE_H
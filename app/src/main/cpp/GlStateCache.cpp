@@ -0,0 +1,155 @@
+#include "GlStateCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include "AndroidOut.h"
+
+GlStateCache::GlStateCache() {
+    invalidate();
+}
+
+template<typename T>
+bool GlStateCache::change(T &current, T wanted) {
+    if (current == wanted) {
+        stats_.skipped++;
+        return false;
+    }
+    current = wanted;
+    stats_.issued++;
+    return true;
+}
+
+void GlStateCache::useProgram(GLuint program) {
+    if (change(program_, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GlStateCache::bindVertexArray(GLuint vertexArray) {
+    if (change(vertexArray_, vertexArray)) {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GlStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    assert(unit < kTrackedTextureUnits);
+
+    GLuint *binding = nullptr;
+    if (target == GL_TEXTURE_2D) {
+        binding = &textures2d_[unit];
+    } else if (target == GL_TEXTURE_2D_ARRAY) {
+        binding = &textures2dArray_[unit];
+    }
+
+    // Checked before the unit, switching units for a binding that's already there is wasted too
+    if (binding && *binding == texture) {
+        stats_.skipped++;
+        return;
+    }
+    if (change(activeTextureUnit_, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    stats_.issued++;
+    if (binding) {
+        *binding = texture;
+    }
+    glBindTexture(target, texture);
+}
+
+void GlStateCache::selectUploadUnit() {
+    if (change(activeTextureUnit_, kUploadTextureUnit)) {
+        glActiveTexture(GL_TEXTURE0 + kUploadTextureUnit);
+    }
+}
+
+void GlStateCache::bindUniformBuffer(GLuint buffer) {
+    if (change(uniformBuffer_, buffer)) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    }
+}
+
+void GlStateCache::bindUniformBufferBase(GLuint index, GLuint buffer) {
+    assert(index < kTrackedUniformBindings);
+    if (change(uniformBufferBases_[index], buffer)) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, index, buffer);
+        uniformBuffer_ = buffer;
+    }
+}
+
+void GlStateCache::setCapability(Flag &current, GLenum capability, bool enabled) {
+    if (change(current, static_cast<Flag>(enabled ? 1 : 0))) {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+}
+
+void GlStateCache::setDepthTest(bool enabled) {
+    setCapability(depthTest_, GL_DEPTH_TEST, enabled);
+}
+
+void GlStateCache::setDepthFunc(GLenum func) {
+    if (change(depthFunc_, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void GlStateCache::setDepthMask(bool enabled) {
+    if (change(depthMask_, static_cast<Flag>(enabled ? 1 : 0))) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GlStateCache::setBlend(bool enabled) {
+    setCapability(blend_, GL_BLEND, enabled);
+}
+
+void GlStateCache::setBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    if (blendSource_ == sourceFactor && blendDestination_ == destinationFactor) {
+        stats_.skipped++;
+        return;
+    }
+    blendSource_ = sourceFactor;
+    blendDestination_ = destinationFactor;
+    stats_.issued++;
+    glBlendFunc(sourceFactor, destinationFactor);
+}
+
+void GlStateCache::setCullFace(bool enabled) {
+    setCapability(cullFace_, GL_CULL_FACE, enabled);
+}
+
+void GlStateCache::invalidateTextures() {
+    activeTextureUnit_ = kUnknown;
+    std::fill(std::begin(textures2d_), std::end(textures2d_), kUnknown);
+    std::fill(std::begin(textures2dArray_), std::end(textures2dArray_), kUnknown);
+}
+
+void GlStateCache::invalidate() {
+    program_ = kUnknown;
+    vertexArray_ = kUnknown;
+    invalidateTextures();
+    uniformBuffer_ = kUnknown;
+    std::fill(std::begin(uniformBufferBases_), std::end(uniformBufferBases_), kUnknown);
+
+    depthTest_ = -1;
+    depthFunc_ = kUnknown;
+    depthMask_ = -1;
+    blend_ = -1;
+    blendSource_ = kUnknown;
+    blendDestination_ = kUnknown;
+    cullFace_ = -1;
+}
+
+void GlStateCache::logStats() const {
+    auto total = stats_.issued + stats_.skipped;
+    aout << "GlStateCache: " << stats_.issued << " state changes issued, " << stats_.skipped
+         << " skipped as redundant ("
+         << (total ? 100.0 * static_cast<double>(stats_.skipped) / static_cast<double>(total) : 0.0)
+         << "%)" << std::endl;
+}
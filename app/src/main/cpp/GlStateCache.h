@@ -0,0 +1,138 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GLSTATECACHE_H
+#define ANDROIDGLINVESTIGATIONS_GLSTATECACHE_H
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+
+/*!
+ * How many state changes went to the driver and how many were dropped as redundant.
+ */
+struct GlStateStats {
+    uint64_t issued = 0;
+    uint64_t skipped = 0;
+};
+
+/*!
+ * Remembers the GL state the renderer binds and drops calls that wouldn't change it, so the cost
+ * of a frame grows with the state that actually changes rather than with the number of draws.
+ * Tracks the program, the vertex array, the uniform buffer bindings, the textures of the first
+ * @a kTrackedTextureUnits units and the depth, blend and culling state.
+ *
+ * The cache only knows about calls made through it. State that's changed behind its back has to
+ * be forgotten with one of the invalidate functions, in particular after deleting a bound object:
+ * GL unbinds it and may hand out its name again. Texture uploads don't have to go through the
+ * cache, they bind on @a kUploadTextureUnit after @a selectUploadUnit.
+ *
+ * Needs no GL context to be created, every state starts out unknown so the first call of each kind
+ * is always issued. Must only be used on the thread that owns the context.
+ */
+class GlStateCache {
+public:
+    //! texture units whose bindings are tracked
+    static constexpr GLuint kTrackedTextureUnits = 8;
+
+    //! the unit code that creates or fills textures binds on, never used for drawing
+    static constexpr GLuint kUploadTextureUnit = 15;
+
+    //! uniform buffer binding points whose buffers are tracked
+    static constexpr GLuint kTrackedUniformBindings = 8;
+
+    GlStateCache();
+
+    void useProgram(GLuint program);
+
+    void bindVertexArray(GLuint vertexArray);
+
+    /*!
+     * Binds @a texture to @a target on texture unit @a unit, activating the unit first if needed.
+     *
+     * @param unit the unit's index, not GL_TEXTUREi. Below @a kTrackedTextureUnits.
+     */
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /*!
+     * Makes @a kUploadTextureUnit the active unit, so textures can be bound directly to create or
+     * fill them without disturbing the bindings used for drawing.
+     */
+    void selectUploadUnit();
+
+    /*!
+     * Binds @a buffer to the generic GL_UNIFORM_BUFFER binding, e.g. to update it.
+     */
+    void bindUniformBuffer(GLuint buffer);
+
+    /*!
+     * Binds @a buffer to uniform block binding point @a index with glBindBufferBase, which also
+     * changes the generic binding.
+     */
+    void bindUniformBufferBase(GLuint index, GLuint buffer);
+
+    void setDepthTest(bool enabled);
+
+    void setDepthFunc(GLenum func);
+
+    void setDepthMask(bool enabled);
+
+    void setBlend(bool enabled);
+
+    void setBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+    /*!
+     * Turns GL_CULL_FACE on or off. The culled face and the winding are left at GL's defaults,
+     * back faces and counterclockwise.
+     */
+    void setCullFace(bool enabled);
+
+    /*!
+     * Forgets every texture binding, e.g. after textures were deleted.
+     */
+    void invalidateTextures();
+
+    /*!
+     * Forgets all state, e.g. after a new context was created or a program was replaced.
+     */
+    void invalidate();
+
+    inline const GlStateStats &getStats() const { return stats_; }
+
+    inline void resetStats() { stats_ = GlStateStats(); }
+
+    void logStats() const;
+
+private:
+    //! an object name or enum no call would ever set, marks a binding as unknown
+    static constexpr GLuint kUnknown = 0xFFFFFFFFu;
+
+    //! a tri-state for capabilities, -1 while unknown
+    using Flag = int8_t;
+
+    /*!
+     * Counts a call and tells if it has to be issued.
+     *
+     * @return true if @a current differs from @a wanted, @a current is updated to it
+     */
+    template<typename T>
+    bool change(T &current, T wanted);
+
+    void setCapability(Flag &current, GLenum capability, bool enabled);
+
+    GLuint program_;
+    GLuint vertexArray_;
+    GLuint activeTextureUnit_;
+    GLuint textures2d_[kTrackedTextureUnits];
+    GLuint textures2dArray_[kTrackedTextureUnits];
+    GLuint uniformBuffer_;
+    GLuint uniformBufferBases_[kTrackedUniformBindings];
+
+    Flag depthTest_;
+    GLenum depthFunc_;
+    Flag depthMask_;
+    Flag blend_;
+    GLenum blendSource_;
+    GLenum blendDestination_;
+    Flag cullFace_;
+
+    GlStateStats stats_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_GLSTATECACHE_H
@@ -0,0 +1,19 @@
+#include "GlobeImpostor.h"
+
+#include <utility>
+
+GlobeImpostor::GlobeImpostor(std::shared_ptr<TextureAsset> spTexture) :
+        spTexture_(std::move(spTexture)),
+        vertexArray_(0) {
+    glGenVertexArrays(1, &vertexArray_);
+}
+
+GlobeImpostor::~GlobeImpostor() {
+    glDeleteVertexArrays(1, &vertexArray_);
+}
+
+void GlobeImpostor::draw(GlStateCache &stateCache) const {
+    stateCache.bindTexture(0, GL_TEXTURE_2D, spTexture_->getTextureID());
+    stateCache.bindVertexArray(vertexArray_);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
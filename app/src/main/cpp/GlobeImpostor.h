@@ -0,0 +1,45 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GLOBEIMPOSTOR_H
+#define ANDROIDGLINVESTIGATIONS_GLOBEIMPOSTOR_H
+
+#include <GLES3/gl3.h>
+#include <memory>
+
+#include "GlStateCache.h"
+#include "TextureAsset.h"
+
+/*!
+ * Draws the globe as a single quad facing the camera that bounds the sphere on screen. There are
+ * no vertex buffers, the vertex shader builds the corners from gl_VertexID. The fragment shader
+ * intersects each pixel's view ray with the unit sphere, so the limb is exact at any zoom and the
+ * depth it writes is the sphere's, not the quad's. Must be created and destroyed with a current
+ * GL context.
+ */
+class GlobeImpostor {
+public:
+    explicit GlobeImpostor(std::shared_ptr<TextureAsset> spTexture);
+
+    ~GlobeImpostor();
+
+    GlobeImpostor(const GlobeImpostor &) = delete;
+    GlobeImpostor &operator=(const GlobeImpostor &) = delete;
+
+    /*!
+     * Swaps the texture, e.g. to replace a placeholder once the real one finished loading
+     */
+    inline void setTexture(std::shared_ptr<TextureAsset> spTexture) {
+        spTexture_ = std::move(spTexture);
+    }
+
+    /*!
+     * Draws the quad with the currently active program.
+     */
+    void draw(GlStateCache &stateCache) const;
+
+private:
+    std::shared_ptr<TextureAsset> spTexture_;
+
+    //! has no attributes, but drawing without any vertex array bound isn't portable
+    GLuint vertexArray_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_GLOBEIMPOSTOR_H
@@ -0,0 +1,114 @@
+#include "GlobeMesh.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "AndroidOut.h"
+#include "MeshOptimizer.h"
+#include "VertexLayout.h"
+
+GlobeMesh::GlobeMesh(const CubeSphere &sphere, std::shared_ptr<TextureAsset> spTexture) :
+        sphere_(sphere),
+        spTexture_(std::move(spTexture)),
+        vertexBuffer_(0),
+        indexBuffer_(0),
+        vertexArray_(0),
+        indexCount_(0),
+        indexType_(GL_UNSIGNED_SHORT) {
+    auto vertices = sphere_.buildGridVertices();
+    auto indices = sphere_.buildGridIndices();
+
+    // Every chunk draws this grid, it's worth the same treatment as any other mesh
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertices.size());
+    vertices = MeshOptimizer::remapVertices(vertices, remap);
+
+    // A grid big enough to need 32-bit indices would be far too fine per chunk
+    std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+    indexCount_ = static_cast<GLsizei>(shortIndices.size());
+
+    glGenVertexArrays(1, &vertexArray_);
+    glGenBuffers(1, &vertexBuffer_);
+    glGenBuffers(1, &indexBuffer_);
+
+    glBindVertexArray(vertexArray_);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    glBufferData(
+            GL_ELEMENT_ARRAY_BUFFER,
+            static_cast<GLsizeiptr>(shortIndices.size() * sizeof(uint16_t)),
+            shortIndices.data(),
+            GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    glBufferData(
+            GL_ARRAY_BUFFER,
+            static_cast<GLsizeiptr>(vertices.size() * sizeof(vertices[0])),
+            vertices.data(),
+            GL_STATIC_DRAW);
+
+    // (s, t, skirt) as normalized shorts, the fourth short only pads the vertex to 8 bytes
+    glVertexAttribPointer(
+            kPositionAttribute,
+            3,
+            GL_UNSIGNED_SHORT,
+            GL_TRUE,
+            sizeof(vertices[0]),
+            nullptr);
+    glEnableVertexAttribArray(kPositionAttribute);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    aout << "GlobeMesh: " << sphere_.getGridSize() << "x" << sphere_.getGridSize()
+         << " chunk grid, " << vertices.size() << " vertices, " << indexCount_ / 3
+         << " triangles per chunk" << std::endl;
+}
+
+GlobeMesh::~GlobeMesh() {
+    glDeleteVertexArrays(1, &vertexArray_);
+    glDeleteBuffers(1, &vertexBuffer_);
+    glDeleteBuffers(1, &indexBuffer_);
+}
+
+void GlobeMesh::update(const TileView &view) {
+    sphere_.selectChunks(view, visibleChunks_);
+}
+
+void GlobeMesh::draw(GlStateCache &stateCache, GLint faceBasisUniform, GLint chunkUniform) const {
+    stateCache.bindTexture(0, GL_TEXTURE_2D, spTexture_->getTextureID());
+    stateCache.bindVertexArray(vertexArray_);
+
+    // Chunks are sorted by face, the basis only changes six times at most
+    int currentFace = -1;
+    for (const auto &chunk: visibleChunks_) {
+        if (chunk.face != currentFace) {
+            const auto &face = CubeSphere::getFace(chunk.face);
+            const float basis[9] = {
+                    face.u[0], face.u[1], face.u[2],
+                    face.v[0], face.v[1], face.v[2],
+                    face.center[0], face.center[1], face.center[2]};
+            glUniformMatrix3fv(faceBasisUniform, 1, GL_FALSE, basis);
+            currentFace = chunk.face;
+        }
+
+        auto size = 1.f / static_cast<float>(1 << chunk.level);
+        glUniform4f(
+                chunkUniform,
+                static_cast<float>(chunk.x) * size,
+                static_cast<float>(chunk.y) * size,
+                size,
+                sphere_.getSkirtDepth(chunk.level));
+        glDrawElements(GL_TRIANGLES, indexCount_, indexType_, nullptr);
+    }
+}
+
+void GlobeMesh::logStats() const {
+    int finestLevel = 0;
+    for (const auto &chunk: visibleChunks_) {
+        finestLevel = std::max(finestLevel, chunk.level);
+    }
+    aout << "GlobeMesh: " << visibleChunks_.size() << " chunks, "
+         << getVisibleTriangleCount() << " triangles, finest level " << finestLevel << std::endl;
+}
@@ -0,0 +1,89 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GLOBEMESH_H
+#define ANDROIDGLINVESTIGATIONS_GLOBEMESH_H
+
+#include <GLES3/gl3.h>
+#include <memory>
+#include <vector>
+
+#include "CubeSphere.h"
+#include "GlStateCache.h"
+#include "TextureAsset.h"
+
+/*!
+ * Draws the globe as the chunks of a @a CubeSphere. All chunks share a single grid in GPU buffers,
+ * the vertex shader places it with two uniforms per chunk:
+ *
+ *   uniform mat3 uFaceBasis; // columns u, v and center of the chunk's cube face
+ *   uniform vec4 uChunk;     // offset of the chunk in its face (x, y), its size, skirt depth
+ *
+ * The grid vertices are (s, t, skirt) at attribute location 0. Only the visible chunks are
+ * drawn, so the triangle count follows the view rather than the size of the planet. Must be
+ * created and destroyed with a current GL context.
+ */
+class GlobeMesh {
+public:
+    /*!
+     * Uploads the shared chunk grid.
+     *
+     * @param sphere the chunk layout, copied
+     * @param spTexture the texture to draw with
+     */
+    GlobeMesh(const CubeSphere &sphere, std::shared_ptr<TextureAsset> spTexture);
+
+    ~GlobeMesh();
+
+    GlobeMesh(const GlobeMesh &) = delete;
+    GlobeMesh &operator=(const GlobeMesh &) = delete;
+
+    inline const CubeSphere &getSphere() const { return sphere_; }
+
+    /*!
+     * Swaps the texture, e.g. to replace a placeholder once the real one finished loading
+     */
+    inline void setTexture(std::shared_ptr<TextureAsset> spTexture) {
+        spTexture_ = std::move(spTexture);
+    }
+
+    /*!
+     * Selects the chunks to draw from now on.
+     *
+     * @param view the camera in the globe's model space
+     */
+    void update(const TileView &view);
+
+    /*!
+     * Draws the chunks picked by the last @a update with the currently active program. The
+     * texture and vertex array are bound once, only the two uniforms change between chunks.
+     *
+     * @param faceBasisUniform location of the mat3 uFaceBasis
+     * @param chunkUniform location of the vec4 uChunk
+     */
+    void draw(GlStateCache &stateCache, GLint faceBasisUniform, GLint chunkUniform) const;
+
+    /*!
+     * @return how many chunks the last @a update selected
+     */
+    inline size_t getVisibleChunkCount() const { return visibleChunks_.size(); }
+
+    /*!
+     * @return how many triangles @a draw issues, skirts included
+     */
+    inline size_t getVisibleTriangleCount() const {
+        return visibleChunks_.size() * static_cast<size_t>(indexCount_ / 3);
+    }
+
+    void logStats() const;
+
+private:
+    CubeSphere sphere_;
+    std::shared_ptr<TextureAsset> spTexture_;
+    std::vector<ChunkId> visibleChunks_;
+
+    GLuint vertexBuffer_;
+    GLuint indexBuffer_;
+    GLuint vertexArray_;
+    GLsizei indexCount_;
+    GLenum indexType_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_GLOBEMESH_H
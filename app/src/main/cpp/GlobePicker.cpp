@@ -0,0 +1,77 @@
+#include "GlobePicker.h"
+
+#include <cmath>
+
+#include "GeoCoordinates.h"
+
+bool GlobePicker::intersectUnitSphere(
+        const Vec3 &origin,
+        const Vec3 &direction,
+        float &outDistance) {
+    // |origin + t * direction|^2 = 1, a quadratic in t with a = 1
+    auto b = dot(origin, direction);
+    auto c = dot(origin, origin) - 1.f;
+    auto discriminant = b * b - c;
+    if (discriminant < 0.f) {
+        return false;
+    }
+    auto root = std::sqrt(discriminant);
+    auto distance = -b - root;
+    if (distance < 0.f) {
+        distance = -b + root;
+    }
+    if (distance < 0.f) {
+        return false;
+    }
+    outDistance = distance;
+    return true;
+}
+
+GlobePicker::GlobePicker() : width_(0), height_(0), regions_(nullptr) {}
+
+void GlobePicker::setView(
+        const Mat4 &projection,
+        const Mat4 &view,
+        const Mat4 &model,
+        int width,
+        int height) {
+    inverseModelViewProjection_ = (projection * view * model).inverted();
+    width_ = width;
+    height_ = height;
+}
+
+bool GlobePicker::getRay(float x, float y, Vec3 &outOrigin, Vec3 &outDirection) const {
+    if (width_ <= 0 || height_ <= 0) {
+        return false;
+    }
+
+    // Screen y grows downwards, normalized device coordinates upwards
+    auto ndcX = x / static_cast<float>(width_) * 2.f - 1.f;
+    auto ndcY = 1.f - y / static_cast<float>(height_) * 2.f;
+    auto nearPoint = inverseModelViewProjection_.projectPoint({ndcX, ndcY, -1.f});
+    auto farPoint = inverseModelViewProjection_.projectPoint({ndcX, ndcY, 1.f});
+    auto direction = farPoint - nearPoint;
+    auto directionLength = length(direction);
+    if (!(directionLength > 0.f)) {
+        return false;
+    }
+    outOrigin = nearPoint;
+    outDirection = direction / directionLength;
+    return true;
+}
+
+bool GlobePicker::pick(float x, float y, GlobePick &outPick) const {
+    Vec3 origin;
+    Vec3 direction;
+    float distance;
+    if (!getRay(x, y, origin, direction) || !intersectUnitSphere(origin, direction, distance)) {
+        return false;
+    }
+    outPick.position = normalize(origin + direction * distance);
+    outPick.distance = distance;
+    latLonFromDirection(outPick.position, outPick.latitude, outPick.longitude);
+    outPick.region = regions_
+                     ? regions_->getRegion(outPick.latitude, outPick.longitude)
+                     : RegionRaster::kNoRegion;
+    return true;
+}
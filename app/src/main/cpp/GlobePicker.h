@@ -0,0 +1,86 @@
+#ifndef ANDROIDGLINVESTIGATIONS_GLOBEPICKER_H
+#define ANDROIDGLINVESTIGATIONS_GLOBEPICKER_H
+
+#include <cstdint>
+
+#include "RegionRaster.h"
+#include "VectorMath.h"
+
+/*!
+ * What's under a point of the screen, see @a GlobePicker::pick.
+ */
+struct GlobePick {
+    //! where the ray hits the globe, on the unit sphere of its model space
+    Vec3 position{0.f, 0.f, 0.f};
+
+    //! degrees north and east, see @a latLonFromDirection
+    float latitude = 0.f;
+    float longitude = 0.f;
+
+    //! from the near plane to the hit along the ray, in model space units
+    float distance = 0.f;
+
+    //! the region there, @a RegionRaster::kNoRegion without regions
+    uint16_t region = RegionRaster::kNoRegion;
+};
+
+/*!
+ * Finds the place on the globe under a point of the screen: the point is unprojected into a ray
+ * through the globe's model space, which is intersected with the unit sphere analytically and the
+ * hit looked up in a @a RegionRaster. Nothing is read back from the GPU and the cost is the same
+ * for any number of regions.
+ *
+ * Pure math, no GL. Give it the matrices the globe is drawn with whenever they change.
+ */
+class GlobePicker {
+public:
+    /*!
+     * Intersects a ray with the unit sphere around the origin.
+     *
+     * @param direction normalized
+     * @param outDistance receives how far along the ray the sphere is first hit. From inside the
+     *     sphere that's where the ray leaves it.
+     * @return false if the ray misses the sphere, or it's behind the origin
+     */
+    static bool intersectUnitSphere(const Vec3 &origin, const Vec3 &direction,
+                                    float &outDistance);
+
+    GlobePicker();
+
+    /*!
+     * @param projection, view, model the matrices the globe is drawn with
+     * @param width, height the viewport in pixels
+     */
+    void setView(const Mat4 &projection, const Mat4 &view, const Mat4 &model,
+                 int width, int height);
+
+    /*!
+     * @param regions looked up for every hit, not owned. Null to skip the lookup.
+     */
+    inline void setRegions(const RegionRaster *regions) { regions_ = regions; }
+
+    /*!
+     * The ray through a point of the screen into the globe's model space.
+     *
+     * @param x, y in pixels from the top left corner, like touch events
+     * @param outOrigin receives the point on the near plane
+     * @param outDirection receives the normalized direction away from the camera
+     * @return false before @a setView
+     */
+    bool getRay(float x, float y, Vec3 &outOrigin, Vec3 &outDirection) const;
+
+    /*!
+     * @param x, y in pixels from the top left corner, like touch events
+     * @return false if the point isn't on the globe
+     */
+    bool pick(float x, float y, GlobePick &outPick) const;
+
+private:
+    //! from normalized device coordinates to the globe's model space
+    Mat4 inverseModelViewProjection_;
+    int width_;
+    int height_;
+    const RegionRaster *regions_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_GLOBEPICKER_H
@@ -0,0 +1,39 @@
+#include "ImageData.h"
+
+#include <algorithm>
+
+ImageData ImageData::downsample() const {
+    ImageData result;
+    result.width = std::max(width / 2, 1);
+    result.height = std::max(height / 2, 1);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+    auto texel = [this](int x, int y, int channel) {
+        x = std::min(x, width - 1);
+        y = std::min(y, height - 1);
+        return static_cast<unsigned>(pixels[(static_cast<size_t>(y) * width + x) * 4 + channel]);
+    };
+
+    for (int y = 0; y < result.height; ++y) {
+        for (int x = 0; x < result.width; ++x) {
+            auto *out = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+            for (int channel = 0; channel < 4; ++channel) {
+                auto sum = texel(2 * x, 2 * y, channel)
+                           + texel(2 * x + 1, 2 * y, channel)
+                           + texel(2 * x, 2 * y + 1, channel)
+                           + texel(2 * x + 1, 2 * y + 1, channel);
+                out[channel] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<ImageData> ImageData::buildMipChain() const {
+    std::vector<ImageData> levels;
+    levels.push_back(*this);
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        levels.push_back(levels.back().downsample());
+    }
+    return levels;
+}
@@ -0,0 +1,28 @@
+#ifndef ANDROIDGLINVESTIGATIONS_IMAGEDATA_H
+#define ANDROIDGLINVESTIGATIONS_IMAGEDATA_H
+
+#include <cstdint>
+#include <vector>
+
+/*!
+ * Decoded RGBA 8888 pixels, tightly packed. Has no Android or GL dependencies so host tools can
+ * share it.
+ */
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    /*!
+     * @return this image halved with a 2x2 box filter, the next level of a mip chain. Odd
+     * dimensions repeat their last row or column.
+     */
+    ImageData downsample() const;
+
+    /*!
+     * @return this image followed by every smaller mip level down to 1x1
+     */
+    std::vector<ImageData> buildMipChain() const;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_IMAGEDATA_H
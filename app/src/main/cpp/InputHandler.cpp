@@ -0,0 +1,122 @@
+#include "InputHandler.h"
+
+#include <game-activity/native_app_glue/android_native_app_glue.h>
+#include <android/keycodes.h>
+
+#include "RenderThread.h"
+
+namespace {
+
+/*!
+ * Builds the touch sample of @a motionEvent at @a historyPos, or of its current position when
+ * @a historyPos is -1. The pointer that went up or down always comes first, then the others up to
+ * kMaxGesturePointers.
+ */
+TouchEvent makeTouchEvent(
+        const GameActivityMotionEvent &motionEvent,
+        TouchEvent::Action action,
+        int32_t actionPointerIndex,
+        int historyPos) {
+    TouchEvent event;
+    event.action = action;
+
+    // GameActivity reports times in nanoseconds of the same monotonic clock as the choreographer
+    event.timeNanos = historyPos >= 0 && motionEvent.historicalEventTimesNanos
+                      ? motionEvent.historicalEventTimesNanos[historyPos]
+                      : motionEvent.eventTime;
+
+    auto addPointer = [&](int32_t index) {
+        auto &pointer = event.pointers[event.pointerCount++];
+        pointer.id = motionEvent.pointers[index].id;
+        if (historyPos >= 0) {
+            pointer.x = GameActivityMotionEvent_getHistoricalX(&motionEvent, index, historyPos);
+            pointer.y = GameActivityMotionEvent_getHistoricalY(&motionEvent, index, historyPos);
+        } else {
+            pointer.x = GameActivityPointerAxes_getX(&motionEvent.pointers[index]);
+            pointer.y = GameActivityPointerAxes_getY(&motionEvent.pointers[index]);
+        }
+    };
+
+    if (actionPointerIndex >= 0) {
+        event.actionPointerId = motionEvent.pointers[actionPointerIndex].id;
+        addPointer(actionPointerIndex);
+    }
+    auto pointerCount = static_cast<int32_t>(motionEvent.pointerCount);
+    for (int32_t index = 0; index < pointerCount; ++index) {
+        if (event.pointerCount == kMaxGesturePointers) {
+            break;
+        }
+        if (index != actionPointerIndex) {
+            addPointer(index);
+        }
+    }
+    return event;
+}
+
+} // namespace
+
+void InputHandler::handleInput(android_app *pApp, RenderThread &renderThread) {
+    // handle all queued inputs
+    auto *inputBuffer = android_app_swap_input_buffers(pApp);
+    if (!inputBuffer) {
+        // no inputs yet.
+        return;
+    }
+
+    // handle motion events (motionEventsCounts can be 0).
+    for (auto i = 0; i < inputBuffer->motionEventsCount; i++) {
+        auto &motionEvent = inputBuffer->motionEvents[i];
+        auto action = motionEvent.action;
+        int32_t pointerIndex = (action & AMOTION_EVENT_ACTION_POINTER_INDEX_MASK)
+                >> AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT;
+
+        switch (action & AMOTION_EVENT_ACTION_MASK) {
+            case AMOTION_EVENT_ACTION_DOWN:
+            case AMOTION_EVENT_ACTION_POINTER_DOWN:
+                renderThread.addTouchEvent(
+                        makeTouchEvent(motionEvent, TouchEvent::Action::Down, pointerIndex, -1));
+                break;
+            case AMOTION_EVENT_ACTION_UP:
+            case AMOTION_EVENT_ACTION_POINTER_UP:
+                renderThread.addTouchEvent(
+                        makeTouchEvent(motionEvent, TouchEvent::Action::Up, pointerIndex, -1));
+                break;
+            case AMOTION_EVENT_ACTION_CANCEL:
+                renderThread.addTouchEvent(
+                        makeTouchEvent(motionEvent, TouchEvent::Action::Cancel, -1, -1));
+                break;
+            case AMOTION_EVENT_ACTION_MOVE:
+                // The touch screen samples faster than events are delivered, the samples in
+                // between come as history, oldest first. Each one feeds the velocity estimate.
+                for (int historyPos = 0; historyPos < motionEvent.historySize; ++historyPos) {
+                    renderThread.addTouchEvent(
+                            makeTouchEvent(
+                                    motionEvent, TouchEvent::Action::Move, -1, historyPos));
+                }
+                renderThread.addTouchEvent(
+                        makeTouchEvent(motionEvent, TouchEvent::Action::Move, -1, -1));
+                break;
+            default:
+                break;
+        }
+    }
+    // clear the motion input count in this buffer for main thread to re-use.
+    android_app_clear_motion_events(inputBuffer);
+
+    // handle input key events.
+    for (auto i = 0; i < inputBuffer->keyEventsCount; i++) {
+        auto &keyEvent = inputBuffer->keyEvents[i];
+        if (keyEvent.action == AKEY_EVENT_ACTION_DOWN && keyEvent.keyCode == AKEYCODE_BACK) {
+            pApp->destroyRequested = 1;
+        }
+
+        // M cycles the globe's render paths, also reachable with `adb shell input keyevent M`
+        if (keyEvent.action == AKEY_EVENT_ACTION_DOWN && keyEvent.keyCode == AKEYCODE_M) {
+            renderThread.cycleGlobeMode();
+        }
+    }
+    // clear the key input count too.
+    android_app_clear_key_events(inputBuffer);
+
+    renderThread.flushInput();
+}
@@ -0,0 +1,26 @@
+#ifndef ANDROIDGLINVESTIGATIONS_INPUTHANDLER_H
+#define ANDROIDGLINVESTIGATIONS_INPUTHANDLER_H
+
+struct android_app;
+class RenderThread;
+
+/*!
+ * Drains the android_app input buffers on the android_app thread and turns them into commands for
+ * the @a RenderThread. Motion events are split into one timestamped @a TouchEvent per sample,
+ * historical ones included, the gestures are recognized on the render thread.
+ */
+class InputHandler {
+public:
+
+    /*!
+     * Handles input from the android_app.
+     *
+     * Note: this will clear the input queue
+     *
+     * @param pApp the app to read input from
+     * @param renderThread receives every touch sample in the queue
+     */
+    void handleInput(android_app *pApp, RenderThread &renderThread);
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_INPUTHANDLER_H
@@ -0,0 +1,280 @@
+#include "Ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kIdentifier[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+//! identifier, nine header words, the index of the DFD, KVD and SGD sections
+constexpr size_t kHeaderSize = 80;
+
+//! each level index entry holds byteOffset, byteLength and uncompressedByteLength
+constexpr size_t kLevelIndexEntrySize = 24;
+
+// Data format descriptor values from the Khronos Data Format specification
+constexpr uint8_t kDfModelEtc2 = 161;
+constexpr uint8_t kDfModelAstc = 162;
+constexpr uint8_t kDfPrimariesBt709 = 1;
+constexpr uint8_t kDfTransferLinear = 1;
+constexpr uint8_t kDfTransferSrgb = 2;
+constexpr uint8_t kDfChannelEtc2Color = 2;
+constexpr uint8_t kDfChannelEtc2Alpha = 15;
+constexpr uint8_t kDfChannelAstcData = 0;
+
+uint32_t readU32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t readU64(const uint8_t *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void appendU32(std::vector<uint8_t> &out, uint32_t value) {
+    uint8_t bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+void appendU64(std::vector<uint8_t> &out, uint64_t value) {
+    uint8_t bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+void appendBytes(std::vector<uint8_t> &out, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    out.push_back(a);
+    out.push_back(b);
+    out.push_back(c);
+    out.push_back(d);
+}
+
+bool isSrgb(Ktx2Format format) {
+    switch (format) {
+        case Ktx2Format::Etc2Rgb8Srgb:
+        case Ktx2Format::Etc2Rgba8Srgb:
+        case Ktx2Format::Astc4x4Srgb:
+        case Ktx2Format::Astc6x6Srgb:
+        case Ktx2Format::Astc8x8Srgb:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*!
+ * Builds the basic data format descriptor KTX2 requires, prefixed with its total size.
+ */
+std::vector<uint8_t> buildDataFormatDescriptor(Ktx2Format format) {
+    struct Sample {
+        uint16_t bitOffset;
+        uint8_t bitLength;
+        uint8_t channel;
+    };
+
+    auto block = Ktx2::getBlockInfo(format);
+    bool isEtc2 = format >= Ktx2Format::Etc2Rgb8Unorm && format <= Ktx2Format::Etc2Rgba8Srgb;
+    bool hasEtc2Alpha = format == Ktx2Format::Etc2Rgba8Unorm
+                        || format == Ktx2Format::Etc2Rgba8Srgb;
+
+    // Bit lengths are stored minus one
+    std::vector<Sample> samples;
+    if (!isEtc2) {
+        samples.push_back({0, 127, kDfChannelAstcData});
+    } else if (hasEtc2Alpha) {
+        samples.push_back({0, 63, kDfChannelEtc2Alpha});
+        samples.push_back({64, 63, kDfChannelEtc2Color});
+    } else {
+        samples.push_back({0, 63, kDfChannelEtc2Color});
+    }
+
+    auto blockSize = static_cast<uint32_t>(24 + 16 * samples.size());
+
+    std::vector<uint8_t> dfd;
+    appendU32(dfd, blockSize + 4);
+
+    // vendor id and descriptor type 0 (Khronos basic), version 2
+    appendU32(dfd, 0);
+    appendU32(dfd, 2u | (blockSize << 16));
+    appendBytes(
+            dfd,
+            isEtc2 ? kDfModelEtc2 : kDfModelAstc,
+            kDfPrimariesBt709,
+            isSrgb(format) ? kDfTransferSrgb : kDfTransferLinear,
+            0);
+    appendBytes(
+            dfd,
+            static_cast<uint8_t>(block.blockWidth - 1),
+            static_cast<uint8_t>(block.blockHeight - 1),
+            0,
+            0);
+    appendBytes(dfd, static_cast<uint8_t>(block.bytesPerBlock), 0, 0, 0);
+    appendBytes(dfd, 0, 0, 0, 0);
+
+    for (auto &sample: samples) {
+        appendU32(
+                dfd,
+                sample.bitOffset
+                | (static_cast<uint32_t>(sample.bitLength) << 16)
+                | (static_cast<uint32_t>(sample.channel) << 24));
+        appendU32(dfd, 0);
+        appendU32(dfd, 0);
+        appendU32(dfd, 0xFFFFFFFFu);
+    }
+    return dfd;
+}
+
+} // namespace
+
+Ktx2BlockInfo Ktx2::getBlockInfo(Ktx2Format format) {
+    switch (format) {
+        case Ktx2Format::Etc2Rgb8Unorm:
+        case Ktx2Format::Etc2Rgb8Srgb:
+            return {4, 4, 8};
+        case Ktx2Format::Etc2Rgba8Unorm:
+        case Ktx2Format::Etc2Rgba8Srgb:
+        case Ktx2Format::Astc4x4Unorm:
+        case Ktx2Format::Astc4x4Srgb:
+            return {4, 4, 16};
+        case Ktx2Format::Astc6x6Unorm:
+        case Ktx2Format::Astc6x6Srgb:
+            return {6, 6, 16};
+        case Ktx2Format::Astc8x8Unorm:
+        case Ktx2Format::Astc8x8Srgb:
+            return {8, 8, 16};
+        default:
+            return {};
+    }
+}
+
+size_t Ktx2::getLevelSize(Ktx2Format format, int width, int height) {
+    auto block = getBlockInfo(format);
+    if (block.bytesPerBlock == 0) {
+        return 0;
+    }
+    auto blocksX = static_cast<size_t>((width + block.blockWidth - 1) / block.blockWidth);
+    auto blocksY = static_cast<size_t>((height + block.blockHeight - 1) / block.blockHeight);
+    return blocksX * blocksY * block.bytesPerBlock;
+}
+
+bool Ktx2::parse(const uint8_t *data, size_t size, Ktx2Image &outImage) {
+    if (size < kHeaderSize || memcmp(data, kIdentifier, sizeof(kIdentifier)) != 0) {
+        return false;
+    }
+
+    auto format = static_cast<Ktx2Format>(readU32(data + 12));
+    auto typeSize = readU32(data + 16);
+    auto width = readU32(data + 20);
+    auto height = readU32(data + 24);
+    auto depth = readU32(data + 28);
+    auto layerCount = readU32(data + 32);
+    auto faceCount = readU32(data + 36);
+    auto levelCount = std::max<uint32_t>(readU32(data + 40), 1);
+    auto supercompression = readU32(data + 44);
+
+    // Only plain 2D block compressed textures, anything else would need a different upload path
+    if (getBlockInfo(format).bytesPerBlock == 0
+        || typeSize != 1
+        || width == 0 || height == 0 || width > 0x8000 || height > 0x8000
+        || depth != 0 || layerCount > 1 || faceCount != 1
+        || supercompression != 0
+        || levelCount > 16) {
+        return false;
+    }
+
+    if (size < kHeaderSize + levelCount * kLevelIndexEntrySize) {
+        return false;
+    }
+
+    outImage.format = format;
+    outImage.width = static_cast<int>(width);
+    outImage.height = static_cast<int>(height);
+    outImage.levels.clear();
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const auto *entry = data + kHeaderSize + level * kLevelIndexEntrySize;
+        Ktx2Level info;
+        info.width = std::max(outImage.width >> level, 1);
+        info.height = std::max(outImage.height >> level, 1);
+
+        auto offset = readU64(entry);
+        auto length = readU64(entry + 8);
+        if (offset > size || length > size - offset
+            || length < getLevelSize(format, info.width, info.height)) {
+            return false;
+        }
+        info.offset = static_cast<size_t>(offset);
+        info.length = getLevelSize(format, info.width, info.height);
+        outImage.levels.push_back(info);
+
+        if (info.width == 1 && info.height == 1) {
+            break;
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> Ktx2::write(
+        Ktx2Format format,
+        int width,
+        int height,
+        const std::vector<std::vector<uint8_t>> &levels) {
+    auto block = getBlockInfo(format);
+    auto levelCount = static_cast<uint32_t>(levels.size());
+    auto dfd = buildDataFormatDescriptor(format);
+
+    auto dfdOffset = static_cast<uint32_t>(kHeaderSize + levelCount * kLevelIndexEntrySize);
+
+    // Level data must be aligned to lcm(block size, 4), and the spec stores the smallest level
+    // first so a streaming reader gets something to show early.
+    auto alignment = static_cast<size_t>(block.bytesPerBlock);
+    auto align = [alignment](size_t offset) {
+        return (offset + alignment - 1) / alignment * alignment;
+    };
+
+    std::vector<size_t> offsets(levelCount);
+    size_t offset = dfdOffset + dfd.size();
+    for (auto level = levelCount; level-- > 0;) {
+        offset = align(offset);
+        offsets[level] = offset;
+        offset += levels[level].size();
+    }
+
+    std::vector<uint8_t> file(kIdentifier, kIdentifier + sizeof(kIdentifier));
+    appendU32(file, static_cast<uint32_t>(format));
+    appendU32(file, 1); // typeSize is 1 for block compressed formats
+    appendU32(file, static_cast<uint32_t>(width));
+    appendU32(file, static_cast<uint32_t>(height));
+    appendU32(file, 0); // pixelDepth
+    appendU32(file, 0); // layerCount
+    appendU32(file, 1); // faceCount
+    appendU32(file, levelCount);
+    appendU32(file, 0); // no supercompression
+
+    appendU32(file, dfdOffset);
+    appendU32(file, static_cast<uint32_t>(dfd.size()));
+    appendU32(file, 0); // no key/value data
+    appendU32(file, 0);
+    appendU64(file, 0); // no supercompression global data
+    appendU64(file, 0);
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        appendU64(file, offsets[level]);
+        appendU64(file, levels[level].size());
+        appendU64(file, levels[level].size());
+    }
+
+    file.insert(file.end(), dfd.begin(), dfd.end());
+
+    for (auto level = levelCount; level-- > 0;) {
+        file.resize(offsets[level], 0);
+        file.insert(file.end(), levels[level].begin(), levels[level].end());
+    }
+    return file;
+}
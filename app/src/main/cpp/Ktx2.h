@@ -0,0 +1,95 @@
+#ifndef ANDROIDGLINVESTIGATIONS_KTX2_H
+#define ANDROIDGLINVESTIGATIONS_KTX2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ * The Vulkan formats we read and write in KTX2 files. KTX2 identifies formats by their VkFormat
+ * value even for GL content.
+ */
+enum class Ktx2Format : uint32_t {
+    Undefined = 0,
+    Etc2Rgb8Unorm = 147,
+    Etc2Rgb8Srgb = 148,
+    Etc2Rgba8Unorm = 151,
+    Etc2Rgba8Srgb = 152,
+    Astc4x4Unorm = 157,
+    Astc4x4Srgb = 158,
+    Astc6x6Unorm = 165,
+    Astc6x6Srgb = 166,
+    Astc8x8Unorm = 171,
+    Astc8x8Srgb = 172,
+};
+
+/*!
+ * Block size of a compressed format, in texels and bytes.
+ */
+struct Ktx2BlockInfo {
+    int blockWidth = 0;
+    int blockHeight = 0;
+    int bytesPerBlock = 0;
+};
+
+/*!
+ * One mip level of a KTX2 file, as a byte range into the file.
+ */
+struct Ktx2Level {
+    int width = 0;
+    int height = 0;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+/*!
+ * The parts of a KTX2 header we use.
+ */
+struct Ktx2Image {
+    Ktx2Format format = Ktx2Format::Undefined;
+    int width = 0;
+    int height = 0;
+
+    //! level 0 (full size) first
+    std::vector<Ktx2Level> levels;
+};
+
+/*!
+ * Reads and writes the subset of KTX 2.0 used for our textures: a single 2D image with block
+ * compressed ETC2 or ASTC data, no supercompression and a full or partial mip chain. Has no
+ * Android or GL dependencies so the host converter shares it.
+ */
+class Ktx2 {
+public:
+    /*!
+     * @return the block size of @a format, or all zeroes if it isn't one we support
+     */
+    static Ktx2BlockInfo getBlockInfo(Ktx2Format format);
+
+    /*!
+     * @return the number of bytes one mip level of @a width x @a height takes in @a format
+     */
+    static size_t getLevelSize(Ktx2Format format, int width, int height);
+
+    /*!
+     * Parses and validates a KTX2 file held in memory. The levels refer to @a data, nothing is
+     * copied.
+     *
+     * @return false if the file is malformed or uses a feature we don't support
+     */
+    static bool parse(const uint8_t *data, size_t size, Ktx2Image &outImage);
+
+    /*!
+     * Serializes compressed mip levels into a KTX2 file.
+     *
+     * @param levels the compressed data of each level, level 0 (full size) first
+     * @return the file contents
+     */
+    static std::vector<uint8_t> write(
+            Ktx2Format format,
+            int width,
+            int height,
+            const std::vector<std::vector<uint8_t>> &levels);
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_KTX2_H
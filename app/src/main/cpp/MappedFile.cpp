@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+
+#ifdef __ANDROID__
+#include <android/asset_manager.h>
+#endif
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string &path) {
+    auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        close(descriptor);
+        return nullptr;
+    }
+
+    auto size = static_cast<size_t>(status.st_size);
+    auto *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps the file alive on its own
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->data_ = static_cast<const uint8_t *>(mapping);
+    file->size_ = size;
+    file->mapping_ = mapping;
+    return file;
+}
+
+#ifdef __ANDROID__
+std::unique_ptr<MappedFile> MappedFile::openAsset(
+        AAssetManager *assetManager,
+        const std::string &assetPath) {
+    auto pAsset = AAssetManager_open(assetManager, assetPath.c_str(), AASSET_MODE_BUFFER);
+    if (!pAsset) {
+        return nullptr;
+    }
+    auto *buffer = static_cast<const uint8_t *>(AAsset_getBuffer(pAsset));
+    auto size = static_cast<size_t>(AAsset_getLength64(pAsset));
+    if (!buffer || size == 0) {
+        AAsset_close(pAsset);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->size_ = size;
+    if (reinterpret_cast<uintptr_t>(buffer) % sizeof(uint32_t) == 0) {
+        file->data_ = buffer;
+        file->asset_ = pAsset;
+    } else {
+        // zipalign only aligns uncompressed assets, anything else is copied once
+        file->copy_.resize((size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+        memcpy(file->copy_.data(), buffer, size);
+        file->data_ = reinterpret_cast<const uint8_t *>(file->copy_.data());
+        AAsset_close(pAsset);
+    }
+    return file;
+}
+#endif
+
+MappedFile::MappedFile() :
+        data_(nullptr),
+        size_(0),
+        mapping_(nullptr),
+        asset_(nullptr) {}
+
+MappedFile::~MappedFile() {
+    if (mapping_) {
+        munmap(mapping_, size_);
+    }
+#ifdef __ANDROID__
+    if (asset_) {
+        AAsset_close(asset_);
+    }
+#endif
+}
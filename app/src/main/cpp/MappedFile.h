@@ -0,0 +1,64 @@
+#ifndef ANDROIDGLINVESTIGATIONS_MAPPEDFILE_H
+#define ANDROIDGLINVESTIGATIONS_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct AAsset;
+struct AAssetManager;
+
+/*!
+ * A read-only file in memory without reading it up front: a private mapping of a file on disk,
+ * or on Android the buffer of an asset, which the asset manager maps straight from the APK if the
+ * asset is stored uncompressed. Pages are read when they're first touched and can be dropped
+ * again under memory pressure, so large datasets don't count against the heap.
+ */
+class MappedFile {
+public:
+    /*!
+     * Maps a file from the file system, e.g. a dataset downloaded into the cache directory.
+     *
+     * @return the mapping, or null if the file can't be opened or is empty
+     */
+    static std::unique_ptr<MappedFile> open(const std::string &path);
+
+#ifdef __ANDROID__
+    /*!
+     * Opens an asset from the assets/ directory. A compressed asset is inflated into memory by
+     * the asset manager instead, keep large ones uncompressed in the build.
+     *
+     * @return the asset's contents, or null if it doesn't exist
+     */
+    static std::unique_ptr<MappedFile> openAsset(
+            AAssetManager *assetManager,
+            const std::string &assetPath);
+#endif
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    //! @return the contents, at least 4 byte aligned
+    inline const uint8_t *getData() const { return data_; }
+
+    inline size_t getSize() const { return size_; }
+
+private:
+    MappedFile();
+
+    const uint8_t *data_;
+    size_t size_;
+
+    //! what to release, a mapping from open or an asset from openAsset
+    void *mapping_;
+    AAsset *asset_;
+
+    //! a copy of an asset buffer that wasn't aligned
+    std::vector<uint32_t> copy_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_MAPPEDFILE_H
@@ -0,0 +1,207 @@
+#include "MarkerLayer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "AndroidOut.h"
+#include "ProgramCache.h"
+#include "ShaderSources.h"
+#include "UniformBuffer.h"
+
+namespace {
+
+//! texels along each edge of an atlas layer
+constexpr int kAtlasCellSize = 64;
+
+//! the symbol's extent from the centre of its cell, in texels
+constexpr float kSymbolRadius = 28.f;
+
+//! width of the dark outline, in texels. About a pixel on a 16 pixel marker.
+constexpr float kOutlineWidth = 4.f;
+
+//! the buffer grows to at least this many instances, then doubles
+constexpr size_t kMinCapacity = 4096;
+
+/*!
+ * Signed distance in texels from (x, y), relative to the cell's centre, to the edge of the atlas
+ * symbol @a index. Negative inside.
+ */
+float getSymbolDistance(int index, float x, float y) {
+    auto radius = std::sqrt(x * x + y * y);
+    switch (index) {
+        case 0:
+            // Disc
+            return radius - kSymbolRadius;
+        case 1:
+            // Ring, hollow in the middle
+            return std::fabs(radius - kSymbolRadius * 0.7f) - kSymbolRadius * 0.3f;
+        case 2:
+            // Square
+            return std::max(std::fabs(x), std::fabs(y)) - kSymbolRadius * 0.8f;
+        default:
+            // Diamond
+            return (std::fabs(x) + std::fabs(y) - kSymbolRadius) * 0.70710678f;
+    }
+}
+
+/*!
+ * The atlas as RG8 layers, r is the symbol's coverage and g the coverage of its inside.
+ */
+std::vector<uint8_t> buildAtlas() {
+    std::vector<uint8_t> texels(
+            static_cast<size_t>(kAtlasCellSize) * kAtlasCellSize * kMarkerAtlasSize * 2);
+    auto *out = texels.data();
+    auto center = static_cast<float>(kAtlasCellSize) * 0.5f;
+    for (int layer = 0; layer < kMarkerAtlasSize; ++layer) {
+        for (int y = 0; y < kAtlasCellSize; ++y) {
+            for (int x = 0; x < kAtlasCellSize; ++x) {
+                auto distance = getSymbolDistance(
+                        layer,
+                        static_cast<float>(x) + 0.5f - center,
+                        static_cast<float>(y) + 0.5f - center);
+                auto outside = std::clamp(0.5f - distance, 0.f, 1.f);
+                auto inside = std::clamp(0.5f - distance - kOutlineWidth, 0.f, 1.f);
+                *out++ = static_cast<uint8_t>(std::lround(outside * 255.f));
+                *out++ = static_cast<uint8_t>(std::lround(inside * 255.f));
+            }
+        }
+    }
+    return texels;
+}
+
+} // namespace
+
+MarkerLayer::MarkerLayer(GlStateCache &stateCache, ProgramCache *programCache) :
+        atlasTexture_(0),
+        instanceBuffer_(0),
+        vertexArray_(0),
+        capacity_(0),
+        instanceCount_(0),
+        uploadCount_(0),
+        uploadedBytes_(0) {
+    auto sources = assembleMarkerShader();
+    shader_ = std::unique_ptr<Shader>(Shader::loadShader(
+            sources.vertex,
+            sources.fragment,
+            "inDirection",
+            "inSize",
+            "uAtlas",
+            programCache));
+    assert(shader_);
+
+    // Created on the upload unit like any other texture, drawing binds it through the cache
+    auto atlas = buildAtlas();
+    stateCache.selectUploadUnit();
+    glGenTextures(1, &atlasTexture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, atlasTexture_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            GL_RG8,
+            kAtlasCellSize,
+            kAtlasCellSize,
+            kMarkerAtlasSize,
+            0,
+            GL_RG,
+            GL_UNSIGNED_BYTE,
+            atlas.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glGenBuffers(1, &instanceBuffer_);
+    glGenVertexArrays(1, &vertexArray_);
+    stateCache.bindVertexArray(vertexArray_);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+
+    // Every attribute advances once per instance, the quad's corners come from gl_VertexID
+    auto stride = static_cast<GLsizei>(sizeof(MarkerInstance));
+    glVertexAttribPointer(
+            0, 3, GL_SHORT, GL_TRUE, stride,
+            reinterpret_cast<const void *>(offsetof(MarkerInstance, direction)));
+    glVertexAttribPointer(
+            1, 1, GL_UNSIGNED_SHORT, GL_FALSE, stride,
+            reinterpret_cast<const void *>(offsetof(MarkerInstance, size)));
+    glVertexAttribPointer(
+            2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+            reinterpret_cast<const void *>(offsetof(MarkerInstance, color)));
+    glVertexAttribIPointer(
+            3, 2, GL_UNSIGNED_BYTE, stride,
+            reinterpret_cast<const void *>(offsetof(MarkerInstance, atlasIndex)));
+    for (GLuint attribute = 0; attribute < 4; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    stateCache.bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+MarkerLayer::~MarkerLayer() {
+    glDeleteVertexArrays(1, &vertexArray_);
+    glDeleteBuffers(1, &instanceBuffer_);
+    glDeleteTextures(1, &atlasTexture_);
+}
+
+void MarkerLayer::upload(MarkerSet &markers) {
+    const auto &instances = markers.getInstances();
+    instanceCount_ = instances.size();
+    if (instances.size() <= capacity_ && !markers.hasChanges()) {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+
+    if (instances.size() > capacity_) {
+        // Room to grow, so adding markers one by one doesn't reallocate every frame
+        capacity_ = std::max({instances.size(), capacity_ * 2, kMinCapacity});
+        glBufferData(
+                GL_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(capacity_ * sizeof(MarkerInstance)),
+                nullptr,
+                GL_DYNAMIC_DRAW);
+        markers.consumeChanges([](size_t, size_t) {});
+        glBufferSubData(
+                GL_ARRAY_BUFFER,
+                0,
+                static_cast<GLsizeiptr>(instances.size() * sizeof(MarkerInstance)),
+                instances.data());
+        uploadCount_++;
+        uploadedBytes_ += instances.size() * sizeof(MarkerInstance);
+    } else {
+        markers.consumeChanges([this, &instances](size_t first, size_t count) {
+            glBufferSubData(
+                    GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(first * sizeof(MarkerInstance)),
+                    static_cast<GLsizeiptr>(count * sizeof(MarkerInstance)),
+                    &instances[first]);
+            uploadCount_++;
+            uploadedBytes_ += count * sizeof(MarkerInstance);
+        });
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MarkerLayer::draw(GlStateCache &stateCache) const {
+    if (instanceCount_ == 0) {
+        return;
+    }
+    shader_->activate(stateCache);
+    stateCache.bindTexture(0, GL_TEXTURE_2D_ARRAY, atlasTexture_);
+    stateCache.bindVertexArray(vertexArray_);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instanceCount_));
+}
+
+void MarkerLayer::logStats(const MarkerSet &markers, const Vec3 &cameraPosition) const {
+    aout << "MarkerLayer: " << markers.size() << " markers, "
+         << markers.countVisible(cameraPosition) << " in front of the horizon, "
+         << uploadCount_ << " uploads of " << uploadedBytes_ / 1024 << " KiB in total"
+         << std::endl;
+}
@@ -0,0 +1,74 @@
+#ifndef ANDROIDGLINVESTIGATIONS_MARKERLAYER_H
+#define ANDROIDGLINVESTIGATIONS_MARKERLAYER_H
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <memory>
+
+#include "GlStateCache.h"
+#include "MarkerSet.h"
+#include "Shader.h"
+
+class ProgramCache;
+
+/*!
+ * Draws the markers of a @a MarkerSet as screen aligned billboards, all of them in one instanced
+ * draw. Each marker is one 16 byte instance, the four corners of its quad come from gl_VertexID.
+ * The vertex shader drops markers behind the globe's horizon with the same test as
+ * @a MarkerSet::isVisible, so the globe never has to be depth tested against billboards that
+ * would poke through it from the far side.
+ *
+ * The symbols come from a small texture array built at startup, one layer per atlas index,
+ * tinted with the marker's colour. Must be created and destroyed with a current GL context.
+ */
+class MarkerLayer {
+public:
+    /*!
+     * Compiles the marker program and creates the atlas, the vertex array and an empty instance
+     * buffer.
+     *
+     * @param programCache if not null, the program is restored from it when possible
+     */
+    MarkerLayer(GlStateCache &stateCache, ProgramCache *programCache);
+
+    ~MarkerLayer();
+
+    MarkerLayer(const MarkerLayer &) = delete;
+    MarkerLayer &operator=(const MarkerLayer &) = delete;
+
+    /*!
+     * Brings the instance buffer up to date with @a markers. Only the changed pages are uploaded,
+     * unless the buffer has to grow, then everything is.
+     */
+    void upload(MarkerSet &markers);
+
+    /*!
+     * Draws every uploaded marker with the layer's own program. Expects the blend state of
+     * @a RenderPass::Transparent.
+     */
+    void draw(GlStateCache &stateCache) const;
+
+    inline GLuint getProgram() const { return shader_->getProgram(); }
+
+    inline GLuint getAtlasTexture() const { return atlasTexture_; }
+
+    /*!
+     * @param cameraPosition the eye in the globe's model space, to count the visible markers
+     */
+    void logStats(const MarkerSet &markers, const Vec3 &cameraPosition) const;
+
+private:
+    std::unique_ptr<Shader> shader_;
+    GLuint atlasTexture_;
+    GLuint instanceBuffer_;
+    GLuint vertexArray_;
+
+    //! instances the buffer has room for, and how many of them are drawn
+    size_t capacity_;
+    size_t instanceCount_;
+
+    uint64_t uploadCount_;
+    uint64_t uploadedBytes_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_MARKERLAYER_H
@@ -0,0 +1,101 @@
+#include "MarkerSet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "GeoCoordinates.h"
+
+namespace {
+
+int16_t toSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+} // namespace
+
+MarkerInstance MarkerSet::pack(const Marker &marker) {
+    auto direction = directionFromLatLon(marker.latitude, marker.longitude);
+
+    MarkerInstance instance{};
+    instance.direction[0] = toSnorm16(direction.x);
+    instance.direction[1] = toSnorm16(direction.y);
+    instance.direction[2] = toSnorm16(direction.z);
+    instance.size = static_cast<uint16_t>(std::lround(
+            std::clamp(marker.size * MarkerInstance::kSizeUnits, 0.f, 65535.f)));
+    instance.color[0] = static_cast<uint8_t>(marker.color >> 24);
+    instance.color[1] = static_cast<uint8_t>(marker.color >> 16);
+    instance.color[2] = static_cast<uint8_t>(marker.color >> 8);
+    instance.color[3] = static_cast<uint8_t>(marker.color);
+    instance.atlasIndex = std::min<uint8_t>(marker.atlasIndex, kMarkerAtlasSize - 1);
+    instance.flags = marker.flags;
+    return instance;
+}
+
+Vec3 MarkerSet::unpackDirection(const MarkerInstance &instance) {
+    // GL ES 3 maps snorm16 to max(c / 32767, -1)
+    auto unpack = [](int16_t c) { return std::max(static_cast<float>(c) / 32767.f, -1.f); };
+    return {unpack(instance.direction[0]),
+            unpack(instance.direction[1]),
+            unpack(instance.direction[2])};
+}
+
+bool MarkerSet::isVisible(const MarkerInstance &instance, const Vec3 &cameraPosition) {
+    if (instance.flags & kMarkerHidden) {
+        return false;
+    }
+
+    // The tangent plane at p is dot(x, p) = |p|^2, the camera is above it if the point is in
+    // front of the horizon. Using |p|^2 rather than 1 keeps the test exact for quantized points.
+    auto direction = unpackDirection(instance);
+    return dot(direction, cameraPosition) > dot(direction, direction);
+}
+
+uint32_t MarkerSet::add(const Marker &marker) {
+    auto index = static_cast<uint32_t>(markers_.size());
+    markers_.push_back(marker);
+    instances_.push_back(pack(marker));
+    markChanged(index);
+    return index;
+}
+
+void MarkerSet::set(uint32_t index, const Marker &marker) {
+    markers_[index] = marker;
+    instances_[index] = pack(marker);
+    markChanged(index);
+}
+
+void MarkerSet::setFlags(uint32_t index, uint8_t flags) {
+    if (markers_[index].flags == flags) {
+        return;
+    }
+    markers_[index].flags = flags;
+    instances_[index].flags = flags;
+    markChanged(index);
+}
+
+void MarkerSet::clear() {
+    markers_.clear();
+    instances_.clear();
+    dirtyPages_.clear();
+
+    // Nothing is left to upload, the layer only draws size() instances
+    hasChanges_ = true;
+}
+
+size_t MarkerSet::countVisible(const Vec3 &cameraPosition) const {
+    return static_cast<size_t>(std::count_if(
+            instances_.begin(),
+            instances_.end(),
+            [&cameraPosition](const MarkerInstance &instance) {
+                return isVisible(instance, cameraPosition);
+            }));
+}
+
+void MarkerSet::markChanged(uint32_t index) {
+    auto page = index / kPageSize;
+    if (page >= dirtyPages_.size()) {
+        dirtyPages_.resize(page + 1, false);
+    }
+    dirtyPages_[page] = true;
+    hasChanges_ = true;
+}
@@ -0,0 +1,165 @@
+#ifndef ANDROIDGLINVESTIGATIONS_MARKERSET_H
+#define ANDROIDGLINVESTIGATIONS_MARKERSET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VectorMath.h"
+
+//! bits of @a Marker::flags
+constexpr uint8_t kMarkerHidden = 1u << 0;
+//! drawn larger and brighter, e.g. the selected animal
+constexpr uint8_t kMarkerHighlighted = 1u << 1;
+
+//! symbols of the built in marker atlas, see @a MarkerLayer
+constexpr uint8_t kMarkerAtlasSize = 4;
+
+/*!
+ * A point of interest on the globe, e.g. where an animal was seen.
+ */
+struct Marker {
+    //! degrees north and east, see @a directionFromLatLon
+    float latitude = 0.f;
+    float longitude = 0.f;
+
+    //! width and height of the billboard on screen, in pixels
+    float size = 16.f;
+
+    //! 0xRRGGBBAA
+    uint32_t color = 0xFFFFFFFFu;
+
+    //! the symbol in the marker atlas, below @a kMarkerAtlasSize
+    uint8_t atlasIndex = 0;
+
+    //! kMarker* bits
+    uint8_t flags = 0;
+};
+
+/*!
+ * How a marker is stored in the per-instance vertex buffer, 16 bytes.
+ */
+struct MarkerInstance {
+    //! the position on the unit sphere as snorm16, about 200 m on an Earth sized globe
+    int16_t direction[3];
+
+    //! the billboard size in 1/@a kSizeUnits pixels
+    uint16_t size;
+
+    //! RGBA
+    uint8_t color[4];
+
+    uint8_t atlasIndex;
+    uint8_t flags;
+    uint16_t padding;
+
+    //! steps per pixel of @a size, enough for smooth zooming up to 4095 pixels
+    static constexpr float kSizeUnits = 16.f;
+};
+
+static_assert(sizeof(MarkerInstance) == 16, "MarkerInstance is laid out for the vertex buffer");
+
+/*!
+ * The markers of a @a MarkerLayer, kept on the CPU together with their packed instances.
+ *
+ * Changes are tracked in pages of @a kPageSize instances, so after editing a few markers only the
+ * pages they're in have to be uploaded again. Markers keep their index for their lifetime, hide
+ * them with @a kMarkerHidden instead of removing them.
+ *
+ * Platform independent, the GL side lives in @a MarkerLayer.
+ */
+class MarkerSet {
+public:
+    //! instances per page of change tracking, 16 KiB
+    static constexpr size_t kPageSize = 1024;
+
+    static MarkerInstance pack(const Marker &marker);
+
+    /*!
+     * @return the instance's position as the vertex shader reads it, within about 1e-4 of the
+     *     unit sphere
+     */
+    static Vec3 unpackDirection(const MarkerInstance &instance);
+
+    /*!
+     * The visibility test of the marker vertex shader: the marker isn't hidden and is in front of
+     * the horizon seen from @a cameraPosition, so the globe doesn't cover it.
+     *
+     * @param cameraPosition the eye in the globe's model space, where the globe is the unit sphere
+     */
+    static bool isVisible(const MarkerInstance &instance, const Vec3 &cameraPosition);
+
+    /*!
+     * @return the index of the new marker
+     */
+    uint32_t add(const Marker &marker);
+
+    void set(uint32_t index, const Marker &marker);
+
+    void setFlags(uint32_t index, uint8_t flags);
+
+    /*!
+     * Removes every marker, indices start from 0 again.
+     */
+    void clear();
+
+    inline const Marker &get(uint32_t index) const { return markers_[index]; }
+
+    inline size_t size() const { return markers_.size(); }
+
+    inline const std::vector<MarkerInstance> &getInstances() const { return instances_; }
+
+    /*!
+     * @return true if any instance changed since the last @a consumeChanges
+     */
+    inline bool hasChanges() const { return hasChanges_; }
+
+    /*!
+     * Hands every run of changed instances to @a upload and forgets the changes.
+     *
+     * @param upload called as upload(first, count) with ranges in instances, in ascending order
+     *     and not touching each other
+     */
+    template<typename Upload>
+    void consumeChanges(Upload &&upload) {
+        if (!hasChanges_) {
+            return;
+        }
+        auto pageCount = dirtyPages_.size();
+        for (size_t page = 0; page < pageCount;) {
+            if (!dirtyPages_[page]) {
+                ++page;
+                continue;
+            }
+            auto end = page;
+            while (end < pageCount && dirtyPages_[end]) {
+                dirtyPages_[end] = false;
+                ++end;
+            }
+            auto first = page * kPageSize;
+            auto last = std::min(end * kPageSize, instances_.size());
+            if (first < last) {
+                upload(first, last - first);
+            }
+            page = end;
+        }
+        hasChanges_ = false;
+    }
+
+    /*!
+     * @return how many markers @a isVisible from @a cameraPosition, the CPU reference for what the
+     *     GPU draws
+     */
+    size_t countVisible(const Vec3 &cameraPosition) const;
+
+private:
+    void markChanged(uint32_t index);
+
+    std::vector<Marker> markers_;
+    std::vector<MarkerInstance> instances_;
+    std::vector<bool> dirtyPages_;
+    bool hasChanges_ = false;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_MARKERSET_H
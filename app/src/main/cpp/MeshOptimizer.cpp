@@ -0,0 +1,179 @@
+#include "MeshOptimizer.h"
+
+#include <cassert>
+
+namespace {
+
+constexpr uint32_t kInvalidVertex = 0xffffffffu;
+
+/*!
+ * The triangles using each vertex, in compressed sparse row form.
+ */
+struct Adjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    Adjacency(const std::vector<uint32_t> &indices, size_t vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indices.size()) {
+        for (auto index : indices) {
+            offsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+};
+
+} // namespace
+
+void MeshOptimizer::optimizeVertexCache(
+        std::vector<uint32_t> &indices,
+        size_t vertexCount,
+        int cacheSize) {
+    assert(indices.size() % 3 == 0);
+    auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    Adjacency adjacency(indices, vertexCount);
+
+    // How many not yet emitted triangles still use each vertex
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    // When each vertex last entered the simulated cache. It's in the cache while
+    // timestamp - cacheTime[v] <= cacheSize.
+    std::vector<int64_t> cacheTime(vertexCount, 0);
+    int64_t timestamp = cacheSize + 1;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    // Tipsify fans around one vertex at a time, then continues with the candidate that stays in the
+    // cache the longest without being evicted by its own remaining triangles
+    uint32_t fanVertex = 0;
+    size_t cursor = 0;
+    while (fanVertex != kInvalidVertex) {
+        candidates.clear();
+
+        for (auto i = adjacency.offsets[fanVertex]; i < adjacency.offsets[fanVertex + 1]; ++i) {
+            auto triangle = adjacency.triangles[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (int corner = 0; corner < 3; ++corner) {
+                auto v = indices[triangle * 3 + corner];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timestamp - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = timestamp++;
+                }
+            }
+        }
+
+        // The candidate with the oldest cache entry that's still guaranteed to be in the cache
+        // after its remaining triangles are emitted
+        uint32_t next = kInvalidVertex;
+        int64_t bestPriority = -1;
+        for (auto v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (timestamp - cacheTime[v] + 2 * int64_t(liveTriangles[v]) <= cacheSize) {
+                priority = timestamp - cacheTime[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        // Dead end: back up to a recently used vertex with work left, otherwise scan onwards
+        while (next == kInvalidVertex && !deadEnd.empty()) {
+            auto v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0) {
+                next = v;
+            }
+        }
+        while (next == kInvalidVertex && cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                next = static_cast<uint32_t>(cursor);
+            }
+            cursor++;
+        }
+        fanVertex = next;
+    }
+
+    assert(result.size() == indices.size());
+    indices.swap(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(
+        std::vector<uint32_t> &indices,
+        size_t vertexCount) {
+    std::vector<uint32_t> remap(vertexCount, kInvalidVertex);
+    uint32_t nextVertex = 0;
+    for (auto &index : indices) {
+        if (remap[index] == kInvalidVertex) {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    // Unused vertices go last so the vertex count doesn't change
+    for (auto &target : remap) {
+        if (target == kInvalidVertex) {
+            target = nextVertex++;
+        }
+    }
+    return remap;
+}
+
+VertexCacheStats MeshOptimizer::analyze(
+        const std::vector<uint32_t> &indices,
+        size_t vertexCount,
+        int cacheSize) {
+    VertexCacheStats stats;
+
+    // A FIFO cache: a vertex is a hit while fewer than cacheSize misses happened since its own
+    std::vector<int64_t> missTime(vertexCount, -int64_t(cacheSize) - 1);
+    int64_t misses = 0;
+    for (auto index : indices) {
+        if (misses - missTime[index] > cacheSize) {
+            missTime[index] = misses++;
+        }
+    }
+
+    stats.shadedVertices = static_cast<size_t>(misses);
+    if (!indices.empty()) {
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    }
+
+    size_t usedVertices = 0;
+    for (auto time : missTime) {
+        if (time >= 0) {
+            usedVertices++;
+        }
+    }
+    if (usedVertices > 0) {
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(usedVertices);
+    }
+    return stats;
+}
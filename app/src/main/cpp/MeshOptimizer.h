@@ -0,0 +1,91 @@
+#ifndef ANDROIDGLINVESTIGATIONS_MESHOPTIMIZER_H
+#define ANDROIDGLINVESTIGATIONS_MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ * Post-transform vertex cache statistics of a triangle list, see @a MeshOptimizer::analyze.
+ */
+struct VertexCacheStats {
+    //! vertex shader invocations with a FIFO cache of the simulated size
+    size_t shadedVertices = 0;
+
+    //! average cache miss ratio: shaded vertices per triangle. 3 is the worst case, around 0.5 the
+    //! best a regular grid can do.
+    float acmr = 0.f;
+
+    //! average transform to vertex ratio: shaded vertices per unique vertex, 1 is ideal
+    float atvr = 0.f;
+};
+
+/*!
+ * Reorders indexed triangle lists so GPUs shade fewer vertices and fetch them more linearly. Works
+ * on 32-bit indices and has no Android or GL dependencies, the host mesh report tool shares it.
+ *
+ * A mesh is optimized in two passes: @a optimizeVertexCache reorders the triangles, then
+ * @a optimizeVertexFetch renumbers the vertices in the order the new triangle list first uses them.
+ */
+class MeshOptimizer {
+public:
+    //! post-transform cache size assumed by default. Mobile GPUs don't document theirs, a small
+    //! FIFO is a safe target: an order tuned for it also does well on larger caches.
+    static constexpr int kDefaultCacheSize = 16;
+
+    /*!
+     * Reorders the triangles of @a indices for a post-transform vertex cache of @a cacheSize
+     * entries using Tipsify (Sander, Nehab and Barczak, 2007). Runs in linear time. The vertices
+     * themselves aren't touched.
+     *
+     * @param indices triangle list, reordered in place
+     * @param vertexCount the number of vertices @a indices refers to
+     */
+    static void optimizeVertexCache(
+            std::vector<uint32_t> &indices,
+            size_t vertexCount,
+            int cacheSize = kDefaultCacheSize);
+
+    /*!
+     * Renumbers the vertices in the order @a indices first references them so vertex fetches walk
+     * memory forwards. Vertices no triangle uses keep their relative order at the end.
+     *
+     * @param indices triangle list, rewritten to the new vertex numbers
+     * @param vertexCount the number of vertices @a indices refers to
+     * @return the new position of each old vertex, apply it with @a remapVertices
+     */
+    static std::vector<uint32_t> optimizeVertexFetch(
+            std::vector<uint32_t> &indices,
+            size_t vertexCount);
+
+    /*!
+     * Moves every vertex to the position @a remap assigns to it.
+     */
+    template<typename T>
+    static std::vector<T> remapVertices(
+            const std::vector<T> &vertices,
+            const std::vector<uint32_t> &remap) {
+        // Copies instead of default constructing, vertex types needn't have a default constructor
+        std::vector<uint32_t> source(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            source[remap[i]] = static_cast<uint32_t>(i);
+        }
+
+        std::vector<T> remapped;
+        remapped.reserve(vertices.size());
+        for (auto i : source) {
+            remapped.push_back(vertices[i]);
+        }
+        return remapped;
+    }
+
+    /*!
+     * Simulates a FIFO post-transform cache of @a cacheSize entries over @a indices.
+     */
+    static VertexCacheStats analyze(
+            const std::vector<uint32_t> &indices,
+            size_t vertexCount,
+            int cacheSize = kDefaultCacheSize);
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_MESHOPTIMIZER_H
@@ -0,0 +1,119 @@
+#include "Model.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "AndroidOut.h"
+
+Model::Model(
+        std::vector<Vertex> vertices,
+        std::vector<Index> indices,
+        std::shared_ptr<TextureAsset> spTexture,
+        const VertexFormat &format,
+        bool keepCpuCopy)
+        : spTexture_(std::move(spTexture)),
+          format_(format),
+          vertexBuffer_(0),
+          indexBuffer_(0),
+          vertexArray_(0),
+          indexCount_(static_cast<GLsizei>(indices.size())),
+          indexType_(GL_UNSIGNED_INT) {
+    VertexLayout layout(format_);
+
+    glGenVertexArrays(1, &vertexArray_);
+    glGenBuffers(1, &indexBuffer_);
+
+    // The index buffer binding is part of the vertex array's state, so bind that first
+    glBindVertexArray(vertexArray_);
+
+    // Pick the narrowest index type that can address every vertex
+    Index maxIndex = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    if (maxIndex <= 0xffff) {
+        indexType_ = GL_UNSIGNED_SHORT;
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        glBufferData(
+                GL_ELEMENT_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(shortIndices.size() * sizeof(uint16_t)),
+                shortIndices.data(),
+                GL_STATIC_DRAW);
+    } else {
+        glBufferData(
+                GL_ELEMENT_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(indices.size() * sizeof(Index)),
+                indices.data(),
+                GL_STATIC_DRAW);
+    }
+
+    // A procedural sphere has no attributes at all, the vertex shader only needs gl_VertexID
+    size_t vertexBytes = 0;
+    if (layout.getStride() > 0) {
+        auto packed = layout.pack(vertices);
+        vertexBytes = packed.size();
+
+        glGenBuffers(1, &vertexBuffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+        glBufferData(
+                GL_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(packed.size()),
+                packed.data(),
+                GL_STATIC_DRAW);
+        layout.applyAttributes();
+    }
+
+    // Unbind the vertex array first so the index buffer stays attached to it
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    aout << "Model: " << indexCount_ / 3 << " triangles, "
+         << (format_.proceduralSphere ? 0 : vertices.size()) << " vertices at "
+         << layout.getStride() << " bytes, " << vertexBytes / 1024 << " KiB of vertex data, "
+         << (indexType_ == GL_UNSIGNED_SHORT ? 16 : 32) << "-bit indices" << std::endl;
+
+    if (keepCpuCopy) {
+        vertices_ = std::move(vertices);
+        indices_ = std::move(indices);
+    }
+}
+
+Model::~Model() {
+    releaseBuffers();
+}
+
+Model::Model(Model &&other) noexcept
+        : vertices_(std::move(other.vertices_)),
+          indices_(std::move(other.indices_)),
+          spTexture_(std::move(other.spTexture_)),
+          format_(other.format_),
+          vertexBuffer_(std::exchange(other.vertexBuffer_, 0)),
+          indexBuffer_(std::exchange(other.indexBuffer_, 0)),
+          vertexArray_(std::exchange(other.vertexArray_, 0)),
+          indexCount_(std::exchange(other.indexCount_, 0)),
+          indexType_(other.indexType_) {}
+
+Model &Model::operator=(Model &&other) noexcept {
+    if (this != &other) {
+        releaseBuffers();
+        vertices_ = std::move(other.vertices_);
+        indices_ = std::move(other.indices_);
+        spTexture_ = std::move(other.spTexture_);
+        format_ = other.format_;
+        vertexBuffer_ = std::exchange(other.vertexBuffer_, 0);
+        indexBuffer_ = std::exchange(other.indexBuffer_, 0);
+        vertexArray_ = std::exchange(other.vertexArray_, 0);
+        indexCount_ = std::exchange(other.indexCount_, 0);
+        indexType_ = other.indexType_;
+    }
+    return *this;
+}
+
+void Model::releaseBuffers() {
+    // Deleting name 0 is a no-op, so moved-from models are fine
+    glDeleteVertexArrays(1, &vertexArray_);
+    glDeleteBuffers(1, &vertexBuffer_);
+    glDeleteBuffers(1, &indexBuffer_);
+    vertexArray_ = 0;
+    vertexBuffer_ = 0;
+    indexBuffer_ = 0;
+}
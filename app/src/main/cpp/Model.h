@@ -1,66 +1,111 @@
 #ifndef ANDROIDGLINVESTIGATIONS_MODEL_H
 #define ANDROIDGLINVESTIGATIONS_MODEL_H
 
+#include <GLES3/gl3.h>
 #include <vector>
 #include "TextureAsset.h"
+#include "VertexLayout.h"
 
-union Vector3 {
-    struct {
-        float x, y, z;
-    };
-    float idx[3];
-};
-
-union Vector2 {
-    struct {
-        float x, y;
-    };
-    struct {
-        float u, v;
-    };
-    float idx[2];
-};
-
-struct Vertex {
-    constexpr Vertex(const Vector3 &inPosition, const Vector2 &inUV) : position(inPosition),
-                                                                       uv(inUV) {}
-
-    Vector3 position;
-    Vector2 uv;
-};
-
-typedef uint16_t Index;
+/*!
+ * Meshes are built with 32-bit indices. Models whose vertices all fit 16 bits upload them as
+ * GL_UNSIGNED_SHORT, which halves the index buffer and is the faster path on most GPUs.
+ */
+typedef uint32_t Index;
 
+/*!
+ * A textured indexed mesh. The vertices and indices are copied into GPU buffers once, together
+ * with a vertex array object describing them, so drawing is a single bind and draw call. Must be
+ * created and destroyed with a current GL context.
+ *
+ * The vertices are packed into the model's @a VertexFormat. A procedural sphere has no vertex
+ * buffer at all, only indices.
+ */
 class Model {
 public:
-    inline Model(
+    /*!
+     * Uploads the mesh into GPU buffers.
+     * @param vertices the vertices, ignored for a procedural sphere
+     * @param indices triangle list indices into @a vertices
+     * @param spTexture the texture to draw with
+     * @param format how to store the vertices on the GPU
+     * @param keepCpuCopy keep @a vertices and @a indices in memory after the upload, only needed
+     * if something reads them back later
+     */
+    Model(
             std::vector<Vertex> vertices,
             std::vector<Index> indices,
-            std::shared_ptr<TextureAsset> spTexture)
-            : vertices_(std::move(vertices)),
-              indices_(std::move(indices)),
-              spTexture_(std::move(spTexture)) {}
+            std::shared_ptr<TextureAsset> spTexture,
+            const VertexFormat &format = VertexFormat(),
+            bool keepCpuCopy = false);
+
+    ~Model();
+
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    Model(Model &&other) noexcept;
+    Model &operator=(Model &&other) noexcept;
 
-    inline const Vertex *getVertexData() const {
-        return vertices_.data();
+    /*!
+     * @return the vertex array object holding the model's buffers and attribute layout
+     */
+    inline GLuint getVertexArray() const {
+        return vertexArray_;
     }
 
-    inline const size_t getIndexCount() const {
-        return indices_.size();
+    inline GLsizei getIndexCount() const {
+        return indexCount_;
     }
 
-    inline const Index *getIndexData() const {
-        return indices_.data();
+    /*!
+     * @return GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, the type of the uploaded index buffer
+     */
+    inline GLenum getIndexType() const {
+        return indexType_;
+    }
+
+    inline const VertexFormat &getVertexFormat() const {
+        return format_;
+    }
+
+    /*!
+     * @return the CPU copy of the vertices, empty unless the model was created with keepCpuCopy
+     */
+    inline const std::vector<Vertex> &getVertices() const {
+        return vertices_;
+    }
+
+    /*!
+     * @return the CPU copy of the indices, empty unless the model was created with keepCpuCopy
+     */
+    inline const std::vector<Index> &getIndices() const {
+        return indices_;
     }
 
     inline const TextureAsset &getTexture() const {
         return *spTexture_;
     }
 
+    /*!
+     * Swaps the texture, e.g. to replace a placeholder once the real one finished loading
+     */
+    inline void setTexture(std::shared_ptr<TextureAsset> spTexture) {
+        spTexture_ = std::move(spTexture);
+    }
+
 private:
+    void releaseBuffers();
+
     std::vector<Vertex> vertices_;
     std::vector<Index> indices_;
     std::shared_ptr<TextureAsset> spTexture_;
+    VertexFormat format_;
+
+    GLuint vertexBuffer_;
+    GLuint indexBuffer_;
+    GLuint vertexArray_;
+    GLsizei indexCount_;
+    GLenum indexType_;
 };
 
 #endif //ANDROIDGLINVESTIGATIONS_MODEL_H
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "PixelFilter.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Four pixels at a time with NEON on ARM and SSE2 on x86, plain C++ anywhere else or when
+// EARTHZOO_MATH_SCALAR is defined like the host tests do
+#if !defined(EARTHZOO_MATH_SCALAR) && defined(__ARM_NEON)
+#define EARTHZOO_PIXELFILTER_NEON 1
+#include <arm_neon.h>
+#elif !defined(EARTHZOO_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define EARTHZOO_PIXELFILTER_SSE 1
+#include <emmintrin.h>
+#endif
+
+PixelFilter PixelFilter::makeOutlineFilter(uint8_t minAlpha) {
+    PixelRange opaqueBlack;
+    opaqueBlack.low = packRgba(0, 0, 0, minAlpha);
+    opaqueBlack.high = packRgba(0, 0, 0, 255);
+    return {opaqueBlack, PixelMap::fill(packRgba(0, 0, 0, 255)), PixelMap::fill(0)};
+}
+
+PixelFilter::PixelFilter(
+        const PixelRange &range,
+        const PixelMap &inside,
+        const PixelMap &outside) :
+        range_(range),
+        inside_(inside),
+        outside_(outside) {}
+
+void PixelFilter::applyRow(uint32_t *pixels, size_t count) const {
+    size_t index = 0;
+
+#if defined(EARTHZOO_PIXELFILTER_NEON)
+    auto low = vreinterpretq_u8_u32(vdupq_n_u32(range_.low));
+    auto high = vreinterpretq_u8_u32(vdupq_n_u32(range_.high));
+    auto insideKeep = vdupq_n_u32(inside_.keep);
+    auto insideColor = vdupq_n_u32(inside_.color);
+    auto outsideKeep = vdupq_n_u32(outside_.keep);
+    auto outsideColor = vdupq_n_u32(outside_.color);
+    auto allSet = vdupq_n_u32(0xFFFFFFFFu);
+    for (; index + 4 <= count; index += 4) {
+        auto pixel = vld1q_u32(pixels + index);
+        auto bytes = vreinterpretq_u8_u32(pixel);
+
+        // Every byte within its bounds, then all four of a pixel
+        auto inRange = vandq_u8(vcgeq_u8(bytes, low), vcleq_u8(bytes, high));
+        auto matches = vceqq_u32(vreinterpretq_u32_u8(inRange), allSet);
+
+        auto mappedInside = vorrq_u32(vandq_u32(pixel, insideKeep), insideColor);
+        auto mappedOutside = vorrq_u32(vandq_u32(pixel, outsideKeep), outsideColor);
+        vst1q_u32(pixels + index, vbslq_u32(matches, mappedInside, mappedOutside));
+    }
+#elif defined(EARTHZOO_PIXELFILTER_SSE)
+    auto low = _mm_set1_epi32(static_cast<int>(range_.low));
+    auto high = _mm_set1_epi32(static_cast<int>(range_.high));
+    auto insideKeep = _mm_set1_epi32(static_cast<int>(inside_.keep));
+    auto insideColor = _mm_set1_epi32(static_cast<int>(inside_.color));
+    auto outsideKeep = _mm_set1_epi32(static_cast<int>(outside_.keep));
+    auto outsideColor = _mm_set1_epi32(static_cast<int>(outside_.color));
+    auto allSet = _mm_set1_epi32(-1);
+    for (; index + 4 <= count; index += 4) {
+        auto *address = reinterpret_cast<__m128i *>(pixels + index);
+        auto pixel = _mm_loadu_si128(address);
+
+        // SSE2 has no unsigned byte compares, a byte is at least low if max(byte, low) is the
+        // byte and at most high if min(byte, high) is
+        auto atLeastLow = _mm_cmpeq_epi8(_mm_max_epu8(pixel, low), pixel);
+        auto atMostHigh = _mm_cmpeq_epi8(_mm_min_epu8(pixel, high), pixel);
+        auto matches = _mm_cmpeq_epi32(_mm_and_si128(atLeastLow, atMostHigh), allSet);
+
+        auto mappedInside = _mm_or_si128(_mm_and_si128(pixel, insideKeep), insideColor);
+        auto mappedOutside = _mm_or_si128(_mm_and_si128(pixel, outsideKeep), outsideColor);
+        _mm_storeu_si128(address, _mm_or_si128(_mm_and_si128(matches, mappedInside),
+                                               _mm_andnot_si128(matches, mappedOutside)));
+    }
+#endif
+
+    for (; index < count; ++index) {
+        pixels[index] = apply(pixels[index]);
+    }
+}
+
+void PixelFilter::applyImage(
+        void *pixels,
+        uint32_t width,
+        uint32_t height,
+        size_t stride,
+        int threadCount) const {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+    auto pixelCount = static_cast<size_t>(width) * height;
+    auto bandCount = static_cast<uint32_t>(std::clamp<size_t>(
+            pixelCount / kMinPixelsPerThread, 1, std::min<size_t>(threadCount, height)));
+    auto bandHeight = (height + bandCount - 1) / bandCount;
+
+    auto *firstRow = static_cast<uint8_t *>(pixels);
+    auto filterRows = [this, firstRow, width, stride](uint32_t first, uint32_t end) {
+        for (auto row = first; row < end; ++row) {
+            applyRow(reinterpret_cast<uint32_t *>(firstRow + row * stride), width);
+        }
+    };
+
+    // Every band is a run of whole rows, the calling thread takes the first
+    std::vector<std::thread> threads;
+    for (uint32_t band = 1; band < bandCount; ++band) {
+        auto first = std::min(band * bandHeight, height);
+        threads.emplace_back(filterRows, first, std::min(first + bandHeight, height));
+    }
+    filterRows(0, std::min(bandHeight, height));
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
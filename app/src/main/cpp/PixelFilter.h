@@ -0,0 +1,107 @@
+#ifndef ANDROIDGLINVESTIGATIONS_PIXELFILTER_H
+#define ANDROIDGLINVESTIGATIONS_PIXELFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * @return a pixel of an RGBA 8888 image as it lies in memory, red in the lowest byte. Android's
+ *     ARGB_8888 bitmaps are laid out like this.
+ */
+constexpr uint32_t packRgba(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+    return static_cast<uint32_t>(red)
+           | static_cast<uint32_t>(green) << 8
+           | static_cast<uint32_t>(blue) << 16
+           | static_cast<uint32_t>(alpha) << 24;
+}
+
+/*!
+ * Bounds for every channel of a pixel, both inclusive and packed like the pixels. A pixel is in
+ * the range if each of its channels is.
+ */
+struct PixelRange {
+    uint32_t low = packRgba(0, 0, 0, 0);
+    uint32_t high = packRgba(255, 255, 255, 255);
+};
+
+/*!
+ * What a @a PixelFilter makes of a pixel: (pixel & keep) | color. Keeping every bit leaves the
+ * pixel as it is, keeping none paints it @a color.
+ */
+struct PixelMap {
+    uint32_t keep = 0xFFFFFFFFu;
+    uint32_t color = 0;
+
+    //! @return a map that leaves pixels alone
+    static constexpr PixelMap unchanged() { return {0xFFFFFFFFu, 0}; }
+
+    //! @return a map that replaces pixels with @a color
+    static constexpr PixelMap fill(uint32_t color) { return {0, color}; }
+};
+
+/*!
+ * Recolours RGBA 8888 images in place: each pixel is tested against a @a PixelRange and mapped
+ * by one of two @a PixelMap, depending on whether it's in the range. That's enough for the
+ * overlays' filters (keying out colours, painting masks, forcing alpha) while four pixels are
+ * tested and mapped at a time with NEON or SSE2.
+ *
+ * Tests run on the stored values, for premultiplied bitmaps the premultiplied ones. Immutable,
+ * platform independent.
+ */
+class PixelFilter {
+public:
+    //! images below this many pixels per thread aren't worth another thread
+    static constexpr size_t kMinPixelsPerThread = 65536;
+
+    /*!
+     * The overlays' outline filter: keeps pure black pixels at least @a minAlpha opaque as solid
+     * black and clears everything else. The overlays paint their grey fill as translucent black,
+     * this leaves only the outline.
+     */
+    static PixelFilter makeOutlineFilter(uint8_t minAlpha);
+
+    /*!
+     * @param range the pixels @a inside applies to
+     * @param inside what becomes of pixels in @a range
+     * @param outside what becomes of all others
+     */
+    PixelFilter(const PixelRange &range, const PixelMap &inside, const PixelMap &outside);
+
+    //! @return whether @a pixel is in the filter's range
+    inline bool matches(uint32_t pixel) const {
+        for (int shift = 0; shift < 32; shift += 8) {
+            auto channel = (pixel >> shift) & 0xFFu;
+            if (channel < ((range_.low >> shift) & 0xFFu)
+                || channel > ((range_.high >> shift) & 0xFFu)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! @return @a pixel filtered
+    inline uint32_t apply(uint32_t pixel) const {
+        const auto &map = matches(pixel) ? inside_ : outside_;
+        return (pixel & map.keep) | map.color;
+    }
+
+    //! filters @a count pixels of a row in place
+    void applyRow(uint32_t *pixels, size_t count) const;
+
+    /*!
+     * Filters an image in place, bands of rows on different threads.
+     *
+     * @param pixels the first row, 4 byte aligned
+     * @param stride bytes from one row to the next
+     * @param threadCount 0 for one per core
+     */
+    void applyImage(void *pixels, uint32_t width, uint32_t height, size_t stride,
+                    int threadCount = 0) const;
+
+private:
+    PixelRange range_;
+    PixelMap inside_;
+    PixelMap outside_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_PIXELFILTER_H
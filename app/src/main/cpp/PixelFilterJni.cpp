@@ -0,0 +1,68 @@
+#include <jni.h>
+#include <algorithm>
+#include <android/bitmap.h>
+
+#include "AndroidOut.h"
+#include "PixelFilter.h"
+
+namespace {
+
+/*!
+ * Runs @a filter over @a bitmap's pixels in place.
+ *
+ * @return false if the bitmap isn't RGBA 8888 or its pixels can't be locked
+ */
+bool filterBitmap(JNIEnv *env, jobject bitmap, const PixelFilter &filter) {
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS
+        || info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        aout << "Can't filter a bitmap that isn't RGBA 8888" << std::endl;
+        return false;
+    }
+
+    void *pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS
+        || !pixels) {
+        aout << "Can't lock the pixels of a bitmap to filter" << std::endl;
+        return false;
+    }
+    filter.applyImage(pixels, info.width, info.height, info.stride);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return true;
+}
+
+} // namespace
+
+extern "C" {
+
+/*!
+ * com.pykens.earthzoo.ui.OverlayFilter.nativeFilter: a @a PixelFilter over a mutable ARGB_8888
+ * bitmap, pixels packed like @a packRgba.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_pykens_earthzoo_ui_OverlayFilter_nativeFilter(
+        JNIEnv *env, jclass, jobject bitmap, jint low, jint high, jint insideKeep,
+        jint insideColor, jint outsideKeep, jint outsideColor) {
+    PixelRange range;
+    range.low = static_cast<uint32_t>(low);
+    range.high = static_cast<uint32_t>(high);
+    PixelFilter filter(
+            range,
+            {static_cast<uint32_t>(insideKeep), static_cast<uint32_t>(insideColor)},
+            {static_cast<uint32_t>(outsideKeep), static_cast<uint32_t>(outsideColor)});
+    return filterBitmap(env, bitmap, filter) ? JNI_TRUE : JNI_FALSE;
+}
+
+/*!
+ * com.pykens.earthzoo.ui.OverlayFilter.nativeKeepOutline: @a PixelFilter::makeOutlineFilter over
+ * a mutable ARGB_8888 bitmap.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_pykens_earthzoo_ui_OverlayFilter_nativeKeepOutline(
+        JNIEnv *env, jclass, jobject bitmap, jint minAlpha) {
+    auto filter = PixelFilter::makeOutlineFilter(
+            static_cast<uint8_t>(std::min(std::max(minAlpha, 0), 255)));
+    return filterBitmap(env, bitmap, filter) ? JNI_TRUE : JNI_FALSE;
+}
+
+}
@@ -0,0 +1,542 @@
+#include "PointStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegreesToRadians = kPi / 180.0;
+
+//! grid columns around the globe
+constexpr double kGridColumns = 4294967296.0;
+
+//! the last grid row, at the north pole
+constexpr double kLastGridRow = 4294967295.0;
+
+//! magic, version, level count, point and node count, three section offsets, block capacity
+constexpr size_t kHeaderSize = 64;
+
+//! deeper trees would take more than 2^64 points at the smallest fanout
+constexpr uint32_t kMaxLevels = 64;
+
+//! a 32 bit extent divided by 2^16 always fits the 16 bit offsets
+constexpr uint32_t kMaxShift = 16;
+
+//! sections start on this boundary so the file can be read in place
+constexpr size_t kSectionAlignment = 8;
+
+uint32_t readU32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t readU64(const uint8_t *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void writeU32(std::vector<uint8_t> &out, size_t offset, uint32_t value) {
+    memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+void writeU64(std::vector<uint8_t> &out, size_t offset, uint64_t value) {
+    memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+size_t alignSection(size_t offset) {
+    return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+/*!
+ * @return the smallest shift that brings @a extent into a 16 bit offset
+ */
+uint32_t getRequiredShift(uint32_t extent) {
+    uint32_t shift = 0;
+    while ((extent >> shift) > 0xFFFFu) {
+        ++shift;
+    }
+    return shift;
+}
+
+uint32_t getRequiredShift(const PointStoreNode &node) {
+    return std::max(getRequiredShift(node.maxX - node.minX),
+                    getRequiredShift(node.maxY - node.minY));
+}
+
+void includeInBounds(PointStoreNode &node, uint32_t x, uint32_t y) {
+    node.minX = std::min(node.minX, x);
+    node.minY = std::min(node.minY, y);
+    node.maxX = std::max(node.maxX, x);
+    node.maxY = std::max(node.maxY, y);
+}
+
+/*!
+ * A point on its way into the file.
+ */
+struct SortEntry {
+    uint64_t key;
+    uint32_t x;
+    uint32_t y;
+    uint32_t id;
+};
+
+} // namespace
+
+/*!
+ * A query as one or two boxes on the grid, two when it crosses the antimeridian, and optionally
+ * the cap the points inside the boxes are tested against.
+ */
+struct PointStore::Query {
+    uint32_t minX[2] = {0, 0};
+    uint32_t maxX[2] = {0, 0};
+    int boxCount = 0;
+    uint32_t minY = 0;
+    uint32_t maxY = 0;
+
+    bool isCap = false;
+
+    //! the cap's centre in radians and the haversine of its radius
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double cosLatitude = 1.0;
+    double haversineRadius = 0.0;
+
+    void setRect(double south, double west, double north, double east) {
+        minY = quantizeLatitude(south);
+        maxY = quantizeLatitude(north);
+
+        auto span = east - west;
+        if (span < 0.0) {
+            span += 360.0;
+        }
+        if (span >= 360.0) {
+            minX[0] = 0;
+            maxX[0] = UINT32_MAX;
+            boxCount = 1;
+            return;
+        }
+
+        auto start = west - 360.0 * std::floor((west + 180.0) / 360.0);
+        auto end = start + span;
+        minX[0] = quantizeLongitude(start);
+        if (end < 180.0) {
+            maxX[0] = quantizeLongitude(end);
+            boxCount = 1;
+        } else {
+            maxX[0] = UINT32_MAX;
+            minX[1] = 0;
+            maxX[1] = quantizeLongitude(end - 360.0);
+            boxCount = 2;
+        }
+    }
+
+    inline bool overlaps(const PointStoreNode &node) const {
+        if (node.maxY < minY || node.minY > maxY) {
+            return false;
+        }
+        for (int box = 0; box < boxCount; ++box) {
+            if (node.maxX >= minX[box] && node.minX <= maxX[box]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! @return true if every point within the node's bounds matches without testing it
+    inline bool contains(const PointStoreNode &node) const {
+        if (isCap || node.minY < minY || node.maxY > maxY) {
+            return false;
+        }
+        for (int box = 0; box < boxCount; ++box) {
+            if (node.minX >= minX[box] && node.maxX <= maxX[box]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool matches(uint32_t x, uint32_t y) const {
+        if (y < minY || y > maxY) {
+            return false;
+        }
+        bool inBox = false;
+        for (int box = 0; box < boxCount; ++box) {
+            inBox = inBox || (x >= minX[box] && x <= maxX[box]);
+        }
+        if (!inBox || !isCap) {
+            return inBox;
+        }
+
+        auto pointLatitude = dequantizeLatitude(y) * kDegreesToRadians;
+        auto pointLongitude = dequantizeLongitude(x) * kDegreesToRadians;
+        auto sinHalfLatitude = std::sin((pointLatitude - latitude) * 0.5);
+        auto sinHalfLongitude = std::sin((pointLongitude - longitude) * 0.5);
+        auto haversine = sinHalfLatitude * sinHalfLatitude
+                         + cosLatitude * std::cos(pointLatitude)
+                           * sinHalfLongitude * sinHalfLongitude;
+        return haversine <= haversineRadius;
+    }
+};
+
+uint32_t PointStore::quantizeLongitude(double longitude) {
+    auto turns = (longitude + 180.0) / 360.0;
+    turns -= std::floor(turns);
+    // Just below a whole turn can round up to it, which is the column at -180 again
+    return static_cast<uint32_t>(static_cast<uint64_t>(turns * kGridColumns) & UINT32_MAX);
+}
+
+uint32_t PointStore::quantizeLatitude(double latitude) {
+    auto fraction = (std::clamp(latitude, -90.0, 90.0) + 90.0) / 180.0;
+    return static_cast<uint32_t>(std::llround(fraction * kLastGridRow));
+}
+
+double PointStore::dequantizeLongitude(uint32_t x) {
+    return static_cast<double>(x) * (360.0 / kGridColumns) - 180.0;
+}
+
+double PointStore::dequantizeLatitude(uint32_t y) {
+    return static_cast<double>(y) * (180.0 / kLastGridRow) - 90.0;
+}
+
+uint64_t PointStore::getHilbertKey(uint32_t x, uint32_t y) {
+    // Descends one level of the curve per bit, rotating the quadrant so the curve stays connected
+    uint64_t key = 0;
+    for (uint32_t step = 1u << 31; step > 0; step >>= 1) {
+        uint32_t right = (x & step) ? 1 : 0;
+        uint32_t top = (y & step) ? 1 : 0;
+        key += static_cast<uint64_t>(step) * step * ((3 * right) ^ top);
+        if (top == 0) {
+            if (right == 1) {
+                x = ~x;
+                y = ~y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return key;
+}
+
+std::vector<uint8_t> PointStore::build(
+        const std::vector<GeoPoint> &points,
+        const PointStoreOptions &options) {
+    auto blockCapacity = std::clamp<uint32_t>(options.blockCapacity, 1, UINT16_MAX);
+    auto fanout = std::clamp<uint32_t>(options.fanout, 2, UINT16_MAX);
+    auto maxShift = std::min(options.maxShift, kMaxShift);
+
+    std::vector<SortEntry> entries(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        auto &entry = entries[i];
+        entry.x = quantizeLongitude(points[i].longitude);
+        entry.y = quantizeLatitude(points[i].latitude);
+        entry.key = getHilbertKey(entry.x, entry.y);
+        entry.id = points[i].id;
+    }
+    std::sort(entries.begin(), entries.end(), [](const SortEntry &a, const SortEntry &b) {
+        return a.key < b.key || (a.key == b.key && a.id < b.id);
+    });
+
+    // Blocks take consecutive points until they're full or their offsets would get too coarse
+    std::vector<std::vector<PointStoreNode>> levels(1);
+    auto &blocks = levels[0];
+    std::vector<PointStoreOffset> offsets(entries.size());
+    for (size_t start = 0; start < entries.size();) {
+        PointStoreNode block{};
+        block.minX = block.maxX = entries[start].x;
+        block.minY = block.maxY = entries[start].y;
+        auto end = start + 1;
+        while (end < entries.size() && end - start < blockCapacity) {
+            auto grown = block;
+            includeInBounds(grown, entries[end].x, entries[end].y);
+            if (getRequiredShift(grown) > maxShift) {
+                break;
+            }
+            block = grown;
+            ++end;
+        }
+
+        block.first = static_cast<uint32_t>(start);
+        block.count = static_cast<uint16_t>(end - start);
+        block.shift = static_cast<uint8_t>(getRequiredShift(block));
+        for (auto i = start; i < end; ++i) {
+            offsets[i].x = static_cast<uint16_t>((entries[i].x - block.minX) >> block.shift);
+            offsets[i].y = static_cast<uint16_t>((entries[i].y - block.minY) >> block.shift);
+        }
+        blocks.push_back(block);
+        start = end;
+    }
+
+    // Each level up groups runs of the one below, they're neighbours along the curve already
+    while (levels.back().size() > 1) {
+        const auto &children = levels.back();
+        std::vector<PointStoreNode> parents;
+        for (size_t start = 0; start < children.size(); start += fanout) {
+            auto end = std::min<size_t>(start + fanout, children.size());
+            PointStoreNode parent = children[start];
+            for (auto i = start + 1; i < end; ++i) {
+                includeInBounds(parent, children[i].minX, children[i].minY);
+                includeInBounds(parent, children[i].maxX, children[i].maxY);
+            }
+            parent.first = static_cast<uint32_t>(start);
+            parent.count = static_cast<uint16_t>(end - start);
+            parent.shift = 0;
+            parents.push_back(parent);
+        }
+        levels.push_back(std::move(parents));
+    }
+    if (entries.empty()) {
+        levels.clear();
+    }
+    std::reverse(levels.begin(), levels.end());
+
+    std::vector<uint64_t> levelStarts(1, 0);
+    for (const auto &level: levels) {
+        levelStarts.push_back(levelStarts.back() + level.size());
+    }
+    auto nodeCount = levelStarts.back();
+
+    auto nodeOffset = alignSection(kHeaderSize + levelStarts.size() * sizeof(uint64_t));
+    auto offsetOffset = alignSection(nodeOffset + nodeCount * sizeof(PointStoreNode));
+    auto idOffset = alignSection(offsetOffset + offsets.size() * sizeof(PointStoreOffset));
+    std::vector<uint8_t> file(idOffset + entries.size() * sizeof(uint32_t));
+
+    memcpy(file.data(), kMagic, sizeof(kMagic));
+    writeU32(file, 8, kVersion);
+    writeU32(file, 12, static_cast<uint32_t>(levels.size()));
+    writeU64(file, 16, entries.size());
+    writeU64(file, 24, nodeCount);
+    writeU64(file, 32, nodeOffset);
+    writeU64(file, 40, offsetOffset);
+    writeU64(file, 48, idOffset);
+    writeU32(file, 56, blockCapacity);
+    for (size_t i = 0; i < levelStarts.size(); ++i) {
+        writeU64(file, kHeaderSize + i * sizeof(uint64_t), levelStarts[i]);
+    }
+
+    auto *outNode = file.data() + nodeOffset;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        for (auto node: levels[level]) {
+            // Inner nodes point into the level below, which the file stores after this one
+            if (level + 1 < levels.size()) {
+                node.first += static_cast<uint32_t>(levelStarts[level + 1]);
+            }
+            memcpy(outNode, &node, sizeof(node));
+            outNode += sizeof(node);
+        }
+    }
+    memcpy(file.data() + offsetOffset, offsets.data(), offsets.size() * sizeof(PointStoreOffset));
+    auto *outId = file.data() + idOffset;
+    for (const auto &entry: entries) {
+        memcpy(outId, &entry.id, sizeof(entry.id));
+        outId += sizeof(entry.id);
+    }
+    return file;
+}
+
+PointStore::PointStore() :
+        pointCount_(0),
+        nodes_(nullptr),
+        offsets_(nullptr),
+        ids_(nullptr) {}
+
+bool PointStore::attach(const uint8_t *data, size_t size) {
+    *this = PointStore();
+
+    if (!data || reinterpret_cast<uintptr_t>(data) % alignof(PointStoreNode) != 0
+        || size < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0
+        || readU32(data + 8) != kVersion) {
+        return false;
+    }
+
+    auto levelCount = readU32(data + 12);
+    auto pointCount = readU64(data + 16);
+    auto nodeCount = readU64(data + 24);
+    auto nodeOffset = readU64(data + 32);
+    auto offsetOffset = readU64(data + 40);
+    auto idOffset = readU64(data + 48);
+    auto blockCapacity = readU32(data + 56);
+
+    // Every section has to be aligned and inside the file, without overflowing on the way
+    auto fits = [size](uint64_t offset, uint64_t count, size_t elementSize) {
+        return offset % kSectionAlignment == 0 && offset <= size
+               && count <= (size - offset) / elementSize;
+    };
+    if (levelCount > kMaxLevels
+        || !fits(kHeaderSize, levelCount + 1, sizeof(uint64_t))
+        || !fits(nodeOffset, nodeCount, sizeof(PointStoreNode))
+        || !fits(offsetOffset, pointCount, sizeof(PointStoreOffset))
+        || !fits(idOffset, pointCount, sizeof(uint32_t))
+        || pointCount > UINT32_MAX
+        || (levelCount == 0) != (pointCount == 0)) {
+        return false;
+    }
+
+    std::vector<size_t> levelStarts;
+    for (uint32_t i = 0; i <= levelCount; ++i) {
+        auto start = readU64(data + kHeaderSize + i * sizeof(uint64_t));
+        if ((i == 0 && start != 0) || (i > 0 && start <= levelStarts.back())) {
+            return false;
+        }
+        levelStarts.push_back(static_cast<size_t>(start));
+    }
+    if (levelStarts.back() != nodeCount || (levelCount > 0 && levelStarts[1] != 1)) {
+        return false;
+    }
+
+    // Children must be on the next level and blocks inside the points, so queries need no checks
+    const auto *nodes = reinterpret_cast<const PointStoreNode *>(data + nodeOffset);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        bool isLeaf = level + 1 == levelCount;
+        uint64_t childStart = isLeaf ? 0 : levelStarts[level + 1];
+        uint64_t childEnd = isLeaf ? pointCount : levelStarts[level + 2];
+        for (auto i = levelStarts[level]; i < levelStarts[level + 1]; ++i) {
+            const auto &node = nodes[i];
+            if (node.count == 0 || node.first < childStart
+                || static_cast<uint64_t>(node.first) + node.count > childEnd
+                || (isLeaf && (node.count > blockCapacity || node.shift > kMaxShift))) {
+                return false;
+            }
+        }
+    }
+
+    pointCount_ = static_cast<size_t>(pointCount);
+    nodes_ = nodes;
+    offsets_ = reinterpret_cast<const PointStoreOffset *>(data + offsetOffset);
+    ids_ = reinterpret_cast<const uint32_t *>(data + idOffset);
+    levelStarts_ = std::move(levelStarts);
+    return true;
+}
+
+size_t PointStore::getBlockCount() const {
+    auto levelCount = getLevelCount();
+    return levelCount == 0 ? 0 : levelStarts_[levelCount] - levelStarts_[levelCount - 1];
+}
+
+size_t PointStore::decodeBlock(size_t block, std::vector<GeoPoint> &outPoints) const {
+    const auto &node = getBlocks()[block];
+    for (auto i = node.first; i < node.first + node.count; ++i) {
+        outPoints.push_back(decode(node, i));
+    }
+    return node.first;
+}
+
+GeoPoint PointStore::getPoint(size_t index) const {
+    // Blocks are in file order, the point's block is the last one that starts at or before it
+    const auto *blocks = getBlocks();
+    auto *end = blocks + getBlockCount();
+    auto *block = std::upper_bound(
+            blocks, end, index,
+            [](size_t value, const PointStoreNode &node) { return value < node.first; });
+    return decode(*(block - 1), index);
+}
+
+size_t PointStore::queryCap(
+        float latitude,
+        float longitude,
+        float radius,
+        std::vector<GeoPoint> &outPoints,
+        PointQueryStats *outStats) const {
+    Query query;
+    double radiusDegrees = std::max(radius, 0.f);
+    if (radiusDegrees >= 180.0) {
+        query.setRect(-90.0, -180.0, 90.0, 180.0);
+    } else {
+        query.isCap = true;
+        query.latitude = latitude * kDegreesToRadians;
+        query.longitude = longitude * kDegreesToRadians;
+        query.cosLatitude = std::cos(query.latitude);
+        auto sinHalfRadius = std::sin(radiusDegrees * kDegreesToRadians * 0.5);
+        query.haversineRadius = sinHalfRadius * sinHalfRadius;
+
+        // The cap's bounding rect, a little larger so rounding can't prune a point the exact test
+        // would take. A cap over a pole spans every longitude.
+        constexpr double kMargin = 1e-6;
+        double south = latitude - radiusDegrees - kMargin;
+        double north = latitude + radiusDegrees + kMargin;
+        if (south <= -90.0 || north >= 90.0) {
+            query.setRect(south, -180.0, north, 180.0);
+        } else {
+            auto ratio = std::sin(radiusDegrees * kDegreesToRadians) / query.cosLatitude;
+            auto halfWidth = std::asin(std::min(ratio, 1.0)) / kDegreesToRadians + kMargin;
+            query.setRect(south, longitude - halfWidth, north, longitude + halfWidth);
+        }
+    }
+
+    PointQueryStats stats;
+    auto before = outPoints.size();
+    run(query, outPoints, stats);
+    if (outStats) {
+        *outStats = stats;
+    }
+    return outPoints.size() - before;
+}
+
+size_t PointStore::queryRect(
+        const GeoRect &rect,
+        std::vector<GeoPoint> &outPoints,
+        PointQueryStats *outStats) const {
+    Query query;
+    query.setRect(rect.south, rect.west, rect.north, rect.east);
+
+    PointQueryStats stats;
+    auto before = outPoints.size();
+    run(query, outPoints, stats);
+    if (outStats) {
+        *outStats = stats;
+    }
+    return outPoints.size() - before;
+}
+
+void PointStore::run(
+        const Query &query,
+        std::vector<GeoPoint> &outPoints,
+        PointQueryStats &stats) const {
+    auto levelCount = getLevelCount();
+    if (levelCount == 0) {
+        return;
+    }
+    auto firstLeaf = levelStarts_[levelCount - 1];
+
+    // Depth first, so the points come out in file order
+    std::vector<size_t> stack = {0};
+    while (!stack.empty()) {
+        auto index = stack.back();
+        stack.pop_back();
+        const auto &node = nodes_[index];
+        stats.nodesVisited++;
+        if (!query.overlaps(node)) {
+            continue;
+        }
+
+        if (index < firstLeaf) {
+            for (auto child = node.first + node.count; child-- > node.first;) {
+                stack.push_back(child);
+            }
+            continue;
+        }
+
+        stats.blocksDecoded++;
+        stats.pointsTested += node.count;
+        bool inside = query.contains(node);
+        for (auto i = node.first; i < node.first + node.count; ++i) {
+            auto x = node.minX + (static_cast<uint32_t>(offsets_[i].x) << node.shift);
+            auto y = node.minY + (static_cast<uint32_t>(offsets_[i].y) << node.shift);
+            if (inside || query.matches(x, y)) {
+                outPoints.push_back(decode(node, i));
+            }
+        }
+    }
+}
+
+GeoPoint PointStore::decode(const PointStoreNode &block, size_t i) const {
+    auto x = block.minX + (static_cast<uint32_t>(offsets_[i].x) << block.shift);
+    auto y = block.minY + (static_cast<uint32_t>(offsets_[i].y) << block.shift);
+    GeoPoint point;
+    point.latitude = static_cast<float>(dequantizeLatitude(y));
+    point.longitude = static_cast<float>(dequantizeLongitude(x));
+    point.id = ids_[i];
+    return point;
+}
@@ -0,0 +1,215 @@
+#ifndef ANDROIDGLINVESTIGATIONS_POINTSTORE_H
+#define ANDROIDGLINVESTIGATIONS_POINTSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GeoCoordinates.h"
+
+/*!
+ * A point to store, or one a query found.
+ */
+struct GeoPoint {
+    //! degrees north and east
+    float latitude = 0.f;
+    float longitude = 0.f;
+
+    //! the caller's identifier, e.g. the row of the observation in its dataset
+    uint32_t id = 0;
+};
+
+/*!
+ * How @a PointStore::build lays out the blocks.
+ */
+struct PointStoreOptions {
+    //! the most points in one block, at most 65535
+    uint32_t blockCapacity = 1024;
+
+    //! blocks of the tree above them combined into one node
+    uint32_t fanout = 32;
+
+    /*!
+     * Blocks store points as 16 bit offsets from their corner in steps of 2^maxShift grid units,
+     * a block is closed early rather than need coarser steps. 10 keeps positions within 10 m.
+     */
+    uint32_t maxShift = 10;
+};
+
+/*!
+ * What a query touched, to tell how well the index pruned.
+ */
+struct PointQueryStats {
+    //! nodes of every level whose bounds were tested
+    size_t nodesVisited = 0;
+
+    //! blocks whose points were decoded
+    size_t blocksDecoded = 0;
+
+    //! points tested against the query, including those of blocks inside it
+    size_t pointsTested = 0;
+};
+
+/*!
+ * One node of the block tree as stored in the file. Bounds are in grid units, see
+ * @a PointStore::quantizeLongitude. A leaf is a block of points, @a first and @a count are a range
+ * of points, otherwise a range of nodes on the level below.
+ */
+struct PointStoreNode {
+    uint32_t minX;
+    uint32_t minY;
+    uint32_t maxX;
+    uint32_t maxY;
+    uint32_t first;
+    uint16_t count;
+
+    //! leaves only, the points' offsets from (minX, minY) are stored divided by 2^shift
+    uint8_t shift;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(PointStoreNode) == 24, "PointStoreNode is read straight from the file");
+
+/*!
+ * One point of a block as stored in the file: its offset from the block's corner, in steps of
+ * 2^shift grid units.
+ */
+struct PointStoreOffset {
+    uint16_t x;
+    uint16_t y;
+};
+
+/*!
+ * Millions of observation points in a read-only binary file, queried by region without loading
+ * or decoding all of it.
+ *
+ * Positions are quantized to a 2^32 x 2^32 grid over longitude and latitude and sorted along the
+ * Hilbert curve through that grid, so points that are close on the map are mostly close in the
+ * file. The sorted points are cut into blocks of up to @a PointStoreOptions::blockCapacity, each
+ * storing its points as 16 bit offsets from its own bounding box, 8 bytes per point with the id.
+ * On top of the blocks sits a packed R-tree: each level groups @a PointStoreOptions::fanout nodes
+ * of the level below under their common bounds, up to a single root. A query walks down the tree
+ * and only decodes the blocks whose bounds it overlaps.
+ *
+ * The file is used where it lies, mapped by @a MappedFile. It is little endian and its sections
+ * are 8 byte aligned. Platform independent, the builder tool shares it.
+ */
+class PointStore {
+public:
+    //! the file's first bytes
+    static constexpr char kMagic[8] = {'E', 'Z', 'P', 'O', 'I', 'N', 'T', 'S'};
+    static constexpr uint32_t kVersion = 1;
+
+    /*!
+     * @return the column of the grid @a longitude falls in, 0 at -180 degrees. Wraps around.
+     */
+    static uint32_t quantizeLongitude(double longitude);
+
+    /*!
+     * @return the row of the grid nearest to @a latitude, 0 at the south pole. Clamped to the
+     *     poles.
+     */
+    static uint32_t quantizeLatitude(double latitude);
+
+    static double dequantizeLongitude(uint32_t x);
+
+    static double dequantizeLatitude(uint32_t y);
+
+    /*!
+     * @return the distance of the cell (x, y) along the Hilbert curve that fills the whole grid
+     */
+    static uint64_t getHilbertKey(uint32_t x, uint32_t y);
+
+    /*!
+     * Sorts @a points along the Hilbert curve and serializes them with the block tree.
+     *
+     * @return the file contents
+     */
+    static std::vector<uint8_t> build(
+            const std::vector<GeoPoint> &points,
+            const PointStoreOptions &options = PointStoreOptions());
+
+    PointStore();
+
+    /*!
+     * Validates a store file held in memory and makes it the one queried. Nothing is copied, the
+     * memory must outlive the queries. On failure the store is left empty.
+     *
+     * @param data must be 4 byte aligned, like a mapping or the buffer of an uncompressed asset
+     * @return false if the file is malformed or of a newer version
+     */
+    bool attach(const uint8_t *data, size_t size);
+
+    inline size_t getPointCount() const { return pointCount_; }
+
+    //! @return how many blocks the points are stored in
+    size_t getBlockCount() const;
+
+    /*!
+     * Appends the points of a block to @a outPoints, in file order. Walking every block this way
+     * decodes the whole store in one pass without a query.
+     *
+     * @param block from 0 to @a getBlockCount, in file order
+     * @return the index in file order of the block's first point
+     */
+    size_t decodeBlock(size_t block, std::vector<GeoPoint> &outPoints) const;
+
+    /*!
+     * @return the point at @a index in file order, its block is found with a binary search
+     */
+    GeoPoint getPoint(size_t index) const;
+
+    //! @return levels of the block tree, the blocks are the last one
+    inline size_t getLevelCount() const {
+        return levelStarts_.empty() ? 0 : levelStarts_.size() - 1;
+    }
+
+    /*!
+     * Appends every point within @a radius of a centre to @a outPoints, in file order.
+     *
+     * @param radius great circle distance in degrees, 180 or more covers the globe
+     * @param outStats if not null, receives what the query touched
+     * @return how many points were appended
+     */
+    size_t queryCap(
+            float latitude,
+            float longitude,
+            float radius,
+            std::vector<GeoPoint> &outPoints,
+            PointQueryStats *outStats = nullptr) const;
+
+    /*!
+     * Appends every point inside @a rect to @a outPoints, in file order. The edges are inclusive
+     * and compared on the grid.
+     *
+     * @param outStats if not null, receives what the query touched
+     * @return how many points were appended
+     */
+    size_t queryRect(
+            const GeoRect &rect,
+            std::vector<GeoPoint> &outPoints,
+            PointQueryStats *outStats = nullptr) const;
+
+private:
+    struct Query;
+
+    void run(const Query &query, std::vector<GeoPoint> &outPoints, PointQueryStats &stats) const;
+
+    //! @return point @a i of the file, which lies in @a block
+    GeoPoint decode(const PointStoreNode &block, size_t i) const;
+
+    //! @return the first leaf, the blocks follow it in file order
+    inline const PointStoreNode *getBlocks() const {
+        return nodes_ + levelStarts_[getLevelCount() - 1];
+    }
+
+    size_t pointCount_;
+    const PointStoreNode *nodes_;
+    const PointStoreOffset *offsets_;
+    const uint32_t *ids_;
+
+    //! the first node of each level, root first, and one past the last leaf
+    std::vector<size_t> levelStarts_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_POINTSTORE_H
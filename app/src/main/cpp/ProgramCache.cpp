@@ -0,0 +1,224 @@
+#include "ProgramCache.h"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "AndroidOut.h"
+
+namespace {
+
+constexpr uint32_t kEntryMagic = 0x42505a45; // "EZPB"
+constexpr uint32_t kEntryVersion = 1;
+
+/*!
+ * The fixed header in front of every cached binary.
+ */
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    uint64_t binaryChecksum;
+    int64_t buildNanos;
+};
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+uint64_t fnv1a(const void *data, size_t length, uint64_t hash = kFnvOffsetBasis) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+uint64_t hashString(const std::string &string, uint64_t hash) {
+    // Hash the terminator too so "ab" + "c" and "a" + "bc" differ
+    return fnv1a(string.c_str(), string.size() + 1, hash);
+}
+
+uint64_t computeKey(
+        const std::string &driverIdentity,
+        const std::string &vertexSource,
+        const std::string &fragmentSource) {
+    auto hash = hashString(driverIdentity, kFnvOffsetBasis);
+    hash = hashString(vertexSource, hash);
+    return hashString(fragmentSource, hash);
+}
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string glString(GLenum name) {
+    auto *value = reinterpret_cast<const char *>(glGetString(name));
+    return value ? value : "";
+}
+
+} // namespace
+
+ProgramCache::ProgramCache(std::string directory) :
+        directory_(std::move(directory)),
+        initialized_(false),
+        enabled_(false) {}
+
+bool ProgramCache::isEnabled() {
+    initialize();
+    return enabled_;
+}
+
+void ProgramCache::initialize() {
+    if (initialized_) {
+        return;
+    }
+    initialized_ = true;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        aout << "ProgramCache: no program binary formats, caching disabled" << std::endl;
+        return;
+    }
+
+    if (directory_.empty()
+        || (mkdir(directory_.c_str(), 0700) != 0 && errno != EEXIST)) {
+        aout << "ProgramCache: can't use '" << directory_ << "', caching disabled" << std::endl;
+        return;
+    }
+
+    driverIdentity_ = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n'
+                      + glString(GL_VERSION);
+    enabled_ = true;
+}
+
+std::string ProgramCache::getEntryPath(
+        const std::string &vertexSource,
+        const std::string &fragmentSource) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin",
+             static_cast<unsigned long long>(
+                     computeKey(driverIdentity_, vertexSource, fragmentSource)));
+    return directory_ + name;
+}
+
+GLuint ProgramCache::loadProgram(const std::string &vertexSource, const std::string &fragmentSource) {
+    if (!isEnabled()) {
+        return 0;
+    }
+
+    auto start = nowNanos();
+    auto path = getEntryPath(vertexSource, fragmentSource);
+    auto key = computeKey(driverIdentity_, vertexSource, fragmentSource);
+
+    auto *file = fopen(path.c_str(), "rb");
+    if (!file) {
+        stats_.misses++;
+        return 0;
+    }
+
+    EntryHeader header{};
+    std::vector<uint8_t> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && header.magic == kEntryMagic
+                 && header.version == kEntryVersion
+                 && header.key == key
+                 && header.binaryLength > 0;
+    if (valid) {
+        binary.resize(header.binaryLength);
+        valid = fread(binary.data(), binary.size(), 1, file) == 1
+                && fnv1a(binary.data(), binary.size()) == header.binaryChecksum;
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), header.binaryLength);
+
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (!program) {
+        // Corrupt, stale or refused by the driver. Drop it, the caller rebuilds and stores anew.
+        aout << "ProgramCache: rejected " << path << std::endl;
+        remove(path.c_str());
+        stats_.rejected++;
+        stats_.misses++;
+        return 0;
+    }
+
+    stats_.hits++;
+    stats_.savedNanos += header.buildNanos - (nowNanos() - start);
+    return program;
+}
+
+void ProgramCache::storeProgram(
+        const std::string &vertexSource,
+        const std::string &fragmentSource,
+        GLuint program,
+        int64_t buildNanos) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<uint8_t> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) {
+        return;
+    }
+    binary.resize(length);
+
+    EntryHeader header{};
+    header.magic = kEntryMagic;
+    header.version = kEntryVersion;
+    header.key = computeKey(driverIdentity_, vertexSource, fragmentSource);
+    header.binaryFormat = format;
+    header.binaryLength = static_cast<uint32_t>(binary.size());
+    header.binaryChecksum = fnv1a(binary.data(), binary.size());
+    header.buildNanos = buildNanos;
+
+    // Write to a temporary file and rename it into place so a crash never leaves half an entry
+    auto path = getEntryPath(vertexSource, fragmentSource);
+    auto tempPath = path + ".tmp";
+    auto *file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(binary.data(), binary.size(), 1, file) == 1;
+    written = (fclose(file) == 0) && written;
+
+    if (written && rename(tempPath.c_str(), path.c_str()) == 0) {
+        stats_.stores++;
+    } else {
+        remove(tempPath.c_str());
+    }
+}
+
+void ProgramCache::logStats() const {
+    aout << "ProgramCache: " << stats_.hits << " hits, "
+         << stats_.misses << " misses ("
+         << stats_.rejected << " rejected), "
+         << stats_.stores << " stored, saved "
+         << static_cast<double>(stats_.savedNanos) / 1e6 << "ms" << std::endl;
+}
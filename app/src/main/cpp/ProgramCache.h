@@ -0,0 +1,89 @@
+#ifndef ANDROIDGLINVESTIGATIONS_PROGRAMCACHE_H
+#define ANDROIDGLINVESTIGATIONS_PROGRAMCACHE_H
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+
+/*!
+ * Hit/miss counters of a @a ProgramCache.
+ */
+struct ProgramCacheStats {
+    //! programs restored from a cached binary
+    uint32_t hits = 0;
+
+    //! programs with no usable cache entry that had to be compiled
+    uint32_t misses = 0;
+
+    //! cached binaries the driver refused to load, these are counted as misses too
+    uint32_t rejected = 0;
+
+    //! binaries written to the cache
+    uint32_t stores = 0;
+
+    //! compile and link time avoided by hits, minus the time spent loading them
+    int64_t savedNanos = 0;
+};
+
+/*!
+ * An on-disk cache of linked GL program binaries, built on glGetProgramBinary/glProgramBinary.
+ * Entries are keyed by a hash of the shader sources and the GL_VENDOR, GL_RENDERER and GL_VERSION
+ * strings, so a driver update naturally invalidates them. A binary the driver rejects anyway is
+ * deleted and the caller compiles from source as usual.
+ *
+ * Must be used on a thread with a current GL context.
+ */
+class ProgramCache {
+public:
+    /*!
+     * @param directory where to keep the binaries. It's created if it doesn't exist.
+     */
+    explicit ProgramCache(std::string directory);
+
+    /*!
+     * Looks up a cached binary for the given sources and loads it into a new program.
+     *
+     * @return a linked program, or 0 if there's no entry or the driver rejected it
+     */
+    GLuint loadProgram(const std::string &vertexSource, const std::string &fragmentSource);
+
+    /*!
+     * Stores the binary of a freshly linked program. The program must have been linked with
+     * GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+     *
+     * @param buildNanos how long compiling and linking took, used to report the time hits save
+     */
+    void storeProgram(
+            const std::string &vertexSource,
+            const std::string &fragmentSource,
+            GLuint program,
+            int64_t buildNanos);
+
+    /*!
+     * @return false if the driver supports no binary formats, in which case nothing is cached
+     */
+    bool isEnabled();
+
+    inline const ProgramCacheStats &getStats() const { return stats_; }
+
+    /*!
+     * Writes the stats to logcat.
+     */
+    void logStats() const;
+
+private:
+    /*!
+     * Reads the driver identity once a context is current.
+     */
+    void initialize();
+
+    std::string getEntryPath(const std::string &vertexSource, const std::string &fragmentSource);
+
+    std::string directory_;
+    std::string driverIdentity_;
+    bool initialized_;
+    bool enabled_;
+    ProgramCacheStats stats_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_PROGRAMCACHE_H
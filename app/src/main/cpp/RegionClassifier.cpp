@@ -0,0 +1,312 @@
+#include "RegionClassifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// The kernel tests four points at a time in the primitives of Simd4.h
+#include "Simd4.h"
+
+namespace {
+
+//! edges flatter than this never cross a ray, like the app's polygon test
+constexpr float kMinEdgeHeight = 0.00001f;
+
+//! slack for the edges a cell keeps, so rounding at its borders can't lose one
+constexpr float kCellMargin = 1e-6f;
+
+//! an edge of an outline on the map, in (u, v)
+struct MapEdge {
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+};
+
+//! an outline, or a copy of it shifted by a whole turn, and its edges
+struct Part {
+    uint16_t region;
+    std::vector<MapEdge> edges;
+};
+
+/*!
+ * Splits @a regions into parts that lie within the map. An outline crossing the antimeridian is
+ * unwrapped so its corners are continuous, then shifted by a turn to cover both sides.
+ */
+std::vector<Part> makeParts(const std::vector<RegionOutline> &regions) {
+    std::vector<Part> parts;
+    for (const auto &region: regions) {
+        auto pointCount = region.points.size() / 2;
+        if (region.id == RegionRaster::kNoRegion || pointCount < 3) {
+            continue;
+        }
+        std::vector<float> u(pointCount);
+        std::vector<float> v(pointCount);
+        for (size_t i = 0; i < pointCount; ++i) {
+            u[i] = region.points[2 * i];
+            v[i] = region.points[2 * i + 1];
+            if (i > 0) {
+                u[i] -= std::round(u[i] - u[i - 1]);
+            }
+        }
+        auto uMin = *std::min_element(u.begin(), u.end());
+        auto uMax = *std::max_element(u.begin(), u.end());
+        for (auto shift = std::ceil(-uMax); shift < 1.f - uMin; shift += 1.f) {
+            Part part;
+            part.region = region.id;
+            for (size_t i = 0, j = pointCount - 1; i < pointCount; j = i++) {
+                if (std::fabs(v[j] - v[i]) > kMinEdgeHeight) {
+                    part.edges.push_back({u[i] + shift, v[i], u[j] + shift, v[j]});
+                }
+            }
+            parts.push_back(std::move(part));
+        }
+    }
+    return parts;
+}
+
+//! @return the index of the lowest set bit of a non-zero @a bits
+inline int getLowestBit(uint32_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctz(bits);
+#else
+    int index = 0;
+    while (!(bits & 1u)) {
+        bits >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/*!
+ * Finds the (u, v) of the map at a latitude and longitude, u wrapped into [0, 1).
+ *
+ * @return false for a NaN or infinite coordinate, which is on no map. The (u, v) are then 0 so
+ *     they still index a cell.
+ */
+inline bool toMap(float latitude, float longitude, float &outU, float &outV) {
+    if (!std::isfinite(latitude) || !std::isfinite(longitude)) {
+        outU = 0.f;
+        outV = 0.f;
+        return false;
+    }
+    auto u = (longitude + 180.f) / 360.f;
+    outU = u - std::floor(u);
+    outV = std::clamp((90.f - latitude) / 180.f, 0.f, 1.f);
+    return true;
+}
+
+} // namespace
+
+RegionClassifier::RegionClassifier(
+        const std::vector<RegionOutline> &regions,
+        const RegionClassifierOptions &options) :
+        columns_(std::max(options.columns, 1)),
+        rows_(std::max(options.rows, 1)) {
+    auto parts = makeParts(regions);
+
+    cells_.resize(static_cast<size_t>(columns_) * static_cast<size_t>(rows_));
+    std::vector<const MapEdge *> partEdges;
+    for (int row = 0; row < rows_; ++row) {
+        auto top = static_cast<float>(row) / static_cast<float>(rows_) - kCellMargin;
+        auto bottom = static_cast<float>(row + 1) / static_cast<float>(rows_) + kCellMargin;
+        for (int column = 0; column < columns_; ++column) {
+            auto west = static_cast<float>(column) / static_cast<float>(columns_) - kCellMargin;
+            auto &cell = cells_[static_cast<size_t>(row) * columns_ + column];
+            cell.firstGroup = static_cast<uint32_t>(groups_.size());
+            cell.groupCount = 0;
+
+            // The edges a ray from a point of the cell towards the east can cross, by outline.
+            // Parts keep their order, so the lowest bit of a group is the first outline.
+            for (size_t partIndex = 0; partIndex < parts.size(); ++partIndex) {
+                const auto &part = parts[partIndex];
+                partEdges.clear();
+                for (const auto &edge: part.edges) {
+                    if (std::max(edge.v0, edge.v1) >= top && std::min(edge.v0, edge.v1) <= bottom
+                        && std::max(edge.u0, edge.u1) >= west) {
+                        partEdges.push_back(&edge);
+                    }
+                }
+                if (partEdges.empty()) {
+                    continue;
+                }
+
+                if (cell.groupCount == 0 || regions_.size() - groups_.back().firstRegion
+                                            == static_cast<size_t>(kGroupSize)) {
+                    groups_.push_back({static_cast<uint32_t>(edgeU0_.size()), 0,
+                                       static_cast<uint32_t>(regions_.size())});
+                    cell.groupCount++;
+                }
+                auto &group = groups_.back();
+                auto bit = 1u << (regions_.size() - group.firstRegion);
+                regions_.push_back(part.region);
+                for (const auto *edge: partEdges) {
+                    edgeU0_.push_back(edge->u0);
+                    edgeV0_.push_back(edge->v0);
+                    edgeV1_.push_back(edge->v1);
+                    edgeSlope_.push_back((edge->u1 - edge->u0) / (edge->v1 - edge->v0));
+                    edgeBit_.push_back(bit);
+                    group.edgeCount++;
+                }
+            }
+        }
+    }
+}
+
+int RegionClassifier::getCell(float u, float v) const {
+    auto column = std::min(static_cast<int>(u * static_cast<float>(columns_)), columns_ - 1);
+    auto row = std::min(static_cast<int>(v * static_cast<float>(rows_)), rows_ - 1);
+    return row * columns_ + column;
+}
+
+uint16_t RegionClassifier::classify(float latitude, float longitude) const {
+    float u;
+    float v;
+    if (!toMap(latitude, longitude, u, v)) {
+        return RegionRaster::kNoRegion;
+    }
+    uint16_t region;
+    classifyCell(cells_[getCell(u, v)], &u, &v, 1, &region);
+    return region;
+}
+
+void RegionClassifier::classify(
+        const float *latLon,
+        size_t count,
+        uint16_t *outRegions,
+        int threadCount) const {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+    auto chunkCount = std::clamp<size_t>(
+            count / kMinPointsPerThread, 1, static_cast<size_t>(threadCount));
+    auto chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // Every thread buckets and classifies its own contiguous share, they share nothing but the
+    // index. The calling thread takes the first share.
+    std::vector<std::thread> threads;
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+        auto first = std::min(chunk * chunkSize, count);
+        auto size = std::min(chunkSize, count - first);
+        threads.emplace_back([this, latLon, outRegions, first, size]() {
+            classifyRange(latLon + 2 * first, size, outRegions + first);
+        });
+    }
+    classifyRange(latLon, std::min(chunkSize, count), outRegions);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+void RegionClassifier::classifyRange(
+        const float *latLon,
+        size_t count,
+        uint16_t *outRegions) const {
+    // Bucket the points by cell with a counting sort, so each cell's edges are loaded once for
+    // all of its points. A slice at a time keeps the scratch arrays in the cache.
+    auto sliceSize = std::min(count, kSliceSize);
+    std::vector<float> u(sliceSize);
+    std::vector<float> v(sliceSize);
+    std::vector<uint32_t> cellOf(sliceSize);
+    std::vector<uint32_t> order(sliceSize);
+    std::vector<float> sortedU(sliceSize);
+    std::vector<float> sortedV(sliceSize);
+    std::vector<uint16_t> sortedRegions(sliceSize);
+
+    // Points that aren't on the map go to a bucket after the last cell
+    auto invalidBucket = cells_.size();
+    std::vector<uint32_t> cellStart(cells_.size() + 2);
+    std::vector<uint32_t> next(cells_.size() + 1);
+
+    for (size_t sliceFirst = 0; sliceFirst < count; sliceFirst += kSliceSize) {
+        auto size = std::min(kSliceSize, count - sliceFirst);
+        const auto *sliceLatLon = latLon + 2 * sliceFirst;
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        for (size_t i = 0; i < size; ++i) {
+            cellOf[i] = toMap(sliceLatLon[2 * i], sliceLatLon[2 * i + 1], u[i], v[i])
+                        ? static_cast<uint32_t>(getCell(u[i], v[i]))
+                        : static_cast<uint32_t>(invalidBucket);
+            cellStart[cellOf[i] + 1]++;
+        }
+        for (size_t cell = 0; cell <= invalidBucket; ++cell) {
+            cellStart[cell + 1] += cellStart[cell];
+        }
+
+        std::copy(cellStart.begin(), cellStart.end() - 1, next.begin());
+        for (size_t i = 0; i < size; ++i) {
+            auto slot = next[cellOf[i]]++;
+            order[slot] = static_cast<uint32_t>(i);
+            sortedU[slot] = u[i];
+            sortedV[slot] = v[i];
+        }
+
+        for (size_t cell = 0; cell < cells_.size(); ++cell) {
+            auto first = cellStart[cell];
+            auto end = cellStart[cell + 1];
+            if (first < end) {
+                classifyCell(cells_[cell], &sortedU[first], &sortedV[first], end - first,
+                             &sortedRegions[first]);
+            }
+        }
+        std::fill(sortedRegions.begin() + cellStart[invalidBucket],
+                  sortedRegions.begin() + cellStart[invalidBucket + 1], RegionRaster::kNoRegion);
+        for (size_t slot = 0; slot < size; ++slot) {
+            outRegions[sliceFirst + order[slot]] = sortedRegions[slot];
+        }
+    }
+}
+
+void RegionClassifier::classifyCell(
+        const Cell &cell,
+        const float *u,
+        const float *v,
+        size_t count,
+        uint16_t *outRegions) const {
+    float blockU[4];
+    float blockV[4];
+    uint32_t parity[4];
+    for (size_t first = 0; first < count; first += 4) {
+        // The last block repeats its last point in the lanes past the end
+        auto lanes = std::min<size_t>(4, count - first);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            auto source = first + std::min(lane, lanes - 1);
+            blockU[lane] = u[source];
+            blockV[lane] = v[source];
+        }
+        auto pointU = load(blockU);
+        auto pointV = load(blockV);
+
+        uint16_t found[4] = {RegionRaster::kNoRegion, RegionRaster::kNoRegion,
+                             RegionRaster::kNoRegion, RegionRaster::kNoRegion};
+        size_t unresolved = lanes;
+        for (uint32_t groupIndex = 0; groupIndex < cell.groupCount && unresolved > 0;
+             ++groupIndex) {
+            const auto &group = groups_[cell.firstGroup + groupIndex];
+
+            // An edge flips a point's bit if the point's row is between its ends and the edge is
+            // east of the point there: the app's test, for four points at once
+            auto bits = zeroMask();
+            auto end = group.firstEdge + group.edgeCount;
+            for (auto edge = group.firstEdge; edge < end; ++edge) {
+                auto v0 = splat(edgeV0_[edge]);
+                auto straddles = maskXor(greater(v0, pointV),
+                                         greater(splat(edgeV1_[edge]), pointV));
+                auto crossing = madd(sub(pointV, v0), splat(edgeSlope_[edge]),
+                                     splat(edgeU0_[edge]));
+                auto east = greater(crossing, pointU);
+                bits = maskXor(bits, maskAnd(maskAnd(straddles, east),
+                                             splatMask(edgeBit_[edge])));
+            }
+
+            storeMask(parity, bits);
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                if (found[lane] == RegionRaster::kNoRegion && parity[lane] != 0) {
+                    found[lane] = regions_[group.firstRegion + getLowestBit(parity[lane])];
+                    unresolved--;
+                }
+            }
+        }
+        std::copy(found, found + lanes, outRegions + first);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef ANDROIDGLINVESTIGATIONS_REGIONCLASSIFIER_H
+#define ANDROIDGLINVESTIGATIONS_REGIONCLASSIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RegionRaster.h"
+
+/*!
+ * How @a RegionClassifier indexes its outlines.
+ */
+struct RegionClassifierOptions {
+    //! cells of the index around the globe and from pole to pole
+    int columns = 64;
+    int rows = 32;
+};
+
+/*!
+ * Tags points with the region they're in, for millions of points at a time. Gives the answer of
+ * InteractiveEarthView's polygon test for every outline in order, the first that contains a point
+ * wins, without testing every edge of every outline per point.
+ *
+ * The outlines are indexed in a grid over the equirectangular map. A point can only be inside an
+ * outline if an edge of it crosses the ray from the point towards the east, so each cell keeps the
+ * edges that pass through its row east of its western border. Points are bucketed by cell and
+ * tested four at a time against the cell's edges with NEON or SSE.
+ *
+ * Outlines that cross the antimeridian, with neighbouring corners more than half the map apart,
+ * are unwrapped and indexed on both sides of it. Longitudes of the points wrap around as well.
+ * Edges are straight on the map like the app's outlines, not great circles.
+ *
+ * Immutable once built, any number of threads can classify with it. Platform independent.
+ */
+class RegionClassifier {
+public:
+    //! batches below this many points per thread aren't worth another thread
+    static constexpr size_t kMinPointsPerThread = 16384;
+
+    /*!
+     * @param regions like @a RegionRaster::bake takes them
+     */
+    explicit RegionClassifier(const std::vector<RegionOutline> &regions,
+                              const RegionClassifierOptions &options = RegionClassifierOptions());
+
+    /*!
+     * @return the region containing a point in degrees, @a RegionRaster::kNoRegion if none does
+     *     or a coordinate is NaN or infinite
+     */
+    uint16_t classify(float latitude, float longitude) const;
+
+    /*!
+     * Classifies a batch of points, split across threads.
+     *
+     * @param latLon @a count (latitude, longitude) pairs in degrees
+     * @param outRegions receives a region id per point, @a RegionRaster::kNoRegion for points
+     *     with a NaN or infinite coordinate
+     * @param threadCount 0 for one per core
+     */
+    void classify(const float *latLon, size_t count, uint16_t *outRegions,
+                  int threadCount = 0) const;
+
+    //! @return edges over all cells, the index's size
+    inline size_t getIndexedEdgeCount() const { return edgeU0_.size(); }
+
+private:
+    //! outlines a cell keeps edges of, in one pass of the kernel: one bit of the parity each
+    static constexpr int kGroupSize = 32;
+
+    //! points a thread buckets by cell at a time
+    static constexpr size_t kSliceSize = 65536;
+
+    //! a run of a cell's edges for up to @a kGroupSize outlines
+    struct EdgeGroup {
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+        //! the outline of bit i is at firstRegion + i of regions_
+        uint32_t firstRegion;
+    };
+
+    struct Cell {
+        uint32_t firstGroup;
+        uint32_t groupCount;
+    };
+
+    int getCell(float u, float v) const;
+
+    /*!
+     * Classifies @a count points of one cell, in (u, v) of the map.
+     */
+    void classifyCell(const Cell &cell, const float *u, const float *v, size_t count,
+                      uint16_t *outRegions) const;
+
+    //! one thread's share of @a classify
+    void classifyRange(const float *latLon, size_t count, uint16_t *outRegions) const;
+
+    int columns_;
+    int rows_;
+    std::vector<Cell> cells_;
+    std::vector<EdgeGroup> groups_;
+    std::vector<uint16_t> regions_;
+
+    // The edges of every group, structure of arrays for the kernel: where the edge starts, how
+    // much u changes per v, the rows it spans and the parity bit it flips
+    std::vector<float> edgeU0_;
+    std::vector<float> edgeV0_;
+    std::vector<float> edgeV1_;
+    std::vector<float> edgeSlope_;
+    std::vector<uint32_t> edgeBit_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_REGIONCLASSIFIER_H
@@ -0,0 +1,46 @@
+#include <jni.h>
+
+#include "Continents.h"
+#include "RegionClassifier.h"
+
+namespace {
+
+//! built on first use, then shared by every call
+const RegionClassifier &getContinentClassifier() {
+    static const RegionClassifier classifier(getContinentOutlines());
+    return classifier;
+}
+
+} // namespace
+
+extern "C" {
+
+/*!
+ * com.pykens.earthzoo.analytics.RegionClassifier.nativeClassify: tags points with the continent
+ * they're on. Both buffers have to be direct so the points are read in place.
+ *
+ * @param points (latitude, longitude) pairs in degrees
+ * @param count the number of points
+ * @param regions receives a @a Continent per point, 0 for none
+ * @return @a count, or -1 if a buffer isn't direct or is too small
+ */
+JNIEXPORT jint JNICALL
+Java_com_pykens_earthzoo_analytics_RegionClassifier_nativeClassify(
+        JNIEnv *env, jclass, jobject points, jint count, jobject regions) {
+    if (count < 0) {
+        return -1;
+    }
+    auto *latLon = static_cast<const float *>(env->GetDirectBufferAddress(points));
+    auto *outRegions = static_cast<uint16_t *>(env->GetDirectBufferAddress(regions));
+    auto pointCount = static_cast<jlong>(count);
+    if (!latLon || !outRegions
+        || env->GetDirectBufferCapacity(points) < 2 * pointCount
+        || env->GetDirectBufferCapacity(regions) < pointCount) {
+        return -1;
+    }
+
+    getContinentClassifier().classify(latLon, static_cast<size_t>(count), outRegions);
+    return count;
+}
+
+}
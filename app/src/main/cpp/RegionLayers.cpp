@@ -0,0 +1,61 @@
+#include "RegionLayers.h"
+
+#include <cstdint>
+
+RegionLayers::RegionLayers(GlStateCache &stateCache, const RegionRaster &regions) :
+        regionTexture_(0),
+        placeholderField_(0) {
+    stateCache.selectUploadUnit();
+
+    // Ids must not be blended between cells, and integer textures can't be filtered anyway
+    glGenTextures(1, &regionTexture_);
+    glBindTexture(GL_TEXTURE_2D, regionTexture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16UI, regions.getWidth(), regions.getHeight());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0,
+            0,
+            regions.getWidth(),
+            regions.getHeight(),
+            GL_RED_INTEGER,
+            GL_UNSIGNED_SHORT,
+            regions.getCells().data());
+
+    static constexpr uint8_t kFar[4] = {255, 255, 255, 255};
+    glGenTextures(1, &placeholderField_);
+    glBindTexture(GL_TEXTURE_2D, placeholderField_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, kFar);
+}
+
+RegionLayers::~RegionLayers() {
+    glDeleteTextures(1, &regionTexture_);
+    glDeleteTextures(1, &placeholderField_);
+}
+
+void RegionLayers::setBoundaryField(
+        GlStateCache &stateCache,
+        std::shared_ptr<TextureAsset> spBoundaryField) {
+    // Loaded textures clamp, sampling across the edges of the map has to wrap like the regions do
+    stateCache.selectUploadUnit();
+    glBindTexture(GL_TEXTURE_2D, spBoundaryField->getTextureID());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    spBoundaryField_ = std::move(spBoundaryField);
+}
+
+void RegionLayers::bind(GlStateCache &stateCache, GLuint regionUnit, GLuint fieldUnit) const {
+    stateCache.bindTexture(regionUnit, GL_TEXTURE_2D, regionTexture_);
+    stateCache.bindTexture(
+            fieldUnit,
+            GL_TEXTURE_2D,
+            spBoundaryField_ ? spBoundaryField_->getTextureID() : placeholderField_);
+}
@@ -0,0 +1,60 @@
+#ifndef ANDROIDGLINVESTIGATIONS_REGIONLAYERS_H
+#define ANDROIDGLINVESTIGATIONS_REGIONLAYERS_H
+
+#include <GLES3/gl3.h>
+#include <memory>
+
+#include "GlStateCache.h"
+#include "RegionRaster.h"
+#include "TextureAsset.h"
+
+/*!
+ * The textures the globe's fragment shader composites over the imagery to show the selected
+ * region: which region every place belongs to and how far it is from the nearest boundary.
+ *
+ * The region ids are a @a RegionRaster uploaded once as an R16UI texture, sampled without
+ * filtering. The boundary field is a @a DistanceField of the boundary lines in its red channel,
+ * made by tools/sdfgen and loaded like any other texture. The shader draws the outline where the
+ * distance is small, a fixed number of screen pixels wide at any zoom. Until it's set a
+ * placeholder that's far from every boundary stands in, there's a highlight but no outline. Both
+ * cover the equirectangular map with its top row at the north pole, like the imagery.
+ *
+ * Neither texture depends on the selection, the shader compares the ids against a uniform. A new
+ * selection is one uniform write. Must be created and destroyed with a current GL context.
+ */
+class RegionLayers {
+public:
+    /*!
+     * Uploads @a regions' cells. The raster isn't referenced afterwards.
+     */
+    RegionLayers(GlStateCache &stateCache, const RegionRaster &regions);
+
+    ~RegionLayers();
+
+    RegionLayers(const RegionLayers &) = delete;
+    RegionLayers &operator=(const RegionLayers &) = delete;
+
+    /*!
+     * Replaces the placeholder with the boundary field once it finished loading. The field is
+     * made to repeat horizontally, its distances run on across the antimeridian.
+     */
+    void setBoundaryField(GlStateCache &stateCache, std::shared_ptr<TextureAsset> spBoundaryField);
+
+    inline bool hasBoundaryField() const { return spBoundaryField_ != nullptr; }
+
+    /*!
+     * Binds the region ids and the boundary field for drawing.
+     *
+     * @param regionUnit, fieldUnit the texture units the shader's samplers read
+     */
+    void bind(GlStateCache &stateCache, GLuint regionUnit, GLuint fieldUnit) const;
+
+private:
+    GLuint regionTexture_;
+
+    //! a texel as far from a boundary as the field encodes, until the boundary field is loaded
+    GLuint placeholderField_;
+    std::shared_ptr<TextureAsset> spBoundaryField_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_REGIONLAYERS_H
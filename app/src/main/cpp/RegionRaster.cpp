@@ -0,0 +1,102 @@
+#include "RegionRaster.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+//! edges flatter than this don't cross a row, like the app's polygon test
+constexpr float kMinEdgeHeight = 0.00001f;
+
+float getCellCenter(int cell, int cellCount) {
+    return (static_cast<float>(cell) + 0.5f) / static_cast<float>(cellCount);
+}
+
+/*!
+ * @return the first of @a cellCount cells whose centre isn't left of @a position, in
+ *     [0, cellCount]. Settled with the same float comparison a point test would make.
+ */
+int getFirstCellFrom(float position, int cellCount) {
+    auto cell = std::clamp(
+            static_cast<int>(std::ceil(position * static_cast<float>(cellCount) - 0.5f)),
+            0, cellCount);
+    while (cell > 0 && getCellCenter(cell - 1, cellCount) >= position) {
+        --cell;
+    }
+    while (cell < cellCount && getCellCenter(cell, cellCount) < position) {
+        ++cell;
+    }
+    return cell;
+}
+
+} // namespace
+
+RegionRaster RegionRaster::bake(
+        const std::vector<RegionOutline> &regions,
+        int width,
+        int height) {
+    RegionRaster raster;
+    if (width <= 0 || height <= 0) {
+        return raster;
+    }
+    raster.width_ = width;
+    raster.height_ = height;
+    raster.cells_.assign(static_cast<size_t>(width) * static_cast<size_t>(height), kNoRegion);
+
+    // One scanline per row through the cell centres. The edges an outline crosses it at, sorted,
+    // pair up into the spans inside.
+    std::vector<float> crossings;
+    for (int y = 0; y < height; ++y) {
+        auto v = getCellCenter(y, height);
+        auto *row = &raster.cells_[static_cast<size_t>(y) * static_cast<size_t>(width)];
+        for (const auto &region: regions) {
+            auto pointCount = region.points.size() / 2;
+            if (region.id == kNoRegion || pointCount < 3) {
+                continue;
+            }
+            crossings.clear();
+            for (size_t i = 0, j = pointCount - 1; i < pointCount; j = i++) {
+                auto ui = region.points[2 * i];
+                auto vi = region.points[2 * i + 1];
+                auto uj = region.points[2 * j];
+                auto vj = region.points[2 * j + 1];
+                auto denominator = vj - vi;
+                if ((vi > v) != (vj > v) && std::fabs(denominator) > kMinEdgeHeight) {
+                    crossings.push_back(ui + (v - vi) / denominator * (uj - ui));
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            // A centre is inside if an odd number of crossings lie to its right
+            for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+                auto first = getFirstCellFrom(crossings[i], width);
+                auto end = getFirstCellFrom(crossings[i + 1], width);
+                for (auto x = first; x < end; ++x) {
+                    if (row[x] == kNoRegion) {
+                        row[x] = region.id;
+                    }
+                }
+            }
+        }
+    }
+    return raster;
+}
+
+RegionRaster::RegionRaster() : width_(0), height_(0) {}
+
+uint16_t RegionRaster::getRegion(float latitude, float longitude) const {
+    return getRegionAt((longitude + 180.f) / 360.f, (90.f - latitude) / 180.f);
+}
+
+uint16_t RegionRaster::getRegionAt(float u, float v) const {
+    if (cells_.empty()) {
+        return kNoRegion;
+    }
+    auto x = static_cast<int>(std::floor(u * static_cast<float>(width_))) % width_;
+    if (x < 0) {
+        x += width_;
+    }
+    auto y = std::clamp(static_cast<int>(std::floor(v * static_cast<float>(height_))),
+                        0, height_ - 1);
+    return cells_[static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(x)];
+}
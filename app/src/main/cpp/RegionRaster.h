@@ -0,0 +1,65 @@
+#ifndef ANDROIDGLINVESTIGATIONS_REGIONRASTER_H
+#define ANDROIDGLINVESTIGATIONS_REGIONRASTER_H
+
+#include <cstdint>
+#include <vector>
+
+/*!
+ * The outline of a region of the map, e.g. a continent.
+ */
+struct RegionOutline {
+    //! what the raster holds inside the region, not @a RegionRaster::kNoRegion
+    uint16_t id = 0;
+
+    //! the corners as (u, v) pairs of the equirectangular map in [0, 1], like the texture
+    //! coordinates: u = (longitude + 180) / 360 and v = (90 - latitude) / 180
+    std::vector<float> points;
+};
+
+/*!
+ * Which region every place on the globe belongs to, as an equirectangular grid of region ids.
+ * Looking up a place samples one cell, the cost doesn't depend on how many regions there are or
+ * how detailed their outlines are.
+ *
+ * Baked from the outlines with the even-odd rule at the centre of each cell, the same test the
+ * app's polygons use, so a cell belongs to a region exactly if its centre does. Where outlines
+ * overlap the one listed first wins. Platform independent, the cells are laid out to be uploaded
+ * as an R16UI texture.
+ */
+class RegionRaster {
+public:
+    //! the id of cells outside every region
+    static constexpr uint16_t kNoRegion = 0;
+
+    /*!
+     * @param width cells around the globe, @a height from pole to pole. Twice as wide as high
+     *     makes them square in degrees.
+     */
+    static RegionRaster bake(const std::vector<RegionOutline> &regions, int width, int height);
+
+    RegionRaster();
+
+    /*!
+     * @return the region at a latitude and longitude in degrees, longitudes wrap around
+     */
+    uint16_t getRegion(float latitude, float longitude) const;
+
+    /*!
+     * @return the region at (u, v) of the map, u wraps around and v is clamped to [0, 1]
+     */
+    uint16_t getRegionAt(float u, float v) const;
+
+    inline int getWidth() const { return width_; }
+
+    inline int getHeight() const { return height_; }
+
+    //! the rows from the north pole down, @a getWidth cells each
+    inline const std::vector<uint16_t> &getCells() const { return cells_; }
+
+private:
+    int width_;
+    int height_;
+    std::vector<uint16_t> cells_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_REGIONRASTER_H
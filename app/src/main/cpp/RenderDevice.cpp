@@ -0,0 +1,184 @@
+#include "RenderDevice.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+#include "AndroidOut.h"
+
+RenderDevice::RenderDevice() :
+        display_(EGL_NO_DISPLAY),
+        config_(nullptr),
+        context_(EGL_NO_CONTEXT),
+        pbufferSurface_(EGL_NO_SURFACE),
+        windowSurface_(EGL_NO_SURFACE),
+        contextLost_(false) {
+    // Choose your render attributes. The pbuffer bit is needed for the offscreen surface that
+    // keeps the context current while there's no window.
+    constexpr EGLint attribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+            EGL_SURFACE_TYPE, EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
+            EGL_BLUE_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_RED_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+    };
+
+    // The default display is probably what you want on Android
+    auto display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(display, nullptr, nullptr);
+
+    // figure out how many configs there are
+    EGLint numConfigs;
+    eglChooseConfig(display, attribs, nullptr, 0, &numConfigs);
+
+    // get the list of configurations
+    std::unique_ptr<EGLConfig[]> supportedConfigs(new EGLConfig[numConfigs]);
+    eglChooseConfig(display, attribs, supportedConfigs.get(), numConfigs, &numConfigs);
+
+    // Find a config we like.
+    // Could likely just grab the first if we don't care about anything else in the config.
+    // Otherwise hook in your own heuristic
+    auto config = *std::find_if(
+            supportedConfigs.get(),
+            supportedConfigs.get() + numConfigs,
+            [&display](const EGLConfig &config) {
+                EGLint red, green, blue, depth;
+                if (eglGetConfigAttrib(display, config, EGL_RED_SIZE, &red)
+                    && eglGetConfigAttrib(display, config, EGL_GREEN_SIZE, &green)
+                    && eglGetConfigAttrib(display, config, EGL_BLUE_SIZE, &blue)
+                    && eglGetConfigAttrib(display, config, EGL_DEPTH_SIZE, &depth)) {
+
+                    aout << "Found config with " << red << ", " << green << ", " << blue << ", "
+                         << depth << std::endl;
+                    return red == 8 && green == 8 && blue == 8 && depth == 24;
+                }
+                return false;
+            });
+
+    aout << "Found " << numConfigs << " configs" << std::endl;
+    aout << "Chose " << config << std::endl;
+
+    display_ = display;
+    config_ = config;
+
+    auto created = createContext();
+    assert(created);
+}
+
+RenderDevice::~RenderDevice() {
+    if (display_ != EGL_NO_DISPLAY) {
+        detachWindow();
+        releaseContext();
+        eglTerminate(display_);
+        display_ = EGL_NO_DISPLAY;
+    }
+}
+
+bool RenderDevice::attachWindow(ANativeWindow *window) {
+    detachWindow();
+
+    auto surface = eglCreateWindowSurface(display_, config_, window, nullptr);
+    if (surface == EGL_NO_SURFACE) {
+        aout << "eglCreateWindowSurface failed: " << eglGetError() << std::endl;
+        return false;
+    }
+
+    if (!makeCurrent(surface)) {
+        eglDestroySurface(display_, surface);
+        return false;
+    }
+    windowSurface_ = surface;
+    return true;
+}
+
+void RenderDevice::detachWindow() {
+    if (windowSurface_ == EGL_NO_SURFACE) {
+        return;
+    }
+
+    // Switch to the pbuffer first so the window surface isn't current when it's destroyed
+    makeCurrent(pbufferSurface_);
+    eglDestroySurface(display_, windowSurface_);
+    windowSurface_ = EGL_NO_SURFACE;
+}
+
+void RenderDevice::getSurfaceSize(EGLint &outWidth, EGLint &outHeight) const {
+    outWidth = 0;
+    outHeight = 0;
+    if (windowSurface_ != EGL_NO_SURFACE) {
+        eglQuerySurface(display_, windowSurface_, EGL_WIDTH, &outWidth);
+        eglQuerySurface(display_, windowSurface_, EGL_HEIGHT, &outHeight);
+    }
+}
+
+RenderDevice::PresentResult RenderDevice::present() {
+    if (eglSwapBuffers(display_, windowSurface_) == EGL_TRUE) {
+        return PresentResult::Presented;
+    }
+
+    auto error = eglGetError();
+    aout << "eglSwapBuffers failed: " << error << std::endl;
+    if (error == EGL_CONTEXT_LOST) {
+        contextLost_ = true;
+        return PresentResult::ContextLost;
+    }
+    return PresentResult::SurfaceLost;
+}
+
+bool RenderDevice::recreateContext() {
+    releaseContext();
+    if (createContext() && (windowSurface_ == EGL_NO_SURFACE || makeCurrent(windowSurface_))) {
+        return true;
+    }
+
+    // Don't leave a half made context behind, hasContext tells the caller to try again later
+    releaseContext();
+    return false;
+}
+
+bool RenderDevice::createContext() {
+    // Create a GLES 3 context
+    EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+    context_ = eglCreateContext(display_, config_, EGL_NO_CONTEXT, contextAttribs);
+    if (context_ == EGL_NO_CONTEXT) {
+        aout << "eglCreateContext failed: " << eglGetError() << std::endl;
+        return false;
+    }
+
+    EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    pbufferSurface_ = eglCreatePbufferSurface(display_, config_, pbufferAttribs);
+    if (pbufferSurface_ == EGL_NO_SURFACE) {
+        aout << "eglCreatePbufferSurface failed: " << eglGetError() << std::endl;
+        return false;
+    }
+
+    contextLost_ = false;
+    return makeCurrent(pbufferSurface_);
+}
+
+void RenderDevice::releaseContext() {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (pbufferSurface_ != EGL_NO_SURFACE) {
+        eglDestroySurface(display_, pbufferSurface_);
+        pbufferSurface_ = EGL_NO_SURFACE;
+    }
+    if (context_ != EGL_NO_CONTEXT) {
+        eglDestroyContext(display_, context_);
+        context_ = EGL_NO_CONTEXT;
+    }
+}
+
+bool RenderDevice::makeCurrent(EGLSurface surface) {
+    if (eglMakeCurrent(display_, surface, surface, context_) == EGL_TRUE) {
+        return true;
+    }
+
+    auto error = eglGetError();
+    aout << "eglMakeCurrent failed: " << error << std::endl;
+    if (error == EGL_CONTEXT_LOST) {
+        contextLost_ = true;
+    }
+    return false;
+}
@@ -0,0 +1,112 @@
+#ifndef ANDROIDGLINVESTIGATIONS_RENDERDEVICE_H
+#define ANDROIDGLINVESTIGATIONS_RENDERDEVICE_H
+
+#include <EGL/egl.h>
+
+struct ANativeWindow;
+
+/*!
+ * Owns the EGL display, config and GLES 3 context. The context outlives any window: while no
+ * window is attached a 1x1 pbuffer keeps it current, so GL objects created through it survive the
+ * app going to the background. Only the window surface is created and destroyed with the window.
+ *
+ * All methods must be called on the thread that created the device.
+ */
+class RenderDevice {
+public:
+    /*!
+     * The outcome of presenting a frame.
+     */
+    enum class PresentResult {
+        //! the frame was presented
+        Presented,
+        //! the window surface is no longer valid, wait for a new window
+        SurfaceLost,
+        //! the context was lost (e.g. after a GPU reset), every GL object is gone
+        ContextLost
+    };
+
+    /*!
+     * Initializes EGL and creates the context, current on an offscreen pbuffer.
+     */
+    RenderDevice();
+
+    /*!
+     * Destroys the context and terminates EGL. Release every GL object before this runs.
+     */
+    ~RenderDevice();
+
+    RenderDevice(const RenderDevice &) = delete;
+    RenderDevice &operator=(const RenderDevice &) = delete;
+
+    /*!
+     * Creates a window surface and makes it current. Any previously attached window is detached.
+     *
+     * @return false if the surface could not be created or made current. Check @a isContextLost to
+     * tell a lost context apart from a bad window.
+     */
+    bool attachWindow(ANativeWindow *window);
+
+    /*!
+     * Destroys the window surface and makes the pbuffer current again, keeping the context alive.
+     */
+    void detachWindow();
+
+    inline bool hasWindow() const { return windowSurface_ != EGL_NO_SURFACE; }
+
+    /*!
+     * @return false after @a releaseContext, or if @a recreateContext failed, until a context is
+     * created again
+     */
+    inline bool hasContext() const { return context_ != EGL_NO_CONTEXT; }
+
+    /*!
+     * Queries the current size of the window surface.
+     */
+    void getSurfaceSize(EGLint &outWidth, EGLint &outHeight) const;
+
+    /*!
+     * Presents the window surface. This is an implicit glFlush.
+     */
+    PresentResult present();
+
+    /*!
+     * @return true if the last EGL call on this device reported EGL_CONTEXT_LOST
+     */
+    inline bool isContextLost() const { return contextLost_; }
+
+    /*!
+     * Unbinds and destroys the context, e.g. after it was lost. GL objects of the old context can
+     * be dropped safely afterwards: with no context current their glDelete* calls are ignored
+     * rather than hitting names that a new context reuses.
+     */
+    void releaseContext();
+
+    /*!
+     * Creates a fresh context, current on the window surface if one is attached. Call
+     * @a releaseContext and drop every GL object first, then recreate them afterwards.
+     *
+     * @return true on success. On failure the device is left without a context.
+     */
+    bool recreateContext();
+
+private:
+    /*!
+     * Creates the context and the offscreen pbuffer and makes them current.
+     */
+    bool createContext();
+
+    /*!
+     * Makes @a surface current, recording a lost context if that's why it failed.
+     */
+    bool makeCurrent(EGLSurface surface);
+
+    EGLDisplay display_;
+    EGLConfig config_;
+    EGLContext context_;
+    EGLSurface pbufferSurface_;
+    EGLSurface windowSurface_;
+    bool contextLost_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_RENDERDEVICE_H
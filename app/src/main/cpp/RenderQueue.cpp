@@ -0,0 +1,74 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int kPassShift = 62;
+constexpr uint64_t kProgramMask = (1u << 14) - 1;
+constexpr uint64_t kTextureMask = (1u << 16) - 1;
+
+/*!
+ * The bits of a non-negative float sort the same way as its value, which makes them usable as an
+ * integer depth without picking a range or precision.
+ */
+uint32_t getDepthBits(float depth) {
+    if (!(depth > 0.f)) {
+        // Negative, zero and NaN
+        return 0;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+uint64_t RenderQueue::makeSortKey(
+        RenderPass pass,
+        uint32_t program,
+        uint32_t texture,
+        float depth) {
+    uint64_t key = static_cast<uint64_t>(pass) << kPassShift;
+    uint64_t state = ((program & kProgramMask) << 16) | (texture & kTextureMask);
+    uint64_t depthBits = getDepthBits(depth);
+
+    if (getPassState(pass).frontToBack) {
+        return key | (state << 32) | depthBits;
+    }
+    return key | ((~depthBits & 0xFFFFFFFFu) << 30) | state;
+}
+
+void RenderQueue::submit(
+        RenderPass pass,
+        uint32_t program,
+        uint32_t texture,
+        float depth,
+        DrawFunction draw) {
+    order_.emplace_back(
+            makeSortKey(pass, program, texture, depth),
+            static_cast<uint32_t>(draws_.size()));
+    draws_.push_back({pass, std::move(draw)});
+}
+
+void RenderQueue::execute(const std::function<void(RenderPass)> &beginPass) {
+    // The index breaks ties, equal keys keep their submission order
+    std::sort(order_.begin(), order_.end());
+
+    bool started = false;
+    auto currentPass = RenderPass::Opaque;
+    for (const auto &entry: order_) {
+        const auto &draw = draws_[entry.second];
+        if (!started || draw.pass != currentPass) {
+            beginPass(draw.pass);
+            currentPass = draw.pass;
+            started = true;
+        }
+        draw.draw();
+    }
+
+    // Keeps the capacity, a frame usually submits the same draws as the one before
+    draws_.clear();
+    order_.clear();
+}
@@ -0,0 +1,113 @@
+#ifndef ANDROIDGLINVESTIGATIONS_RENDERQUEUE_H
+#define ANDROIDGLINVESTIGATIONS_RENDERQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/*!
+ * The passes of a frame, drawn in this order.
+ */
+enum class RenderPass : uint8_t {
+    //! surfaces that cover what's behind them completely, front to back so hidden pixels are
+    //! rejected by the depth test before they're shaded
+    Opaque,
+    //! opaque surfaces whose edges fade out with alpha coverage, like the ray traced globe's limb.
+    //! Front to back like Opaque, but after it so the edges blend over what's already there.
+    Coverage,
+    //! overlays that blend with what's behind them, back to front so each blends over the ones
+    //! further away. They don't write depth, so they never hide each other.
+    Transparent,
+};
+
+constexpr size_t kRenderPassCount = 3;
+
+/*!
+ * The fixed function state a pass draws with. Anything not listed is the same for every pass.
+ */
+struct PassState {
+    bool blend;
+    bool depthWrite;
+    bool cullBackFaces;
+    //! false if the pass draws back to front
+    bool frontToBack;
+};
+
+constexpr PassState kPassStates[kRenderPassCount] = {
+        {false, true, true, true},
+        {true, true, true, true},
+        {true, false, false, false},
+};
+
+inline constexpr const PassState &getPassState(RenderPass pass) {
+    return kPassStates[static_cast<size_t>(pass)];
+}
+
+/*!
+ * Collects the draws of a frame and issues them sorted, so state changes and overdraw depend on
+ * what's in the scene rather than on the order it was submitted in.
+ *
+ * Every draw gets a 64-bit sort key, most significant first:
+ *  - the pass, 2 bits
+ *  - for front to back passes the program (14 bits), the texture (16 bits) and the depth (32
+ *    bits), so draws sharing state are adjacent and the nearest of them go first
+ *  - for back to front passes the inverted depth, then the program and texture, since the blend
+ *    order has to win over state changes
+ *
+ * Program and texture names are truncated to their fields, a collision only costs a state change.
+ * Platform independent, the queue never touches GL itself.
+ */
+class RenderQueue {
+public:
+    using DrawFunction = std::function<void()>;
+
+    /*!
+     * @param depth distance of the draw from the camera along the view direction, negative values
+     *     count as 0
+     */
+    static uint64_t makeSortKey(RenderPass pass, uint32_t program, uint32_t texture, float depth);
+
+    /*!
+     * Queues a draw for the next @a execute.
+     *
+     * @param program the GL program the draw uses
+     * @param texture its main texture, 0 if it has none
+     * @param depth as for @a makeSortKey
+     * @param draw issues the draw, called from @a execute
+     */
+    void submit(
+            RenderPass pass,
+            uint32_t program,
+            uint32_t texture,
+            float depth,
+            DrawFunction draw);
+
+    /*!
+     * Runs the queued draws in key order and empties the queue. Draws with equal keys run in the
+     * order they were submitted.
+     *
+     * @param beginPass called before the first draw of every pass that has draws, to apply the
+     *     pass's @a PassState
+     */
+    void execute(const std::function<void(RenderPass)> &beginPass);
+
+    /*!
+     * @return how many draws are queued
+     */
+    inline size_t getSize() const { return draws_.size(); }
+
+private:
+    struct Draw {
+        RenderPass pass;
+        DrawFunction draw;
+    };
+
+    std::vector<Draw> draws_;
+
+    //! (key, index into draws_), sorted instead of the draws so no function is moved around
+    std::vector<std::pair<uint64_t, uint32_t>> order_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_RENDERQUEUE_H
@@ -0,0 +1,260 @@
+#include "RenderThread.h"
+
+#include <android/looper.h>
+
+#include "AndroidOut.h"
+#include "FramePacer.h"
+#include "Renderer.h"
+
+RenderThread::RenderThread(AAssetManager *assetManager, std::string cacheDirectory) :
+        assetManager_(assetManager),
+        cacheDirectory_(std::move(cacheDirectory)),
+        nextSequence_(1),
+        looper_(nullptr),
+        acknowledgedSequence_(0) {
+    thread_ = std::thread(&RenderThread::threadMain, this);
+
+    // Wait for the looper so commands sent from now on can wake the thread up
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return looper_ != nullptr; });
+}
+
+RenderThread::~RenderThread() {
+    RenderCommand quit;
+    quit.type = RenderCommand::Type::Quit;
+    send(quit);
+    thread_.join();
+
+    ALooper_release(looper_);
+}
+
+void RenderThread::setWindow(ANativeWindow *window) {
+    RenderCommand command;
+    command.type = RenderCommand::Type::WindowCreated;
+    command.window = window;
+    sendAndWait(command);
+}
+
+void RenderThread::releaseWindow() {
+    RenderCommand command;
+    command.type = RenderCommand::Type::WindowDestroyed;
+    sendAndWait(command);
+}
+
+void RenderThread::addTouchEvent(const TouchEvent &event) {
+    // Only merge while the queue can't keep up, otherwise every historical sample gets through
+    if (pendingTouches_.size() >= kTouchQueueCapacity
+        && event.action == TouchEvent::Action::Move
+        && pendingTouches_.back().action == TouchEvent::Action::Move) {
+        pendingTouches_.back() = event;
+        return;
+    }
+    pendingTouches_.push_back(event);
+}
+
+void RenderThread::flushInput() {
+    if (pendingTouches_.empty()) {
+        return;
+    }
+
+    // If the render thread is behind, whatever doesn't fit waits for the next flush
+    size_t sent = 0;
+    while (sent < pendingTouches_.size() && touches_.push(pendingTouches_[sent])) {
+        sent++;
+    }
+    pendingTouches_.erase(pendingTouches_.begin(), pendingTouches_.begin() + sent);
+    ALooper_wake(looper_);
+}
+
+void RenderThread::requestRedraw() {
+    RenderCommand command;
+    command.type = RenderCommand::Type::Redraw;
+    send(command);
+}
+
+void RenderThread::cycleGlobeMode() {
+    RenderCommand command;
+    command.type = RenderCommand::Type::CycleGlobeMode;
+    send(command);
+}
+
+void RenderThread::send(const RenderCommand &command) {
+    while (!commands_.push(command)) {
+        ALooper_wake(looper_);
+        std::this_thread::yield();
+    }
+    ALooper_wake(looper_);
+}
+
+void RenderThread::sendAndWait(RenderCommand command) {
+    // Touches queued before a lifecycle change belong to the old window
+    flushInput();
+
+    command.sequence = nextSequence_++;
+    send(command);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this, &command] {
+        return acknowledgedSequence_ >= command.sequence;
+    });
+}
+
+void RenderThread::acknowledge(uint64_t sequence) {
+    if (sequence == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acknowledgedSequence_ = sequence;
+    }
+    condition_.notify_all();
+}
+
+void RenderThread::threadMain() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        looper_ = ALooper_prepare(0);
+        ALooper_acquire(looper_);
+    }
+    condition_.notify_all();
+
+    // The choreographer attaches to this thread's looper, so the pacer has to be created here
+    FramePacer framePacer;
+
+    // The renderer lives as long as the thread. It sets up EGL and loads every GPU resource right
+    // away, windows coming and going later only create and destroy a surface.
+    renderer_ = std::make_unique<Renderer>(assetManager_, cacheDirectory_);
+
+    bool running = true;
+    while (running) {
+        // Block until there is something to do. Commands from the android_app thread and the vsync
+        // callback both wake the looper.
+        bool wasIdle = !framePacer.isFrameScheduled();
+        int timeout = -1;
+        int64_t blockStart = FramePacer::nowNanos();
+
+        bool done = false;
+        while (!done) {
+            int result = ALooper_pollOnce(timeout, nullptr, nullptr, nullptr);
+            if (timeout != 0 && wasIdle) {
+                framePacer.addIdleTime(FramePacer::nowNanos() - blockStart);
+            }
+
+            // Something woke us up, drain anything else that's pending without blocking again.
+            timeout = 0;
+            switch (result) {
+                case ALOOPER_POLL_TIMEOUT:
+                    [[clang::fallthrough]];
+                case ALOOPER_POLL_WAKE:
+                    done = true;
+                    break;
+                case ALOOPER_POLL_ERROR:
+                    aout << "ALooper_pollOnce returned an error" << std::endl;
+                    done = true;
+                    break;
+                case ALOOPER_POLL_CALLBACK:
+                    // The choreographer delivers its vsync callback here
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        running = processCommands();
+
+        // A vsync may have arrived while there was no window to draw to, consume it either way so
+        // a stale frame isn't drawn later.
+        int64_t frameTimeNanos = 0;
+        bool frameReady = framePacer.consumeFrame(frameTimeNanos);
+
+        if (running && renderer_->hasWindow()) {
+            // Render a frame, but only when the display is ready for one and something changed.
+            // All touches since the last frame become a single camera update here.
+            if (frameReady) {
+                applyGestures(frameTimeNanos, framePacer.getVsyncPeriodNanos());
+                // A frame that wasn't presented doesn't count towards the pacing
+                if (renderer_->isSceneDirty() && renderer_->render()) {
+                    framePacer.frameRendered(frameTimeNanos);
+                }
+            }
+
+            // While the globe keeps changing, keep asking for the next vsync. Once the scene is
+            // clean and no gesture is moving, no callback is posted and the loop blocks in the
+            // looper on the next pass.
+            if (renderer_->isSceneDirty() || gestures_.needsFrame()) {
+                framePacer.requestFrame();
+            }
+        }
+    }
+
+    renderer_.reset();
+}
+
+bool RenderThread::processCommands() {
+    // Touches only update the gesture, the camera moves once per frame in applyGestures
+    TouchEvent touch;
+    while (touches_.pop(touch)) {
+        gestures_.onTouchEvent(touch);
+    }
+
+    RenderCommand command;
+    while (commands_.pop(command)) {
+        switch (command.type) {
+            case RenderCommand::Type::WindowCreated:
+                if (!renderer_->attachWindow(command.window)) {
+                    aout << "Could not attach the new window" << std::endl;
+                }
+                break;
+            case RenderCommand::Type::WindowDestroyed:
+                renderer_->detachWindow();
+                break;
+            case RenderCommand::Type::Redraw:
+                renderer_->requestRedraw();
+                break;
+            case RenderCommand::Type::CycleGlobeMode: {
+                auto mode = renderer_->getGlobeMode();
+                auto next = mode == GlobeMode::UvSphere ? GlobeMode::Chunked
+                            : mode == GlobeMode::Chunked ? GlobeMode::Impostor
+                            : GlobeMode::UvSphere;
+                renderer_->setGlobeMode(next);
+                break;
+            }
+            case RenderCommand::Type::Quit:
+                acknowledge(command.sequence);
+                return false;
+        }
+        acknowledge(command.sequence);
+    }
+    return true;
+}
+
+void RenderThread::applyGestures(int64_t frameTimeNanos, int64_t vsyncPeriodNanos) {
+    auto presentTimeNanos = frameTimeNanos + kPresentLatencyFrames * vsyncPeriodNanos;
+    auto motion = gestures_.update(frameTimeNanos, presentTimeNanos);
+    if (motion.dx != 0.f || motion.dy != 0.f) {
+        renderer_->rotate(motion.dx, motion.dy);
+    }
+    if (motion.distanceScale != 1.f) {
+        renderer_->zoom(motion.distanceScale);
+    }
+
+    // Picked against the frame on screen, before this frame's motion is drawn
+    float tapX;
+    float tapY;
+    if (gestures_.consumeTap(tapX, tapY)) {
+        renderer_->selectAt(tapX, tapY);
+    }
+
+    // One summary per gesture, once the fingers are up and the fling has settled
+    const auto &stats = gestures_.getStats();
+    if (stats.framesWithInput > 0 && !gestures_.isTouching() && !gestures_.needsFrame()) {
+        auto frames = static_cast<double>(stats.framesWithInput);
+        aout << "GestureEngine: " << stats.samples << " samples in "
+             << stats.framesWithInput << " frames, " << stats.flingFrames << " fling frames, "
+             << "touch->photon avg " << stats.totalTouchToPhotonNanos / frames / 1e6
+             << "ms max " << static_cast<double>(stats.maxTouchToPhotonNanos) / 1e6
+             << "ms, predicted avg " << stats.totalPredictionNanos / frames / 1e6 << "ms"
+             << std::endl;
+        gestures_.resetStats();
+    }
+}
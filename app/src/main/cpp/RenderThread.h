@@ -0,0 +1,168 @@
+#ifndef ANDROIDGLINVESTIGATIONS_RENDERTHREAD_H
+#define ANDROIDGLINVESTIGATIONS_RENDERTHREAD_H
+
+#include <android/asset_manager.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GestureEngine.h"
+#include "SpscQueue.h"
+
+struct ALooper;
+struct ANativeWindow;
+class Renderer;
+
+/*!
+ * A message from the android_app thread to the render thread.
+ */
+struct RenderCommand {
+    enum class Type {
+        //! a window is available, start rendering into it
+        WindowCreated,
+        //! the window is going away, stop using it
+        WindowDestroyed,
+        //! the window contents need to be presented again
+        Redraw,
+        //! switch to the next GlobeMode, for comparing the render paths
+        CycleGlobeMode,
+        //! leave the render loop
+        Quit
+    };
+
+    Type type = Type::Redraw;
+    ANativeWindow *window = nullptr;
+
+    //! identifies commands the sender waits on, see @a RenderThread::sendAndWait
+    uint64_t sequence = 0;
+};
+
+/*!
+ * Runs the @a Renderer on a dedicated thread that owns the EGL context. The android_app thread
+ * only translates input and lifecycle events into @a TouchEvent samples and @a RenderCommand
+ * messages, which reach the render thread through lock-free single producer/single consumer
+ * queues. A slow frame therefore never delays input draining, and an input burst never delays a
+ * frame. Touches go through a @a GestureEngine on the render thread, which turns everything that
+ * arrived before a vsync into that frame's camera motion.
+ *
+ * Everything public except the constructor and destructor must be called from the android_app
+ * thread, which is the only producer of the queue.
+ */
+class RenderThread {
+public:
+    /*!
+     * Starts the render thread. It creates the renderer right away, but idles until a window is
+     * attached with @a setWindow.
+     *
+     * @param assetManager used by the renderer to load its assets
+     * @param cacheDirectory the app's cache directory, used for the shader program cache
+     */
+    RenderThread(AAssetManager *assetManager, std::string cacheDirectory);
+
+    /*!
+     * Stops the render loop, destroys the renderer and joins the thread.
+     */
+    ~RenderThread();
+
+    RenderThread(const RenderThread &) = delete;
+    RenderThread &operator=(const RenderThread &) = delete;
+
+    /*!
+     * Attaches @a window to the renderer. Returns once the render thread has created a surface
+     * for it.
+     */
+    void setWindow(ANativeWindow *window);
+
+    /*!
+     * Detaches the window from the renderer, keeping its GPU resources alive. Returns once the
+     * render thread no longer uses the window, so it's safe to return from APP_CMD_TERM_WINDOW
+     * afterwards.
+     */
+    void releaseWindow();
+
+    /*!
+     * Queues a touch sample for the render thread. Samples wait on this side until @a flushInput
+     * manages to hand them over. While the render thread is behind, consecutive moves are merged
+     * into the newest one, so a full queue costs velocity detail but never position.
+     */
+    void addTouchEvent(const TouchEvent &event);
+
+    /*!
+     * Hands the queued touch samples to the render thread and wakes it up.
+     */
+    void flushInput();
+
+    /*!
+     * Asks the render thread to present a new frame even though nothing moved.
+     */
+    void requestRedraw();
+
+    /*!
+     * Asks the render thread to draw the globe the next way in @a GlobeMode.
+     */
+    void cycleGlobeMode();
+
+private:
+    //! capacity of the command queue, input has its own so this rarely fills up
+    static constexpr size_t kQueueCapacity = 64;
+
+    //! capacity of the touch queue, a few frames of samples from a fast touch screen
+    static constexpr size_t kTouchQueueCapacity = 256;
+
+    //! frames from a vsync until the frame rendered for it is on screen
+    static constexpr int kPresentLatencyFrames = 2;
+
+    /*!
+     * Pushes @a command, waking the render thread and retrying until there's room in the queue.
+     */
+    void send(const RenderCommand &command);
+
+    /*!
+     * Sends @a command and blocks until the render thread has processed it.
+     */
+    void sendAndWait(RenderCommand command);
+
+    void threadMain();
+
+    /*!
+     * Drains the command queue on the render thread.
+     *
+     * @return false once a quit command was received
+     */
+    bool processCommands();
+
+    /*!
+     * Applies the gestures' motion for the frame of @a frameTimeNanos to the renderer.
+     */
+    void applyGestures(int64_t frameTimeNanos, int64_t vsyncPeriodNanos);
+
+    void acknowledge(uint64_t sequence);
+
+    AAssetManager *assetManager_;
+    std::string cacheDirectory_;
+    SpscQueue<RenderCommand, kQueueCapacity> commands_;
+    SpscQueue<TouchEvent, kTouchQueueCapacity> touches_;
+
+    // producer side state, only touched on the android_app thread
+    std::vector<TouchEvent> pendingTouches_;
+    uint64_t nextSequence_;
+
+    // render thread state
+    std::unique_ptr<Renderer> renderer_;
+    GestureEngine gestures_;
+
+    // The render thread's looper is published once during startup, the mutex and condition
+    // variable also back the blocking lifecycle commands. Input never waits on them.
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    ALooper *looper_;
+    uint64_t acknowledgedSequence_;
+
+    std::thread thread_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_RENDERTHREAD_H
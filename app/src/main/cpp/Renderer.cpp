@@ -1,17 +1,25 @@
 #include "Renderer.h"
 
-#include <game-activity/native_app_glue/android_native_app_glue.h>
+#include <android/asset_manager.h>
+#include <android/looper.h>
+#include <android/native_window.h>
 #include <GLES3/gl3.h>
 #include <algorithm>
 #include <cmath>
 #include <iterator>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <vector>
-#include <android/keycodes.h>
 
 #include "AndroidOut.h"
+#include "Continents.h"
+#include "GeoCoordinates.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "PointStore.h"
 #include "Shader.h"
+#include "ShaderSources.h"
 #include "Utility.h"
 #include "TextureAsset.h"
 
@@ -40,242 +48,396 @@ aout << std::endl;\
 //! Color for cornflower blue. Can be sent directly to glClearColor
 #define CORNFLOWER_BLUE 100 / 255.f, 149 / 255.f, 237 / 255.f, 1
 
-// Vertex shader, you'd typically load this from assets
-static const char *vertex = R"vertex(#version 300 es
-in vec3 inPosition;
-in vec2 inUV;
-
-out vec2 fragUV;
-out vec3 fragNormal;
-
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
-
-void main() {
-    vec4 worldPos = uModel * vec4(inPosition, 1.0);
-    mat3 normalMatrix = mat3(uView * uModel);
-    fragNormal = normalize(normalMatrix * normalize(inPosition));
-    fragUV = vec2(inUV.x, 1.0 - inUV.y);
-    gl_Position = uProjection * uView * worldPos;
-}
-)vertex";
-
-// Fragment shader, you'd typically load this from assets
-static const char *fragment = R"fragment(#version 300 es
-precision mediump float;
-
-in vec2 fragUV;
-in vec3 fragNormal;
-
-uniform sampler2D uTexture;
-uniform vec3 uLightDir;
-
-out vec4 outColor;
-
-void main() {
-    vec3 baseColor = texture(uTexture, fragUV).rgb;
-    vec3 normal = normalize(fragNormal);
-    float diffuse = max(dot(normal, normalize(uLightDir)), 0.0);
-    float ambient = 0.3;
-    float brightness = clamp(ambient + diffuse * 0.7, 0.0, 1.0);
-    vec3 litColor = baseColor * brightness;
-    float rim = pow(1.0 - max(dot(normal, vec3(0.0, 0.0, -1.0)), 0.0), 2.0);
-    litColor += vec3(0.05, 0.1, 0.2) * rim;
-    outColor = vec4(litColor, 1.0);
-}
-)fragment";
-
 static constexpr float kPi = 3.14159265358979323846f;
 static constexpr float kFieldOfViewRadians = 60.f * kPi / 180.f;
 static constexpr float kNearPlane = 0.1f;
 static constexpr float kFarPlane = 20.f;
-static constexpr float kCameraDistance = 3.0f;
+//! pinch zoom range, the closest keeps the near plane well clear of the surface
+static constexpr float kMinCameraDistance = 1.2f;
+static constexpr float kMaxCameraDistance = 8.0f;
 static constexpr float kMaxPitchRadians = 1.3f;
 
+//! how the globe's vertices are stored. Its positions are on the unit sphere, so snorm16 loses
+//! nothing visible and the UVs fit half floats. 12 bytes per vertex instead of 20.
+static const VertexFormat kGlobeVertexFormat{
+        PositionFormat::Snorm16,
+        UvFormat::Half2,
+        NormalFormat::None,
+        false};
+
+//! quads along each edge of a globe chunk
+static constexpr int kChunkGridSize = 16;
+
+//! the finest chunk level, about 40 m per quad on an Earth sized globe
+static constexpr int kChunkMaxLevel = 14;
+
+//! chunks are refined until the flat triangles are at most this many pixels off the sphere
+static constexpr float kChunkMaxPixelError = 1.f;
+
+//! how many rendered frames pass between two frame timing reports in logcat
+static constexpr int64_t kFrameReportInterval = 600;
+
+//! how many bytes of texture data are uploaded per frame while assets are streaming in
+static constexpr size_t kTextureUploadBudgetBytes = 2 * 1024 * 1024;
+
+//! where the imagery pyramid lives in the assets
+static constexpr const char *kTileDirectory = "tiles";
+
+//! GPU memory the resident imagery tiles may take, mipmaps included
+static constexpr size_t kTileCacheBudgetBytes = 32 * 1024 * 1024;
+
+//! how many bytes of tiles are uploaded per frame, about three 256px tiles
+static constexpr size_t kTileUploadBudgetBytes = 1024 * 1024;
+
+// Texture units of the tiled imagery, unit 0 is the model's own texture
+static constexpr GLint kTileAtlasUnit = 1;
+static constexpr GLint kTileIndirectionUnit = 2;
+
+// Texture units of the selection's layers, see RegionLayers
+static constexpr GLint kRegionIdUnit = 3;
+static constexpr GLint kBoundaryFieldUnit = 4;
+
+/*!
+ * the distance field of the boundary lines drawn around the selected region, made from
+ * res/drawable/boundries.png by "sdfgen --lines". Block compression would garble the distances,
+ * there are no KTX2 variants.
+ */
+static constexpr const char *kBoundaryFieldAsset = "boundaries_sdf.png";
+
+//! how wide the selected region's outline is drawn, in screen pixels
+static constexpr float kOutlineWidthPixels = 3.f;
+
+//! the observations shown on the globe, there are none if it isn't in the assets
+static constexpr const char *kObservationAsset = "observations.ezpts";
+
+//! clusters are picked so their markers are at least this many pixels apart
+static constexpr float kClusterSpacingPixels = 48.f;
+
+//! cells of the continent raster picking looks up, about a third of a degree each
+static constexpr int kRegionRasterWidth = 1024;
+static constexpr int kRegionRasterHeight = 512;
+
+//! towards the light in view space, w is unused. Never changes, it's uploaded once.
+static constexpr Vec4 kLightDirection{0.3f, 0.6f, -1.0f, 0.f};
+
 Renderer::~Renderer() {
-    if (display_ != EGL_NO_DISPLAY) {
-        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-        if (context_ != EGL_NO_CONTEXT) {
-            eglDestroyContext(display_, context_);
-            context_ = EGL_NO_CONTEXT;
-        }
-        if (surface_ != EGL_NO_SURFACE) {
-            eglDestroySurface(display_, surface_);
-            surface_ = EGL_NO_SURFACE;
+    // GPU resources have to go while their context is still alive, device_ is destroyed last
+    releaseGpuResources();
+
+    // Joins the worker, nothing wakes the looper after this
+    clusterBuilder_.reset();
+    if (clusterLooper_) {
+        ALooper_release(clusterLooper_);
+    }
+}
+
+bool Renderer::attachWindow(ANativeWindow *window) {
+    auto start = FrameProfiler::nowNanos();
+
+    // A context that couldn't be recreated after a loss gets another try with every new window
+    if (!device_.hasContext() && !handleContextLoss()) {
+        return false;
+    }
+
+    if (!device_.attachWindow(window)) {
+        if (!device_.isContextLost() || !handleContextLoss() || !device_.attachWindow(window)) {
+            return false;
         }
-        eglTerminate(display_);
-        display_ = EGL_NO_DISPLAY;
     }
+
+    // make width and height invalid so it gets updated the first frame in @a updateRenderArea()
+    width_ = -1;
+    height_ = -1;
+    redrawRequested_ = true;
+
+    aout << "Window attached in " << (FrameProfiler::nowNanos() - start) / 1e6 << "ms"
+         << std::endl;
+    return true;
 }
 
-void Renderer::render() {
+void Renderer::detachWindow() {
+    device_.detachWindow();
+}
+
+bool Renderer::render() {
     // Check to see if the surface has changed size. This is _necessary_ to do every frame when
     // using immersive mode as you'll get no other notification that your renderable area has
     // changed.
     updateRenderArea();
 
-    shader_->activate();
+    frameProfiler_->beginFrame();
+
+    // Feed the next slice of any texture that finished decoding in the background. The uploads
+    // bind the textures directly, on a unit that's never drawn with.
+    stateCache_.selectUploadUnit();
+    textureLoader_->uploadPending(kTextureUploadBudgetBytes);
+    if (tileCache_ && tileCache_->uploadPending(kTileUploadBudgetBytes)) {
+        // New detail may let the selection refine further
+        tilesNeedUpdate_ = true;
+    }
+    frameProfiler_->endStage(FrameStage::Upload);
+
+    shader_->activate(stateCache_);
+
+    // A new selection is a single uniform, the layers it's drawn from never change
+    if (selectionNeedsUpdate_) {
+        glUniform1ui(selectedRegionUniform_, selectedRegion_);
+        selectionNeedsUpdate_ = false;
+    }
 
     // When the renderable area changes, the projection matrix has to also be updated.
     if (shaderNeedsNewProjectionMatrix_) {
-        Utility::buildPerspectiveMatrix(
-                projectionMatrix_.data(),
+        projectionMatrix_ = Mat4::perspective(
                 kFieldOfViewRadians,
                 float(width_) / float(height_),
                 kNearPlane,
                 kFarPlane);
         shaderNeedsNewProjectionMatrix_ = false;
-        shader_->setProjectionMatrix(projectionMatrix_.data());
+        auto &camera = cameraUniforms_->edit();
+        camera.projection = projectionMatrix_;
+        camera.viewport = {
+                float(width_), float(height_), 1.f / float(width_), 1.f / float(height_)};
+        tilesNeedUpdate_ = true;
+        chunksNeedUpdate_ = true;
+        clustersNeedUpdate_ = true;
     }
 
+    bool cameraMoved = viewNeedsUpdate_ || modelNeedsUpdate_;
     if (viewNeedsUpdate_) {
-        Utility::buildIdentityMatrix(viewMatrix_.data());
-        viewMatrix_[12] = 0.f;
-        viewMatrix_[13] = 0.f;
-        viewMatrix_[14] = -kCameraDistance;
-        shader_->setViewMatrix(viewMatrix_.data());
+        viewMatrix_ = Mat4::translation({0.f, 0.f, -cameraDistance_});
+        cameraUniforms_->edit().view = viewMatrix_;
         viewNeedsUpdate_ = false;
+        tilesNeedUpdate_ = true;
+        chunksNeedUpdate_ = true;
+        clustersNeedUpdate_ = true;
     }
 
     if (modelNeedsUpdate_) {
-        float rotationX[16];
-        float rotationY[16];
-        Utility::buildRotationMatrixX(rotationX, rotationX_);
-        Utility::buildRotationMatrixY(rotationY, rotationY_);
-        Utility::multiplyMatrix(modelMatrix_.data(), rotationY, rotationX);
-        shader_->setModelMatrix(modelMatrix_.data());
+        modelMatrix_ = Mat4::rotationY(rotationY_) * Mat4::rotationX(rotationX_);
+        globeUniforms_->edit().model = modelMatrix_;
         modelNeedsUpdate_ = false;
+        tilesNeedUpdate_ = true;
+        chunksNeedUpdate_ = true;
+        clustersNeedUpdate_ = true;
+    }
+
+    if (cameraMoved) {
+        // The markers' horizon test runs in model space
+        globeUniforms_->edit().cameraPosition = Vec4(getCameraPosition(), 1.f);
     }
 
-    const float lightDir[3] = {0.3f, 0.6f, -1.0f};
-    shader_->setLightDirection(lightDir);
+    if (tileCache_ && tilesNeedUpdate_) {
+        updateVisibleTiles();
+        tilesNeedUpdate_ = false;
+    }
+
+    if (globeMesh_ && chunksNeedUpdate_) {
+        globeMesh_->update(getCameraView());
+        chunksNeedUpdate_ = false;
+    }
 
-    // clear the buffers
+    // The markers show the clusters picked for this view, so they're uploaded once those are
+    updateClusterMarkers();
+    markerLayer_->upload(markers_);
+
+    // Only the blocks that changed are uploaded, a still frame uploads nothing
+    cameraUniforms_->flush(stateCache_);
+    globeUniforms_->flush(stateCache_);
+    frameProfiler_->endStage(FrameStage::Matrices);
+
+    if (tileCache_) {
+        tileCache_->bind(stateCache_, kTileAtlasUnit, kTileIndirectionUnit);
+    }
+    regionLayers_->bind(stateCache_, kRegionIdUnit, kBoundaryFieldUnit);
+
+    // clear the buffers. The last pass of the previous frame may have turned depth writes off,
+    // which masks the clear as well.
+    stateCache_.setDepthMask(true);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Render all the models.
-    if (!models_.empty()) {
-        for (const auto &model: models_) {
-            shader_->drawModel(model);
+    submitScene();
+    renderQueue_.execute([this](RenderPass pass) { beginPass(pass); });
+    frameProfiler_->endGpuWork();
+    frameProfiler_->endStage(FrameStage::Draw);
+
+    // Present the rendered image. This is an implicit glFlush.
+    auto presentResult = device_.present();
+    frameProfiler_->endStage(FrameStage::Swap);
+    redrawRequested_ = false;
+
+    if (presentResult != RenderDevice::PresentResult::Presented) {
+        // The frame never reached the screen, its timings would only skew the next frame's
+        frameProfiler_->discardFrame();
+        if (presentResult == RenderDevice::PresentResult::ContextLost) {
+            // Everything has to be rebuilt, the profiler included
+            handleContextLoss();
+        } else {
+            // Drawing into it would only fail again. Without a window the render thread stops
+            // asking for frames, the next attachWindow brings a new surface and redraws.
+            aout << "Window surface lost, waiting for a new window" << std::endl;
+            device_.detachWindow();
         }
+        return false;
     }
 
-    // Present the rendered image. This is an implicit glFlush.
-    auto swapResult = eglSwapBuffers(display_, surface_);
-    assert(swapResult == EGL_TRUE);
+    frameProfiler_->endFrame();
+    if (frameProfiler_->getFrameCount() % kFrameReportInterval == 0) {
+        frameProfiler_->logReport();
+        if (tileCache_) {
+            tileCache_->logStats();
+        }
+        if (globeMesh_) {
+            globeMesh_->logStats();
+        }
+        markerLayer_->logStats(markers_, getCameraPosition());
+        if (clusterTree_) {
+            aout << "Clusters: " << clusterTree_->getPointCount() << " observations shown as "
+                 << visibleClusters_.size() << " markers" << std::endl;
+        }
+        stateCache_.logStats();
+        aout << "Uniform blocks uploaded: camera " << cameraUniforms_->getUploadCount()
+             << ", globe " << globeUniforms_->getUploadCount() << " times in "
+             << frameProfiler_->getFrameCount() << " frames" << std::endl;
+    }
+    return true;
 }
 
 void Renderer::initRenderer() {
-    // Choose your render attributes
-    constexpr EGLint attribs[] = {
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-            EGL_BLUE_SIZE, 8,
-            EGL_GREEN_SIZE, 8,
-            EGL_RED_SIZE, 8,
-            EGL_DEPTH_SIZE, 24,
-            EGL_NONE
-    };
-
-    // The default display is probably what you want on Android
-    auto display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    eglInitialize(display, nullptr, nullptr);
-
-    // figure out how many configs there are
-    EGLint numConfigs;
-    eglChooseConfig(display, attribs, nullptr, 0, &numConfigs);
-
-    // get the list of configurations
-    std::unique_ptr<EGLConfig[]> supportedConfigs(new EGLConfig[numConfigs]);
-    eglChooseConfig(display, attribs, supportedConfigs.get(), numConfigs, &numConfigs);
-
-    // Find a config we like.
-    // Could likely just grab the first if we don't care about anything else in the config.
-    // Otherwise hook in your own heuristic
-    auto config = *std::find_if(
-            supportedConfigs.get(),
-            supportedConfigs.get() + numConfigs,
-            [&display](const EGLConfig &config) {
-                EGLint red, green, blue, depth;
-                if (eglGetConfigAttrib(display, config, EGL_RED_SIZE, &red)
-                    && eglGetConfigAttrib(display, config, EGL_GREEN_SIZE, &green)
-                    && eglGetConfigAttrib(display, config, EGL_BLUE_SIZE, &blue)
-                    && eglGetConfigAttrib(display, config, EGL_DEPTH_SIZE, &depth)) {
-
-                    aout << "Found config with " << red << ", " << green << ", " << blue << ", "
-                         << depth << std::endl;
-                    return red == 8 && green == 8 && blue == 8 && depth == 24;
-                }
-                return false;
-            });
+    PRINT_GL_STRING(GL_VENDOR);
+    PRINT_GL_STRING(GL_RENDERER);
+    PRINT_GL_STRING(GL_VERSION);
+    PRINT_GL_STRING_AS_LIST(GL_EXTENSIONS);
 
-    aout << "Found " << numConfigs << " configs" << std::endl;
-    aout << "Chose " << config << std::endl;
+    // Nothing is known about a new context
+    stateCache_.invalidate();
+
+    frameProfiler_ = std::make_unique<FrameProfiler>();
+    textureLoader_ = std::make_unique<TextureLoader>(assetManager_);
+
+    cameraUniforms_ = std::make_unique<UniformBuffer<CameraUniforms>>(
+            stateCache_, kCameraBlockBinding);
+    globeUniforms_ = std::make_unique<UniformBuffer<GlobeUniforms>>(
+            stateCache_, kGlobeBlockBinding);
+    globeUniforms_->edit().lightDirection = kLightDirection;
+
+    int maxTileLevel;
+    int tileSize;
+    if (TileCache::readManifest(assetManager_, kTileDirectory, maxTileLevel, tileSize)) {
+        tileCache_ = std::make_unique<TileCache>(
+                assetManager_,
+                kTileDirectory,
+                TilePyramid(maxTileLevel, tileSize),
+                kTileCacheBudgetBytes);
+    }
 
-    // create the proper window surface
-    EGLint format;
-    eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID, &format);
-    EGLSurface surface = eglCreateWindowSurface(display, config, app_->window, nullptr);
+    loadGlobeShader();
 
-    // Create a GLES 3 context
-    EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
-    EGLContext context = eglCreateContext(display, config, nullptr, contextAttribs);
+    // setup any other gl related global states
+    glClearColor(CORNFLOWER_BLUE);
 
-    // get some window metrics
-    auto madeCurrent = eglMakeCurrent(display, surface, surface, context);
-    assert(madeCurrent);
+    stateCache_.setDepthTest(true);
+    stateCache_.setDepthFunc(GL_LEQUAL);
 
-    display_ = display;
-    surface_ = surface;
-    context_ = context;
+    // Blending and culling are switched per pass, see beginPass. Every pass blends the same way.
+    stateCache_.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // make width and height invalid so it gets updated the first frame in @a updateRenderArea()
-    width_ = -1;
-    height_ = -1;
+    // get some demo models into memory
+    createModels();
 
-    PRINT_GL_STRING(GL_VENDOR);
-    PRINT_GL_STRING(GL_RENDERER);
-    PRINT_GL_STRING(GL_VERSION);
-    PRINT_GL_STRING_AS_LIST(GL_EXTENSIONS);
+    markerLayer_ = std::make_unique<MarkerLayer>(stateCache_, &programCache_);
+    if (!clusterBuilder_) {
+        createObservations();
+    }
+    if (regions_.getCells().empty()) {
+        regions_ = RegionRaster::bake(
+                getContinentOutlines(), kRegionRasterWidth, kRegionRasterHeight);
+        picker_.setRegions(&regions_);
+    }
+    createRegionLayers();
+}
+
+void Renderer::loadGlobeShader() {
+    // The shader is specialised for the way the globe is drawn
+    auto sources = assembleGlobeShader(
+            globeMode_, VertexLayout(kGlobeVertexFormat).getShaderDefines());
+    const char *positionAttributeName = globeMode_ == GlobeMode::Chunked ? "inGrid" : "inPosition";
 
     shader_ = std::unique_ptr<Shader>(
             Shader::loadShader(
-                    vertex,
-                    fragment,
-                    "inPosition",
+                    sources.vertex,
+                    sources.fragment,
+                    positionAttributeName,
                     "inUV",
-                    "uModel",
-                    "uView",
-                    "uProjection",
-                    "uLightDir",
-                    "uTexture"));
+                    "uTexture",
+                    &programCache_));
     assert(shader_);
+    programCache_.logStats();
+
+    // Note: there's only one shader in this demo, so I'll activate it here. render() activates it
+    // again every frame, which the state cache drops while it's still in use.
+    shader_->activate(stateCache_);
+
+    // Samplers never change units, so they're set once for the program's lifetime
+    glUniform1i(shader_->getUniformLocation("uUseTiles"), tileCache_ ? 1 : 0);
+    glUniform1i(shader_->getUniformLocation("uTileAtlas"), kTileAtlasUnit);
+    glUniform1i(shader_->getUniformLocation("uTileIndirection"), kTileIndirectionUnit);
+    glUniform1i(shader_->getUniformLocation("uRegionIds"), kRegionIdUnit);
+    glUniform1i(shader_->getUniformLocation("uBoundaryField"), kBoundaryFieldUnit);
+    glUniform1f(shader_->getUniformLocation("uOutlineWidth"), kOutlineWidthPixels);
+    selectedRegionUniform_ = shader_->getUniformLocation("uSelectedRegion");
+    glUniform1ui(selectedRegionUniform_, selectedRegion_);
+    selectionNeedsUpdate_ = false;
+    faceBasisUniform_ = shader_->getUniformLocation("uFaceBasis");
+    chunkUniform_ = shader_->getUniformLocation("uChunk");
+
+    // The matrices stay in their uniform buffers, a new program reads them through its blocks
+}
 
-    // Note: there's only one shader in this demo, so I'll activate it here. For a more complex game
-    // you'll want to track the active shader and activate/deactivate it as necessary
-    shader_->activate();
+void Renderer::releaseGpuResources() {
+    // The loader goes first, its pending textures and callbacks reference the models
+    textureLoader_.reset();
+    tileCache_.reset();
+    releaseGlobe();
+    markerLayer_.reset();
+    regionLayers_.reset();
+    spEarthTexture_.reset();
+    cameraUniforms_.reset();
+    globeUniforms_.reset();
+    frameProfiler_.reset();
+}
 
-    // setup any other gl related global states
-    glClearColor(CORNFLOWER_BLUE);
+bool Renderer::handleContextLoss() {
+    aout << "GL context lost, recreating GPU resources" << std::endl;
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    device_.releaseContext();
+    releaseGpuResources();
 
-    // enable alpha globally for now, you probably don't want to do this in a game
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (!device_.recreateContext()) {
+        // Nothing can be drawn without a context. Without a window the render thread stops
+        // asking for frames, attachWindow tries again.
+        aout << "Could not recreate the GL context, waiting for a new window" << std::endl;
+        device_.detachWindow();
+        return false;
+    }
 
-    // get some demo models into memory
-    createModels();
+    initRenderer();
+
+    // Every piece of GL state is new, push all of it again on the next frame
+    width_ = -1;
+    height_ = -1;
+    shaderNeedsNewProjectionMatrix_ = true;
+    viewNeedsUpdate_ = true;
+    modelNeedsUpdate_ = true;
+    redrawRequested_ = true;
+    tilesNeedUpdate_ = true;
+    chunksNeedUpdate_ = true;
+    return true;
 }
 
 void Renderer::updateRenderArea() {
     EGLint width;
-    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
-
     EGLint height;
-    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
+    device_.getSurfaceSize(width, height);
 
     if (width != width_ || height != height_) {
         width_ = width;
@@ -291,6 +453,121 @@ void Renderer::updateRenderArea() {
  * @brief Create any demo models we want for this demo.
  */
 void Renderer::createModels() {
+    // Start out with the procedural texture, it's tiny and ready right away. The real one is
+    // loaded in the background and swapped in once it's fully uploaded. A compressed variant is
+    // preferred when one was built with tools/ktxconvert.
+    spEarthTexture_ = TextureAsset::createProceduralEarthTexture();
+    createGlobe();
+
+    textureLoader_->load(
+            TextureAsset::selectAssetVariant(assetManager_, "earth"),
+            [this](std::shared_ptr<TextureAsset> spEarthTexture) {
+                spEarthTexture_ = std::move(spEarthTexture);
+                for (auto &model: models_) {
+                    model.setTexture(spEarthTexture_);
+                }
+                if (globeMesh_) {
+                    globeMesh_->setTexture(spEarthTexture_);
+                }
+                if (globeImpostor_) {
+                    globeImpostor_->setTexture(spEarthTexture_);
+                }
+
+                // The placeholder was just deleted, its name may come back for another texture
+                stateCache_.invalidateTextures();
+                redrawRequested_ = true;
+            });
+}
+
+void Renderer::createRegionLayers() {
+    regionLayers_ = std::make_unique<RegionLayers>(stateCache_, regions_);
+
+    // The highlight shows right away, the outline once the field is uploaded
+    textureLoader_->load(
+            kBoundaryFieldAsset,
+            [this](std::shared_ptr<TextureAsset> spBoundaryField) {
+                regionLayers_->setBoundaryField(stateCache_, std::move(spBoundaryField));
+                redrawRequested_ = true;
+            });
+}
+
+void Renderer::createObservations() {
+    // Nothing is made up in place of a missing store, the globe shows no observations then
+    observationFile_ = MappedFile::openAsset(assetManager_, kObservationAsset);
+    if (!observationFile_
+        || !observationStore_.attach(observationFile_->getData(), observationFile_->getSize())) {
+        aout << "No observations in the assets (" << kObservationAsset << ")" << std::endl;
+        observationFile_.reset();
+        return;
+    }
+
+    // The builder wakes this thread when a tree is ready, the next frame picks it up
+    clusterLooper_ = ALooper_forThread();
+    if (clusterLooper_) {
+        ALooper_acquire(clusterLooper_);
+    }
+    auto *looper = clusterLooper_;
+    clusterBuilder_ = std::make_unique<ClusterBuilder>(ClusterTreeOptions(), [looper]() {
+        if (looper) {
+            ALooper_wake(looper);
+        }
+    });
+
+    // Clustered straight from the mapped store, the builder keeps no copy of the points
+    aout << "Loaded " << observationStore_.getPointCount() << " observations from "
+         << kObservationAsset << std::endl;
+    clusterBuilder_->setStore(&observationStore_);
+}
+
+void Renderer::updateClusterMarkers() {
+    // One colour per power of ten of observations, white for single ones
+    static constexpr uint32_t kPalette[] = {
+            0xFFFFFFFFu, 0x5FAD56FFu, 0x4D9078FFu, 0xF2C14EFFu, 0xF78154FFu, 0xB4436CFFu};
+
+    if (!clusterBuilder_) {
+        return;
+    }
+    auto generation = clusterBuilder_->getGeneration();
+    auto treeChanged = generation != clusterGeneration_;
+    if (treeChanged) {
+        clusterTree_ = clusterBuilder_->getTree();
+        clusterGeneration_ = generation;
+    }
+    if (!clusterTree_ || !(treeChanged || clustersNeedUpdate_)) {
+        return;
+    }
+    clustersNeedUpdate_ = false;
+
+    // A few hundred markers at most, rebuilding all of them is cheaper than working out the
+    // difference to the last selection
+    clusterTree_->selectClusters(getCameraView(), kClusterSpacingPixels, visibleClusters_);
+    markers_.clear();
+    for (const auto &ref: visibleClusters_) {
+        const auto &cluster = clusterTree_->get(ref);
+        auto magnitude = std::log10(static_cast<float>(cluster.count));
+        Marker marker;
+        latLonFromDirection(ClusterTree::getCentroid(cluster), marker.latitude, marker.longitude);
+        marker.size = 12.f + 6.f * magnitude;
+        marker.color = kPalette[std::min(
+                static_cast<size_t>(magnitude + 0.5f), std::size(kPalette) - 1)];
+        marker.atlasIndex = cluster.count == 1 ? 1 : 0;
+        markers_.add(marker);
+    }
+}
+
+void Renderer::createGlobe() {
+    if (globeMode_ == GlobeMode::Chunked) {
+        globeMesh_ = std::make_unique<GlobeMesh>(
+                CubeSphere(kChunkGridSize, kChunkMaxLevel, kChunkMaxPixelError),
+                spEarthTexture_);
+        chunksNeedUpdate_ = true;
+        return;
+    }
+    if (globeMode_ == GlobeMode::Impostor) {
+        globeImpostor_ = std::make_unique<GlobeImpostor>(spEarthTexture_);
+        return;
+    }
+
     const int latSegments = 64;
     const int lonSegments = 128;
 
@@ -315,7 +592,9 @@ void Renderer::createModels() {
                     sinTheta * sinPhi
             };
             Vector2 uv{u, v};
-            vertices.emplace_back(position, uv);
+
+            // On a unit sphere the normal is the position
+            vertices.emplace_back(position, uv, position);
         }
     }
 
@@ -329,104 +608,195 @@ void Renderer::createModels() {
             Index bottomLeft = static_cast<Index>((lat + 1) * rowStride + lon);
             Index bottomRight = static_cast<Index>(bottomLeft + 1);
 
+            // Counterclockwise seen from outside, like every other mesh, so culling keeps them
             indices.push_back(topLeft);
-            indices.push_back(bottomLeft);
             indices.push_back(topRight);
+            indices.push_back(bottomLeft);
 
             indices.push_back(topRight);
-            indices.push_back(bottomLeft);
             indices.push_back(bottomRight);
+            indices.push_back(bottomLeft);
         }
     }
 
-    auto *assetManager = app_->activity->assetManager;
-    auto spEarthTexture = TextureAsset::loadAsset(assetManager, "earth.png");
+    // The row-major grid misses the post-transform cache on almost every other vertex. Reorder the
+    // triangles for the cache, then the vertices for linear fetches. A procedural sphere derives
+    // each vertex from its index, so its vertices have to stay where they are.
+    auto before = MeshOptimizer::analyze(indices, vertices.size());
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    if (!kGlobeVertexFormat.proceduralSphere) {
+        auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertices.size());
+        vertices = MeshOptimizer::remapVertices(vertices, remap);
+    }
+    auto after = MeshOptimizer::analyze(indices, vertices.size());
+    aout << "Globe mesh ACMR " << before.acmr << " -> " << after.acmr << std::endl;
+
+    auto format = kGlobeVertexFormat;
+    if (format.proceduralSphere) {
+        format.sphereLatSegments = latSegments;
+        format.sphereLonSegments = lonSegments;
+    }
+    models_.emplace_back(
+            std::move(vertices),
+            std::move(indices),
+            spEarthTexture_,
+            format);
+}
+
+void Renderer::releaseGlobe() {
+    models_.clear();
+    globeMesh_.reset();
+    globeImpostor_.reset();
+    shader_.reset();
 
-    models_.emplace_back(std::move(vertices), std::move(indices), spEarthTexture);
+    // The names of the deleted program and vertex arrays may be handed out again
+    stateCache_.invalidate();
 }
 
-void Renderer::handleInput() {
-    // handle all queued inputs
-    auto *inputBuffer = android_app_swap_input_buffers(app_);
-    if (!inputBuffer) {
-        // no inputs yet.
+void Renderer::setGlobeMode(GlobeMode mode) {
+    if (mode == globeMode_) {
         return;
     }
 
-    // handle motion events (motionEventsCounts can be 0).
-    for (auto i = 0; i < inputBuffer->motionEventsCount; i++) {
-        auto &motionEvent = inputBuffer->motionEvents[i];
-        auto action = motionEvent.action;
-        auto pointerIndex = (action & AMOTION_EVENT_ACTION_POINTER_INDEX_MASK)
-                >> AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT;
-
-        switch (action & AMOTION_EVENT_ACTION_MASK) {
-            case AMOTION_EVENT_ACTION_DOWN:
-            case AMOTION_EVENT_ACTION_POINTER_DOWN: {
-                auto &pointer = motionEvent.pointers[pointerIndex];
-                if (activePointerId_ == -1) {
-                    activePointerId_ = pointer.id;
-                    lastTouchX_ = GameActivityPointerAxes_getX(&pointer);
-                    lastTouchY_ = GameActivityPointerAxes_getY(&pointer);
-                }
-                break;
-            }
-            case AMOTION_EVENT_ACTION_CANCEL:
-            case AMOTION_EVENT_ACTION_UP:
-            case AMOTION_EVENT_ACTION_POINTER_UP: {
-                auto &pointer = motionEvent.pointers[pointerIndex];
-                if (pointer.id == activePointerId_) {
-                    activePointerId_ = -1;
-                }
-                break;
-            }
-            case AMOTION_EVENT_ACTION_MOVE: {
-                if (activePointerId_ == -1) {
-                    break;
-                }
+    globeMode_ = mode;
+    if (!device_.hasContext()) {
+        // Lost, the globe is built in the new mode once a context is recreated
+        return;
+    }
 
-                for (auto index = 0; index < motionEvent.pointerCount; index++) {
-                    auto &pointer = motionEvent.pointers[index];
-                    if (pointer.id == activePointerId_) {
-                        float x = GameActivityPointerAxes_getX(&pointer);
-                        float y = GameActivityPointerAxes_getY(&pointer);
-                        float dx = x - lastTouchX_;
-                        float dy = y - lastTouchY_;
-                        lastTouchX_ = x;
-                        lastTouchY_ = y;
-
-                        int width = std::max(width_, 1);
-                        int height = std::max(height_, 1);
-                        rotationY_ += (dx / static_cast<float>(width)) * 2.f * kPi;
-                        rotationX_ += (dy / static_cast<float>(height)) * kPi;
-
-                        rotationX_ = std::clamp(rotationX_, -kMaxPitchRadians, kMaxPitchRadians);
-                        if (rotationY_ > kPi) {
-                            rotationY_ -= 2.f * kPi;
-                        } else if (rotationY_ < -kPi) {
-                            rotationY_ += 2.f * kPi;
-                        }
-
-                        modelNeedsUpdate_ = true;
-                        break;
-                    }
-                }
-                break;
-            }
-            default:
-                break;
-        }
+    releaseGlobe();
+    loadGlobeShader();
+    createGlobe();
+    redrawRequested_ = true;
+}
+
+TileView Renderer::getCameraView() const {
+    auto tanHalfFov = std::tan(kFieldOfViewRadians * 0.5f);
+    auto aspect = float(width_) / float(std::max(height_, 1));
+
+    auto camera = getCameraPosition();
+    TileView view;
+    view.cameraPosition[0] = camera.x;
+    view.cameraPosition[1] = camera.y;
+    view.cameraPosition[2] = camera.z;
+    view.projectionScale = float(height_) / (2.f * tanHalfFov);
+    view.halfDiagonalFov = std::atan(tanHalfFov * std::sqrt(1.f + aspect * aspect));
+    return view;
+}
+
+void Renderer::updateVisibleTiles() {
+    tileCache_->getPyramid().selectTiles(getCameraView(), visibleTiles_);
+    tileCache_->update(visibleTiles_);
+}
+
+void Renderer::submitScene() {
+    // The globe's centre is the origin of its model space
+    auto depth = getViewDepth({0.f, 0.f, 0.f});
+    auto program = shader_->getProgram();
+
+    if (globeMesh_) {
+        renderQueue_.submit(
+                RenderPass::Opaque,
+                program,
+                spEarthTexture_->getTextureID(),
+                depth,
+                [this]() { globeMesh_->draw(stateCache_, faceBasisUniform_, chunkUniform_); });
+    }
+    if (globeImpostor_) {
+        // The limb fades out over a pixel, it has to blend with what's behind it
+        renderQueue_.submit(
+                RenderPass::Coverage,
+                program,
+                spEarthTexture_->getTextureID(),
+                depth,
+                [this]() { globeImpostor_->draw(stateCache_); });
+    }
+    for (const auto &model: models_) {
+        renderQueue_.submit(
+                RenderPass::Opaque,
+                program,
+                model.getTexture().getTextureID(),
+                depth,
+                [this, &model]() { shader_->drawModel(model, stateCache_); });
     }
-    // clear the motion input count in this buffer for main thread to re-use.
-    android_app_clear_motion_events(inputBuffer);
 
-    // handle input key events.
-    for (auto i = 0; i < inputBuffer->keyEventsCount; i++) {
-        auto &keyEvent = inputBuffer->keyEvents[i];
-        if (keyEvent.action == AKEY_EVENT_ACTION_DOWN && keyEvent.keyCode == AKEYCODE_BACK) {
-            app_->destroyRequested = 1;
-        }
+    // The markers sit on the near side of the globe, one unit in front of its centre
+    renderQueue_.submit(
+            RenderPass::Transparent,
+            markerLayer_->getProgram(),
+            markerLayer_->getAtlasTexture(),
+            depth - 1.f,
+            [this]() { markerLayer_->draw(stateCache_); });
+}
+
+Vec3 Renderer::getCameraPosition() const {
+    // The camera sits at (0, 0, cameraDistance_) in world space. The model matrix is a pure
+    // rotation, so its transpose takes the camera into the globe's model space.
+    return modelMatrix_.transposed().transformVector({0.f, 0.f, cameraDistance_});
+}
+
+void Renderer::beginPass(RenderPass pass) {
+    const auto &state = getPassState(pass);
+    stateCache_.setBlend(state.blend);
+    stateCache_.setDepthMask(state.depthWrite);
+    stateCache_.setCullFace(state.cullBackFaces);
+}
+
+float Renderer::getViewDepth(const Vec3 &position) const {
+    // The camera looks down -z in view space
+    return -(viewMatrix_ * modelMatrix_).transformPoint(position).z;
+}
+
+bool Renderer::selectAt(float x, float y) {
+    // The matrices are still the ones of the frame the user tapped on
+    picker_.setView(projectionMatrix_, viewMatrix_, modelMatrix_, width_, height_);
+    GlobePick pick;
+    if (!picker_.pick(x, y, pick)) {
+        return false;
+    }
+    if (pick.region != selectedRegion_) {
+        selectedRegion_ = pick.region;
+        selectionNeedsUpdate_ = true;
+    }
+
+    const auto *name = getContinentName(pick.region);
+    aout << "Picked " << pick.latitude << ", " << pick.longitude << " in "
+         << (name ? name : "no continent");
+    ClusterRef cluster;
+    if (clusterTree_ && clusterTree_->findCluster(
+            clusterTree_->selectLevel(getCameraView(), kClusterSpacingPixels),
+            pick.latitude, pick.longitude, cluster)) {
+        aout << ", " << clusterTree_->get(cluster).count << " observations around";
+    }
+    aout << std::endl;
+    return true;
+}
+
+void Renderer::rotate(float dx, float dy) {
+    FrameProfiler::ScopedTimer inputTimer(*frameProfiler_, FrameStage::Input);
+
+    // Closer to the surface the same drag covers less of the globe, so it keeps up with the finger
+    auto altitudeScale = (cameraDistance_ - 1.f) / (kDefaultCameraDistance - 1.f);
+
+    int width = std::max(width_, 1);
+    int height = std::max(height_, 1);
+    rotationY_ += (dx / static_cast<float>(width)) * 2.f * kPi * altitudeScale;
+    rotationX_ += (dy / static_cast<float>(height)) * kPi * altitudeScale;
+
+    // A coalesced drag can cover more than one turn, wrap back into [-pi, pi]
+    rotationX_ = std::clamp(rotationX_, -kMaxPitchRadians, kMaxPitchRadians);
+    rotationY_ = std::remainder(rotationY_, 2.f * kPi);
+
+    modelNeedsUpdate_ = true;
+}
+
+void Renderer::zoom(float distanceScale) {
+    FrameProfiler::ScopedTimer inputTimer(*frameProfiler_, FrameStage::Input);
+
+    auto distance = std::clamp(
+            cameraDistance_ * distanceScale, kMinCameraDistance, kMaxCameraDistance);
+    if (distance != cameraDistance_) {
+        cameraDistance_ = distance;
+        viewNeedsUpdate_ = true;
     }
-    // clear the key input count too.
-    android_app_clear_key_events(inputBuffer);
 }
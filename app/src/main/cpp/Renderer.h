@@ -2,59 +2,192 @@
 #define ANDROIDGLINVESTIGATIONS_RENDERER_H
 
 #include <EGL/egl.h>
-#include <array>
 #include <cstdint>
 #include <memory>
+#include <string>
 
+#include "ClusterBuilder.h"
+#include "FrameProfiler.h"
+#include "GlStateCache.h"
+#include "GlobeImpostor.h"
+#include "GlobeMesh.h"
+#include "GlobePicker.h"
+#include "MappedFile.h"
+#include "MarkerLayer.h"
+#include "MarkerSet.h"
 #include "Model.h"
+#include "ProgramCache.h"
+#include "RegionLayers.h"
+#include "RegionRaster.h"
+#include "RenderDevice.h"
+#include "RenderQueue.h"
 #include "Shader.h"
+#include "ShaderSources.h"
+#include "TextureLoader.h"
+#include "TileCache.h"
+#include "TilePyramid.h"
+#include "UniformBuffer.h"
+#include "VectorMath.h"
 
-struct android_app;
+struct ANativeWindow;
+struct AAssetManager;
+struct ALooper;
 
 class Renderer {
 public:
+    //! how the globe is drawn until @a setGlobeMode picks another way
+    static constexpr GlobeMode kDefaultGlobeMode = GlobeMode::Chunked;
+
+    //! distance from the camera to the centre of the unit globe until a pinch changes it
+    static constexpr float kDefaultCameraDistance = 3.0f;
+
     /*!
-     * @param pApp the android_app this Renderer belongs to, needed to configure GL
+     * Creates the EGL context and all GL resources. Must be called on the thread that will render.
+     * Nothing is drawn until a window is attached with @a attachWindow.
+     *
+     * @param assetManager used to load the textures
+     * @param cacheDirectory the app's cache directory, compiled shader programs are kept there
      */
-    inline Renderer(android_app *pApp) :
-            app_(pApp),
-            display_(EGL_NO_DISPLAY),
-            surface_(EGL_NO_SURFACE),
-            context_(EGL_NO_CONTEXT),
+    inline Renderer(AAssetManager *assetManager, const std::string &cacheDirectory) :
+            assetManager_(assetManager),
+            programCache_(cacheDirectory + "/programs"),
             width_(0),
             height_(0),
             shaderNeedsNewProjectionMatrix_(true),
             viewNeedsUpdate_(true),
             modelNeedsUpdate_(true),
+            redrawRequested_(true),
+            tilesNeedUpdate_(true),
+            chunksNeedUpdate_(true),
+            clustersNeedUpdate_(true),
+            selectionNeedsUpdate_(false),
+            globeMode_(kDefaultGlobeMode),
+            faceBasisUniform_(-1),
+            chunkUniform_(-1),
+            selectedRegionUniform_(-1),
+            clusterLooper_(nullptr),
+            clusterGeneration_(0),
+            selectedRegion_(RegionRaster::kNoRegion),
             rotationX_(0.f),
             rotationY_(0.f),
-            activePointerId_(-1),
-            lastTouchX_(0.f),
-            lastTouchY_(0.f) {
+            cameraDistance_(kDefaultCameraDistance) {
         initRenderer();
     }
 
     virtual ~Renderer();
 
     /*!
-     * Handles input from the android_app.
+     * Starts rendering into @a window. Only an EGL surface is created, the context and every GPU
+     * resource are kept from before.
      *
-     * Note: this will clear the input queue
+     * @return false if no surface could be created for the window
+     */
+    bool attachWindow(ANativeWindow *window);
+
+    /*!
+     * Stops rendering into the current window and destroys its surface. GPU resources stay alive
+     * until the next @a attachWindow.
      */
-    void handleInput();
+    void detachWindow();
 
     /*!
-     * Renders all the models in the renderer
+     * @return true if a window is attached and frames can be rendered
      */
-    void render();
+    inline bool hasWindow() const { return device_.hasWindow(); }
+
+    /*!
+     * Rotates the globe by a drag gesture.
+     *
+     * @param dx horizontal drag distance in pixels, spins the globe around its axis
+     * @param dy vertical drag distance in pixels, tilts the globe
+     */
+    void rotate(float dx, float dy);
+
+    /*!
+     * Moves the camera towards or away from the globe by a pinch gesture, within a fixed range.
+     *
+     * @param distanceScale factor for the distance to the centre of the globe
+     */
+    void zoom(float distanceScale);
+
+    /*!
+     * Switches how the globe is drawn, e.g. to compare the mesh and impostor paths on the same
+     * view. Rebuilds the globe's program and geometry, the textures are kept.
+     */
+    void setGlobeMode(GlobeMode mode);
+
+    inline GlobeMode getGlobeMode() const { return globeMode_; }
+
+    /*!
+     * Selects the continent under a tap, as the last frame showed it, and highlights it on the
+     * globe.
+     *
+     * @param x, y in pixels from the top left corner of the window
+     * @return false if the tap missed the globe, the selection is kept then
+     */
+    bool selectAt(float x, float y);
+
+    //! @return the continent picked last, @a RegionRaster::kNoRegion before the first pick
+    inline uint16_t getSelectedRegion() const { return selectedRegion_; }
+
+    /*!
+     * Renders all the models in the renderer. Must only be called while a window is attached. If
+     * the window surface turns out to be lost it's released, @a hasWindow is false until the next
+     * @a attachWindow.
+     *
+     * @return true if the frame was presented, false if the surface or the context was lost
+     */
+    bool render();
+
+    /*!
+     * @return true if anything that affects the image changed since the last call to @a render,
+     * meaning a new frame has to be presented. When this is false the caller can skip rendering
+     * entirely and let the device idle.
+     */
+    inline bool isSceneDirty() const {
+        return redrawRequested_
+               || shaderNeedsNewProjectionMatrix_
+               || viewNeedsUpdate_
+               || modelNeedsUpdate_
+               || selectionNeedsUpdate_
+               || markers_.hasChanges()
+               || (clusterBuilder_ && clusterBuilder_->getGeneration() != clusterGeneration_)
+               || (textureLoader_ && textureLoader_->hasPendingUploads())
+               || (tileCache_ && tileCache_->hasPendingUploads());
+    }
+
+    /*!
+     * Forces the next frame to be drawn even though nothing in the scene moved, e.g. because the
+     * window was resized or its contents were lost.
+     */
+    inline void requestRedraw() { redrawRequested_ = true; }
+
+    /*!
+     * @return per-frame CPU/GPU timings of this renderer. The report getters are thread safe.
+     */
+    inline const FrameProfiler &getFrameProfiler() const { return *frameProfiler_; }
 
 private:
     /*!
-     * Performs necessary OpenGL initialization. Customize this if you want to change your EGL
-     * context or application-wide settings.
+     * Performs necessary OpenGL initialization and creates every GPU resource. Customize this if
+     * you want to change application-wide settings.
      */
     void initRenderer();
 
+    /*!
+     * Drops every GPU resource. Must run before the context they belong to is destroyed.
+     */
+    void releaseGpuResources();
+
+    /*!
+     * Recovers from a lost context: drops the dead resources, creates a new context and rebuilds
+     * everything in it.
+     *
+     * @return false if no new context could be created. The window is detached then and the
+     *     device left without a context, the next @a attachWindow tries again.
+     */
+    bool handleContextLoss();
+
     /*!
      * @brief we have to check every frame to see if the framebuffer has changed in size. If it has,
      * update the viewport accordingly
@@ -67,29 +200,145 @@ private:
      */
     void createModels();
 
-    android_app *app_;
-    EGLDisplay display_;
-    EGLSurface surface_;
-    EGLContext context_;
+    /*!
+     * Compiles or restores the program for the current @a GlobeMode and activates it.
+     */
+    void loadGlobeShader();
+
+    /*!
+     * Uploads the continents for highlighting the selected one and starts loading the boundary
+     * mask. Needs @a regions_.
+     */
+    void createRegionLayers();
+
+    /*!
+     * Loads the observations and starts clustering them in the background. Without an
+     * observation store in the assets there are none.
+     */
+    void createObservations();
+
+    /*!
+     * Shows the clusters of the newest tree that fit the view as markers, if the tree or the view
+     * changed since they were picked.
+     */
+    void updateClusterMarkers();
+
+    /*!
+     * Creates the geometry for the current @a GlobeMode, drawn with the earth texture.
+     */
+    void createGlobe();
+
+    /*!
+     * Drops the globe's program and geometry.
+     */
+    void releaseGlobe();
+
+    /*!
+     * @return the camera in the globe's model space, for tile and chunk selection
+     */
+    TileView getCameraView() const;
+
+    /*!
+     * Picks the imagery tiles for the current view and hands them to the tile cache.
+     */
+    void updateVisibleTiles();
+
+    /*!
+     * Queues the draws of the frame: the globe, in whichever form the current @a GlobeMode has,
+     * and the markers.
+     */
+    void submitScene();
+
+    /*!
+     * @return the camera position in the globe's model space
+     */
+    Vec3 getCameraPosition() const;
+
+    /*!
+     * Applies the state @a pass declares, called by the render queue as the pass begins.
+     */
+    void beginPass(RenderPass pass);
+
+    /*!
+     * @return how far in front of the camera @a position of the globe's model space is, the depth
+     *     draws are sorted by
+     */
+    float getViewDepth(const Vec3 &position) const;
+
+    // Declared first so it's destroyed last, after every GPU resource below was released
+    RenderDevice device_;
+
+    AAssetManager *assetManager_;
+    ProgramCache programCache_;
     EGLint width_;
     EGLint height_;
 
     bool shaderNeedsNewProjectionMatrix_;
     bool viewNeedsUpdate_;
     bool modelNeedsUpdate_;
+    bool redrawRequested_;
+    bool tilesNeedUpdate_;
+    bool chunksNeedUpdate_;
+    bool clustersNeedUpdate_;
+    bool selectionNeedsUpdate_;
+
+    std::unique_ptr<FrameProfiler> frameProfiler_;
+    std::unique_ptr<TextureLoader> textureLoader_;
+
+    // Every bind and state change of a frame goes through here, so redundant ones are dropped
+    GlStateCache stateCache_;
+    RenderQueue renderQueue_;
+
+    // The matrices and the light, shared by every program through their uniform blocks
+    std::unique_ptr<UniformBuffer<CameraUniforms>> cameraUniforms_;
+    std::unique_ptr<UniformBuffer<GlobeUniforms>> globeUniforms_;
+
+    // Only created when the assets contain a tile pyramid
+    std::unique_ptr<TileCache> tileCache_;
+    std::vector<TileId> visibleTiles_;
 
     std::unique_ptr<Shader> shader_;
     std::vector<Model> models_;
 
-    std::array<float, 16> projectionMatrix_{};
-    std::array<float, 16> viewMatrix_{};
-    std::array<float, 16> modelMatrix_{};
+    // The globe drawn in the current mode: the UV sphere in models_, a mesh or an impostor
+    GlobeMode globeMode_;
+    std::shared_ptr<TextureAsset> spEarthTexture_;
+    std::unique_ptr<GlobeMesh> globeMesh_;
+    std::unique_ptr<GlobeImpostor> globeImpostor_;
+    GLint faceBasisUniform_;
+    GLint chunkUniform_;
+    GLint selectedRegionUniform_;
+
+    // The markers outlive the GPU layer drawing them, a new layer uploads all of them
+    MarkerSet markers_;
+    std::unique_ptr<MarkerLayer> markerLayer_;
+
+    // The observations, clustered for the zoom level and shown through markers_. Not a GPU
+    // resource, a lost context doesn't cluster them again. The store stays mapped for the trees,
+    // it's declared first so they're released before it.
+    std::unique_ptr<MappedFile> observationFile_;
+    PointStore observationStore_;
+    std::unique_ptr<ClusterBuilder> clusterBuilder_;
+    ALooper *clusterLooper_;
+    std::shared_ptr<const ClusterTree> clusterTree_;
+    uint64_t clusterGeneration_;
+    std::vector<ClusterRef> visibleClusters_;
+
+    // Which continent each place belongs to, for picking. Not a GPU resource either.
+    RegionRaster regions_;
+    GlobePicker picker_;
+    uint16_t selectedRegion_;
+
+    // The same raster on the GPU, with the boundaries drawn around the selected continent
+    std::unique_ptr<RegionLayers> regionLayers_;
+
+    Mat4 projectionMatrix_;
+    Mat4 viewMatrix_;
+    Mat4 modelMatrix_;
 
     float rotationX_;
     float rotationY_;
-    int32_t activePointerId_;
-    float lastTouchX_;
-    float lastTouchY_;
+    float cameraDistance_;
 };
 
 #endif //ANDROIDGLINVESTIGATIONS_RENDERER_H
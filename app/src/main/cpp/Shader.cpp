@@ -1,7 +1,12 @@
 #include "Shader.h"
 
+#include <chrono>
+
 #include "AndroidOut.h"
+#include "GlStateCache.h"
 #include "Model.h"
+#include "ProgramCache.h"
+#include "UniformBuffer.h"
 #include "Utility.h"
 
 Shader *Shader::loadShader(
@@ -9,22 +14,89 @@ Shader *Shader::loadShader(
         const std::string &fragmentSource,
         const std::string &positionAttributeName,
         const std::string &uvAttributeName,
-        const std::string &modelMatrixUniformName,
-        const std::string &viewMatrixUniformName,
-        const std::string &projectionMatrixUniformName,
-        const std::string &lightDirectionUniformName,
-        const std::string &textureUniformName) {
+        const std::string &textureUniformName,
+        ProgramCache *programCache) {
     Shader *shader = nullptr;
 
+    // Try the binary cache first, it skips compiling and linking entirely
+    GLuint program = 0;
+    if (programCache) {
+        program = programCache->loadProgram(vertexSource, fragmentSource);
+    }
+
+    if (!program) {
+        auto start = std::chrono::steady_clock::now();
+        bool cacheable = programCache && programCache->isEnabled();
+        program = buildProgram(vertexSource, fragmentSource, cacheable);
+        if (program && cacheable) {
+            auto buildNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            programCache->storeProgram(vertexSource, fragmentSource, program, buildNanos);
+        }
+    }
+
+    if (program) {
+        // Get the attribute and uniform locations by name. The attributes are hardcoded with
+        // layout= in the shader, models set up their vertex arrays against those locations.
+        GLint positionAttribute = glGetAttribLocation(program, positionAttributeName.c_str());
+        GLint uvAttribute = glGetAttribLocation(program, uvAttributeName.c_str());
+        GLint textureUniform = glGetUniformLocation(
+                program,
+                textureUniformName.c_str());
+
+        // A procedural sphere shader has no vertex attributes at all, those are allowed to be
+        // missing. Any attribute that's present has to be where models expect it.
+        auto hasLocation = [](GLint location, VertexAttribute expected) {
+            return location == -1 || location == static_cast<GLint>(expected);
+        };
+
+        // Only create a new shader if all the attributes are found where models expect them
+        if (hasLocation(positionAttribute, kPositionAttribute)
+            && hasLocation(uvAttribute, kUvAttribute)
+            && textureUniform != -1) {
+
+            // Point the blocks at the shared buffers. A block the program doesn't use is inactive
+            // and has no index, which is fine.
+            for (const auto &block: kUniformBlocks) {
+                GLuint index = glGetUniformBlockIndex(program, block.name);
+                if (index != GL_INVALID_INDEX) {
+                    glUniformBlockBinding(program, index, block.binding);
+                }
+            }
+
+            shader = new Shader(
+                    program,
+                    positionAttribute,
+                    uvAttribute,
+                    textureUniform,
+                    glGetUniformLocation(program, kSphereSegmentsUniformName));
+            // Put back whatever was in use, a GlStateCache may be tracking it
+            GLint previousProgram = 0;
+            glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+            glUseProgram(program);
+            glUniform1i(textureUniform, 0);
+            glUseProgram(static_cast<GLuint>(previousProgram));
+        } else {
+            glDeleteProgram(program);
+        }
+    }
+
+    return shader;
+}
+
+GLuint Shader::buildProgram(
+        const std::string &vertexSource,
+        const std::string &fragmentSource,
+        bool retrievable) {
     GLuint vertexShader = loadShader(GL_VERTEX_SHADER, vertexSource);
     if (!vertexShader) {
-        return nullptr;
+        return 0;
     }
 
     GLuint fragmentShader = loadShader(GL_FRAGMENT_SHADER, fragmentSource);
     if (!fragmentShader) {
         glDeleteShader(vertexShader);
-        return nullptr;
+        return 0;
     }
 
     GLuint program = glCreateProgram();
@@ -32,6 +104,11 @@ Shader *Shader::loadShader(
         glAttachShader(program, vertexShader);
         glAttachShader(program, fragmentShader);
 
+        // Must be set before linking for glGetProgramBinary to be guaranteed to work
+        if (retrievable) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
         glLinkProgram(program);
         GLint linkStatus = GL_FALSE;
         glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -48,51 +125,7 @@ Shader *Shader::loadShader(
             }
 
             glDeleteProgram(program);
-        } else {
-            // Get the attribute and uniform locations by name. You may also choose to hardcode
-            // indices with layout= in your shader, but it is not done in this sample
-            GLint positionAttribute = glGetAttribLocation(program, positionAttributeName.c_str());
-            GLint uvAttribute = glGetAttribLocation(program, uvAttributeName.c_str());
-            GLint modelMatrixUniform = glGetUniformLocation(
-                    program,
-                    modelMatrixUniformName.c_str());
-            GLint viewMatrixUniform = glGetUniformLocation(
-                    program,
-                    viewMatrixUniformName.c_str());
-            GLint projectionMatrixUniform = glGetUniformLocation(
-                    program,
-                    projectionMatrixUniformName.c_str());
-            GLint lightDirectionUniform = glGetUniformLocation(
-                    program,
-                    lightDirectionUniformName.c_str());
-            GLint textureUniform = glGetUniformLocation(
-                    program,
-                    textureUniformName.c_str());
-
-            // Only create a new shader if all the attributes are found.
-            if (positionAttribute != -1
-                && uvAttribute != -1
-                && modelMatrixUniform != -1
-                && viewMatrixUniform != -1
-                && projectionMatrixUniform != -1
-                && lightDirectionUniform != -1
-                && textureUniform != -1) {
-
-                shader = new Shader(
-                        program,
-                        positionAttribute,
-                        uvAttribute,
-                        modelMatrixUniform,
-                        viewMatrixUniform,
-                        projectionMatrixUniform,
-                        lightDirectionUniform,
-                        textureUniform);
-                glUseProgram(program);
-                glUniform1i(textureUniform, 0);
-                glUseProgram(0);
-            } else {
-                glDeleteProgram(program);
-            }
+            program = 0;
         }
     }
 
@@ -100,7 +133,7 @@ Shader *Shader::loadShader(
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
-    return shader;
+    return program;
 }
 
 GLuint Shader::loadShader(GLenum shaderType, const std::string &shaderSource) {
@@ -134,60 +167,25 @@ GLuint Shader::loadShader(GLenum shaderType, const std::string &shaderSource) {
     return shader;
 }
 
-void Shader::activate() const {
-    glUseProgram(program_);
+void Shader::activate(GlStateCache &stateCache) const {
+    stateCache.useProgram(program_);
 }
 
-void Shader::deactivate() const {
-    glUseProgram(0);
+GLint Shader::getUniformLocation(const std::string &name) const {
+    return glGetUniformLocation(program_, name.c_str());
 }
 
-void Shader::drawModel(const Model &model) const {
-    // The position attribute is 3 floats
-    glVertexAttribPointer(
-            position_, // attrib
-            3, // elements
-            GL_FLOAT, // of type float
-            GL_FALSE, // don't normalize
-            sizeof(Vertex), // stride is Vertex bytes
-            model.getVertexData() // pull from the start of the vertex data
-    );
-    glEnableVertexAttribArray(position_);
-
-    // The uv attribute is 2 floats
-    glVertexAttribPointer(
-            uv_, // attrib
-            2, // elements
-            GL_FLOAT, // of type float
-            GL_FALSE, // don't normalize
-            sizeof(Vertex), // stride is Vertex bytes
-            ((uint8_t *) model.getVertexData()) + sizeof(Vector3) // offset Vector3 from the start
-    );
-    glEnableVertexAttribArray(uv_);
-
+void Shader::drawModel(const Model &model, GlStateCache &stateCache) const {
     // Setup the texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, model.getTexture().getTextureID());
-
-    // Draw as indexed triangles
-    glDrawElements(GL_TRIANGLES, model.getIndexCount(), GL_UNSIGNED_SHORT, model.getIndexData());
-
-    glDisableVertexAttribArray(uv_);
-    glDisableVertexAttribArray(position_);
-}
-
-void Shader::setModelMatrix(const float *modelMatrix) const {
-    glUniformMatrix4fv(modelMatrix_, 1, GL_FALSE, modelMatrix);
-}
-
-void Shader::setViewMatrix(const float *viewMatrix) const {
-    glUniformMatrix4fv(viewMatrix_, 1, GL_FALSE, viewMatrix);
-}
+    stateCache.bindTexture(0, GL_TEXTURE_2D, model.getTexture().getTextureID());
 
-void Shader::setProjectionMatrix(const float *projectionMatrix) const {
-    glUniformMatrix4fv(projectionMatrix_, 1, GL_FALSE, projectionMatrix);
-}
+    // A procedural sphere rebuilds its vertices from gl_VertexID and needs the grid size for that
+    const auto &format = model.getVertexFormat();
+    if (format.proceduralSphere && sphereSegments_ != -1) {
+        glUniform2i(sphereSegments_, format.sphereLonSegments, format.sphereLatSegments);
+    }
 
-void Shader::setLightDirection(const float *direction) const {
-    glUniform3fv(lightDirection_, 1, direction);
+    // The vertex array holds the buffers and the whole attribute layout
+    stateCache.bindVertexArray(model.getVertexArray());
+    glDrawElements(GL_TRIANGLES, model.getIndexCount(), model.getIndexType(), nullptr);
 }
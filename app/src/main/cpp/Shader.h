@@ -4,17 +4,25 @@
 #include <string>
 #include <GLES3/gl3.h>
 
+class GlStateCache;
 class Model;
+class ProgramCache;
 
 /*!
  * A class representing a simple shader program. It consists of vertex and fragment components. The
- * input attributes are a position (as a Vector3) and a uv (as a Vector2). It exposes uniforms for
- * the model, view, and projection matrices independently as well as a single directional light
- * vector. The shader expects a single texture for fragment shading, and performs simple diffuse
- * lighting.
+ * input attributes are a position (as a Vector3) and a uv (as a Vector2). The matrices and the
+ * light direction come from the uniform blocks in @a kUniformBlocks, which every program is bound
+ * to when it's loaded. The shader expects a single texture for fragment shading, and performs
+ * simple diffuse lighting.
  */
 class Shader {
 public:
+    /*!
+     * The optional ivec2 uniform receiving (lonSegments, latSegments) of procedural sphere models,
+     * see @a VertexFormat::proceduralSphereFormat.
+     */
+    static constexpr const char *kSphereSegmentsUniformName = "uSphereSegments";
+
     /*!
      * Loads a shader given the full sourcecode and names for necessary attributes and uniforms to
      * link to. Returns a valid shader on success or null on failure. Shader resources are
@@ -24,19 +32,18 @@ public:
      * @param fragmentSource The full source code of your fragment program
      * @param positionAttributeName The name of the position attribute in your vertex program
      * @param uvAttributeName The name of the uv coordinate attribute in your vertex program
-     * @param projectionMatrixUniformName The name of your model/view/projection matrix uniform
-     * @return a valid Shader on success, otherwise null.
+     * @param textureUniformName The name of the sampler the model's texture is bound to
+     * @param programCache If not null, the linked program is restored from this cache when
+     * possible, and stored into it after a compile otherwise
+     * @return a valid Shader on success, otherwise null. The program in use is left as it was.
      */
     static Shader *loadShader(
             const std::string &vertexSource,
             const std::string &fragmentSource,
             const std::string &positionAttributeName,
             const std::string &uvAttributeName,
-            const std::string &modelMatrixUniformName,
-            const std::string &viewMatrixUniformName,
-            const std::string &projectionMatrixUniformName,
-            const std::string &lightDirectionUniformName,
-            const std::string &textureUniformName);
+            const std::string &textureUniformName,
+            ProgramCache *programCache = nullptr);
 
     inline ~Shader() {
         if (program_) {
@@ -46,32 +53,26 @@ public:
     }
 
     /*!
-     * Prepares the shader for use, call this before executing any draw commands
+     * Prepares the shader for use, call this before executing any draw commands. Does nothing if
+     * the program is already in use.
      */
-    void activate() const;
+    void activate(GlStateCache &stateCache) const;
 
-    /*!
-     * Cleans up the shader after use, call this after executing any draw commands
-     */
-    void deactivate() const;
+    //! @return the GL program, e.g. to sort draws by it
+    inline GLuint getProgram() const { return program_; }
 
     /*!
      * Renders a single model
      * @param model a model to render
      */
-    void drawModel(const Model &model) const;
+    void drawModel(const Model &model, GlStateCache &stateCache) const;
 
     /*!
-     * Sets the model/view/projection matrix in the shader.
-     * @param projectionMatrix sixteen floats, column major, defining an OpenGL projection matrix.
+     * Looks up a uniform this class doesn't track itself, e.g. an optional sampler.
+     * @param name the name of the uniform in either stage
+     * @return its location, or -1 if the program has no such active uniform
      */
-    void setModelMatrix(const float *modelMatrix) const;
-
-    void setViewMatrix(const float *viewMatrix) const;
-
-    void setProjectionMatrix(const float *projectionMatrix) const;
-
-    void setLightDirection(const float *direction) const;
+    GLint getUniformLocation(const std::string &name) const;
 
 private:
     /*!
@@ -82,39 +83,42 @@ private:
      */
     static GLuint loadShader(GLenum shaderType, const std::string &shaderSource);
 
+    /*!
+     * Helper function to compile both stages and link them into a program
+     * @param vertexSource The full source code for your vertex program
+     * @param fragmentSource The full source code of your fragment program
+     * @param retrievable Whether the program binary will be read back with glGetProgramBinary
+     * @return the id of the linked program, or 0 in the case of an error
+     */
+    static GLuint buildProgram(
+            const std::string &vertexSource,
+            const std::string &fragmentSource,
+            bool retrievable);
+
     /*!
      * Constructs a new instance of a shader. Use @a loadShader
      * @param program the GL program id of the shader
      * @param position the attribute location of the position
      * @param uv the attribute location of the uv coordinates
-     * @param projectionMatrix the uniform location of the projection matrix
+     * @param sphereSegments the uniform location of the procedural sphere size, or -1
      */
     constexpr Shader(
             GLuint program,
             GLint position,
             GLint uv,
-            GLint modelMatrix,
-            GLint viewMatrix,
-            GLint projectionMatrix,
-            GLint lightDirection,
-            GLint textureSampler)
+            GLint textureSampler,
+            GLint sphereSegments)
             : program_(program),
               position_(position),
               uv_(uv),
-              modelMatrix_(modelMatrix),
-              viewMatrix_(viewMatrix),
-              projectionMatrix_(projectionMatrix),
-              lightDirection_(lightDirection),
-              textureSampler_(textureSampler) {}
+              textureSampler_(textureSampler),
+              sphereSegments_(sphereSegments) {}
 
     GLuint program_;
     GLint position_;
     GLint uv_;
-    GLint modelMatrix_;
-    GLint viewMatrix_;
-    GLint projectionMatrix_;
-    GLint lightDirection_;
     GLint textureSampler_;
+    GLint sphereSegments_;
 };
 
 #endif //ANDROIDGLINVESTIGATIONS_SHADER_H
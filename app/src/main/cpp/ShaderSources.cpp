@@ -0,0 +1,402 @@
+#include "ShaderSources.h"
+
+#include "DistanceField.h"
+
+namespace {
+
+// Vertex shader, you'd typically load this from assets. The #version line, the uniform blocks and
+// the defines of the globe's VertexLayout are prepended in assembleGlobeShader.
+const char *kGlobeVertex = R"vertex(
+#ifdef PROCEDURAL_SPHERE
+// (lonSegments, latSegments) of the sphere, vertex i sits on row i / (lonSegments + 1)
+uniform ivec2 uSphereSegments;
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inUV;
+#endif
+#ifdef VERTEX_NORMALS
+layout(location = 2) in vec2 inNormal;
+#endif
+
+out highp vec2 fragUV;
+out vec3 fragNormal;
+
+#ifdef VERTEX_NORMALS
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+void main() {
+#ifdef PROCEDURAL_SPHERE
+    const float pi = 3.14159265358979;
+    int columns = uSphereSegments.x + 1;
+    highp vec2 uv = vec2(
+            float(gl_VertexID % columns) / float(uSphereSegments.x),
+            float(gl_VertexID / columns) / float(uSphereSegments.y));
+    float theta = uv.y * pi;
+    float phi = uv.x * 2.0 * pi;
+    vec3 position = vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+#else
+    highp vec2 uv = inUV;
+    vec3 position = inPosition;
+#endif
+#ifdef VERTEX_NORMALS
+    vec3 normal = decodeOctahedral(inNormal);
+#else
+    // Every model so far is a unit sphere, its normal is its position
+    vec3 normal = normalize(position);
+#endif
+    vec4 worldPos = uModel * vec4(position, 1.0);
+    mat3 normalMatrix = mat3(uView * uModel);
+    fragNormal = normalize(normalMatrix * normal);
+    fragUV = vec2(uv.x, 1.0 - uv.y);
+    gl_Position = uProjection * uView * worldPos;
+}
+)vertex";
+
+// Vertex shader of the chunked globe, see GlobeMesh. Places the shared chunk grid on the sphere.
+const char *kChunkVertex = R"vertex(
+layout(location = 0) in vec3 inGrid;
+
+out highp vec3 fragPosition;
+out vec3 fragNormal;
+
+// Columns u, v and center of the chunk's cube face
+uniform mat3 uFaceBasis;
+
+// Offset of the chunk in its face (xy), its size and how deep its skirt hangs
+uniform vec4 uChunk;
+
+// Same mapping as CubeSphere::cubeToSphere
+vec3 cubeToSphere(vec3 c) {
+    vec3 c2 = c * c;
+    return c * sqrt(1.0 - c2.yzx * 0.5 - c2.zxy * 0.5 + c2.yzx * c2.zxy / 3.0);
+}
+
+void main() {
+    vec2 face = (uChunk.xy + inGrid.xy * uChunk.z) * 2.0 - 1.0;
+    vec3 direction = cubeToSphere(uFaceBasis * vec3(face, 1.0));
+    vec3 position = direction * (1.0 - inGrid.z * uChunk.w);
+
+    fragPosition = direction;
+    vec4 worldPos = uModel * vec4(position, 1.0);
+    mat3 normalMatrix = mat3(uView * uModel);
+    fragNormal = normalize(normalMatrix * direction);
+    gl_Position = uProjection * uView * worldPos;
+}
+)vertex";
+
+// Vertex shader of the ray traced globe, see GlobeImpostor. Spans a quad facing the camera over
+// the unit sphere's silhouette, corner i of the strip is (i >> 1, i & 1) so it's wound
+// counterclockwise on screen and survives back-face culling.
+const char *kImpostorVertex = R"vertex(
+out highp vec3 fragViewPosition;
+
+void main() {
+    vec3 center = (uView * uModel * vec4(0.0, 0.0, 0.0, 1.0)).xyz;
+    float distance = length(center);
+
+    // The tangent cone from the eye has half angle asin(1 / distance). A quad through the centre
+    // covers it when it extends distance * tan of that angle.
+    float halfSize = distance / sqrt(max(distance * distance - 1.0, 1e-4));
+
+    vec3 forward = center / distance;
+    vec3 helper = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(helper, forward));
+    vec3 up = cross(forward, right);
+
+    vec2 corner = vec2(float(gl_VertexID >> 1), float(gl_VertexID & 1)) * 2.0 - 1.0;
+    vec3 position = center + (corner.x * right + corner.y * up) * halfSize;
+    fragViewPosition = position;
+    gl_Position = uProjection * vec4(position, 1.0);
+}
+)vertex";
+
+// Fragment shader, you'd typically load this from assets. The #version line and the uniform blocks
+// are prepended in assembleGlobeShader, with CHUNKED_GLOBE defined when drawing a GlobeMesh and
+// IMPOSTOR_GLOBE when drawing a GlobeImpostor.
+const char *kGlobeFragment = R"fragment(
+precision mediump float;
+
+#if defined(IMPOSTOR_GLOBE)
+// The view ray through this fragment, the eye is at the origin of view space
+in highp vec3 fragViewPosition;
+#elif defined(CHUNKED_GLOBE)
+// Texture coordinates are computed per fragment from the direction. Interpolating them per vertex
+// would smear a chunk that straddles the antimeridian across the whole map.
+in highp vec3 fragPosition;
+in vec3 fragNormal;
+#else
+in highp vec2 fragUV;
+in vec3 fragNormal;
+#endif
+
+uniform sampler2D uTexture;
+
+// Tiled imagery, see TileCache. uTexture is the fallback where no tile is resident.
+uniform bool uUseTiles;
+uniform mediump sampler2DArray uTileAtlas;
+uniform mediump usampler2D uTileIndirection;
+
+// The selected region, see RegionLayers: a region id per cell of the map, the distance to the
+// nearest boundary line and the id to show, 0 for none
+uniform highp usampler2D uRegionIds;
+uniform sampler2D uBoundaryField;
+uniform highp uint uSelectedRegion;
+
+// How wide the outline is drawn in screen pixels, however far the globe is zoomed
+uniform float uOutlineWidth;
+
+out vec4 outColor;
+
+const vec3 kHighlightColor = vec3(1.0, 0.922, 0.231);
+const float kHighlightOpacity = 0.4;
+const vec3 kOutlineColor = vec3(1.0, 0.922, 0.231);
+
+// Boundary lines run between cells, a line is the selection's if a cell this many cells away on
+// either axis is
+const int kOutlineReach = 2;
+
+// The boundary field stores 128 on the lines and BOUNDARY_FIELD_SPREAD texels per 127 away from
+// them, see DistanceField. BOUNDARY_FIELD_SPREAD is defined in assembleGlobeShader.
+float getBoundaryDistance(highp vec2 uv, highp vec2 uvDx, highp vec2 uvDy) {
+    float value = textureGrad(uBoundaryField, uv, uvDx, uvDy).r;
+    return (value * 255.0 - 128.0) * (BOUNDARY_FIELD_SPREAD / 127.0);
+}
+
+// How much of a fragment the outline covers, anti-aliased over a pixel. Distances are in field
+// texels, the gradients say how many of them a pixel spans.
+float getOutlineCoverage(highp vec2 uv, highp vec2 uvDx, highp vec2 uvDy) {
+    highp vec2 size = vec2(textureSize(uBoundaryField, 0));
+    float texelsPerPixel = max(0.5 * (length(uvDx * size) + length(uvDy * size)), 1e-4);
+    float away = abs(getBoundaryDistance(uv, uvDx, uvDy));
+    float coverage = clamp(0.5 * uOutlineWidth + 0.5 - away / texelsPerPixel, 0.0, 1.0);
+
+    // Farther than the field reaches every distance reads the same, zoomed far out that would
+    // cover everything near the region
+    return coverage * clamp((BOUNDARY_FIELD_SPREAD - away) / texelsPerPixel, 0.0, 1.0);
+}
+
+// uvDx and uvDy are the gradients of the continuous coordinate, the tile local one jumps at tile
+// borders. They have to be taken before any non-uniform branch.
+vec3 sampleImagery(highp vec2 uv, highp vec2 uvDx, highp vec2 uvDy) {
+    if (!uUseTiles) {
+        return textureGrad(uTexture, uv, uvDx, uvDy).rgb;
+    }
+
+    // One indirection texel per tile of the finest level tells which layer holds the finest
+    // resident tile there, and at what level
+    ivec2 cells = textureSize(uTileIndirection, 0);
+    ivec2 cell = clamp(ivec2(uv * vec2(cells)), ivec2(0), cells - 1);
+    uvec2 entry = texelFetch(uTileIndirection, cell, 0).rg;
+    if (entry.r == 255u) {
+        return textureGrad(uTexture, uv, uvDx, uvDy).rgb;
+    }
+
+    int level = int(entry.g);
+    int finestLevel = int(log2(float(cells.y)) + 0.5);
+    ivec2 tile = cell >> (finestLevel - level);
+    highp vec2 tileCount = vec2(float(2 << level), float(1 << level));
+    highp vec2 local = clamp(uv * tileCount - vec2(tile), 0.0, 1.0);
+    return textureGrad(
+            uTileAtlas,
+            vec3(local, float(entry.r)),
+            uvDx * tileCount,
+            uvDy * tileCount).rgb;
+}
+
+highp uint getRegion(ivec2 cell, ivec2 cells) {
+    cell.x = cell.x < 0 ? cell.x + cells.x : (cell.x >= cells.x ? cell.x - cells.x : cell.x);
+    cell.y = clamp(cell.y, 0, cells.y - 1);
+    return texelFetch(uRegionIds, cell, 0).r;
+}
+
+// How much of the selection's highlight (x) and outline (y) covers the fragment at uv
+vec2 sampleSelection(highp vec2 uv, highp vec2 uvDx, highp vec2 uvDy) {
+    if (uSelectedRegion == 0u) {
+        return vec2(0.0);
+    }
+
+    ivec2 cells = textureSize(uRegionIds, 0);
+    ivec2 cell = ivec2(floor(uv * vec2(cells)));
+    bool inside = getRegion(cell, cells) == uSelectedRegion;
+    bool near = inside
+            || getRegion(cell + ivec2(kOutlineReach, 0), cells) == uSelectedRegion
+            || getRegion(cell - ivec2(kOutlineReach, 0), cells) == uSelectedRegion
+            || getRegion(cell + ivec2(0, kOutlineReach), cells) == uSelectedRegion
+            || getRegion(cell - ivec2(0, kOutlineReach), cells) == uSelectedRegion;
+    float boundary = near ? getOutlineCoverage(uv, uvDx, uvDy) : 0.0;
+    return vec2(inside ? kHighlightOpacity : 0.0, boundary);
+}
+
+void main() {
+#if defined(IMPOSTOR_GLOBE)
+    // Intersect the view ray with the unit sphere. Everything below is computed even for rays that
+    // miss so the derivatives stay defined, they're discarded at the end.
+    highp mat4 modelView = uView * uModel;
+    highp vec3 center = modelView[3].xyz;
+    highp vec3 ray = normalize(fragViewPosition);
+    highp float along = dot(ray, center);
+    highp float discriminant = along * along - dot(center, center) + 1.0;
+    highp vec3 hit = ray * (along - sqrt(max(discriminant, 0.0)));
+    highp vec3 viewNormal = normalize(hit - center);
+
+    // The discriminant falls off linearly across the limb, which gives a pixel wide coverage ramp
+    float coverage = clamp(0.5 + discriminant / max(fwidth(discriminant), 1e-6), 0.0, 1.0);
+
+    // The model matrix is a rotation, its transpose takes the view normal back to the globe
+    highp vec3 direction = transpose(mat3(modelView)) * viewNormal;
+    vec3 normal = viewNormal;
+
+    highp vec4 clipPosition = uProjection * vec4(hit, 1.0);
+    gl_FragDepth = clamp(clipPosition.z / clipPosition.w * 0.5 + 0.5, 0.0, 1.0);
+#elif defined(CHUNKED_GLOBE)
+    highp vec3 direction = normalize(fragPosition);
+    vec3 normal = normalize(fragNormal);
+#endif
+#if defined(IMPOSTOR_GLOBE) || defined(CHUNKED_GLOBE)
+    // The same mapping as the UV sphere: u runs with longitude, v from the south pole up
+    const highp float pi = 3.14159265358979;
+    highp float longitude = atan(direction.z, direction.x) / (2.0 * pi);
+    highp vec2 uv = vec2(fract(longitude), 1.0 - acos(clamp(direction.y, -1.0, 1.0)) / pi);
+    highp vec2 uvDx = dFdx(uv);
+    highp vec2 uvDy = dFdy(uv);
+
+    // fract() jumps at longitude 0 and atan() at 180 degrees, take the gradient of whichever is
+    // continuous at this fragment so the mip level doesn't collapse along the seam
+    highp float longitudeDx = dFdx(longitude);
+    highp float longitudeDy = dFdy(longitude);
+    if (abs(longitudeDx) + abs(longitudeDy) < abs(uvDx.x) + abs(uvDy.x)) {
+        uvDx.x = longitudeDx;
+        uvDy.x = longitudeDy;
+    }
+#else
+    highp vec2 uv = fragUV;
+    highp vec2 uvDx = dFdx(uv);
+    highp vec2 uvDy = dFdy(uv);
+    vec3 normal = normalize(fragNormal);
+#endif
+    vec3 baseColor = sampleImagery(uv, uvDx, uvDy);
+    vec2 selection = sampleSelection(uv, uvDx, uvDy);
+    baseColor = mix(baseColor, kHighlightColor, selection.x);
+    float diffuse = max(dot(normal, normalize(uLightDir.xyz)), 0.0);
+    float ambient = 0.3;
+    float brightness = clamp(ambient + diffuse * 0.7, 0.0, 1.0);
+    vec3 litColor = baseColor * brightness;
+    float rim = pow(1.0 - max(dot(normal, vec3(0.0, 0.0, -1.0)), 0.0), 2.0);
+    litColor += vec3(0.05, 0.1, 0.2) * rim;
+
+    // The outline isn't shaded, it reads as a line on the map even on the night side
+    litColor = mix(litColor, kOutlineColor, selection.y);
+#ifdef IMPOSTOR_GLOBE
+    if (coverage <= 0.0) {
+        discard;
+    }
+    outColor = vec4(litColor, coverage);
+#else
+    outColor = vec4(litColor, 1.0);
+#endif
+}
+)fragment";
+
+// Billboards of the marker layer. Corner i of the strip is (i & 1, i >> 1), counterclockwise.
+const char *kMarkerVertex = R"vertex(
+layout(location = 0) in vec3 inDirection;
+layout(location = 1) in float inSize;
+layout(location = 2) in vec4 inColor;
+// (atlas index, flags)
+layout(location = 3) in uvec2 inSymbol;
+
+out vec2 fragCorner;
+flat out float fragLayer;
+flat out vec4 fragColor;
+
+const uint kHidden = 1u;
+const uint kHighlighted = 2u;
+const float kSizeUnits = 16.0;
+
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    fragCorner = corner;
+    fragLayer = float(inSymbol.x);
+    fragColor = inColor;
+
+    // Same test as MarkerSet::isVisible. Markers behind the horizon go outside the clip volume.
+    bool hidden = (inSymbol.y & kHidden) != 0u;
+    if (hidden || dot(inDirection, uCameraPosition.xyz) <= dot(inDirection, inDirection)) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    float size = inSize / kSizeUnits;
+    if ((inSymbol.y & kHighlighted) != 0u) {
+        size *= 1.5;
+        fragColor.rgb = mix(fragColor.rgb, vec3(1.0), 0.35);
+    }
+
+    // One pixel in view units at the marker's depth, projection[1][1] is 1 / tan(fovY / 2)
+    vec3 center = (uView * uModel * vec4(inDirection, 1.0)).xyz;
+    float pixel = 2.0 * -center.z / (uProjection[1][1] * uViewport.y);
+    float radius = 0.5 * size * pixel;
+
+    // Pulled towards the eye by its radius, so the globe doesn't cut the billboard in half
+    center -= normalize(center) * radius;
+    vec3 position = center + vec3((corner * 2.0 - 1.0) * radius, 0.0);
+    gl_Position = uProjection * vec4(position, 1.0);
+}
+)vertex";
+
+const char *kMarkerFragment = R"fragment(
+precision mediump float;
+
+uniform mediump sampler2DArray uAtlas;
+
+in vec2 fragCorner;
+flat in float fragLayer;
+flat in vec4 fragColor;
+
+out vec4 outColor;
+
+void main() {
+    // r covers the symbol, g its inside without the outline
+    vec2 symbol = texture(uAtlas, vec3(fragCorner, fragLayer)).rg;
+    if (symbol.r <= 0.0) {
+        discard;
+    }
+    outColor = vec4(fragColor.rgb * mix(0.2, 1.0, symbol.g), fragColor.a * symbol.r);
+}
+)fragment";
+
+} // namespace
+
+ShaderSources assembleGlobeShader(GlobeMode mode, const std::string &vertexDefines) {
+    ShaderSources sources;
+    sources.vertex = std::string("#version 300 es\n") + kUniformBlockSource;
+    sources.fragment = std::string("#version 300 es\n") + kUniformBlockSource;
+    switch (mode) {
+        case GlobeMode::UvSphere:
+            sources.vertex += vertexDefines + kGlobeVertex;
+            break;
+        case GlobeMode::Chunked:
+            sources.vertex += kChunkVertex;
+            sources.fragment += "#define CHUNKED_GLOBE\n";
+            break;
+        case GlobeMode::Impostor:
+            sources.vertex += kImpostorVertex;
+            sources.fragment += "#define IMPOSTOR_GLOBE\n";
+            break;
+    }
+    sources.fragment += "#define BOUNDARY_FIELD_SPREAD "
+                        + std::to_string(DistanceField::kSpreadTexels) + "\n";
+    sources.fragment += kGlobeFragment;
+    return sources;
+}
+
+ShaderSources assembleMarkerShader() {
+    std::string header = std::string("#version 300 es\n") + kUniformBlockSource;
+    return {header + kMarkerVertex, header + kMarkerFragment};
+}
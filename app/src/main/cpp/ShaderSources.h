@@ -0,0 +1,55 @@
+#ifndef ANDROIDGLINVESTIGATIONS_SHADERSOURCES_H
+#define ANDROIDGLINVESTIGATIONS_SHADERSOURCES_H
+
+#include <string>
+
+// The GLSL the renderer's programs are assembled from. Platform independent, the host tools write
+// out every variant and validate it with glslangValidator.
+
+//! the GLSL declarations of the blocks, for both stages. The precisions are spelled out since
+//! a block used by both stages must declare its members the same way in each.
+constexpr const char *kUniformBlockSource = R"glsl(
+layout(std140) uniform CameraBlock {
+    highp mat4 uProjection;
+    highp mat4 uView;
+    highp vec4 uViewport;
+};
+
+layout(std140) uniform GlobeBlock {
+    highp mat4 uModel;
+    highp vec4 uLightDir;
+    highp vec4 uCameraPosition;
+};
+)glsl";
+
+/*!
+ * How the globe is drawn.
+ */
+enum class GlobeMode {
+    //! a single UV sphere @a Model, drawn whole
+    UvSphere,
+    //! a @a GlobeMesh, only the visible chunks at the detail the view needs
+    Chunked,
+    //! a @a GlobeImpostor, one quad ray traced against the sphere per pixel
+    Impostor,
+};
+
+/*!
+ * Both stages of a program, ready for @a Shader::loadShader.
+ */
+struct ShaderSources {
+    std::string vertex;
+    std::string fragment;
+};
+
+/*!
+ * @param vertexDefines the #define lines of the globe's @a VertexLayout, only
+ *     @a GlobeMode::UvSphere reads vertex attributes
+ * @return the globe's program, specialised for the way it's drawn
+ */
+ShaderSources assembleGlobeShader(GlobeMode mode, const std::string &vertexDefines);
+
+//! @return the program of @a MarkerLayer
+ShaderSources assembleMarkerShader();
+
+#endif //ANDROIDGLINVESTIGATIONS_SHADERSOURCES_H
@@ -0,0 +1,154 @@
+#ifndef ANDROIDGLINVESTIGATIONS_SIMD4_H
+#define ANDROIDGLINVESTIGATIONS_SIMD4_H
+
+/*!
+ * The few 4-wide float primitives the SIMD kernels are written in, for the .cpp files that have
+ * kernels only. NEON on ARM and SSE2 on x86. Anything else, or defining EARTHZOO_MATH_SCALAR like
+ * the host tests do to check both paths, gets plain C++.
+ *
+ * Every backend rounds the same way, so they agree bit for bit: @a madd rounds the product before
+ * adding on all of them rather than fusing it where NEON could. Loads and stores take unaligned
+ * pointers.
+ *
+ * The primitives have internal linkage, a binary may link kernels built for different backends,
+ * like the host tools do.
+ */
+
+#include <cstdint>
+
+#if !defined(EARTHZOO_MATH_SCALAR) && defined(__ARM_NEON)
+#define EARTHZOO_SIMD_NEON 1
+#include <arm_neon.h>
+#elif !defined(EARTHZOO_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define EARTHZOO_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+#if defined(EARTHZOO_SIMD_NEON)
+
+typedef float32x4_t Float4;
+typedef uint32x4_t Mask4;
+
+inline Float4 load(const float *source) { return vld1q_f32(source); }
+
+inline void store(float *destination, Float4 value) { vst1q_f32(destination, value); }
+
+inline Float4 splat(float value) { return vdupq_n_f32(value); }
+
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+
+inline Float4 sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+
+inline Mask4 splatMask(uint32_t value) { return vdupq_n_u32(value); }
+
+inline Mask4 zeroMask() { return vdupq_n_u32(0); }
+
+inline Mask4 greater(Float4 a, Float4 b) { return vcgtq_f32(a, b); }
+
+inline Mask4 maskXor(Mask4 a, Mask4 b) { return veorq_u32(a, b); }
+
+inline Mask4 maskAnd(Mask4 a, Mask4 b) { return vandq_u32(a, b); }
+
+inline void storeMask(uint32_t *destination, Mask4 mask) { vst1q_u32(destination, mask); }
+
+#elif defined(EARTHZOO_SIMD_SSE)
+
+typedef __m128 Float4;
+typedef __m128i Mask4;
+
+inline Float4 load(const float *source) { return _mm_loadu_ps(source); }
+
+inline void store(float *destination, Float4 value) { _mm_storeu_ps(destination, value); }
+
+inline Float4 splat(float value) { return _mm_set1_ps(value); }
+
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+
+inline Float4 sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+
+inline Mask4 splatMask(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+
+inline Mask4 zeroMask() { return _mm_setzero_si128(); }
+
+inline Mask4 greater(Float4 a, Float4 b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+
+inline Mask4 maskXor(Mask4 a, Mask4 b) { return _mm_xor_si128(a, b); }
+
+inline Mask4 maskAnd(Mask4 a, Mask4 b) { return _mm_and_si128(a, b); }
+
+inline void storeMask(uint32_t *destination, Mask4 mask) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(destination), mask);
+}
+
+#else
+
+struct Float4 {
+    float v[4];
+};
+
+struct Mask4 {
+    uint32_t v[4];
+};
+
+inline Float4 load(const float *source) { return {{source[0], source[1], source[2], source[3]}}; }
+
+inline void store(float *destination, Float4 value) {
+    for (int i = 0; i < 4; ++i) {
+        destination[i] = value.v[i];
+    }
+}
+
+inline Float4 splat(float value) { return {{value, value, value, value}}; }
+
+inline Float4 add(Float4 a, Float4 b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+
+inline Float4 sub(Float4 a, Float4 b) {
+    return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+}
+
+inline Float4 mul(Float4 a, Float4 b) {
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+
+inline Mask4 splatMask(uint32_t value) { return {{value, value, value, value}}; }
+
+inline Mask4 zeroMask() { return {{0u, 0u, 0u, 0u}}; }
+
+inline Mask4 greater(Float4 a, Float4 b) {
+    Mask4 result;
+    for (int i = 0; i < 4; ++i) {
+        result.v[i] = a.v[i] > b.v[i] ? 0xFFFFFFFFu : 0u;
+    }
+    return result;
+}
+
+inline Mask4 maskXor(Mask4 a, Mask4 b) {
+    return {{a.v[0] ^ b.v[0], a.v[1] ^ b.v[1], a.v[2] ^ b.v[2], a.v[3] ^ b.v[3]}};
+}
+
+inline Mask4 maskAnd(Mask4 a, Mask4 b) {
+    return {{a.v[0] & b.v[0], a.v[1] & b.v[1], a.v[2] & b.v[2], a.v[3] & b.v[3]}};
+}
+
+inline void storeMask(uint32_t *destination, Mask4 mask) {
+    for (int i = 0; i < 4; ++i) {
+        destination[i] = mask.v[i];
+    }
+}
+
+#endif
+
+//! a * b + c, the product rounded first on every backend
+inline Float4 madd(Float4 a, Float4 b, Float4 c) { return add(mul(a, b), c); }
+
+} // namespace
+
+#endif //ANDROIDGLINVESTIGATIONS_SIMD4_H
@@ -0,0 +1,58 @@
+#ifndef ANDROIDGLINVESTIGATIONS_SPSCQUEUE_H
+#define ANDROIDGLINVESTIGATIONS_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * A bounded, lock-free queue for exactly one producer thread and one consumer thread. Neither side
+ * ever blocks: @a push fails when the queue is full and @a pop fails when it's empty, leaving it to
+ * the caller to decide whether to retry, coalesce or drop.
+ *
+ * @tparam T a trivially copyable item type
+ * @tparam N the capacity, must be a power of two
+ */
+template<typename T, size_t N>
+class SpscQueue {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+    /*!
+     * Appends an item. Only call this from the producer thread.
+     *
+     * @return false if the queue is full, in which case nothing was added
+     */
+    bool push(const T &item) {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * Removes the oldest item. Only call this from the consumer thread.
+     *
+     * @return false if the queue is empty, in which case @a outItem is untouched
+     */
+    bool pop(T &outItem) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        outItem = items_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Keep the two indices on separate cache lines so the threads don't false-share
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) std::array<T, N> items_{};
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_SPSCQUEUE_H
@@ -8,6 +8,11 @@
 
 #include "TextureAsset.h"
 
+#include <GLES2/gl2ext.h>
+
+#include "AndroidOut.h"
+#include "Utility.h"
+
 namespace {
 
 GLuint createTextureFromPixels(const uint8_t *data, int width, int height) {
@@ -37,10 +42,50 @@ GLuint createTextureFromPixels(const uint8_t *data, int width, int height) {
     return textureId;
 }
 
+bool assetExists(AAssetManager *assetManager, const std::string &assetPath) {
+    auto pAsset = AAssetManager_open(assetManager, assetPath.c_str(), AASSET_MODE_UNKNOWN);
+    if (!pAsset) {
+        return false;
+    }
+    AAsset_close(pAsset);
+    return true;
+}
+
 } // namespace
 
 std::shared_ptr<TextureAsset>
 TextureAsset::loadAsset(AAssetManager *assetManager, const std::string &assetPath) {
+    if (isCompressedAsset(assetPath)) {
+        CompressedImageData compressed;
+        auto read = readCompressedAsset(assetManager, assetPath, compressed);
+        assert(read);
+
+        auto spTexture = createCompressedStorage(
+                compressed.internalFormat,
+                compressed.width,
+                compressed.height,
+                static_cast<int>(compressed.levels.size()));
+        for (size_t level = 0; level < compressed.levels.size(); ++level) {
+            spTexture->uploadCompressedLevel(
+                    static_cast<int>(level),
+                    compressed.internalFormat,
+                    compressed.levels[level]);
+        }
+        return spTexture;
+    }
+
+    ImageData image;
+    auto decoded = decodeAsset(assetManager, assetPath, image);
+    assert(decoded);
+
+    auto textureId = createTextureFromPixels(image.pixels.data(), image.width, image.height);
+    return std::shared_ptr<TextureAsset>(new TextureAsset(textureId));
+}
+
+bool TextureAsset::decodeAsset(
+        AAssetManager *assetManager,
+        const std::string &assetPath,
+        ImageData &outImage) {
     // Get the image from asset manager
     assert(assetManager != nullptr);
 
@@ -48,12 +93,17 @@ TextureAsset::loadAsset(AAssetManager *assetManager, const std::string &assetPat
             assetManager,
             assetPath.c_str(),
             AASSET_MODE_BUFFER);
-    assert(pAsset != nullptr);
+    if (!pAsset) {
+        return false;
+    }
 
     // Make a decoder to turn it into a texture
     AImageDecoder *pAndroidDecoder = nullptr;
     auto result = AImageDecoder_createFromAAsset(pAsset, &pAndroidDecoder);
-    assert(result == ANDROID_IMAGE_DECODER_SUCCESS);
+    if (result != ANDROID_IMAGE_DECODER_SUCCESS) {
+        AAsset_close(pAsset);
+        return false;
+    }
 
     // make sure we get 8 bits per channel out. RGBA order.
     AImageDecoder_setAndroidBitmapFormat(pAndroidDecoder, ANDROID_BITMAP_FORMAT_RGBA_8888);
@@ -62,29 +112,200 @@ TextureAsset::loadAsset(AAssetManager *assetManager, const std::string &assetPat
     const AImageDecoderHeaderInfo *pAndroidHeader = nullptr;
     pAndroidHeader = AImageDecoder_getHeaderInfo(pAndroidDecoder);
 
-    // important metrics for sending to GL
+    // important metrics for sending to GL. Ask for a tightly packed stride so rows can be
+    // uploaded without GL_UNPACK_ROW_LENGTH.
     auto width = AImageDecoderHeaderInfo_getWidth(pAndroidHeader);
     auto height = AImageDecoderHeaderInfo_getHeight(pAndroidHeader);
-    auto stride = AImageDecoder_getMinimumStride(pAndroidDecoder);
+    auto stride = static_cast<size_t>(width) * 4;
 
     // Get the bitmap data of the image
-    auto upAndroidImageData = std::make_unique<std::vector<uint8_t>>(height * stride);
+    outImage.width = width;
+    outImage.height = height;
+    outImage.pixels.resize(height * stride);
     auto decodeResult = AImageDecoder_decodeImage(
             pAndroidDecoder,
-            upAndroidImageData->data(),
+            outImage.pixels.data(),
             stride,
-            upAndroidImageData->size());
-    assert(decodeResult == ANDROID_IMAGE_DECODER_SUCCESS);
-
-    auto textureId = createTextureFromPixels(upAndroidImageData->data(), width, height);
+            outImage.pixels.size());
 
     // cleanup helpers
     AImageDecoder_delete(pAndroidDecoder);
     AAsset_close(pAsset);
 
+    return decodeResult == ANDROID_IMAGE_DECODER_SUCCESS;
+}
+
+std::string TextureAsset::selectAssetVariant(
+        AAssetManager *assetManager,
+        const std::string &baseName) {
+    // ASTC needs an extension on GLES 3.0, but gives better quality per bit where it's available.
+    // ETC2 is part of core GLES 3.0.
+    std::vector<std::string> candidates;
+    if (Utility::hasGlExtension("GL_KHR_texture_compression_astc_ldr")) {
+        candidates.push_back(baseName + ".astc.ktx2");
+    }
+    candidates.push_back(baseName + ".etc2.ktx2");
+
+    for (auto &candidate: candidates) {
+        if (assetExists(assetManager, candidate)) {
+            return candidate;
+        }
+    }
+    return baseName + ".png";
+}
+
+bool TextureAsset::isCompressedAsset(const std::string &assetPath) {
+    static const std::string kExtension = ".ktx2";
+    return assetPath.size() >= kExtension.size()
+           && assetPath.compare(assetPath.size() - kExtension.size(), kExtension.size(), kExtension)
+              == 0;
+}
+
+bool TextureAsset::readCompressedAsset(
+        AAssetManager *assetManager,
+        const std::string &assetPath,
+        CompressedImageData &outImage) {
+    assert(assetManager != nullptr);
+
+    auto pAsset = AAssetManager_open(
+            assetManager,
+            assetPath.c_str(),
+            AASSET_MODE_BUFFER);
+    if (!pAsset) {
+        return false;
+    }
+
+    auto *data = static_cast<const uint8_t *>(AAsset_getBuffer(pAsset));
+    auto size = static_cast<size_t>(AAsset_getLength64(pAsset));
+
+    Ktx2Image ktx;
+    bool valid = data && Ktx2::parse(data, size, ktx);
+    auto internalFormat = valid ? getGlFormat(ktx.format) : GL_NONE;
+    if (internalFormat == GL_NONE) {
+        aout << "Unsupported KTX2 file " << assetPath << std::endl;
+        AAsset_close(pAsset);
+        return false;
+    }
+
+    outImage.internalFormat = internalFormat;
+    outImage.width = ktx.width;
+    outImage.height = ktx.height;
+    outImage.levels.clear();
+    for (auto &level: ktx.levels) {
+        CompressedImageData::Level copy;
+        copy.width = level.width;
+        copy.height = level.height;
+        copy.data.assign(data + level.offset, data + level.offset + level.length);
+        outImage.levels.push_back(std::move(copy));
+    }
+
+    AAsset_close(pAsset);
+    return true;
+}
+
+GLenum TextureAsset::getGlFormat(Ktx2Format format) {
+    switch (format) {
+        case Ktx2Format::Etc2Rgb8Unorm:
+            return GL_COMPRESSED_RGB8_ETC2;
+        case Ktx2Format::Etc2Rgb8Srgb:
+            return GL_COMPRESSED_SRGB8_ETC2;
+        case Ktx2Format::Etc2Rgba8Unorm:
+            return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case Ktx2Format::Etc2Rgba8Srgb:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+        case Ktx2Format::Astc4x4Unorm:
+            return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+        case Ktx2Format::Astc4x4Srgb:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+        case Ktx2Format::Astc6x6Unorm:
+            return GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+        case Ktx2Format::Astc6x6Srgb:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR;
+        case Ktx2Format::Astc8x8Unorm:
+            return GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+        case Ktx2Format::Astc8x8Srgb:
+            return GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR;
+        default:
+            return GL_NONE;
+    }
+}
+
+std::shared_ptr<TextureAsset> TextureAsset::createStorage(int width, int height, int levelCount) {
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, width, height);
+
+    return std::shared_ptr<TextureAsset>(new TextureAsset(textureId));
+}
+
+void TextureAsset::uploadRows(
+        int level,
+        int yOffset,
+        int width,
+        int rowCount,
+        const uint8_t *pixels) const {
+    glBindTexture(GL_TEXTURE_2D, textureID_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(
+            GL_TEXTURE_2D,
+            level,
+            0,
+            yOffset,
+            width,
+            rowCount,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            pixels);
+}
+
+std::shared_ptr<TextureAsset> TextureAsset::createCompressedStorage(
+        GLenum internalFormat,
+        int width,
+        int height,
+        int levelCount) {
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Compressed formats can't be mipmapped by GL, the file has to carry every level it needs
+    glTexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, width, height);
+
     return std::shared_ptr<TextureAsset>(new TextureAsset(textureId));
 }
 
+void TextureAsset::uploadCompressedLevel(
+        int level,
+        GLenum internalFormat,
+        const CompressedImageData::Level &image) const {
+    glBindTexture(GL_TEXTURE_2D, textureID_);
+    glCompressedTexSubImage2D(
+            GL_TEXTURE_2D,
+            level,
+            0,
+            0,
+            image.width,
+            image.height,
+            internalFormat,
+            static_cast<GLsizei>(image.data.size()),
+            image.data.data());
+}
+
 TextureAsset::~TextureAsset() {
     // return texture resources
     glDeleteTextures(1, &textureID_);
@@ -4,12 +4,36 @@
 #include <memory>
 #include <android/asset_manager.h>
 #include <GLES3/gl3.h>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include "ImageData.h"
+#include "Ktx2.h"
+
+/*!
+ * Block compressed mip levels read from a KTX2 file, ready for glCompressedTexSubImage2D.
+ */
+struct CompressedImageData {
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> data;
+    };
+
+    GLenum internalFormat = GL_NONE;
+    int width = 0;
+    int height = 0;
+
+    //! level 0 (full size) first
+    std::vector<Level> levels;
+};
 
 class TextureAsset {
 public:
     /*!
-     * Loads a texture asset from the assets/ directory
+     * Loads a texture asset from the assets/ directory. Files ending in .ktx2 are uploaded as
+     * compressed blocks with their baked mip levels, anything else is decoded as an image.
      * @param assetManager Asset manager to use
      * @param assetPath The path to the asset
      * @return a shared pointer to a texture asset, resources will be reclaimed when it's cleaned up
@@ -19,6 +43,89 @@ public:
 
     static std::shared_ptr<TextureAsset> createProceduralEarthTexture();
 
+    /*!
+     * Picks the best variant of a texture the device can sample. Looks for
+     * "<baseName>.astc.ktx2" if ASTC is supported, then "<baseName>.etc2.ktx2", which every
+     * GLES 3 device can decode, and falls back to "<baseName>.png". Needs a current GL context.
+     *
+     * @return the asset path to load
+     */
+    static std::string selectAssetVariant(AAssetManager *assetManager, const std::string &baseName);
+
+    /*!
+     * @return true if @a assetPath names a KTX2 file that @a readCompressedAsset handles
+     */
+    static bool isCompressedAsset(const std::string &assetPath);
+
+    /*!
+     * Reads a KTX2 file from the assets/ directory without touching GL, so it's safe to call from
+     * any thread.
+     * @param assetManager Asset manager to use
+     * @param assetPath The path to the asset
+     * @param outImage receives the compressed levels
+     * @return true if the file was valid and its format maps to a GL format
+     */
+    static bool readCompressedAsset(
+            AAssetManager *assetManager,
+            const std::string &assetPath,
+            CompressedImageData &outImage);
+
+    /*!
+     * @return the GL internal format for @a format, or GL_NONE if there is none
+     */
+    static GLenum getGlFormat(Ktx2Format format);
+
+    /*!
+     * Decodes an image from the assets/ directory without touching GL, so it's safe to call from
+     * any thread.
+     * @param assetManager Asset manager to use
+     * @param assetPath The path to the asset
+     * @param outImage receives the decoded pixels
+     * @return true on success
+     */
+    static bool decodeAsset(
+            AAssetManager *assetManager,
+            const std::string &assetPath,
+            ImageData &outImage);
+
+    /*!
+     * Allocates immutable RGBA storage for a texture with @a levelCount mip levels. The contents
+     * are undefined until they're filled in with @a uploadRows.
+     */
+    static std::shared_ptr<TextureAsset> createStorage(int width, int height, int levelCount);
+
+    /*!
+     * Uploads a horizontal band of tightly packed RGBA pixels into one mip level. Lets large
+     * textures be uploaded in slices spread over several frames.
+     * @param level the mip level to write
+     * @param yOffset the first row to write
+     * @param width the width of the mip level
+     * @param rowCount how many rows @a pixels holds
+     * @param pixels the rows to upload
+     */
+    void uploadRows(int level, int yOffset, int width, int rowCount, const uint8_t *pixels) const;
+
+    /*!
+     * Allocates immutable storage in a compressed @a internalFormat, to be filled in with
+     * @a uploadCompressedLevel.
+     */
+    static std::shared_ptr<TextureAsset> createCompressedStorage(
+            GLenum internalFormat,
+            int width,
+            int height,
+            int levelCount);
+
+    /*!
+     * Uploads one whole level of compressed blocks.
+     * @param level the mip level to write
+     * @param internalFormat the format the storage was created with
+     * @param image the level's size and blocks
+     */
+    void uploadCompressedLevel(
+            int level,
+            GLenum internalFormat,
+            const CompressedImageData::Level &image) const;
+
     ~TextureAsset();
 
     /*!
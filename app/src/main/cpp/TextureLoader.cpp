@@ -0,0 +1,170 @@
+#include "TextureLoader.h"
+
+#include <android/looper.h>
+#include <algorithm>
+
+#include "AndroidOut.h"
+
+TextureLoader::TextureLoader(AAssetManager *assetManager) :
+        assetManager_(assetManager),
+        looper_(ALooper_forThread()),
+        decodedCount_(0),
+        quit_(false) {
+    if (looper_) {
+        ALooper_acquire(looper_);
+    }
+    worker_ = std::thread(&TextureLoader::workerMain, this);
+}
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    condition_.notify_all();
+    worker_.join();
+
+    if (looper_) {
+        ALooper_release(looper_);
+    }
+}
+
+void TextureLoader::load(const std::string &assetPath, Callback onReady) {
+    auto job = std::make_unique<Job>();
+    job->assetPath = assetPath;
+    job->onReady = std::move(onReady);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.push_back(std::move(job));
+    }
+    condition_.notify_all();
+}
+
+void TextureLoader::uploadPending(size_t byteBudget) {
+    if (decodedCount_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &job: decoded_) {
+            uploading_.push_back(std::move(job));
+        }
+        decoded_.clear();
+        decodedCount_.store(0, std::memory_order_release);
+    }
+
+    size_t uploaded = 0;
+    while (!uploading_.empty() && uploaded < byteBudget) {
+        auto &job = *uploading_.front();
+        uploaded += uploadSlice(job, byteBudget - uploaded);
+
+        if (job.level == job.getLevelCount()) {
+            aout << "TextureLoader: " << job.assetPath << " ready, "
+                 << job.uploadedBytes / 1024 << " KiB" << std::endl;
+            auto finished = std::move(uploading_.front());
+            uploading_.erase(uploading_.begin());
+            finished->onReady(std::move(finished->texture));
+        }
+    }
+}
+
+size_t TextureLoader::uploadSlice(Job &job, size_t byteBudget) {
+    if (!job.compressed.levels.empty()) {
+        auto &compressed = job.compressed;
+        if (!job.texture) {
+            job.texture = TextureAsset::createCompressedStorage(
+                    compressed.internalFormat,
+                    compressed.width,
+                    compressed.height,
+                    static_cast<int>(compressed.levels.size()));
+        }
+
+        // Compressed levels go up whole, they are small enough that one per slice is fine
+        auto &level = compressed.levels[job.level];
+        auto bytes = level.data.size();
+        job.texture->uploadCompressedLevel(
+                static_cast<int>(job.level),
+                compressed.internalFormat,
+                level);
+        level.data = std::vector<uint8_t>();
+        job.level++;
+        job.uploadedBytes += bytes;
+        return bytes;
+    }
+
+    if (!job.texture) {
+        auto &base = job.levels.front();
+        job.texture = TextureAsset::createStorage(
+                base.width,
+                base.height,
+                static_cast<int>(job.levels.size()));
+    }
+
+    // Upload as many rows of the current level as fit in what's left of the budget, but at
+    // least one so progress is always made.
+    auto &level = job.levels[job.level];
+    auto rowBytes = static_cast<size_t>(level.width) * 4;
+    auto rows = static_cast<int>(std::max<size_t>(byteBudget / rowBytes, 1));
+    rows = std::min(rows, level.height - job.row);
+
+    job.texture->uploadRows(
+            static_cast<int>(job.level),
+            job.row,
+            level.width,
+            rows,
+            &level.pixels[job.row * rowBytes]);
+    auto bytes = rows * rowBytes;
+    job.row += rows;
+    job.uploadedBytes += bytes;
+
+    if (job.row == level.height) {
+        // Free the CPU copy as soon as a level is on the GPU
+        level.pixels = std::vector<uint8_t>();
+        job.level++;
+        job.row = 0;
+    }
+    return bytes;
+}
+
+void TextureLoader::workerMain() {
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return quit_ || !queued_.empty(); });
+            if (quit_) {
+                return;
+            }
+            job = std::move(queued_.front());
+            queued_.pop_front();
+        }
+
+        if (TextureAsset::isCompressedAsset(job->assetPath)) {
+            // The mip chain was baked offline, there's nothing to do but read it
+            if (!TextureAsset::readCompressedAsset(assetManager_, job->assetPath, job->compressed)) {
+                aout << "TextureLoader: failed to read " << job->assetPath << std::endl;
+                continue;
+            }
+        } else {
+            ImageData image;
+            if (!TextureAsset::decodeAsset(assetManager_, job->assetPath, image)) {
+                aout << "TextureLoader: failed to decode " << job->assetPath << std::endl;
+                continue;
+            }
+
+            // Build the whole mip chain here so the render thread never runs glGenerateMipmap
+            job->levels = image.buildMipChain();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (quit_) {
+                return;
+            }
+            decoded_.push_back(std::move(job));
+            decodedCount_.store(decoded_.size(), std::memory_order_release);
+        }
+
+        // The render thread may be idle, wake it so it starts uploading
+        if (looper_) {
+            ALooper_wake(looper_);
+        }
+    }
+}
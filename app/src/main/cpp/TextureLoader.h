@@ -0,0 +1,123 @@
+#ifndef ANDROIDGLINVESTIGATIONS_TEXTURELOADER_H
+#define ANDROIDGLINVESTIGATIONS_TEXTURELOADER_H
+
+#include <android/asset_manager.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TextureAsset.h"
+
+struct ALooper;
+
+/*!
+ * Loads textures without stalling the render thread. Images are decoded and their mip chain is
+ * built on a worker thread. The GPU upload is then split into slices of rows that the render
+ * thread feeds in a few per frame through @a uploadPending, within a byte budget, so neither the
+ * first frame nor any later one waits on a large image. KTX2 files skip decoding and mip
+ * generation entirely, their baked levels are uploaded one per slice.
+ *
+ * A texture is only handed out once every level is uploaded. Until then the caller keeps drawing
+ * with whatever placeholder it has.
+ *
+ * Apart from the worker, everything runs on the render thread that created the loader.
+ */
+class TextureLoader {
+public:
+    /*!
+     * Receives a fully uploaded texture on the render thread.
+     */
+    using Callback = std::function<void(std::shared_ptr<TextureAsset>)>;
+
+    /*!
+     * Starts the worker. Must be called on the render thread: its looper is woken whenever an
+     * image finishes decoding so the uploads can start even if nothing else is being drawn.
+     */
+    explicit TextureLoader(AAssetManager *assetManager);
+
+    /*!
+     * Stops the worker, dropping any loads that haven't finished.
+     */
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader &) = delete;
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    /*!
+     * Queues an image from the assets/ directory for loading.
+     *
+     * @param assetPath The path to the asset
+     * @param onReady called from @a uploadPending once the texture can be used
+     */
+    void load(const std::string &assetPath, Callback onReady);
+
+    /*!
+     * @return true if decoded images are waiting to be uploaded, i.e. the caller should keep
+     * calling @a uploadPending on the next frames
+     */
+    inline bool hasPendingUploads() const {
+        return !uploading_.empty() || decodedCount_.load(std::memory_order_acquire) > 0;
+    }
+
+    /*!
+     * Uploads the next slices of pending textures and hands out the ones that completed. Call
+     * this once per frame with a current GL context.
+     *
+     * @param byteBudget roughly how many bytes to upload before returning
+     */
+    void uploadPending(size_t byteBudget);
+
+private:
+    struct Job {
+        std::string assetPath;
+        Callback onReady;
+
+        //! level 0 first, filled in by the worker. Only one of these is used.
+        std::vector<ImageData> levels;
+        CompressedImageData compressed;
+
+        // upload progress, only touched on the render thread
+        std::shared_ptr<TextureAsset> texture;
+        size_t level = 0;
+        int row = 0;
+        size_t uploadedBytes = 0;
+
+        inline size_t getLevelCount() const {
+            return compressed.levels.empty() ? levels.size() : compressed.levels.size();
+        }
+    };
+
+    /*!
+     * Uploads the next slice of @a job, at most about @a byteBudget bytes but always something.
+     *
+     * @return the number of bytes uploaded
+     */
+    static size_t uploadSlice(Job &job, size_t byteBudget);
+
+    void workerMain();
+
+    AAssetManager *assetManager_;
+    ALooper *looper_;
+
+    // shared with the worker
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::unique_ptr<Job>> queued_;
+    std::vector<std::unique_ptr<Job>> decoded_;
+    std::atomic<size_t> decodedCount_;
+    bool quit_;
+
+    // render thread only
+    std::vector<std::unique_ptr<Job>> uploading_;
+
+    std::thread worker_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_TEXTURELOADER_H
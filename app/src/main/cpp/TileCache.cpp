@@ -0,0 +1,441 @@
+#include "TileCache.h"
+
+#include <android/looper.h>
+#include <algorithm>
+#include <sstream>
+
+#include "AndroidOut.h"
+#include "TextureAsset.h"
+
+//! decoding is the slow part, a couple of workers keep up with a fast fling
+static constexpr int kWorkerCount = 2;
+
+//! deeper pyramids would need an indirection texture wider than GLES 3 guarantees (2048)
+static constexpr int kMaxPyramidLevel = 10;
+
+bool TileCache::readManifest(
+        AAssetManager *assetManager,
+        const std::string &directory,
+        int &outMaxLevel,
+        int &outTileSize) {
+    auto path = directory + "/manifest";
+    auto pAsset = AAssetManager_open(assetManager, path.c_str(), AASSET_MODE_BUFFER);
+    if (!pAsset) {
+        return false;
+    }
+    std::string contents(
+            static_cast<const char *>(AAsset_getBuffer(pAsset)),
+            static_cast<size_t>(AAsset_getLength(pAsset)));
+    AAsset_close(pAsset);
+
+    outMaxLevel = -1;
+    outTileSize = 0;
+    std::istringstream stream(contents);
+    std::string key;
+    int value;
+    while (stream >> key >> value) {
+        if (key == "levels") {
+            outMaxLevel = value - 1;
+        } else if (key == "tileSize") {
+            outTileSize = value;
+        }
+    }
+
+    bool isPowerOfTwo = outTileSize > 0 && (outTileSize & (outTileSize - 1)) == 0;
+    if (outMaxLevel < 0 || outMaxLevel > kMaxPyramidLevel || !isPowerOfTwo) {
+        aout << "Invalid tile manifest " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TileCache::TileCache(
+        AAssetManager *assetManager,
+        std::string directory,
+        const TilePyramid &pyramid,
+        size_t memoryBudgetBytes) :
+        assetManager_(assetManager),
+        directory_(std::move(directory)),
+        pyramid_(pyramid),
+        layerCount_(0),
+        mipLevels_(1),
+        looper_(ALooper_forThread()),
+        arrayTexture_(0),
+        indirectionTexture_(0),
+        indirectionDirty_(true),
+        generation_(0),
+        uploads_(0),
+        evictions_(0),
+        decodedCount_(0),
+        quit_(false) {
+    auto tileSize = pyramid_.getTileSize();
+    while ((tileSize >> (mipLevels_ - 1)) > 1) {
+        mipLevels_++;
+    }
+
+    // A full mip chain adds a third to the size of each layer. Layer kNoLayer is reserved as the
+    // indirection's empty marker, and the level 0 tiles must always fit.
+    auto layerBytes = static_cast<size_t>(tileSize) * tileSize * 4 * 4 / 3;
+    GLint maxLayers = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    layerCount_ = static_cast<int>(std::min<size_t>(
+            memoryBudgetBytes / layerBytes,
+            std::min<GLint>(maxLayers, kNoLayer)));
+    layerCount_ = std::max(layerCount_, TilePyramid::getTileCountX(0) + 1);
+
+    glGenTextures(1, &arrayTexture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipLevels_, GL_RGBA8, tileSize, tileSize, layerCount_);
+
+    auto maxLevel = pyramid_.getMaxLevel();
+    indirection_.assign(
+            static_cast<size_t>(TilePyramid::getTileCountX(maxLevel))
+            * TilePyramid::getTileCountY(maxLevel) * 2,
+            0);
+
+    glGenTextures(1, &indirectionTexture_);
+    glBindTexture(GL_TEXTURE_2D, indirectionTexture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage2D(
+            GL_TEXTURE_2D,
+            1,
+            GL_RG8UI,
+            TilePyramid::getTileCountX(maxLevel),
+            TilePyramid::getTileCountY(maxLevel));
+
+    layers_.resize(layerCount_);
+    for (int layer = layerCount_ - 1; layer >= 0; --layer) {
+        freeLayers_.push_back(layer);
+    }
+
+    aout << "TileCache: " << maxLevel + 1 << " levels of " << tileSize << "px tiles, "
+         << layerCount_ << " layers (" << layerCount_ * layerBytes / (1024 * 1024) << " MiB)"
+         << std::endl;
+
+    if (looper_) {
+        ALooper_acquire(looper_);
+    }
+    for (int i = 0; i < kWorkerCount; ++i) {
+        workers_.emplace_back(&TileCache::workerMain, this);
+    }
+}
+
+TileCache::~TileCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    condition_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+
+    if (looper_) {
+        ALooper_release(looper_);
+    }
+
+    glDeleteTextures(1, &indirectionTexture_);
+    glDeleteTextures(1, &arrayTexture_);
+}
+
+void TileCache::update(const std::vector<TileId> &tiles) {
+    generation_++;
+
+    auto touch = [this](const TileId &tile) {
+        auto resident = residentLayers_.find(tile.getKey());
+        if (resident == residentLayers_.end()) {
+            return false;
+        }
+        layers_[resident->second].lastUsed = generation_;
+        return true;
+    };
+
+    // Walk up from every wanted tile to the ancestor currently shown in its place. Everything on
+    // the way is requested, so detail arrives level by level instead of all at once at the end.
+    std::vector<TileId> wanted;
+    auto want = [&](const TileId &tile) {
+        for (auto current = tile;; current = current.getParent()) {
+            if (touch(current)) {
+                break;
+            }
+            if (failed_.count(current.getKey()) == 0) {
+                wanted.push_back(current);
+            }
+            if (current.level == 0) {
+                break;
+            }
+        }
+    };
+
+    // The level 0 tiles are the fallback for everything, they're wanted even when out of view
+    for (int x = 0; x < TilePyramid::getTileCountX(0); ++x) {
+        want({0, x, 0});
+    }
+    for (auto &tile: tiles) {
+        want(tile);
+    }
+
+    std::sort(wanted.begin(), wanted.end(), [](const TileId &a, const TileId &b) {
+        return a.getKey() < b.getKey();
+    });
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+    // Don't ask for more than fits next to the tiles in use, the finest ones are left out
+    auto inUse = static_cast<size_t>(std::count_if(
+            layers_.begin(),
+            layers_.end(),
+            [this](const ResidentTile &tile) {
+                return tile.occupied && tile.lastUsed == generation_;
+            }));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Requests nobody has started on yet are rebuilt from scratch, which drops stale ones
+        for (auto &tile: queued_) {
+            pending_.erase(tile.getKey());
+        }
+        queued_.clear();
+
+        auto available = static_cast<size_t>(layerCount_) - std::min<size_t>(
+                inUse + pending_.size(),
+                layerCount_);
+        for (auto &tile: wanted) {
+            if (available == 0) {
+                break;
+            }
+            if (pending_.insert(tile.getKey()).second) {
+                queued_.push_back(tile);
+                available--;
+            }
+        }
+    }
+    condition_.notify_all();
+}
+
+bool TileCache::uploadPending(size_t byteBudget) {
+    bool changed = false;
+    size_t uploaded = 0;
+
+    while (uploaded < byteBudget) {
+        DecodedTile tile;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (decoded_.empty()) {
+                break;
+            }
+            tile = std::move(decoded_.front());
+            decoded_.erase(decoded_.begin());
+            decodedCount_.store(decoded_.size(), std::memory_order_release);
+            pending_.erase(tile.id.getKey());
+        }
+
+        auto key = tile.id.getKey();
+        if (tile.levels.empty()) {
+            aout << "TileCache: could not load " << getTilePath(tile.id) << std::endl;
+            failed_.insert(key);
+            continue;
+        }
+        if (residentLayers_.count(key) > 0) {
+            continue;
+        }
+
+        auto layer = acquireLayer();
+        if (layer < 0) {
+            // Everything resident is on screen, the coarser ancestor has to do
+            continue;
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = 0; level < mipLevels_ && level < static_cast<int>(tile.levels.size());
+             ++level) {
+            auto &image = tile.levels[level];
+            glTexSubImage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    level,
+                    0,
+                    0,
+                    layer,
+                    image.width,
+                    image.height,
+                    1,
+                    GL_RGBA,
+                    GL_UNSIGNED_BYTE,
+                    image.pixels.data());
+            uploaded += image.pixels.size();
+        }
+
+        auto &resident = layers_[layer];
+        resident.id = tile.id;
+        resident.occupied = true;
+        resident.lastUsed = generation_;
+        residentLayers_[key] = layer;
+
+        uploads_++;
+        indirectionDirty_ = true;
+        changed = true;
+    }
+    return changed;
+}
+
+void TileCache::bind(GlStateCache &stateCache, GLuint arrayUnit, GLuint indirectionUnit) {
+    if (indirectionDirty_) {
+        stateCache.selectUploadUnit();
+        rebuildIndirection();
+        indirectionDirty_ = false;
+    }
+
+    stateCache.bindTexture(arrayUnit, GL_TEXTURE_2D_ARRAY, arrayTexture_);
+    stateCache.bindTexture(indirectionUnit, GL_TEXTURE_2D, indirectionTexture_);
+}
+
+int TileCache::acquireLayer() {
+    if (!freeLayers_.empty()) {
+        auto layer = freeLayers_.back();
+        freeLayers_.pop_back();
+        return layer;
+    }
+
+    int oldest = -1;
+    for (int layer = 0; layer < layerCount_; ++layer) {
+        auto &tile = layers_[layer];
+        if (tile.id.level == 0 || tile.lastUsed == generation_) {
+            continue;
+        }
+        if (oldest < 0 || tile.lastUsed < layers_[oldest].lastUsed) {
+            oldest = layer;
+        }
+    }
+    if (oldest < 0) {
+        return -1;
+    }
+
+    residentLayers_.erase(layers_[oldest].id.getKey());
+    layers_[oldest].occupied = false;
+    evictions_++;
+    indirectionDirty_ = true;
+    return oldest;
+}
+
+void TileCache::rebuildIndirection() {
+    auto maxLevel = pyramid_.getMaxLevel();
+    auto width = TilePyramid::getTileCountX(maxLevel);
+    auto height = TilePyramid::getTileCountY(maxLevel);
+
+    for (size_t i = 0; i < indirection_.size(); i += 2) {
+        indirection_[i] = kNoLayer;
+        indirection_[i + 1] = 0;
+    }
+
+    // Paint coarse to fine so every cell ends up with the finest tile covering it
+    std::vector<int> order;
+    for (int layer = 0; layer < layerCount_; ++layer) {
+        if (layers_[layer].occupied) {
+            order.push_back(layer);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return layers_[a].id.level < layers_[b].id.level;
+    });
+
+    for (auto layer: order) {
+        auto &tile = layers_[layer].id;
+        auto cells = 1 << (maxLevel - tile.level);
+        for (int y = tile.y * cells; y < (tile.y + 1) * cells; ++y) {
+            auto *row = &indirection_[static_cast<size_t>(y) * width * 2];
+            for (int x = tile.x * cells; x < (tile.x + 1) * cells; ++x) {
+                row[x * 2] = static_cast<uint8_t>(layer);
+                row[x * 2 + 1] = static_cast<uint8_t>(tile.level);
+            }
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, indirectionTexture_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            0,
+            0,
+            width,
+            height,
+            GL_RG_INTEGER,
+            GL_UNSIGNED_BYTE,
+            indirection_.data());
+}
+
+std::string TileCache::getTilePath(const TileId &tile) const {
+    return directory_ + "/" + std::to_string(tile.level) + "/" + std::to_string(tile.x) + "_"
+           + std::to_string(tile.y) + ".png";
+}
+
+TileCacheStats TileCache::getStats() const {
+    TileCacheStats stats;
+    stats.residentTiles = residentLayers_.size();
+    stats.capacity = static_cast<size_t>(layerCount_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.pendingTiles = pending_.size();
+    }
+    stats.uploads = uploads_;
+    stats.evictions = evictions_;
+    stats.failedLoads = failed_.size();
+    return stats;
+}
+
+void TileCache::logStats() const {
+    auto stats = getStats();
+    aout << "TileCache: " << stats.residentTiles << "/" << stats.capacity << " resident, "
+         << stats.pendingTiles << " pending, "
+         << stats.uploads << " uploads, "
+         << stats.evictions << " evictions, "
+         << stats.failedLoads << " failed" << std::endl;
+}
+
+void TileCache::workerMain() {
+    auto tileSize = pyramid_.getTileSize();
+
+    while (true) {
+        TileId id;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return quit_ || !queued_.empty(); });
+            if (quit_) {
+                return;
+            }
+            // The queue is sorted coarse first
+            id = queued_.front();
+            queued_.erase(queued_.begin());
+        }
+
+        DecodedTile tile;
+        tile.id = id;
+        ImageData image;
+        if (TextureAsset::decodeAsset(assetManager_, getTilePath(id), image)
+            && image.width == tileSize && image.height == tileSize) {
+            tile.levels = image.buildMipChain();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (quit_) {
+                return;
+            }
+            decoded_.push_back(std::move(tile));
+            decodedCount_.store(decoded_.size(), std::memory_order_release);
+        }
+
+        // The render thread may be idle, wake it so it uploads the tile
+        if (looper_) {
+            ALooper_wake(looper_);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#ifndef ANDROIDGLINVESTIGATIONS_TILECACHE_H
+#define ANDROIDGLINVESTIGATIONS_TILECACHE_H
+
+#include <android/asset_manager.h>
+#include <GLES3/gl3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "GlStateCache.h"
+#include "ImageData.h"
+#include "TilePyramid.h"
+
+struct ALooper;
+
+/*!
+ * Counters of a @a TileCache, for logging.
+ */
+struct TileCacheStats {
+    size_t residentTiles = 0;
+    size_t capacity = 0;
+    size_t pendingTiles = 0;
+    uint64_t uploads = 0;
+    uint64_t evictions = 0;
+    uint64_t failedLoads = 0;
+};
+
+/*!
+ * Streams the tiles of an imagery pyramid into a fixed size GL_TEXTURE_2D_ARRAY, one tile per
+ * layer. The pyramid lives in the assets as "<directory>/<level>/<x>_<y>.png" next to a
+ * "<directory>/manifest" giving its depth and tile size, tools/tilecut writes both.
+ *
+ * Every frame the renderer hands over the tiles it wants (see @a TilePyramid::selectTiles). The
+ * cache requests the missing ones coarse first, worker threads decode them and @a uploadPending
+ * copies them into free layers, evicting the least recently wanted tiles once the memory budget
+ * is used up. The level 0 tiles are never evicted so there's always something to fall back to.
+ *
+ * Shaders find the tiles through an indirection texture with one RG8UI texel per tile of the
+ * finest level: R is the array layer of the finest resident tile covering it, or
+ * @a kNoLayer, and G that tile's level. A region keeps showing its coarser ancestor until the
+ * finer tile arrives.
+ *
+ * Apart from the workers, everything runs on the render thread that created the cache.
+ */
+class TileCache {
+public:
+    //! indirection value for regions without any resident tile
+    static constexpr uint8_t kNoLayer = 255;
+
+    /*!
+     * Reads "<directory>/manifest".
+     * @param outMaxLevel receives the finest level
+     * @param outTileSize receives the tile width and height in texels
+     * @return false if there is no pyramid
+     */
+    static bool readManifest(
+            AAssetManager *assetManager,
+            const std::string &directory,
+            int &outMaxLevel,
+            int &outTileSize);
+
+    /*!
+     * Allocates the tile array and indirection texture and starts the workers. Must be called on
+     * the render thread with a current GL context.
+     *
+     * @param directory the pyramid's directory in the assets
+     * @param pyramid the shape of the pyramid, from @a readManifest
+     * @param memoryBudgetBytes how much GPU memory the tile array may use, including mipmaps
+     */
+    TileCache(
+            AAssetManager *assetManager,
+            std::string directory,
+            const TilePyramid &pyramid,
+            size_t memoryBudgetBytes);
+
+    /*!
+     * Stops the workers and deletes the textures.
+     */
+    ~TileCache();
+
+    TileCache(const TileCache &) = delete;
+    TileCache &operator=(const TileCache &) = delete;
+
+    inline const TilePyramid &getPyramid() const { return pyramid_; }
+
+    /*!
+     * Marks @a tiles as in use and requests the ones that aren't resident, together with the
+     * levels between them and their nearest resident ancestor. Queued requests for tiles that
+     * are no longer wanted are dropped.
+     *
+     * @param tiles the tiles to draw, as returned by @a TilePyramid::selectTiles
+     */
+    void update(const std::vector<TileId> &tiles);
+
+    /*!
+     * @return true if decoded tiles are waiting to be uploaded
+     */
+    inline bool hasPendingUploads() const {
+        return decodedCount_.load(std::memory_order_acquire) > 0;
+    }
+
+    /*!
+     * Uploads decoded tiles into the array. Call this once per frame with a current GL context.
+     *
+     * @param byteBudget roughly how many bytes to upload before returning
+     * @return true if any tile became resident, meaning the view should be refined again
+     */
+    bool uploadPending(size_t byteBudget);
+
+    /*!
+     * Binds the tile array and the indirection texture, uploading the indirection first if
+     * residency changed.
+     *
+     * @param arrayUnit the texture unit's index for the tile array, not GL_TEXTUREi
+     * @param indirectionUnit the texture unit's index for the indirection texture
+     */
+    void bind(GlStateCache &stateCache, GLuint arrayUnit, GLuint indirectionUnit);
+
+    TileCacheStats getStats() const;
+
+    void logStats() const;
+
+private:
+    struct ResidentTile {
+        TileId id;
+        bool occupied = false;
+
+        //! the @a update generation that last wanted this tile
+        uint64_t lastUsed = 0;
+    };
+
+    struct DecodedTile {
+        TileId id;
+
+        //! the tile's mip chain, empty if it couldn't be loaded
+        std::vector<ImageData> levels;
+    };
+
+    void workerMain();
+
+    /*!
+     * @return a free layer, evicting the least recently used tile that isn't in use this frame,
+     * or -1 if every layer is in use
+     */
+    int acquireLayer();
+
+    void rebuildIndirection();
+
+    std::string getTilePath(const TileId &tile) const;
+
+    AAssetManager *assetManager_;
+    std::string directory_;
+    TilePyramid pyramid_;
+    int layerCount_;
+    int mipLevels_;
+    ALooper *looper_;
+
+    GLuint arrayTexture_;
+    GLuint indirectionTexture_;
+    std::vector<uint8_t> indirection_;
+    bool indirectionDirty_;
+
+    // render thread only
+    std::vector<ResidentTile> layers_;
+    std::vector<int> freeLayers_;
+    std::unordered_map<uint64_t, int> residentLayers_;
+    std::unordered_set<uint64_t> failed_;
+    uint64_t generation_;
+    uint64_t uploads_;
+    uint64_t evictions_;
+
+    // shared with the workers
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+
+    //! every tile that is queued, decoding or decoded but not uploaded yet
+    std::unordered_set<uint64_t> pending_;
+    std::vector<TileId> queued_;
+    std::vector<DecodedTile> decoded_;
+    std::atomic<size_t> decodedCount_;
+    bool quit_;
+
+    std::vector<std::thread> workers_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_TILECACHE_H
@@ -0,0 +1,108 @@
+#include "TilePyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+//! refine while a texel of the current level would cover more than this many pixels
+constexpr float kMaxPixelsPerTexel = 1.f;
+
+//! limits how much grazing angles reduce the wanted resolution, the texels still cover the
+//! other direction fully
+constexpr float kMinFacing = 0.25f;
+
+float dot(const float *a, const float *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+float length(const float *a) {
+    return std::sqrt(dot(a, a));
+}
+
+float angleBetween(float cosine) {
+    return std::acos(std::clamp(cosine, -1.f, 1.f));
+}
+
+} // namespace
+
+TilePyramid::TilePyramid(int maxLevel, int tileSize) :
+        maxLevel_(maxLevel),
+        tileSize_(tileSize) {}
+
+void TilePyramid::selectTiles(const TileView &view, std::vector<TileId> &outTiles) const {
+    outTiles.clear();
+    for (int x = 0; x < getTileCountX(0); ++x) {
+        selectRecursive(view, {0, x, 0}, outTiles);
+    }
+    std::sort(outTiles.begin(), outTiles.end(), [](const TileId &a, const TileId &b) {
+        return a.getKey() < b.getKey();
+    });
+}
+
+void TilePyramid::selectRecursive(
+        const TileView &view,
+        const TileId &tile,
+        std::vector<TileId> &outTiles) const {
+    // The tile's centre on the unit sphere, using the same mapping as the globe mesh: s runs
+    // with longitude, and t = 1 - v where v runs from the north pole at 0 to the south pole at 1
+    auto s = (static_cast<float>(tile.x) + 0.5f) / static_cast<float>(getTileCountX(tile.level));
+    auto t = (static_cast<float>(tile.y) + 0.5f) / static_cast<float>(getTileCountY(tile.level));
+    auto theta = (1.f - t) * kPi;
+    auto phi = s * 2.f * kPi;
+    float center[3] = {
+            std::sin(theta) * std::cos(phi),
+            std::cos(theta),
+            std::sin(theta) * std::sin(phi)};
+
+    // Tiles span the same angle in both directions, this bounds the centre to corner angle
+    auto extent = kPi / static_cast<float>(1 << tile.level);
+    auto angularRadius = extent * 0.7072f;
+    auto radius = std::min(angularRadius, 2.f);
+
+    const auto *camera = view.cameraPosition;
+    auto cameraDistance = length(camera);
+
+    // Back-facing: past the horizon as seen from the camera
+    if (cameraDistance > 1.f) {
+        auto horizonAngle = std::acos(1.f / cameraDistance);
+        auto tileAngle = angleBetween(dot(center, camera) / cameraDistance);
+        if (tileAngle > horizonAngle + angularRadius) {
+            return;
+        }
+    }
+
+    // Outside the view cone. The camera always looks at the centre of the globe, and the tile is
+    // bounded by a sphere of its arc radius around its centre.
+    float toTile[3] = {center[0] - camera[0], center[1] - camera[1], center[2] - camera[2]};
+    auto tileDistance = std::max(length(toTile), 1e-4f);
+    if (cameraDistance > 1e-4f && tileDistance > radius) {
+        auto offAxis = angleBetween(-dot(toTile, camera) / (tileDistance * cameraDistance));
+        if (offAxis > view.halfDiagonalFov + std::asin(radius / tileDistance)) {
+            return;
+        }
+    }
+
+    // Project one texel at the nearest possible point of the tile. Towards the horizon the
+    // surface is seen at a grazing angle and texels shrink on screen, take the most head-on
+    // angle any part of the tile could have.
+    auto nearest = std::max(tileDistance - radius, 1e-3f);
+    auto viewAngle = angleBetween(-dot(toTile, center) / tileDistance);
+    auto facing = std::max(std::cos(std::max(viewAngle - angularRadius, 0.f)), kMinFacing);
+    auto texelSize = extent / static_cast<float>(tileSize_);
+    auto pixelsPerTexel = texelSize / nearest * view.projectionScale * facing;
+
+    if (tile.level >= maxLevel_ || pixelsPerTexel <= kMaxPixelsPerTexel) {
+        outTiles.push_back(tile);
+        return;
+    }
+
+    for (int child = 0; child < 4; ++child) {
+        selectRecursive(
+                view,
+                {tile.level + 1, tile.x * 2 + (child & 1), tile.y * 2 + (child >> 1)},
+                outTiles);
+    }
+}
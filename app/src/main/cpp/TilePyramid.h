@@ -0,0 +1,91 @@
+#ifndef ANDROIDGLINVESTIGATIONS_TILEPYRAMID_H
+#define ANDROIDGLINVESTIGATIONS_TILEPYRAMID_H
+
+#include <cstdint>
+#include <vector>
+
+/*!
+ * Identifies one tile of the imagery pyramid. Level 0 splits the equirectangular map into a west
+ * and an east tile, every further level splits each tile into 2x2 children, so level z has
+ * 2^(z+1) x 2^z tiles, each covering the same angle in latitude and longitude. Tile (0, 0) of
+ * every level is at the top left of the map, where texture coordinates are (0, 0).
+ */
+struct TileId {
+    int level = 0;
+    int x = 0;
+    int y = 0;
+
+    /*!
+     * @return a unique key for hashing and sorting, coarser levels sort first
+     */
+    inline uint64_t getKey() const {
+        return (static_cast<uint64_t>(level) << 48)
+               | (static_cast<uint64_t>(y) << 24)
+               | static_cast<uint64_t>(x);
+    }
+
+    inline bool operator==(const TileId &other) const {
+        return level == other.level && x == other.x && y == other.y;
+    }
+
+    /*!
+     * @return the tile one level up that contains this one. Must not be called on level 0.
+     */
+    inline TileId getParent() const { return {level - 1, x / 2, y / 2}; }
+};
+
+/*!
+ * What the camera sees, in the globe's model space where the globe is the unit sphere.
+ */
+struct TileView {
+    //! the eye position
+    float cameraPosition[3] = {0.f, 0.f, 0.f};
+
+    //! pixels covered by one unit at distance 1, i.e. viewportHeight / (2 tan(fovY / 2))
+    float projectionScale = 1.f;
+
+    //! half the angle across the diagonal of the view, in radians
+    float halfDiagonalFov = 0.f;
+};
+
+/*!
+ * Picks the tiles that cover the visible part of the globe at the right resolution. Pure math,
+ * no GL and no I/O.
+ */
+class TilePyramid {
+public:
+    /*!
+     * @param maxLevel the finest level available
+     * @param tileSize the width and height of a tile in texels
+     */
+    TilePyramid(int maxLevel, int tileSize);
+
+    inline int getMaxLevel() const { return maxLevel_; }
+
+    inline int getTileSize() const { return tileSize_; }
+
+    static inline int getTileCountX(int level) { return 2 << level; }
+
+    static inline int getTileCountY(int level) { return 1 << level; }
+
+    /*!
+     * Walks the quadtree from level 0 and collects the tiles to draw: every tile that faces the
+     * camera and lies in the view, refined until one texel covers at most a pixel or the finest
+     * level is reached. Tiles come out coarsest first.
+     *
+     * @param view the camera
+     * @param outTiles receives the selected tiles, it's cleared first
+     */
+    void selectTiles(const TileView &view, std::vector<TileId> &outTiles) const;
+
+private:
+    void selectRecursive(
+            const TileView &view,
+            const TileId &tile,
+            std::vector<TileId> &outTiles) const;
+
+    int maxLevel_;
+    int tileSize_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_TILEPYRAMID_H
@@ -0,0 +1,138 @@
+#ifndef ANDROIDGLINVESTIGATIONS_UNIFORMBUFFER_H
+#define ANDROIDGLINVESTIGATIONS_UNIFORMBUFFER_H
+
+#include <GLES3/gl3.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "GlStateCache.h"
+#include "ShaderSources.h"
+#include "VectorMath.h"
+
+// The uniform blocks shared by every program of the renderer. Each struct mirrors its GLSL block
+// in kUniformBlockSource byte for byte under the std140 rules: matrices are four vec4 columns,
+// vec3s are padded to a vec4. Programs are bound to the binding points in kUniformBlocks when
+// they're loaded, see Shader::loadShader, so they all read the same buffers.
+
+//! changes when the surface is resized or the camera moves
+struct CameraUniforms {
+    Mat4 projection;
+    Mat4 view;
+    //! (width, height, 1 / width, 1 / height) of the viewport in pixels
+    Vec4 viewport;
+};
+
+//! changes when the globe turns, the light only when it's set
+struct GlobeUniforms {
+    Mat4 model;
+    //! xyz is the direction towards the light in view space, w is unused
+    Vec4 lightDirection;
+    //! xyz is the eye in the globe's model space, w is 1
+    Vec4 cameraPosition;
+};
+
+static_assert(offsetof(CameraUniforms, view) == 64
+              && offsetof(CameraUniforms, viewport) == 128
+              && sizeof(CameraUniforms) == 144,
+              "CameraUniforms must match the std140 layout of CameraBlock");
+static_assert(offsetof(GlobeUniforms, lightDirection) == 64
+              && offsetof(GlobeUniforms, cameraPosition) == 80
+              && sizeof(GlobeUniforms) == 96,
+              "GlobeUniforms must match the std140 layout of GlobeBlock");
+
+constexpr GLuint kCameraBlockBinding = 0;
+constexpr GLuint kGlobeBlockBinding = 1;
+
+/*!
+ * A uniform block's name in GLSL and the binding point its buffer is bound to.
+ */
+struct UniformBlockBinding {
+    const char *name;
+    GLuint binding;
+};
+
+constexpr UniformBlockBinding kUniformBlocks[] = {
+        {"CameraBlock", kCameraBlockBinding},
+        {"GlobeBlock", kGlobeBlockBinding},
+};
+
+/*!
+ * A uniform buffer holding one block of type @a T. Changes are made to a CPU copy and only
+ * uploaded by @a flush if they changed anything since the last upload. Must be created and
+ * destroyed with a current GL context.
+ */
+template<typename T>
+class UniformBuffer {
+public:
+    /*!
+     * Creates the buffer and binds it to its binding point for good.
+     *
+     * @param binding the binding point the block of type @a T is bound to in every program
+     */
+    UniformBuffer(GlStateCache &stateCache, GLuint binding) :
+            buffer_(0),
+            data_(),
+            dirty_(true),
+            uploads_(0) {
+        glGenBuffers(1, &buffer_);
+        stateCache.bindUniformBuffer(buffer_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        stateCache.bindUniformBufferBase(binding, buffer_);
+    }
+
+    ~UniformBuffer() {
+        glDeleteBuffers(1, &buffer_);
+    }
+
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    inline const T &get() const { return data_; }
+
+    /*!
+     * Replaces the contents. Marks the buffer dirty only if any byte differs, so setting the same
+     * values every frame costs a compare rather than an upload.
+     */
+    inline void set(const T &data) {
+        if (std::memcmp(&data_, &data, sizeof(T)) != 0) {
+            data_ = data;
+            dirty_ = true;
+        }
+    }
+
+    /*!
+     * @return the CPU copy for changing parts of it, the buffer is marked dirty
+     */
+    inline T &edit() {
+        dirty_ = true;
+        return data_;
+    }
+
+    /*!
+     * Uploads the CPU copy if it changed since the last upload.
+     *
+     * @return true if anything was uploaded
+     */
+    bool flush(GlStateCache &stateCache) {
+        if (!dirty_) {
+            return false;
+        }
+        stateCache.bindUniformBuffer(buffer_);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data_);
+        dirty_ = false;
+        uploads_++;
+        return true;
+    }
+
+    //! @return how many times @a flush uploaded the block
+    inline uint64_t getUploadCount() const { return uploads_; }
+
+private:
+    GLuint buffer_;
+    T data_;
+    bool dirty_;
+    uint64_t uploads_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_UNIFORMBUFFER_H
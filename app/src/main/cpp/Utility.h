@@ -9,42 +9,11 @@ public:
 
     static inline void assertGlError() { assert(checkAndLogGlError()); }
 
-    /**
-     * Generates an orthographic projection matrix given the half height, aspect ratio, near, and far
-     * planes
-     *
-     * @param outMatrix the matrix to write into
-     * @param halfHeight half of the height of the screen
-     * @param aspect the width of the screen divided by the height
-     * @param near the distance of the near plane
-     * @param far the distance of the far plane
-     * @return the generated matrix, this will be the same as @a outMatrix so you can chain calls
-     *     together if needed
+    /*!
+     * @return true if @a extension appears as a whole word in the GL_EXTENSIONS string. Needs a
+     *     current GL context.
      */
-    static float *buildOrthographicMatrix(
-            float *outMatrix,
-            float halfHeight,
-            float aspect,
-            float near,
-            float far);
-
-    static float *buildIdentityMatrix(float *outMatrix);
-
-    static float *buildPerspectiveMatrix(
-            float *outMatrix,
-            float fovYRadians,
-            float aspect,
-            float near,
-            float far);
-
-    static float *multiplyMatrix(
-            float *outMatrix,
-            const float *lhs,
-            const float *rhs);
-
-    static float *buildRotationMatrixX(float *outMatrix, float radians);
-
-    static float *buildRotationMatrixY(float *outMatrix, float radians);
+    static bool hasGlExtension(const char *extension);
 };
 
 #endif //ANDROIDGLINVESTIGATIONS_UTILITY_H
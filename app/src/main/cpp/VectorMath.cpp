@@ -0,0 +1,293 @@
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <limits>
+
+// The 4-wide kernels are written in the primitives of Simd4.h
+#include "Simd4.h"
+
+namespace {
+
+inline Float4 load(const Vec4 &v) { return load(&v.x); }
+
+/*!
+ * The columns of a matrix, loaded once for transforming many vectors.
+ */
+struct Columns {
+    Float4 c0;
+    Float4 c1;
+    Float4 c2;
+    Float4 c3;
+
+    explicit Columns(const Mat4 &m) :
+            c0(load(m.columns[0])),
+            c1(load(m.columns[1])),
+            c2(load(m.columns[2])),
+            c3(load(m.columns[3])) {}
+
+    //! M * (x, y, z, 1)
+    inline Float4 point(float x, float y, float z) const {
+        return madd(c0, splat(x), madd(c1, splat(y), madd(c2, splat(z), c3)));
+    }
+
+    //! M * (x, y, z, w)
+    inline Float4 vector(float x, float y, float z, float w) const {
+        return madd(c0, splat(x), madd(c1, splat(y), add(mul(c2, splat(z)), mul(c3, splat(w)))));
+    }
+};
+
+inline Vec4 toVec4(Float4 value) {
+    Vec4 result;
+    store(&result.x, value);
+    return result;
+}
+
+inline Vec3 toVec3(Float4 value) {
+    // Vec3 is padded to four floats, the fourth lane lands in the padding
+    Vec3 result;
+    store(&result.x, value);
+    result.padding = 0.f;
+    return result;
+}
+
+} // namespace
+
+Vec4 Vec4::operator+(const Vec4 &other) const {
+    return toVec4(add(load(*this), load(other)));
+}
+
+Vec4 Vec4::operator-(const Vec4 &other) const {
+    return toVec4(sub(load(*this), load(other)));
+}
+
+Vec4 Vec4::operator*(float scale) const {
+    return toVec4(mul(load(*this), splat(scale)));
+}
+
+Quat Quat::fromAxisAngle(const Vec3 &axis, float radians) {
+    auto s = std::sin(radians * 0.5f);
+    return {axis.x * s, axis.y * s, axis.z * s, std::cos(radians * 0.5f)};
+}
+
+Quat Quat::operator*(const Quat &other) const {
+    return {w * other.x + x * other.w + y * other.z - z * other.y,
+            w * other.y - x * other.z + y * other.w + z * other.x,
+            w * other.z + x * other.y - y * other.x + z * other.w,
+            w * other.w - x * other.x - y * other.y - z * other.z};
+}
+
+Quat Quat::normalized() const {
+    auto length = std::sqrt(x * x + y * y + z * z + w * w);
+    if (length == 0.f) {
+        return {};
+    }
+    return {x / length, y / length, z / length, w / length};
+}
+
+Vec3 Quat::rotate(const Vec3 &v) const {
+    // v + 2w (q x v) + 2 q x (q x v), with q the vector part
+    Vec3 q{x, y, z};
+    auto t = cross(q, v) * 2.f;
+    return v + t * w + cross(q, t);
+}
+
+Quat Quat::slerp(const Quat &a, const Quat &b, float t) {
+    auto cosine = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+
+    // q and -q are the same rotation, go the short way
+    auto sign = cosine < 0.f ? -1.f : 1.f;
+    cosine *= sign;
+
+    float weightA;
+    float weightB;
+    if (cosine > 0.9995f) {
+        // Nearly parallel, a normalized lerp is indistinguishable and avoids dividing by ~0
+        weightA = 1.f - t;
+        weightB = t;
+    } else {
+        auto angle = std::acos(cosine);
+        auto sine = std::sin(angle);
+        weightA = std::sin((1.f - t) * angle) / sine;
+        weightB = std::sin(t * angle) / sine;
+    }
+    weightB *= sign;
+
+    return Quat(
+            a.x * weightA + b.x * weightB,
+            a.y * weightA + b.y * weightB,
+            a.z * weightA + b.z * weightB,
+            a.w * weightA + b.w * weightB).normalized();
+}
+
+Mat4 Mat4::rotationX(float radians) {
+    auto s = std::sin(radians);
+    auto c = std::cos(radians);
+    return {{1.f, 0.f, 0.f, 0.f},
+            {0.f, c, s, 0.f},
+            {0.f, -s, c, 0.f},
+            {0.f, 0.f, 0.f, 1.f}};
+}
+
+Mat4 Mat4::rotationY(float radians) {
+    auto s = std::sin(radians);
+    auto c = std::cos(radians);
+    return {{c, 0.f, -s, 0.f},
+            {0.f, 1.f, 0.f, 0.f},
+            {s, 0.f, c, 0.f},
+            {0.f, 0.f, 0.f, 1.f}};
+}
+
+Mat4 Mat4::rotationZ(float radians) {
+    auto s = std::sin(radians);
+    auto c = std::cos(radians);
+    return {{c, s, 0.f, 0.f},
+            {-s, c, 0.f, 0.f},
+            {0.f, 0.f, 1.f, 0.f},
+            {0.f, 0.f, 0.f, 1.f}};
+}
+
+Mat4 Mat4::rotation(const Quat &q) {
+    auto xx = q.x * q.x;
+    auto yy = q.y * q.y;
+    auto zz = q.z * q.z;
+    auto xy = q.x * q.y;
+    auto xz = q.x * q.z;
+    auto yz = q.y * q.z;
+    auto wx = q.w * q.x;
+    auto wy = q.w * q.y;
+    auto wz = q.w * q.z;
+    return {{1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy), 0.f},
+            {2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx), 0.f},
+            {2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy), 0.f},
+            {0.f, 0.f, 0.f, 1.f}};
+}
+
+Mat4 Mat4::perspective(float fovYRadians, float aspect, float near, float far) {
+    auto f = 1.f / std::tan(fovYRadians * 0.5f);
+    return {{f / aspect, 0.f, 0.f, 0.f},
+            {0.f, f, 0.f, 0.f},
+            {0.f, 0.f, (far + near) / (near - far), -1.f},
+            {0.f, 0.f, 2.f * far * near / (near - far), 0.f}};
+}
+
+Mat4 Mat4::orthographic(float halfHeight, float aspect, float near, float far) {
+    auto halfWidth = halfHeight * aspect;
+    return {{1.f / halfWidth, 0.f, 0.f, 0.f},
+            {0.f, 1.f / halfHeight, 0.f, 0.f},
+            {0.f, 0.f, -2.f / (far - near), 0.f},
+            {0.f, 0.f, -(far + near) / (far - near), 1.f}};
+}
+
+Mat4 Mat4::lookAt(const Vec3 &eye, const Vec3 &target, const Vec3 &up) {
+    auto forward = normalize(target - eye);
+    auto right = normalize(cross(forward, up));
+    auto trueUp = cross(right, forward);
+    return {{right.x, trueUp.x, -forward.x, 0.f},
+            {right.y, trueUp.y, -forward.y, 0.f},
+            {right.z, trueUp.z, -forward.z, 0.f},
+            {-dot(right, eye), -dot(trueUp, eye), dot(forward, eye), 1.f}};
+}
+
+Mat4 Mat4::operator*(const Mat4 &other) const {
+    Columns lhs(*this);
+    auto column = [&lhs](const Vec4 &c) { return toVec4(lhs.vector(c.x, c.y, c.z, c.w)); };
+    return {column(other.columns[0]),
+            column(other.columns[1]),
+            column(other.columns[2]),
+            column(other.columns[3])};
+}
+
+Vec4 Mat4::operator*(const Vec4 &v) const {
+    return toVec4(Columns(*this).vector(v.x, v.y, v.z, v.w));
+}
+
+Vec3 Mat4::transformPoint(const Vec3 &p) const {
+    return toVec3(Columns(*this).point(p.x, p.y, p.z));
+}
+
+Vec3 Mat4::transformVector(const Vec3 &v) const {
+    Columns m(*this);
+    return toVec3(madd(m.c0, splat(v.x), madd(m.c1, splat(v.y), mul(m.c2, splat(v.z)))));
+}
+
+Vec3 Mat4::projectPoint(const Vec3 &p) const {
+    auto clip = toVec4(Columns(*this).point(p.x, p.y, p.z));
+    return clip.xyz() / clip.w;
+}
+
+Mat4 Mat4::transposed() const {
+    const auto &c = columns;
+    return {{c[0].x, c[1].x, c[2].x, c[3].x},
+            {c[0].y, c[1].y, c[2].y, c[3].y},
+            {c[0].z, c[1].z, c[2].z, c[3].z},
+            {c[0].w, c[1].w, c[2].w, c[3].w}};
+}
+
+Mat4 Mat4::inverted() const {
+    // Cofactor expansion through the 2x2 sub-determinants of the top and bottom two rows
+    const float *m = data();
+    auto s0 = m[0] * m[5] - m[4] * m[1];
+    auto s1 = m[0] * m[9] - m[8] * m[1];
+    auto s2 = m[0] * m[13] - m[12] * m[1];
+    auto s3 = m[4] * m[9] - m[8] * m[5];
+    auto s4 = m[4] * m[13] - m[12] * m[5];
+    auto s5 = m[8] * m[13] - m[12] * m[9];
+    auto c5 = m[10] * m[15] - m[14] * m[11];
+    auto c4 = m[6] * m[15] - m[14] * m[7];
+    auto c3 = m[6] * m[11] - m[10] * m[7];
+    auto c2 = m[2] * m[15] - m[14] * m[3];
+    auto c1 = m[2] * m[11] - m[10] * m[3];
+    auto c0 = m[2] * m[7] - m[6] * m[3];
+
+    auto determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (determinant == 0.f) {
+        auto nan = std::numeric_limits<float>::quiet_NaN();
+        Vec4 column(nan, nan, nan, nan);
+        return {column, column, column, column};
+    }
+    auto inverse = 1.f / determinant;
+
+    return {{(m[5] * c5 - m[9] * c4 + m[13] * c3) * inverse,
+             (-m[1] * c5 + m[9] * c2 - m[13] * c1) * inverse,
+             (m[1] * c4 - m[5] * c2 + m[13] * c0) * inverse,
+             (-m[1] * c3 + m[5] * c1 - m[9] * c0) * inverse},
+            {(-m[4] * c5 + m[8] * c4 - m[12] * c3) * inverse,
+             (m[0] * c5 - m[8] * c2 + m[12] * c1) * inverse,
+             (-m[0] * c4 + m[4] * c2 - m[12] * c0) * inverse,
+             (m[0] * c3 - m[4] * c1 + m[8] * c0) * inverse},
+            {(m[7] * s5 - m[11] * s4 + m[15] * s3) * inverse,
+             (-m[3] * s5 + m[11] * s2 - m[15] * s1) * inverse,
+             (m[3] * s4 - m[7] * s2 + m[15] * s0) * inverse,
+             (-m[3] * s3 + m[7] * s1 - m[11] * s0) * inverse},
+            {(-m[6] * s5 + m[10] * s4 - m[14] * s3) * inverse,
+             (m[2] * s5 - m[10] * s2 + m[14] * s1) * inverse,
+             (-m[2] * s4 + m[6] * s2 - m[14] * s0) * inverse,
+             (m[2] * s3 - m[6] * s1 + m[10] * s0) * inverse}};
+}
+
+void Mat4::transformPoints(const Vec3 *points, Vec3 *outPoints, size_t count) const {
+    Columns m(*this);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &p = points[i];
+        store(&outPoints[i].x, m.point(p.x, p.y, p.z));
+        outPoints[i].padding = 0.f;
+    }
+}
+
+void Mat4::transformVectors(const Vec4 *vectors, Vec4 *outVectors, size_t count) const {
+    Columns m(*this);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &v = vectors[i];
+        store(&outVectors[i].x, m.vector(v.x, v.y, v.z, v.w));
+    }
+}
+
+const char *getVectorMathBackend() {
+#if defined(EARTHZOO_SIMD_NEON)
+    return "neon";
+#elif defined(EARTHZOO_SIMD_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
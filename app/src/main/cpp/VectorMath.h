@@ -0,0 +1,262 @@
+#ifndef ANDROIDGLINVESTIGATIONS_VECTORMATH_H
+#define ANDROIDGLINVESTIGATIONS_VECTORMATH_H
+
+#include <cmath>
+#include <cstddef>
+
+// Value types for camera, picking and per-instance math. The small inline operations are plain
+// C++ the compiler vectorizes as it sees fit, the 4-wide kernels behind Mat4 and the batch
+// transforms live in VectorMath.cpp with NEON, SSE and scalar versions.
+
+/*!
+ * A 3D vector. Padded to 16 bytes so arrays of them can be loaded four lanes at a time, the fourth
+ * float is never read as part of the value.
+ */
+struct alignas(16) Vec3 {
+    float x;
+    float y;
+    float z;
+    float padding;
+
+    constexpr Vec3() : x(0.f), y(0.f), z(0.f), padding(0.f) {}
+
+    constexpr Vec3(float inX, float inY, float inZ) : x(inX), y(inY), z(inZ), padding(0.f) {}
+
+    constexpr Vec3 operator+(const Vec3 &other) const {
+        return {x + other.x, y + other.y, z + other.z};
+    }
+
+    constexpr Vec3 operator-(const Vec3 &other) const {
+        return {x - other.x, y - other.y, z - other.z};
+    }
+
+    constexpr Vec3 operator-() const { return {-x, -y, -z}; }
+
+    constexpr Vec3 operator*(float scale) const { return {x * scale, y * scale, z * scale}; }
+
+    constexpr Vec3 operator/(float divisor) const {
+        return {x / divisor, y / divisor, z / divisor};
+    }
+
+    inline Vec3 &operator+=(const Vec3 &other) { return *this = *this + other; }
+
+    inline Vec3 &operator-=(const Vec3 &other) { return *this = *this - other; }
+
+    inline Vec3 &operator*=(float scale) { return *this = *this * scale; }
+
+    constexpr bool operator==(const Vec3 &other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+constexpr Vec3 operator*(float scale, const Vec3 &v) { return v * scale; }
+
+constexpr float dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+constexpr Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+inline float length(const Vec3 &v) { return std::sqrt(dot(v, v)); }
+
+/*!
+ * @return @a v scaled to unit length, or the zero vector if @a v is zero
+ */
+inline Vec3 normalize(const Vec3 &v) {
+    auto lengthSquared = dot(v, v);
+    return lengthSquared > 0.f ? v / std::sqrt(lengthSquared) : Vec3();
+}
+
+/*!
+ * A 4D vector, also used for homogeneous points and the columns of @a Mat4.
+ */
+struct alignas(16) Vec4 {
+    float x;
+    float y;
+    float z;
+    float w;
+
+    constexpr Vec4() : x(0.f), y(0.f), z(0.f), w(0.f) {}
+
+    constexpr Vec4(float inX, float inY, float inZ, float inW) : x(inX), y(inY), z(inZ), w(inW) {}
+
+    constexpr Vec4(const Vec3 &v, float inW) : x(v.x), y(v.y), z(v.z), w(inW) {}
+
+    constexpr Vec3 xyz() const { return {x, y, z}; }
+
+    Vec4 operator+(const Vec4 &other) const;
+
+    Vec4 operator-(const Vec4 &other) const;
+
+    Vec4 operator*(float scale) const;
+
+    constexpr bool operator==(const Vec4 &other) const {
+        return x == other.x && y == other.y && z == other.z && w == other.w;
+    }
+};
+
+constexpr float dot(const Vec4 &a, const Vec4 &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/*!
+ * A rotation as a unit quaternion, (x, y, z) is the vector part.
+ */
+struct alignas(16) Quat {
+    float x;
+    float y;
+    float z;
+    float w;
+
+    constexpr Quat() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+
+    constexpr Quat(float inX, float inY, float inZ, float inW) : x(inX), y(inY), z(inZ), w(inW) {}
+
+    static constexpr Quat identity() { return {}; }
+
+    /*!
+     * @param axis the rotation axis, must be unit length
+     * @param radians counter-clockwise looking down @a axis
+     */
+    static Quat fromAxisAngle(const Vec3 &axis, float radians);
+
+    /*!
+     * @return the rotation applying @a other first, then this
+     */
+    Quat operator*(const Quat &other) const;
+
+    constexpr Quat conjugate() const { return {-x, -y, -z, w}; }
+
+    Quat normalized() const;
+
+    /*!
+     * Rotates @a v, cheaper than going through a matrix for a single vector.
+     */
+    Vec3 rotate(const Vec3 &v) const;
+
+    /*!
+     * Interpolates along the shorter arc from @a a at t = 0 to @a b at t = 1.
+     */
+    static Quat slerp(const Quat &a, const Quat &b, float t);
+};
+
+/*!
+ * A 4x4 matrix stored column-major like GL expects, so @a data can go straight to
+ * glUniformMatrix4fv. Vectors are columns and multiply from the right: (A * B) * v = A * (B * v).
+ */
+struct alignas(16) Mat4 {
+    Vec4 columns[4];
+
+    //! the identity
+    constexpr Mat4() : columns{
+            {1.f, 0.f, 0.f, 0.f},
+            {0.f, 1.f, 0.f, 0.f},
+            {0.f, 0.f, 1.f, 0.f},
+            {0.f, 0.f, 0.f, 1.f}} {}
+
+    constexpr Mat4(const Vec4 &c0, const Vec4 &c1, const Vec4 &c2, const Vec4 &c3)
+            : columns{c0, c1, c2, c3} {}
+
+    static constexpr Mat4 identity() { return {}; }
+
+    static constexpr Mat4 translation(const Vec3 &offset) {
+        return {{1.f, 0.f, 0.f, 0.f},
+                {0.f, 1.f, 0.f, 0.f},
+                {0.f, 0.f, 1.f, 0.f},
+                {offset, 1.f}};
+    }
+
+    static constexpr Mat4 scale(const Vec3 &factors) {
+        return {{factors.x, 0.f, 0.f, 0.f},
+                {0.f, factors.y, 0.f, 0.f},
+                {0.f, 0.f, factors.z, 0.f},
+                {0.f, 0.f, 0.f, 1.f}};
+    }
+
+    /*!
+     * Rotations counter-clockwise around an axis when looking down it towards the origin.
+     */
+    static Mat4 rotationX(float radians);
+
+    static Mat4 rotationY(float radians);
+
+    static Mat4 rotationZ(float radians);
+
+    static Mat4 rotation(const Quat &rotation);
+
+    /*!
+     * A right handed perspective projection into GL clip space, looking down -z.
+     */
+    static Mat4 perspective(float fovYRadians, float aspect, float near, float far);
+
+    /*!
+     * A right handed orthographic projection into GL clip space, looking down -z.
+     *
+     * @param halfHeight half of the visible height
+     * @param aspect the width of the view divided by its height
+     */
+    static Mat4 orthographic(float halfHeight, float aspect, float near, float far);
+
+    /*!
+     * A view matrix for an eye at @a eye looking at @a target.
+     */
+    static Mat4 lookAt(const Vec3 &eye, const Vec3 &target, const Vec3 &up);
+
+    constexpr const float *data() const { return &columns[0].x; }
+
+    constexpr const Vec4 &operator[](int column) const { return columns[column]; }
+
+    inline Vec4 &operator[](int column) { return columns[column]; }
+
+    Mat4 operator*(const Mat4 &other) const;
+
+    Vec4 operator*(const Vec4 &v) const;
+
+    /*!
+     * @return this * (p, 1) without the perspective divide, for affine matrices
+     */
+    Vec3 transformPoint(const Vec3 &p) const;
+
+    /*!
+     * @return this * (v, 0), directions ignore the translation
+     */
+    Vec3 transformVector(const Vec3 &v) const;
+
+    /*!
+     * @return this * (p, 1) divided by its w, e.g. from view space to normalized device coordinates
+     */
+    Vec3 projectPoint(const Vec3 &p) const;
+
+    Mat4 transposed() const;
+
+    /*!
+     * @return the inverse, or a matrix of NaNs if this one isn't invertible
+     */
+    Mat4 inverted() const;
+
+    /*!
+     * Applies @a transformPoint to @a count points. @a points and @a outPoints may be the same
+     * array.
+     */
+    void transformPoints(const Vec3 *points, Vec3 *outPoints, size_t count) const;
+
+    /*!
+     * Applies this matrix to @a count homogeneous vectors, e.g. points to clip space.
+     * @a vectors and @a outVectors may be the same array.
+     */
+    void transformVectors(const Vec4 *vectors, Vec4 *outVectors, size_t count) const;
+
+    constexpr bool operator==(const Mat4 &other) const {
+        return columns[0] == other.columns[0]
+               && columns[1] == other.columns[1]
+               && columns[2] == other.columns[2]
+               && columns[3] == other.columns[3];
+    }
+};
+
+/*!
+ * @return the name of the kernels this build uses, "neon", "sse" or "scalar"
+ */
+const char *getVectorMathBackend();
+
+#endif //ANDROIDGLINVESTIGATIONS_VECTORMATH_H
@@ -0,0 +1,195 @@
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+int16_t toSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+uint16_t toUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+template<typename T>
+void write(uint8_t *destination, const T &value) {
+    memcpy(destination, &value, sizeof(T));
+}
+
+} // namespace
+
+VertexLayout::VertexLayout(const VertexFormat &format) : format_(format), stride_(0) {
+    if (format_.proceduralSphere) {
+        return;
+    }
+
+    switch (format_.position) {
+        case PositionFormat::Float3:
+            attributes_.push_back({kPositionAttribute, 3, GL_FLOAT, GL_FALSE, stride_});
+            stride_ += 12;
+            break;
+        case PositionFormat::Snorm16:
+            // The fourth short only pads the position to keep the next attribute 4 byte aligned
+            attributes_.push_back({kPositionAttribute, 3, GL_SHORT, GL_TRUE, stride_});
+            stride_ += 8;
+            break;
+    }
+
+    switch (format_.uv) {
+        case UvFormat::Float2:
+            attributes_.push_back({kUvAttribute, 2, GL_FLOAT, GL_FALSE, stride_});
+            stride_ += 8;
+            break;
+        case UvFormat::Half2:
+            attributes_.push_back({kUvAttribute, 2, GL_HALF_FLOAT, GL_FALSE, stride_});
+            stride_ += 4;
+            break;
+        case UvFormat::Unorm16:
+            attributes_.push_back({kUvAttribute, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride_});
+            stride_ += 4;
+            break;
+    }
+
+    switch (format_.normal) {
+        case NormalFormat::None:
+            break;
+        case NormalFormat::Octahedral16:
+            attributes_.push_back({kNormalAttribute, 2, GL_SHORT, GL_TRUE, stride_});
+            stride_ += 4;
+            break;
+    }
+}
+
+std::vector<uint8_t> VertexLayout::pack(const std::vector<Vertex> &vertices) const {
+    std::vector<uint8_t> packed(vertices.size() * stride_, 0);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto &vertex = vertices[i];
+        auto *destination = &packed[i * stride_];
+
+        for (auto &attribute: attributes_) {
+            auto *out = destination + attribute.offset;
+            switch (attribute.location) {
+                case kPositionAttribute:
+                    for (int c = 0; c < 3; ++c) {
+                        if (format_.position == PositionFormat::Float3) {
+                            write(out + c * 4, vertex.position.idx[c]);
+                        } else {
+                            write(out + c * 2, toSnorm16(vertex.position.idx[c]));
+                        }
+                    }
+                    break;
+                case kUvAttribute:
+                    for (int c = 0; c < 2; ++c) {
+                        if (format_.uv == UvFormat::Float2) {
+                            write(out + c * 4, vertex.uv.idx[c]);
+                        } else if (format_.uv == UvFormat::Half2) {
+                            write(out + c * 2, toHalf(vertex.uv.idx[c]));
+                        } else {
+                            write(out + c * 2, toUnorm16(vertex.uv.idx[c]));
+                        }
+                    }
+                    break;
+                case kNormalAttribute: {
+                    float x;
+                    float y;
+                    encodeOctahedral(vertex.normal, x, y);
+                    write(out, toSnorm16(x));
+                    write(out + 2, toSnorm16(y));
+                    break;
+                }
+            }
+        }
+    }
+    return packed;
+}
+
+void VertexLayout::applyAttributes() const {
+    for (auto &attribute: attributes_) {
+        glVertexAttribPointer(
+                attribute.location,
+                attribute.components,
+                attribute.type,
+                attribute.normalized,
+                stride_,
+                reinterpret_cast<const void *>(static_cast<uintptr_t>(attribute.offset)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
+
+std::string VertexLayout::getShaderDefines() const {
+    std::string defines;
+    if (format_.proceduralSphere) {
+        defines += "#define PROCEDURAL_SPHERE\n";
+    } else if (format_.normal != NormalFormat::None) {
+        defines += "#define VERTEX_NORMALS\n";
+    }
+    return defines;
+}
+
+void VertexLayout::encodeOctahedral(const Vector3 &normal, float &outX, float &outY) {
+    auto length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (length == 0.f) {
+        outX = 0.f;
+        outY = 0.f;
+        return;
+    }
+
+    // Project onto the octahedron, then fold the lower half over the diagonals
+    auto x = normal.x / length;
+    auto y = normal.y / length;
+    if (normal.z < 0.f) {
+        auto foldedX = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+        auto foldedY = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = foldedX;
+        y = foldedY;
+    }
+    outX = x;
+    outY = y;
+}
+
+uint16_t VertexLayout::toHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    auto biasedExponent = static_cast<int>((bits >> 23) & 0xFFu);
+    auto mantissa = bits & 0x7FFFFFu;
+
+    if (biasedExponent == 0xFF) {
+        // Infinity stays infinity, NaN stays NaN
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+
+    auto exponent = biasedExponent - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+
+    if (exponent <= 0) {
+        // Subnormal half, or too small even for that
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000u;
+        auto shift = static_cast<uint32_t>(14 - exponent);
+        auto half = mantissa >> shift;
+        auto remainder = mantissa & ((1u << shift) - 1u);
+        auto halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // A carry out of the mantissa correctly bumps the exponent
+    auto half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    auto remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
@@ -0,0 +1,168 @@
+#ifndef ANDROIDGLINVESTIGATIONS_VERTEXLAYOUT_H
+#define ANDROIDGLINVESTIGATIONS_VERTEXLAYOUT_H
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+union Vector3 {
+    struct {
+        float x, y, z;
+    };
+    float idx[3];
+};
+
+union Vector2 {
+    struct {
+        float x, y;
+    };
+    struct {
+        float u, v;
+    };
+    float idx[2];
+};
+
+/*!
+ * A vertex as meshes are generated, in full precision. What actually goes to the GPU is decided
+ * by the model's @a VertexFormat.
+ */
+struct Vertex {
+    constexpr Vertex(const Vector3 &inPosition, const Vector2 &inUV) : position(inPosition),
+                                                                       uv(inUV),
+                                                                       normal{0.f, 0.f, 0.f} {}
+
+    constexpr Vertex(const Vector3 &inPosition, const Vector2 &inUV, const Vector3 &inNormal)
+            : position(inPosition),
+              uv(inUV),
+              normal(inNormal) {}
+
+    Vector3 position;
+    Vector2 uv;
+
+    //! only stored if the format has normals, otherwise the shader derives them from position
+    Vector3 normal;
+};
+
+/*!
+ * The attribute locations every shader drawing a @a Model declares with layout(location = ...).
+ * A model's vertex array object is set up once against these, so it works with any such shader.
+ */
+enum VertexAttribute : GLuint {
+    kPositionAttribute = 0,
+    kUvAttribute = 1,
+    kNormalAttribute = 2
+};
+
+enum class PositionFormat {
+    //! 3 floats, 12 bytes
+    Float3,
+
+    //! 3 normalized shorts, 8 bytes with padding. Positions must lie within [-1, 1].
+    Snorm16
+};
+
+enum class UvFormat {
+    //! 2 floats, 8 bytes
+    Float2,
+
+    //! 2 half floats, 4 bytes
+    Half2,
+
+    //! 2 normalized unsigned shorts, 4 bytes. UVs must lie within [0, 1].
+    Unorm16
+};
+
+enum class NormalFormat {
+    //! no normal attribute, the shader uses the normalized position, which is right for spheres
+    None,
+
+    //! octahedral encoding in 2 normalized shorts, 4 bytes
+    Octahedral16
+};
+
+/*!
+ * How a model's vertices are stored on the GPU.
+ */
+struct VertexFormat {
+    PositionFormat position = PositionFormat::Float3;
+    UvFormat uv = UvFormat::Float2;
+    NormalFormat normal = NormalFormat::None;
+
+    //! no vertex buffer at all, the vertex shader builds a UV sphere from gl_VertexID
+    bool proceduralSphere = false;
+
+    //! the tessellation of the procedural sphere. Vertex i is on row i / (lonSegments + 1),
+    //! column i % (lonSegments + 1), like the vertices of a generated UV sphere.
+    int sphereLatSegments = 0;
+    int sphereLonSegments = 0;
+
+    /*!
+     * @return the vertex format of a procedural UV sphere
+     */
+    static inline VertexFormat proceduralSphereFormat(int latSegments, int lonSegments) {
+        VertexFormat format;
+        format.proceduralSphere = true;
+        format.sphereLatSegments = latSegments;
+        format.sphereLonSegments = lonSegments;
+        return format;
+    }
+};
+
+/*!
+ * The byte layout of a @a VertexFormat: packs vertices into it, sets up the matching vertex
+ * attributes and tells shaders which inputs to expect.
+ */
+class VertexLayout {
+public:
+    explicit VertexLayout(const VertexFormat &format);
+
+    inline const VertexFormat &getFormat() const { return format_; }
+
+    /*!
+     * @return the size of one packed vertex, 0 for a procedural sphere
+     */
+    inline GLsizei getStride() const { return stride_; }
+
+    /*!
+     * Packs @a vertices into this layout.
+     */
+    std::vector<uint8_t> pack(const std::vector<Vertex> &vertices) const;
+
+    /*!
+     * Points the vertex attributes at the buffer bound to GL_ARRAY_BUFFER and enables them. Meant
+     * to be recorded into a vertex array object.
+     */
+    void applyAttributes() const;
+
+    /*!
+     * @return #define lines to put after #version in the vertex shader: VERTEX_NORMALS if there's
+     * a normal attribute, PROCEDURAL_SPHERE for a procedural sphere
+     */
+    std::string getShaderDefines() const;
+
+    /*!
+     * Encodes a unit vector into the two octahedral coordinates, each in [-1, 1].
+     */
+    static void encodeOctahedral(const Vector3 &normal, float &outX, float &outY);
+
+    /*!
+     * Converts to an IEEE 754 half float, rounding to nearest.
+     */
+    static uint16_t toHalf(float value);
+
+private:
+    struct Attribute {
+        VertexAttribute location;
+        GLint components;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei offset;
+    };
+
+    VertexFormat format_;
+    std::vector<Attribute> attributes_;
+    GLsizei stride_;
+};
+
+#endif //ANDROIDGLINVESTIGATIONS_VERTEXLAYOUT_H
@@ -1,7 +1,9 @@
 #include <jni.h>
+#include <string>
 
 #include "AndroidOut.h"
-#include "Renderer.h"
+#include "InputHandler.h"
+#include "RenderThread.h"
 
 #include <game-activity/GameActivity.cpp>
 #include <game-text-input/gametextinput.cpp>
@@ -16,25 +18,27 @@ extern "C" {
  * @param cmd the command to handle
  */
 void handle_cmd(android_app *pApp, int32_t cmd) {
+    // The render thread is created before any command can arrive, see android_main
+    auto *pRenderThread = reinterpret_cast<RenderThread *>(pApp->userData);
+
     switch (cmd) {
         case APP_CMD_INIT_WINDOW:
-            // A new window is created, associate a renderer with it. You may replace this with a
-            // "game" class if that suits your needs. Remember to change all instances of userData
-            // if you change the class here as a reinterpret_cast is dangerous this in the
-            // android_main function and the APP_CMD_TERM_WINDOW handler case.
-            pApp->userData = new Renderer(pApp);
+            // A new window is created, the render thread starts drawing into it. The renderer and
+            // its GPU resources outlive windows, so only a surface has to be created here.
+            pRenderThread->setWindow(pApp->window);
             break;
         case APP_CMD_TERM_WINDOW:
-            // The window is being destroyed. Use this to clean up your userData to avoid leaking
-            // resources.
-            //
-            // We have to check if userData is assigned just in case this comes in really quickly
-            if (pApp->userData) {
-                //
-                auto *pRenderer = reinterpret_cast<Renderer *>(pApp->userData);
-                pApp->userData = nullptr;
-                delete pRenderer;
-            }
+            // The window is being destroyed. The window must not be touched once we return from
+            // here, so this blocks until the render thread has released it.
+            pRenderThread->releaseWindow();
+            break;
+        case APP_CMD_WINDOW_RESIZED:
+        case APP_CMD_CONTENT_RECT_CHANGED:
+        case APP_CMD_WINDOW_REDRAW_NEEDED:
+        case APP_CMD_GAINED_FOCUS:
+            // Nothing in the scene moved, but the contents of the window have to be presented
+            // again. The render loop only draws when the scene is dirty, so flag it explicitly.
+            pRenderThread->requestRedraw();
             break;
         default:
             break;
@@ -56,6 +60,64 @@ bool motion_event_filter_func(const GameActivityMotionEvent *motionEvent) {
             sourceClass == AINPUT_SOURCE_CLASS_JOYSTICK);
 }
 
+/*!
+ * Looks up the app's cache directory through Context.getCacheDir(), which GameActivity doesn't
+ * expose natively. Falls back to the internal data path if the call fails.
+ *
+ * @param pApp the app to query
+ * @return the absolute path of the cache directory
+ */
+std::string get_cache_directory(android_app *pApp) {
+    auto *activity = pApp->activity;
+    std::string path;
+
+    JNIEnv *env = nullptr;
+    bool attached = false;
+    if (activity->vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        attached = activity->vm->AttachCurrentThread(&env, nullptr) == JNI_OK;
+    }
+
+    if (env) {
+        auto activityClass = env->GetObjectClass(activity->javaGameActivity);
+        auto getCacheDir = env->GetMethodID(activityClass, "getCacheDir", "()Ljava/io/File;");
+        auto file = env->CallObjectMethod(activity->javaGameActivity, getCacheDir);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            file = nullptr;
+        }
+        if (file) {
+            auto fileClass = env->GetObjectClass(file);
+            auto getAbsolutePath = env->GetMethodID(
+                    fileClass,
+                    "getAbsolutePath",
+                    "()Ljava/lang/String;");
+            auto javaPath = static_cast<jstring>(env->CallObjectMethod(file, getAbsolutePath));
+            if (env->ExceptionCheck()) {
+                env->ExceptionClear();
+                javaPath = nullptr;
+            }
+            if (javaPath) {
+                auto *chars = env->GetStringUTFChars(javaPath, nullptr);
+                path = chars;
+                env->ReleaseStringUTFChars(javaPath, chars);
+                env->DeleteLocalRef(javaPath);
+            }
+            env->DeleteLocalRef(fileClass);
+            env->DeleteLocalRef(file);
+        }
+        env->DeleteLocalRef(activityClass);
+    }
+
+    if (attached) {
+        activity->vm->DetachCurrentThread();
+    }
+
+    if (path.empty() && activity->internalDataPath) {
+        path = activity->internalDataPath;
+    }
+    return path;
+}
+
 /*!
  * This the main entry point for a native activity
  */
@@ -63,6 +125,13 @@ void android_main(struct android_app *pApp) {
     // Can be removed, useful to ensure your code is running
     aout << "Welcome to android_main" << std::endl;
 
+    // Rendering happens on its own thread that owns the EGL context. This thread only forwards
+    // input and lifecycle events to it. If you change your user data remember to change it in
+    // handle_cmd too.
+    RenderThread renderThread(pApp->activity->assetManager, get_cache_directory(pApp));
+    InputHandler inputHandler;
+    pApp->userData = &renderThread;
+
     // Register an event handler for Android events
     pApp->onAppCmd = handle_cmd;
 
@@ -73,15 +142,18 @@ void android_main(struct android_app *pApp) {
 
     // This sets up a typical game/event loop. It will run until the app is destroyed.
     do {
-        // Process all pending events before running game logic.
+        // Block until there is something to do. Input and commands both wake the looper, then
+        // process everything that's pending before handing input over.
+        int timeout = -1;
         bool done = false;
         while (!done) {
-            // 0 is non-blocking.
-            int timeout = 0;
             int events;
             android_poll_source *pSource;
             int result = ALooper_pollOnce(timeout, nullptr, &events,
                                           reinterpret_cast<void**>(&pSource));
+
+            // Something woke us up, drain anything else that's pending without blocking again.
+            timeout = 0;
             switch (result) {
                 case ALOOPER_POLL_TIMEOUT:
                     [[clang::fallthrough]];
@@ -101,18 +173,10 @@ void android_main(struct android_app *pApp) {
             }
         }
 
-        // Check if any user data is associated. This is assigned in handle_cmd
-        if (pApp->userData) {
-            // We know that our user data is a Renderer, so reinterpret cast it. If you change your
-            // user data remember to change it here
-            auto *pRenderer = reinterpret_cast<Renderer *>(pApp->userData);
-
-            // Process game input
-            pRenderer->handleInput();
-
-            // Render a frame
-            pRenderer->render();
-        }
+        // Forward input to the render thread. This never waits on rendering.
+        inputHandler.handleInput(pApp, renderThread);
     } while (!pApp->destroyRequested);
+
+    pApp->userData = nullptr;
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,40 @@
+package com.pykens.earthzoo.analytics
+
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+import java.nio.ShortBuffer
+
+/**
+ * Tags observation points with the continent they're on, natively and in bulk. Gives the same
+ * answer as InteractiveEarthView's polygon test, region ids are the continents' order there
+ * starting at 1, 0 for none.
+ *
+ * Nothing is classified when the native library isn't loaded, callers check [isAvailable] or fall
+ * back when [classify] returns false.
+ */
+object RegionClassifier {
+
+    /** Whether the native library loaded, without it [classify] always returns false */
+    val isAvailable: Boolean = try {
+        System.loadLibrary("earthzoo")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+
+    /**
+     * Classifies [count] (latitude, longitude) pairs in degrees from [points] into [regions].
+     * Both buffers have to be direct and in native byte order; their positions are ignored.
+     *
+     * @return false if the native library isn't loaded, or a buffer isn't direct, isn't in native
+     *     byte order or is too small
+     */
+    fun classify(points: FloatBuffer, count: Int, regions: ShortBuffer): Boolean =
+        isAvailable &&
+            points.order() == ByteOrder.nativeOrder() &&
+            regions.order() == ByteOrder.nativeOrder() &&
+            nativeClassify(points, count, regions) == count
+
+    @JvmStatic
+    private external fun nativeClassify(points: FloatBuffer, count: Int, regions: ShortBuffer): Int
+}
@@ -496,6 +496,9 @@ class InteractiveEarthView @JvmOverloads constructor(
     }
 
     companion object {
+        /** overlay pixels less opaque than this are fill, not outline */
+        private const val OUTLINE_MIN_ALPHA = 250
+
         private fun point(x: Float, y: Float) = PointF(x, y)
     }
 
@@ -530,34 +533,43 @@ class InteractiveEarthView @JvmOverloads constructor(
             val drawable = ContextCompat.getDrawable(context, resId) ?: return null
             val source = drawable.toBitmap(config = Bitmap.Config.ARGB_8888)
             val mutable = source.copy(Bitmap.Config.ARGB_8888, true)
-            val width = mutable.width
-            val height = mutable.height
-            val pixels = IntArray(width * height)
-            mutable.getPixels(pixels, 0, width, 0, 0, width, height)
-            for (index in pixels.indices) {
-                val color = pixels[index]
-                val red = Color.red(color)
-                val green = Color.green(color)
-                val blue = Color.blue(color)
-                val alpha = Color.alpha(color)
-                val isPureBlack = red == 0 && green == 0 && blue == 0
-                // The overlay encodes the grey fill as semi-transparent black. Treat any
-                // partially transparent pixel as background so only the solid black outline
-                // remains visible.
-                val isOpaqueEnough = alpha >= 250
-                pixels[index] = if (isPureBlack && isOpaqueEnough) {
-                    Color.BLACK
-                } else {
-                    Color.TRANSPARENT
-                }
+            if (!OverlayFilter.keepOutline(mutable, OUTLINE_MIN_ALPHA)) {
+                keepOutline(mutable)
             }
-            mutable.setPixels(pixels, 0, width, 0, 0, width, height)
             filteredOverrideBitmaps[resId] = mutable
             mutable
         }
         return BitmapDrawable(resources, bitmap)
     }
 
+    /**
+     * [OverlayFilter.keepOutline] in Kotlin, for when the native library isn't available.
+     */
+    private fun keepOutline(bitmap: Bitmap) {
+        val width = bitmap.width
+        val height = bitmap.height
+        val pixels = IntArray(width * height)
+        bitmap.getPixels(pixels, 0, width, 0, 0, width, height)
+        for (index in pixels.indices) {
+            val color = pixels[index]
+            val red = Color.red(color)
+            val green = Color.green(color)
+            val blue = Color.blue(color)
+            val alpha = Color.alpha(color)
+            val isPureBlack = red == 0 && green == 0 && blue == 0
+            // The overlay encodes the grey fill as semi-transparent black. Treat any
+            // partially transparent pixel as background so only the solid black outline
+            // remains visible.
+            val isOpaqueEnough = alpha >= OUTLINE_MIN_ALPHA
+            pixels[index] = if (isPureBlack && isOpaqueEnough) {
+                Color.BLACK
+            } else {
+                Color.TRANSPARENT
+            }
+        }
+        bitmap.setPixels(pixels, 0, width, 0, 0, width, height)
+    }
+
     private class SavedState : View.BaseSavedState {
         var selectedIndex: Int = -1
         var isZoomed: Boolean = false
@@ -0,0 +1,62 @@
+package com.pykens.earthzoo.ui
+
+import android.graphics.Bitmap
+
+/**
+ * Recolours ARGB_8888 bitmaps in place with the native PixelFilter, rows in parallel and several
+ * pixels per instruction. A pixel whose every channel is within [low, high] becomes
+ * `(pixel and insideKeep) or insideColor`, every other pixel `(pixel and outsideKeep) or
+ * outsideColor`. Pixels are packed with [rgba], the way they lie in memory, and tested as stored:
+ * premultiplied.
+ *
+ * Every filter returns false without touching the bitmap when the native library isn't loaded or
+ * can't filter it, callers fall back to filtering in Kotlin.
+ */
+internal object OverlayFilter {
+
+    private val isAvailable: Boolean = try {
+        System.loadLibrary("earthzoo")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+
+    /** @return a pixel as [Bitmap.Config.ARGB_8888] keeps it in memory, red in the lowest byte */
+    fun rgba(red: Int, green: Int, blue: Int, alpha: Int): Int =
+        red or (green shl 8) or (blue shl 16) or (alpha shl 24)
+
+    fun filter(
+        bitmap: Bitmap,
+        low: Int,
+        high: Int,
+        insideKeep: Int,
+        insideColor: Int,
+        outsideKeep: Int,
+        outsideColor: Int
+    ): Boolean = canFilter(bitmap) &&
+        nativeFilter(bitmap, low, high, insideKeep, insideColor, outsideKeep, outsideColor)
+
+    /**
+     * Keeps pure black pixels at least [minAlpha] opaque as solid black and clears the rest, the
+     * overlays' outlines without their translucent fill.
+     */
+    fun keepOutline(bitmap: Bitmap, minAlpha: Int): Boolean =
+        canFilter(bitmap) && nativeKeepOutline(bitmap, minAlpha)
+
+    private fun canFilter(bitmap: Bitmap): Boolean =
+        isAvailable && bitmap.isMutable && bitmap.config == Bitmap.Config.ARGB_8888
+
+    @JvmStatic
+    private external fun nativeFilter(
+        bitmap: Bitmap,
+        low: Int,
+        high: Int,
+        insideKeep: Int,
+        insideColor: Int,
+        outsideKeep: Int,
+        outsideColor: Int
+    ): Boolean
+
+    @JvmStatic
+    private external fun nativeKeepOutline(bitmap: Bitmap, minAlpha: Int): Boolean
+}
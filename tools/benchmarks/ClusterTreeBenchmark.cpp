@@ -0,0 +1,163 @@
+// Builds cluster trees of synthetic observations and times what the app does with them each
+// frame and on a tap: selecting the clusters for a view, finding the cluster under a point and
+// expanding it. Selection is compared against the flat alternative, testing every point.
+//
+//   clustertree_bench [point count]...
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "ClusterTree.h"
+#include "GeoCoordinates.h"
+#include "SyntheticPoints.h"
+
+namespace {
+
+constexpr int kQueryCount = 1000;
+constexpr int kSelectionCount = 50;
+constexpr float kSpacingPixels = 48.f;
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+//! a 1080x2280 portrait screen with a 60 degree vertical field of view
+TileView makeView(const Vec3 &direction, float distance) {
+    constexpr float kTanHalfFov = 0.57735f;
+    constexpr float kAspect = 1080.f / 2280.f;
+    TileView view;
+    view.cameraPosition[0] = direction.x * distance;
+    view.cameraPosition[1] = direction.y * distance;
+    view.cameraPosition[2] = direction.z * distance;
+    view.projectionScale = 2280.f / (2.f * kTanHalfFov);
+    view.halfDiagonalFov = std::atan(kTanHalfFov * std::sqrt(1.f + kAspect * kAspect));
+    return view;
+}
+
+/*!
+ * What showing every point costs without the tree: the horizon test the marker shader runs, on
+ * the CPU for every point.
+ */
+size_t countFacingPoints(const std::vector<Vec3> &directions, const TileView &view) {
+    Vec3 camera{view.cameraPosition[0], view.cameraPosition[1], view.cameraPosition[2]};
+    size_t count = 0;
+    for (const auto &direction: directions) {
+        count += dot(direction, camera) > 1.f ? 1 : 0;
+    }
+    return count;
+}
+
+void run(size_t pointCount) {
+    auto points = generateSyntheticPoints(pointCount, 1);
+    std::vector<Vec3> directions;
+    directions.reserve(points.size());
+    for (const auto &point: points) {
+        directions.push_back(directionFromLatLon(point.latitude, point.longitude));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto tree = ClusterTree::build(points);
+    auto buildMillis = elapsedMicroseconds(start) / 1000.0;
+    size_t clusterCount = 0;
+    for (int level = 0; level < tree.getLevelCount(); ++level) {
+        clusterCount += tree.getLevel(level).size();
+    }
+    std::printf("%zu points: built %d levels, %zu clusters in %.0f ms (%.0f ns per point)\n",
+                pointCount, tree.getLevelCount(), clusterCount, buildMillis,
+                buildMillis * 1e6 / static_cast<double>(pointCount));
+
+    std::mt19937 random(2);
+    std::uniform_int_distribution<size_t> pickPoint(0, pointCount - 1);
+    std::printf("  %-16s %8s %10s %12s %12s\n",
+                "camera distance", "level", "clusters", "select us", "scan us");
+    std::vector<ClusterRef> selected;
+    for (float distance: {3.f, 1.5f, 1.05f, 1.005f, 1.0005f}) {
+        std::vector<TileView> views;
+        for (int i = 0; i < kSelectionCount; ++i) {
+            const auto &point = points[pickPoint(random)];
+            views.push_back(makeView(directionFromLatLon(point.latitude, point.longitude),
+                                     distance));
+        }
+
+        size_t selectedTotal = 0;
+        start = std::chrono::steady_clock::now();
+        for (const auto &view: views) {
+            tree.selectClusters(view, kSpacingPixels, selected);
+            selectedTotal += selected.size();
+        }
+        auto selectMicros = elapsedMicroseconds(start) / kSelectionCount;
+
+        size_t facing = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 3; ++i) {
+            facing += countFacingPoints(directions, views[i]);
+        }
+        auto scanMicros = elapsedMicroseconds(start) / 3.0;
+
+        std::printf("  %-16.4f %8d %10.0f %12.1f %12.0f%s\n",
+                    distance, tree.selectLevel(views[0], kSpacingPixels),
+                    static_cast<double>(selectedTotal) / kSelectionCount, selectMicros,
+                    scanMicros, facing == 0 ? " (nothing facing)" : "");
+    }
+
+    // Taps on observations at a mid zoom level: find the cluster, then what it expands into
+    auto level = std::min(8, tree.getLevelCount() - 1);
+    std::vector<GeoPoint> taps;
+    for (int i = 0; i < kQueryCount; ++i) {
+        taps.push_back(points[pickPoint(random)]);
+    }
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto &tap: taps) {
+        ClusterRef cluster;
+        found += tree.findCluster(level, tap.latitude, tap.longitude, cluster) ? 1 : 0;
+    }
+    auto findNanos = elapsedMicroseconds(start) * 1000.0 / kQueryCount;
+
+    size_t expandedPoints = 0;
+    int expansionLevels = 0;
+    std::vector<ClusterRef> children;
+    start = std::chrono::steady_clock::now();
+    for (const auto &tap: taps) {
+        ClusterRef cluster;
+        if (tree.findCluster(level, tap.latitude, tap.longitude, cluster)) {
+            expansionLevels += tree.getExpansionLevel(cluster);
+            children.clear();
+            tree.getChildren(cluster, children);
+            size_t first;
+            expandedPoints += tree.getPointRange(cluster, first);
+        }
+    }
+    auto expandNanos = elapsedMicroseconds(start) * 1000.0 / kQueryCount;
+    auto foundCount = static_cast<double>(std::max<size_t>(found, 1));
+    std::printf("  tap at level %d: find %.0f ns, find and expand %.0f ns (%zu of %d found, "
+                "%.0f points each, split on level %.1f)\n\n",
+                level, findNanos, expandNanos, found, kQueryCount,
+                static_cast<double>(expandedPoints) / foundCount, expansionLevels / foundCount);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = {100000, 1000000, 10000000};
+    }
+    for (auto count: counts) {
+        if (count == 0) {
+            std::fprintf(stderr, "usage: %s [point count]...\n", argv[0]);
+            return 1;
+        }
+        run(count);
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Loads the marker layer with the demo sightings the renderer used to show, 100k by default, and
+// times what the app does with them: adding and packing the markers, the first upload of every
+// instance, re-uploading after a few edits, and the CPU horizon test the marker shader runs.
+//
+//   markerset_bench [marker count]...
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "MarkerSet.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+constexpr int kEditRounds = 100;
+constexpr int kEditsPerRound = 20;
+constexpr int kVisibilityRounds = 20;
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/*!
+ * Sightings uniform over the sphere's area with a fixed seed, sizes, colours and symbols cycling
+ * through what the marker shader draws.
+ */
+std::vector<Marker> generateMarkers(size_t count) {
+    static constexpr uint32_t kPalette[] = {
+            0xF2C14EFFu, 0xF78154FFu, 0x4D9078FFu, 0xB4436CFFu, 0x5FAD56FFu, 0xFFFFFFFFu};
+
+    std::mt19937 random(20240611u);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::vector<Marker> markers(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto &marker = markers[i];
+        marker.latitude = std::asin(unit(random) * 2.f - 1.f) * 180.f / kPi;
+        marker.longitude = unit(random) * 360.f - 180.f;
+        marker.size = 10.f + unit(random) * 10.f;
+        marker.color = kPalette[i % std::size(kPalette)];
+        marker.atlasIndex = static_cast<uint8_t>(i % kMarkerAtlasSize);
+    }
+    return markers;
+}
+
+void run(size_t markerCount) {
+    auto markers = generateMarkers(markerCount);
+
+    MarkerSet set;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &marker: markers) {
+        set.add(marker);
+    }
+    auto addMillis = elapsedMicroseconds(start) / 1000.0;
+
+    // The first frame uploads every instance
+    size_t uploadCount = 0;
+    size_t uploadedBytes = 0;
+    start = std::chrono::steady_clock::now();
+    set.consumeChanges([&](size_t, size_t count) {
+        ++uploadCount;
+        uploadedBytes += count * sizeof(MarkerInstance);
+    });
+    auto uploadMicros = elapsedMicroseconds(start);
+    std::printf("%zu markers: added in %.1f ms (%.0f ns each), first upload %.1f KiB in %zu "
+                "ranges, %.0f us\n",
+                markerCount, addMillis, addMillis * 1e6 / static_cast<double>(markerCount),
+                static_cast<double>(uploadedBytes) / 1024.0, uploadCount, uploadMicros);
+
+    // A few highlights toggled per frame, only their pages go up again
+    std::mt19937 random(2);
+    std::uniform_int_distribution<uint32_t> pickMarker(
+            0, static_cast<uint32_t>(markerCount - 1));
+    uploadCount = 0;
+    uploadedBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kEditRounds; ++round) {
+        for (int i = 0; i < kEditsPerRound; ++i) {
+            auto index = pickMarker(random);
+            set.setFlags(index, set.get(index).flags ^ kMarkerHighlighted);
+        }
+        set.consumeChanges([&](size_t, size_t count) {
+            ++uploadCount;
+            uploadedBytes += count * sizeof(MarkerInstance);
+        });
+    }
+    auto editMicros = elapsedMicroseconds(start) / kEditRounds;
+    std::printf("  %d edits a frame: %.1f us, %.1f KiB in %.1f ranges uploaded\n",
+                kEditsPerRound, editMicros,
+                static_cast<double>(uploadedBytes) / 1024.0 / kEditRounds,
+                static_cast<double>(uploadCount) / kEditRounds);
+
+    // What the vertex shader's horizon test keeps, from a few camera distances
+    std::printf("  %-16s %10s %12s\n", "camera distance", "visible", "count us");
+    for (float distance: {3.f, 1.5f, 1.05f}) {
+        size_t visible = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kVisibilityRounds; ++i) {
+            visible += set.countVisible(Vec3{0.f, 0.f, distance});
+        }
+        auto countMicros = elapsedMicroseconds(start) / kVisibilityRounds;
+        std::printf("  %-16.2f %10zu %12.0f\n",
+                    distance, visible / kVisibilityRounds, countMicros);
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = {100000};
+    }
+    for (auto count: counts) {
+        if (count == 0) {
+            std::fprintf(stderr, "usage: %s [marker count]...\n", argv[0]);
+            return 1;
+        }
+        run(count);
+    }
+    return 0;
+}
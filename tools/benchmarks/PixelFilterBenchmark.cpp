@@ -0,0 +1,180 @@
+// Filters an overlay the way InteractiveEarthView does when Africa is first tapped and times
+// PixelFilter against a port of the Kotlin loop it replaces: getPixels into an ARGB array, a
+// branch per pixel, and setPixels back.
+//
+//   pixelfilter_bench [overlay png] [thread count]
+//
+// Without a path it filters app/src/main/res/drawable/africa.png.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <png.h>
+
+#include "ImageData.h"
+#include "PixelFilter.h"
+
+namespace {
+
+constexpr int kRepeatCount = 20;
+
+//! the overlays' outline threshold, InteractiveEarthView's OUTLINE_MIN_ALPHA
+constexpr uint8_t kOutlineMinAlpha = 250;
+
+bool readPng(const std::string &path, ImageData &outImage) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str())) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    outImage.width = static_cast<int>(png.width);
+    outImage.height = static_cast<int>(png.height);
+    outImage.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, nullptr, outImage.pixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+//! premultiplies @a image like a decoded Android bitmap holds it
+std::vector<uint32_t> premultiply(const ImageData &image) {
+    std::vector<uint32_t> pixels(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        const auto *rgba = &image.pixels[4 * i];
+        auto alpha = static_cast<uint32_t>(rgba[3]);
+        pixels[i] = packRgba(static_cast<uint8_t>((rgba[0] * alpha + 127) / 255),
+                             static_cast<uint8_t>((rgba[1] * alpha + 127) / 255),
+                             static_cast<uint8_t>((rgba[2] * alpha + 127) / 255),
+                             static_cast<uint8_t>(alpha));
+    }
+    return pixels;
+}
+
+/*!
+ * The Kotlin version: getPixels unpremultiplies into ARGB ints, the loop takes each colour apart
+ * with Color.red and friends, setPixels premultiplies back into the bitmap.
+ */
+void filterLikeKotlin(std::vector<uint32_t> &bitmap) {
+    std::vector<int32_t> pixels(bitmap.size());
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        auto pixel = bitmap[i];
+        auto alpha = pixel >> 24;
+        uint32_t argb = alpha << 24;
+        if (alpha != 0) {
+            for (int channel = 0; channel < 3; ++channel) {
+                auto value = (pixel >> (8 * channel)) & 0xFFu;
+                argb |= std::min((value * 255 + alpha / 2) / alpha, 255u) << (16 - 8 * channel);
+            }
+        }
+        pixels[i] = static_cast<int32_t>(argb);
+    }
+
+    for (auto &color: pixels) {
+        auto red = (color >> 16) & 0xFF;
+        auto green = (color >> 8) & 0xFF;
+        auto blue = color & 0xFF;
+        auto alpha = (color >> 24) & 0xFF;
+        auto isPureBlack = red == 0 && green == 0 && blue == 0;
+        auto isOpaqueEnough = alpha >= kOutlineMinAlpha;
+        color = isPureBlack && isOpaqueEnough ? static_cast<int32_t>(0xFF000000u) : 0;
+    }
+
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+        auto argb = static_cast<uint32_t>(pixels[i]);
+        auto alpha = argb >> 24;
+        uint32_t pixel = alpha << 24;
+        for (int channel = 0; channel < 3; ++channel) {
+            auto value = (argb >> (16 - 8 * channel)) & 0xFFu;
+            pixel |= ((value * alpha + 127) / 255) << (8 * channel);
+        }
+        bitmap[i] = pixel;
+    }
+}
+
+/*!
+ * @return the fastest of @a kRepeatCount runs of @a filter over fresh copies of @a source, in
+ *     milliseconds
+ */
+template<typename Filter>
+double measure(const std::vector<uint32_t> &source, std::vector<uint32_t> &outFiltered,
+               Filter filter) {
+    auto best = 1e30;
+    for (int i = 0; i < kRepeatCount; ++i) {
+        outFiltered = source;
+        auto start = std::chrono::steady_clock::now();
+        filter(outFiltered);
+        std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string path = argc > 1 ? argv[1] : EARTHZOO_OVERLAY_PNG;
+    auto threadCount = argc > 2 ? std::atoi(argv[2])
+                                : static_cast<int>(std::thread::hardware_concurrency());
+    ImageData image;
+    if (threadCount <= 0 || !readPng(path, image)) {
+        std::fprintf(stderr, "usage: %s [overlay png] [thread count]\n", argv[0]);
+        return 1;
+    }
+
+    auto source = premultiply(image);
+    auto width = static_cast<uint32_t>(image.width);
+    auto height = static_cast<uint32_t>(image.height);
+    auto stride = static_cast<size_t>(width) * 4;
+    auto filter = PixelFilter::makeOutlineFilter(kOutlineMinAlpha);
+    std::printf("%s: %ux%u, best of %d runs\n\n", path.c_str(), width, height, kRepeatCount);
+
+    std::vector<uint32_t> expected;
+    auto kotlinMillis = measure(source, expected, filterLikeKotlin);
+
+    std::vector<uint32_t> filtered;
+    auto pixelMillis = measure(source, filtered, [&filter](std::vector<uint32_t> &pixels) {
+        for (auto &pixel: pixels) {
+            pixel = filter.apply(pixel);
+        }
+    });
+    auto pixelMatches = filtered == expected;
+
+    auto singleMillis = measure(source, filtered, [&](std::vector<uint32_t> &pixels) {
+        filter.applyImage(pixels.data(), width, height, stride, 1);
+    });
+    auto singleMatches = filtered == expected;
+
+    auto parallelMillis = measure(source, filtered, [&](std::vector<uint32_t> &pixels) {
+        filter.applyImage(pixels.data(), width, height, stride, threadCount);
+    });
+    auto parallelMatches = filtered == expected;
+
+    auto megapixels = static_cast<double>(width) * height / 1e6;
+    auto report = [&](const std::string &name, double millis, bool matches) {
+        std::printf("%-26s %8.2f ms %8.0f Mpixels/s %7.1fx  %s\n", name.c_str(), millis,
+                    megapixels / millis * 1000.0, kotlinMillis / millis,
+                    matches ? "" : "(differs from the Kotlin loop)");
+    };
+    report("Kotlin loop port", kotlinMillis, true);
+    report("PixelFilter, per pixel", pixelMillis, pixelMatches);
+    report("PixelFilter, 1 thread", singleMillis, singleMatches);
+    report("PixelFilter, " + std::to_string(threadCount) + " thread"
+           + (threadCount == 1 ? "" : "s"), parallelMillis, parallelMatches);
+    return 0;
+}
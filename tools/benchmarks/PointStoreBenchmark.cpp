@@ -0,0 +1,210 @@
+// Builds a PointStore from synthetic observations, maps it from disk and times region queries
+// against scanning the same points held in a std::vector, the way the app would keep them without
+// the store.
+//
+//   pointstore_bench [point count] [store path]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "PointStore.h"
+#include "SyntheticPoints.h"
+
+namespace {
+
+constexpr double kDegreesToRadians = 3.14159265358979323846 / 180.0;
+
+//! queries of each kind timed against the store, the scan only gets a few of them
+constexpr int kQueryCount = 200;
+constexpr int kScanQueryCount = 3;
+
+struct CapQuery {
+    float latitude;
+    float longitude;
+    float radius;
+};
+
+size_t scanCap(const std::vector<GeoPoint> &points, const CapQuery &cap,
+               std::vector<GeoPoint> &outPoints) {
+    auto latitude = cap.latitude * kDegreesToRadians;
+    auto longitude = cap.longitude * kDegreesToRadians;
+    auto cosLatitude = std::cos(latitude);
+    auto sinHalfRadius = std::sin(cap.radius * kDegreesToRadians * 0.5);
+    auto haversineRadius = sinHalfRadius * sinHalfRadius;
+    auto before = outPoints.size();
+    for (const auto &point: points) {
+        auto pointLatitude = point.latitude * kDegreesToRadians;
+        auto sinHalfLatitude = std::sin((pointLatitude - latitude) * 0.5);
+        auto sinHalfLongitude = std::sin((point.longitude * kDegreesToRadians - longitude) * 0.5);
+        auto haversine = sinHalfLatitude * sinHalfLatitude
+                         + cosLatitude * std::cos(pointLatitude)
+                           * sinHalfLongitude * sinHalfLongitude;
+        if (haversine <= haversineRadius) {
+            outPoints.push_back(point);
+        }
+    }
+    return outPoints.size() - before;
+}
+
+size_t scanRect(const std::vector<GeoPoint> &points, const GeoRect &rect,
+                std::vector<GeoPoint> &outPoints) {
+    auto crosses = rect.west > rect.east;
+    auto before = outPoints.size();
+    for (const auto &point: points) {
+        auto inLongitude = crosses
+                           ? point.longitude >= rect.west || point.longitude <= rect.east
+                           : point.longitude >= rect.west && point.longitude <= rect.east;
+        if (inLongitude && point.latitude >= rect.south && point.latitude <= rect.north) {
+            outPoints.push_back(point);
+        }
+    }
+    return outPoints.size() - before;
+}
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/*!
+ * Times @a queryStore over every query and @a scan over the first few, then prints a row.
+ */
+template<typename Query, typename StoreFunction, typename ScanFunction>
+void measure(const char *name, const std::vector<Query> &queries, StoreFunction queryStore,
+             ScanFunction scan) {
+    std::vector<GeoPoint> found;
+    PointQueryStats total;
+    size_t storePoints = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &query: queries) {
+        PointQueryStats stats;
+        found.clear();
+        storePoints += queryStore(query, found, stats);
+        total.blocksDecoded += stats.blocksDecoded;
+        total.pointsTested += stats.pointsTested;
+    }
+    auto storeMicros = elapsedMicroseconds(start) / static_cast<double>(queries.size());
+
+    size_t scanPoints = 0;
+    size_t storeScanPoints = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kScanQueryCount; ++i) {
+        found.clear();
+        scanPoints += scan(queries[i], found);
+    }
+    auto scanMicros = elapsedMicroseconds(start) / kScanQueryCount;
+    for (int i = 0; i < kScanQueryCount; ++i) {
+        PointQueryStats stats;
+        found.clear();
+        storeScanPoints += queryStore(queries[i], found, stats);
+    }
+
+    auto count = static_cast<double>(queries.size());
+    std::printf("%-22s %10.1f %12.1f %10.0f %10.0f %8.1fx  %s\n",
+                name, storeMicros, scanMicros,
+                static_cast<double>(storePoints) / count,
+                static_cast<double>(total.blocksDecoded) / count,
+                scanMicros / storeMicros,
+                scanPoints == storeScanPoints ? "" : "(edges differ by the quantization)");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t pointCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    std::string path = argc > 2 ? argv[2] : "pointstore_bench.ezpts";
+    if (pointCount == 0) {
+        std::fprintf(stderr, "usage: %s [point count] [store path]\n", argv[0]);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto points = generateSyntheticPoints(pointCount, 1);
+    std::printf("generated %zu points in %.0f ms\n",
+                pointCount, elapsedMicroseconds(start) / 1000.0);
+
+    start = std::chrono::steady_clock::now();
+    auto contents = PointStore::build(points);
+    std::printf("built the store in %.0f ms, %zu bytes, %.2f per point (the vector takes %zu)\n",
+                elapsedMicroseconds(start) / 1000.0, contents.size(),
+                static_cast<double>(contents.size()) / static_cast<double>(pointCount),
+                sizeof(GeoPoint));
+    {
+        std::ofstream output(path, std::ios::binary);
+        output.write(reinterpret_cast<const char *>(contents.data()),
+                     static_cast<std::streamsize>(contents.size()));
+    }
+    contents = std::vector<uint8_t>();
+
+    start = std::chrono::steady_clock::now();
+    auto file = MappedFile::open(path);
+    PointStore store;
+    if (!file || !store.attach(file->getData(), file->getSize())) {
+        std::fprintf(stderr, "%s: can't map the store\n", path.c_str());
+        return 1;
+    }
+    std::printf("mapped and validated in %.0f us: %zu blocks, %zu levels\n\n",
+                elapsedMicroseconds(start), store.getBlockCount(), store.getLevelCount());
+
+    // Queries centred on data, like a user looking at where the observations are
+    std::mt19937 random(2);
+    std::uniform_int_distribution<size_t> pickPoint(0, pointCount - 1);
+    auto makeCaps = [&](float radius) {
+        std::vector<CapQuery> caps;
+        for (int i = 0; i < kQueryCount; ++i) {
+            const auto &centre = points[pickPoint(random)];
+            caps.push_back({centre.latitude, centre.longitude, radius});
+        }
+        return caps;
+    };
+    auto makeRects = [&](float width, float height, bool acrossAntimeridian) {
+        std::vector<GeoRect> rects;
+        for (int i = 0; i < kQueryCount; ++i) {
+            const auto &centre = points[pickPoint(random)];
+            auto west = acrossAntimeridian ? 180.f - width * 0.5f : centre.longitude - width * 0.5f;
+            auto east = west + width;
+            if (east > 180.f) {
+                east -= 360.f;
+            }
+            if (west < -180.f) {
+                west += 360.f;
+            }
+            auto south = std::clamp(centre.latitude - height * 0.5f, -90.f, 90.f - height);
+            rects.push_back({south, west, south + height, east});
+        }
+        return rects;
+    };
+
+    auto cap = [&store](const CapQuery &query, std::vector<GeoPoint> &out,
+                        PointQueryStats &stats) {
+        return store.queryCap(query.latitude, query.longitude, query.radius, out, &stats);
+    };
+    auto rect = [&store](const GeoRect &query, std::vector<GeoPoint> &out,
+                         PointQueryStats &stats) {
+        return store.queryRect(query, out, &stats);
+    };
+    auto scanCaps = [&points](const CapQuery &query, std::vector<GeoPoint> &out) {
+        return scanCap(points, query, out);
+    };
+    auto scanRects = [&points](const GeoRect &query, std::vector<GeoPoint> &out) {
+        return scanRect(points, query, out);
+    };
+
+    std::printf("%-22s %10s %12s %10s %10s %9s\n",
+                "query", "store us", "scan us", "points", "blocks", "speedup");
+    measure("cap 10 km", makeCaps(0.09f), cap, scanCaps);
+    measure("cap 100 km", makeCaps(0.9f), cap, scanCaps);
+    measure("cap 1000 km", makeCaps(9.f), cap, scanCaps);
+    measure("viewport 4x3 deg", makeRects(4.f, 3.f, false), rect, scanRects);
+    measure("viewport 40x30 deg", makeRects(40.f, 30.f, false), rect, scanRects);
+    measure("viewport antimeridian", makeRects(40.f, 30.f, true), rect, scanRects);
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Classifies synthetic observations by the region they're in and times RegionClassifier against
+// the polygon test InteractiveEarthView runs per point, over every outline in order. Once with the
+// continents, once with many small outlines where the grid index matters most.
+//
+//   regionclassifier_bench [point count] [thread count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Continents.h"
+#include "RegionClassifier.h"
+#include "SyntheticPoints.h"
+
+namespace {
+
+//! the baseline only classifies the first of these many points and is scaled up
+constexpr size_t kBaselinePointCount = 1000000;
+
+constexpr int kStarCount = 200;
+
+double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+//! InteractiveEarthView's Continent.contains
+bool containsPoint(const RegionOutline &outline, float u, float v) {
+    auto result = false;
+    auto count = outline.points.size() / 2;
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        auto ui = outline.points[2 * i];
+        auto vi = outline.points[2 * i + 1];
+        auto uj = outline.points[2 * j];
+        auto vj = outline.points[2 * j + 1];
+        if ((vi > v) != (vj > v)) {
+            auto denominator = vj - vi;
+            if (std::fabs(denominator) > 0.00001f) {
+                auto crossing = ui + (v - vi) / denominator * (uj - ui);
+                if (u < crossing) {
+                    result = !result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void scanRegions(const std::vector<RegionOutline> &outlines, const float *latLon, size_t count,
+                 uint16_t *outRegions) {
+    for (size_t i = 0; i < count; ++i) {
+        auto u = (latLon[2 * i + 1] + 180.f) / 360.f;
+        auto v = (90.f - latLon[2 * i]) / 180.f;
+        outRegions[i] = RegionRaster::kNoRegion;
+        for (const auto &outline: outlines) {
+            if (containsPoint(outline, u, v)) {
+                outRegions[i] = outline.id;
+                break;
+            }
+        }
+    }
+}
+
+//! small stars scattered over the map, like parks or reserves
+std::vector<RegionOutline> makeStars(int count) {
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> centre(0.05f, 0.95f);
+    std::uniform_real_distribution<float> radius(0.002f, 0.02f);
+    std::vector<RegionOutline> stars;
+    for (int i = 0; i < count; ++i) {
+        RegionOutline star;
+        star.id = static_cast<uint16_t>(i + 1);
+        auto u = centre(random);
+        auto v = centre(random);
+        auto outer = radius(random);
+        for (int corner = 0; corner < 16; ++corner) {
+            auto angle = 6.2831853f * static_cast<float>(corner) / 16.f;
+            auto distance = corner % 2 == 0 ? outer : outer * 0.5f;
+            star.points.push_back(u + distance * std::cos(angle));
+            star.points.push_back(v + distance * std::sin(angle));
+        }
+        stars.push_back(std::move(star));
+    }
+    return stars;
+}
+
+void measure(const char *name, const std::vector<RegionOutline> &outlines,
+             const std::vector<float> &latLon, int threadCount) {
+    auto count = latLon.size() / 2;
+    size_t edgeCount = 0;
+    for (const auto &outline: outlines) {
+        edgeCount += outline.points.size() / 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    RegionClassifier classifier(outlines);
+    auto buildMillis = elapsedMilliseconds(start);
+
+    auto baselineCount = std::min(count, kBaselinePointCount);
+    std::vector<uint16_t> expected(baselineCount);
+    start = std::chrono::steady_clock::now();
+    scanRegions(outlines, latLon.data(), baselineCount, expected.data());
+    auto baselineMillis = elapsedMilliseconds(start) * static_cast<double>(count)
+                          / static_cast<double>(baselineCount);
+
+    std::vector<uint16_t> regions(count);
+    start = std::chrono::steady_clock::now();
+    classifier.classify(latLon.data(), count, regions.data(), 1);
+    auto singleMillis = elapsedMilliseconds(start);
+
+    start = std::chrono::steady_clock::now();
+    classifier.classify(latLon.data(), count, regions.data(), threadCount);
+    auto parallelMillis = elapsedMilliseconds(start);
+
+    size_t differences = 0;
+    size_t classified = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i < baselineCount && regions[i] != expected[i]) {
+            differences++;
+        }
+        if (regions[i] != RegionRaster::kNoRegion) {
+            classified++;
+        }
+    }
+
+    std::printf("%s: %zu outlines, %zu edges, %zu in the index built in %.1f ms\n",
+                name, outlines.size(), edgeCount, classifier.getIndexedEdgeCount(), buildMillis);
+    std::printf("  %-24s %10.1f ms %8.1f Mpoints/s\n", "per point, every outline",
+                baselineMillis, static_cast<double>(count) / baselineMillis / 1000.0);
+    std::printf("  %-24s %10.1f ms %8.1f Mpoints/s %6.1fx\n", "classifier, 1 thread",
+                singleMillis, static_cast<double>(count) / singleMillis / 1000.0,
+                baselineMillis / singleMillis);
+    std::printf("  %-24s %10.1f ms %8.1f Mpoints/s %6.1fx\n",
+                ("classifier, " + std::to_string(threadCount) + " thread"
+                 + (threadCount == 1 ? "" : "s")).c_str(),
+                parallelMillis, static_cast<double>(count) / parallelMillis / 1000.0,
+                baselineMillis / parallelMillis);
+    std::printf("  %zu points in a region, %zu of %zu differ from the baseline by rounding\n\n",
+                classified, differences, baselineCount);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t pointCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    auto threadCount = argc > 2 ? std::atoi(argv[2])
+                                : static_cast<int>(std::thread::hardware_concurrency());
+    if (pointCount == 0 || threadCount <= 0) {
+        std::fprintf(stderr, "usage: %s [point count] [thread count]\n", argv[0]);
+        return 1;
+    }
+
+    auto points = generateSyntheticPoints(pointCount, 1);
+    std::vector<float> latLon(2 * pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        latLon[2 * i] = points[i].latitude;
+        latLon[2 * i + 1] = points[i].longitude;
+    }
+    points = std::vector<GeoPoint>();
+    std::printf("%zu synthetic points\n\n", pointCount);
+
+    measure("continents", getContinentOutlines(), latLon, threadCount);
+    measure("stars", makeStars(kStarCount), latLon, threadCount);
+    return 0;
+}
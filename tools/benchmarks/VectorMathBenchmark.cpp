@@ -0,0 +1,147 @@
+// Times VectorMath against the float* helpers the renderer used before it, on the work the app
+// does with them: composing matrices and pushing arrays of points through one.
+//
+//   vectormath_bench [point count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "VectorMath.h"
+
+namespace {
+
+// The previous Utility helpers, kept here as the baseline
+
+void referenceMultiply(float *outMatrix, const float *lhs, const float *rhs) {
+    float result[16];
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            result[col * 4 + row] =
+                    lhs[0 * 4 + row] * rhs[col * 4 + 0] +
+                    lhs[1 * 4 + row] * rhs[col * 4 + 1] +
+                    lhs[2 * 4 + row] * rhs[col * 4 + 2] +
+                    lhs[3 * 4 + row] * rhs[col * 4 + 3];
+        }
+    }
+    std::copy(result, result + 16, outMatrix);
+}
+
+void referenceTransformPoints(const float *matrix, const float *points, float *out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const float *p = points + i * 3;
+        for (int row = 0; row < 3; ++row) {
+            out[i * 3 + row] = matrix[row] * p[0]
+                               + matrix[4 + row] * p[1]
+                               + matrix[8 + row] * p[2]
+                               + matrix[12 + row];
+        }
+    }
+}
+
+template<typename Function>
+double measureNanoseconds(size_t operations, Function function) {
+    // Best of a few runs, the first one also warms the caches
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(operations));
+    }
+    return best;
+}
+
+void report(const char *name, double reference, double vectorMath) {
+    std::printf("%-26s %8.2f ns %8.2f ns %6.2fx\n",
+                name, reference, vectorMath, reference / vectorMath);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t pointCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    if (pointCount == 0) {
+        std::fprintf(stderr, "usage: %s [point count]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    std::printf("VectorMath backend: %s\n", getVectorMathBackend());
+    std::printf("%-26s %11s %11s %7s\n", "", "reference", "VectorMath", "speedup");
+
+    // One view-projection times many model matrices, like building a matrix per object
+    constexpr size_t kMatrixCount = 4096;
+    constexpr int kRepeats = 256;
+    auto viewProjection =
+            Mat4::perspective(1.f, 1.5f, 0.1f, 10.f) * Mat4::translation({0.f, 0.f, -3.f});
+    std::vector<Mat4> models(kMatrixCount);
+    for (auto &model: models) {
+        model = Mat4::translation({distribution(random), distribution(random), 0.f})
+                * Mat4::rotationY(distribution(random));
+    }
+    std::vector<Mat4> products(kMatrixCount);
+    float checksum = 0.f;
+
+    auto referenceProducts = measureNanoseconds(kMatrixCount * kRepeats, [&]() {
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            for (size_t i = 0; i < kMatrixCount; ++i) {
+                referenceMultiply(
+                        &products[i].columns[0].x, viewProjection.data(), models[i].data());
+            }
+            checksum += products[repeat].columns[0].x;
+        }
+    });
+    auto vectorMathProducts = measureNanoseconds(kMatrixCount * kRepeats, [&]() {
+        for (int repeat = 0; repeat < kRepeats; ++repeat) {
+            for (size_t i = 0; i < kMatrixCount; ++i) {
+                products[i] = viewProjection * models[i];
+            }
+            checksum += products[repeat].columns[0].x;
+        }
+    });
+    report("Mat4 * Mat4", referenceProducts, vectorMathProducts);
+
+    // A big batch of points through one matrix, like markers or picking candidates
+    std::vector<float> referencePoints(pointCount * 3);
+    std::vector<Vec3> points(pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        points[i] = {distribution(random), distribution(random), distribution(random)};
+        referencePoints[i * 3] = points[i].x;
+        referencePoints[i * 3 + 1] = points[i].y;
+        referencePoints[i * 3 + 2] = points[i].z;
+    }
+    std::vector<float> referenceOut(referencePoints.size());
+    std::vector<Vec3> out(pointCount);
+
+    auto referenceBatch = measureNanoseconds(pointCount, [&]() {
+        referenceTransformPoints(
+                viewProjection.data(), referencePoints.data(), referenceOut.data(), pointCount);
+        checksum += referenceOut[pointCount / 2];
+    });
+    auto vectorMathBatch = measureNanoseconds(pointCount, [&]() {
+        viewProjection.transformPoints(points.data(), out.data(), pointCount);
+        checksum += out[pointCount / 2].x;
+    });
+    report("transformPoints (per point)", referenceBatch, vectorMathBatch);
+
+    std::vector<Vec4> vectors(pointCount);
+    for (size_t i = 0; i < pointCount; ++i) {
+        vectors[i] = Vec4(points[i], 1.f);
+    }
+    std::vector<Vec4> clip(pointCount);
+    auto vectorMathClip = measureNanoseconds(pointCount, [&]() {
+        viewProjection.transformVectors(vectors.data(), clip.data(), pointCount);
+        checksum += clip[pointCount / 2].w;
+    });
+    report("transformVectors (per vec)", referenceBatch, vectorMathClip);
+
+    // Keeps the optimizer from dropping the work
+    std::printf("checksum %g\n", checksum);
+    return 0;
+}
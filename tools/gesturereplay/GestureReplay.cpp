@@ -0,0 +1,375 @@
+#include "GestureReplay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+//! a frame's lag is only measured while the finger moves at least this fast at its present time
+//! (pixels per second)
+constexpr float kMinMeasuredSpeed = 100.f;
+
+//! how far around a frame's present time its shown position is looked for on the trace
+constexpr int64_t kLagSearchBackNanos = 250000000LL;
+constexpr int64_t kLagSearchAheadNanos = 100000000LL;
+
+//! the safety net for traces the engine never settles on, ten minutes at 60 Hz
+constexpr int kMaxReplayFrames = 36000;
+
+struct TruthSample {
+    int64_t timeNanos;
+    float x;
+    float y;
+};
+
+/*!
+ * The pan position the trace describes, the centroid of the fingers without jumps when fingers
+ * come and go. This is the path the globe should follow if there was no latency.
+ */
+std::vector<TruthSample> buildTruth(const std::vector<TouchEvent> &events) {
+    std::vector<TruthSample> truth;
+    std::vector<TouchPointer> down;
+    float panX = 0.f;
+    float panY = 0.f;
+    float baseX = 0.f;
+    float baseY = 0.f;
+
+    auto centroid = [&down](float &outX, float &outY) {
+        outX = 0.f;
+        outY = 0.f;
+        for (const auto &pointer: down) {
+            outX += pointer.x / static_cast<float>(down.size());
+            outY += pointer.y / static_cast<float>(down.size());
+        }
+    };
+
+    for (const auto &event: events) {
+        // Positions first, the pan only follows fingers that were already down
+        for (int i = 0; i < event.pointerCount; ++i) {
+            for (auto &pointer: down) {
+                if (pointer.id == event.pointers[i].id) {
+                    pointer = event.pointers[i];
+                }
+            }
+        }
+        float x;
+        float y;
+        centroid(x, y);
+        if (!down.empty()) {
+            panX += x - baseX;
+            panY += y - baseY;
+        }
+
+        switch (event.action) {
+            case TouchEvent::Action::Down:
+                for (int i = 0; i < event.pointerCount; ++i) {
+                    if (event.pointers[i].id == event.actionPointerId
+                        && down.size() < kMaxGesturePointers) {
+                        down.push_back(event.pointers[i]);
+                    }
+                }
+                break;
+            case TouchEvent::Action::Up:
+                down.erase(
+                        std::remove_if(down.begin(), down.end(), [&event](const TouchPointer &p) {
+                            return p.id == event.actionPointerId;
+                        }),
+                        down.end());
+                break;
+            case TouchEvent::Action::Cancel:
+                down.clear();
+                break;
+            case TouchEvent::Action::Move:
+                break;
+        }
+        centroid(baseX, baseY);
+        truth.push_back({event.timeNanos, panX, panY});
+    }
+    return truth;
+}
+
+/*!
+ * @return how long before @a presentTimeNanos the trace passed closest to the shown position, or
+ *     -1 if the finger is too slow at that time for the lag to mean anything
+ */
+int64_t measureVisualLag(
+        const std::vector<TruthSample> &truth,
+        int64_t presentTimeNanos,
+        float shownX,
+        float shownY) {
+    auto first = std::lower_bound(
+            truth.begin(), truth.end(), presentTimeNanos - kLagSearchBackNanos,
+            [](const TruthSample &sample, int64_t time) { return sample.timeNanos < time; });
+    auto last = std::upper_bound(
+            truth.begin(), truth.end(), presentTimeNanos + kLagSearchAheadNanos,
+            [](int64_t time, const TruthSample &sample) { return time < sample.timeNanos; });
+    if (first == truth.end() || last - first < 2) {
+        return -1;
+    }
+
+    // Only a moving finger has a lag, a resting one is simply caught up with or not
+    auto present = std::upper_bound(
+            truth.begin(), truth.end(), presentTimeNanos,
+            [](int64_t time, const TruthSample &sample) { return time < sample.timeNanos; });
+    if (present == truth.begin() || present == truth.end()) {
+        return -1;
+    }
+    const auto &before = *(present - 1);
+    auto presentSpeed = std::hypot(present->x - before.x, present->y - before.y)
+                        / (static_cast<float>(present->timeNanos - before.timeNanos) * 1e-9f);
+    if (!(presentSpeed >= kMinMeasuredSpeed)) {
+        return -1;
+    }
+
+    auto bestDistance = std::numeric_limits<float>::max();
+    double bestTime = 0.0;
+    for (auto it = first; it + 1 < last; ++it) {
+        const auto &a = *it;
+        const auto &b = *(it + 1);
+        auto segmentX = b.x - a.x;
+        auto segmentY = b.y - a.y;
+        auto lengthSquared = segmentX * segmentX + segmentY * segmentY;
+        auto t = lengthSquared > 0.f
+                 ? std::clamp(
+                        ((shownX - a.x) * segmentX + (shownY - a.y) * segmentY) / lengthSquared,
+                        0.f, 1.f)
+                 : 0.f;
+        auto distance = std::hypot(a.x + segmentX * t - shownX, a.y + segmentY * t - shownY);
+        if (distance < bestDistance) {
+            auto duration = static_cast<double>(b.timeNanos - a.timeNanos);
+            bestDistance = distance;
+            bestTime = static_cast<double>(a.timeNanos) + duration * t;
+        }
+    }
+    return presentTimeNanos - static_cast<int64_t>(bestTime);
+}
+
+} // namespace
+
+ReplayResult replayTouchTrace(const std::vector<TouchEvent> &events, const ReplayConfig &config) {
+    ReplayResult result;
+    if (events.empty()) {
+        return result;
+    }
+
+    auto truth = buildTruth(events);
+
+    GestureEngine engine;
+    engine.setPredictionEnabled(config.prediction);
+
+    auto periodNanos = static_cast<int64_t>(1e9 / config.refreshHz);
+    auto startNanos = events.front().timeNanos;
+    float shownX = 0.f;
+    float shownY = 0.f;
+    float shownDistanceScale = 1.f;
+    double totalLag = 0.0;
+
+    size_t next = 0;
+    for (int frame = 0; frame < kMaxReplayFrames; ++frame) {
+        auto frameTimeNanos = startNanos + frame * periodNanos;
+
+        // Everything the app received before the vsync is handled before the frame, like the
+        // render thread draining its touch queue
+        while (next < events.size()
+               && events[next].timeNanos + config.inputDelayNanos <= frameTimeNanos) {
+            engine.onTouchEvent(events[next++]);
+        }
+
+        if (engine.needsFrame()) {
+            auto presentTimeNanos = frameTimeNanos + config.presentLatencyFrames * periodNanos;
+            auto motion = engine.update(frameTimeNanos, presentTimeNanos);
+            shownX += motion.dx;
+            shownY += motion.dy;
+            shownDistanceScale *= motion.distanceScale;
+
+            ReplayFrame replayFrame{};
+            replayFrame.frameTimeNanos = frameTimeNanos;
+            replayFrame.presentTimeNanos = presentTimeNanos;
+            replayFrame.shownX = shownX;
+            replayFrame.shownY = shownY;
+            replayFrame.shownDistanceScale = shownDistanceScale;
+            replayFrame.touching = engine.isTouching();
+            replayFrame.visualLagNanos = replayFrame.touching
+                                         ? measureVisualLag(truth, presentTimeNanos, shownX, shownY)
+                                         : -1;
+            if (replayFrame.visualLagNanos != -1) {
+                totalLag += static_cast<double>(replayFrame.visualLagNanos);
+                result.maxVisualLagNanos = std::max(
+                        result.maxVisualLagNanos, replayFrame.visualLagNanos);
+                result.measuredFrames++;
+            }
+            result.frames.push_back(replayFrame);
+        }
+
+        if (next == events.size() && !engine.needsFrame()) {
+            break;
+        }
+    }
+
+    result.stats = engine.getStats();
+    if (result.measuredFrames > 0) {
+        result.meanVisualLagNanos = totalLag / static_cast<double>(result.measuredFrames);
+    }
+    return result;
+}
+
+bool readTouchTrace(std::istream &in, std::vector<TouchEvent> &outEvents, std::string &outError) {
+    outEvents.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        auto firstChar = line.find_first_not_of(" \t\r");
+        if (firstChar == std::string::npos || line[firstChar] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        double timeMillis;
+        std::string action;
+        TouchEvent event;
+        if (!(fields >> timeMillis >> action >> event.actionPointerId)) {
+            outError = "line " + std::to_string(lineNumber) + ": expected time, action and id";
+            return false;
+        }
+        event.timeNanos = static_cast<int64_t>(std::llround(timeMillis * 1e6));
+
+        if (action == "down") {
+            event.action = TouchEvent::Action::Down;
+        } else if (action == "move") {
+            event.action = TouchEvent::Action::Move;
+        } else if (action == "up") {
+            event.action = TouchEvent::Action::Up;
+        } else if (action == "cancel") {
+            event.action = TouchEvent::Action::Cancel;
+        } else {
+            outError = "line " + std::to_string(lineNumber) + ": unknown action " + action;
+            return false;
+        }
+
+        std::string pointer;
+        while (fields >> pointer) {
+            TouchPointer parsed;
+            char colon;
+            char comma;
+            std::istringstream pointerFields(pointer);
+            if (event.pointerCount == kMaxGesturePointers
+                || !(pointerFields >> parsed.id >> colon >> parsed.x >> comma >> parsed.y)
+                || colon != ':' || comma != ',') {
+                outError = "line " + std::to_string(lineNumber) + ": bad pointer " + pointer;
+                return false;
+            }
+            event.pointers[event.pointerCount++] = parsed;
+        }
+
+        if (!outEvents.empty() && event.timeNanos < outEvents.back().timeNanos) {
+            outError = "line " + std::to_string(lineNumber) + ": time goes backwards";
+            return false;
+        }
+        outEvents.push_back(event);
+    }
+    return true;
+}
+
+void writeTouchTrace(std::ostream &out, const std::vector<TouchEvent> &events) {
+    static const char *const kActionNames[] = {"down", "move", "up", "cancel"};
+    for (const auto &event: events) {
+        out << std::fixed << std::setprecision(6) << static_cast<double>(event.timeNanos) / 1e6
+            << std::defaultfloat << std::setprecision(9) << ' '
+            << kActionNames[static_cast<int>(event.action)] << ' ' << event.actionPointerId;
+        for (int i = 0; i < event.pointerCount; ++i) {
+            const auto &pointer = event.pointers[i];
+            out << ' ' << pointer.id << ':' << pointer.x << ',' << pointer.y;
+        }
+        out << '\n';
+    }
+}
+
+std::vector<TouchEvent> makeDragTrace(
+        float speed,
+        int durationMillis,
+        double sampleHz,
+        int holdAtEndMillis) {
+    constexpr float kStartX = 100.f;
+    constexpr float kY = 500.f;
+    constexpr int64_t kStartNanos = 1000000000LL;
+
+    auto sample = [](TouchEvent::Action action, int64_t timeNanos, float x) {
+        TouchEvent event;
+        event.action = action;
+        event.timeNanos = timeNanos;
+        event.actionPointerId = action == TouchEvent::Action::Move ? -1 : 0;
+        event.pointerCount = 1;
+        event.pointers[0] = {0, x, kY};
+        return event;
+    };
+
+    std::vector<TouchEvent> events;
+    events.push_back(sample(TouchEvent::Action::Down, kStartNanos, kStartX));
+
+    auto intervalNanos = 1e9 / sampleHz;
+    auto durationNanos = static_cast<int64_t>(durationMillis) * 1000000LL;
+    int64_t timeNanos = kStartNanos;
+    for (int i = 1;; ++i) {
+        timeNanos = kStartNanos + static_cast<int64_t>(i * intervalNanos);
+        if (timeNanos > kStartNanos + durationNanos) {
+            break;
+        }
+        auto x = kStartX + speed * static_cast<float>(timeNanos - kStartNanos) * 1e-9f;
+        events.push_back(sample(TouchEvent::Action::Move, timeNanos, x));
+    }
+
+    auto endX = events.back().pointers[0].x;
+    auto upNanos = events.back().timeNanos + static_cast<int64_t>(holdAtEndMillis) * 1000000LL
+                   + static_cast<int64_t>(intervalNanos);
+    events.push_back(sample(TouchEvent::Action::Up, upNanos, endX));
+    return events;
+}
+
+std::vector<TouchEvent> makePinchTrace(
+        float startSpan,
+        float endSpan,
+        int durationMillis,
+        double sampleHz) {
+    constexpr float kCenterX = 500.f;
+    constexpr float kCenterY = 800.f;
+    constexpr int64_t kStartNanos = 1000000000LL;
+
+    // Pointer 0 is the left finger and goes down first, pointer 1 the right one. Like the app's
+    // events, the pointer that goes up or down comes first.
+    auto sample = [](TouchEvent::Action action, int64_t timeNanos, int32_t actionId, float span) {
+        TouchPointer left{0, kCenterX - span * 0.5f, kCenterY};
+        TouchPointer right{1, kCenterX + span * 0.5f, kCenterY};
+        TouchEvent event;
+        event.action = action;
+        event.timeNanos = timeNanos;
+        event.actionPointerId = actionId;
+        event.pointerCount = 2;
+        event.pointers[0] = actionId == 1 ? right : left;
+        event.pointers[1] = actionId == 1 ? left : right;
+        return event;
+    };
+
+    std::vector<TouchEvent> events;
+    events.push_back(sample(TouchEvent::Action::Down, kStartNanos, 0, startSpan));
+    events.back().pointerCount = 1;
+    events.push_back(sample(TouchEvent::Action::Down, kStartNanos + 1000000, 1, startSpan));
+
+    auto intervalNanos = 1e9 / sampleHz;
+    auto steps = static_cast<int>(static_cast<double>(durationMillis) * 1e6 / intervalNanos);
+    for (int i = 1; i <= steps; ++i) {
+        auto t = static_cast<float>(i) / static_cast<float>(steps);
+        auto timeNanos = kStartNanos + 1000000 + static_cast<int64_t>(i * intervalNanos);
+        events.push_back(sample(
+                TouchEvent::Action::Move, timeNanos, -1, startSpan + (endSpan - startSpan) * t));
+    }
+
+    auto endNanos = events.back().timeNanos + static_cast<int64_t>(intervalNanos);
+    events.push_back(sample(TouchEvent::Action::Up, endNanos, 1, endSpan));
+    events.push_back(sample(TouchEvent::Action::Up, endNanos + 1000000, 0, endSpan));
+    events.back().pointerCount = 1;
+    return events;
+}
@@ -0,0 +1,106 @@
+#ifndef EARTHZOO_TOOLS_GESTUREREPLAY_H
+#define EARTHZOO_TOOLS_GESTUREREPLAY_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "GestureEngine.h"
+
+/*!
+ * How a trace is played back through a @a GestureEngine, standing in for the display and the
+ * input pipeline of a device.
+ */
+struct ReplayConfig {
+    //! the display's refresh rate, frames are rendered on every vsync
+    double refreshHz = 60.0;
+
+    //! vsyncs from a frame's vsync until it's on screen, like RenderThread::kPresentLatencyFrames
+    int presentLatencyFrames = 2;
+
+    //! time from a touch sample until the app can read it
+    int64_t inputDelayNanos = 4000000;
+
+    bool prediction = true;
+};
+
+/*!
+ * One rendered frame of a replay.
+ */
+struct ReplayFrame {
+    int64_t frameTimeNanos;
+    int64_t presentTimeNanos;
+
+    //! the pan position shown by this frame, the sum of every GestureMotion so far
+    float shownX;
+    float shownY;
+
+    //! the camera distance factor shown by this frame, the product of every GestureMotion so far
+    float shownDistanceScale;
+
+    //! true if a finger was down when the frame was rendered
+    bool touching;
+
+    /*!
+     * How long ago the finger was where this frame shows it, measured on the trace at the present
+     * time. Negative when the prediction overshoots, -1 if it can't be told, e.g. during a fling.
+     */
+    int64_t visualLagNanos;
+};
+
+struct ReplayResult {
+    std::vector<ReplayFrame> frames;
+
+    //! the engine's own touch-to-photon estimate
+    GestureStats stats;
+
+    //! mean and maximum of the frames' @a visualLagNanos where it could be measured
+    double meanVisualLagNanos = 0.0;
+    int64_t maxVisualLagNanos = 0;
+    size_t measuredFrames = 0;
+};
+
+/*!
+ * Plays @a events back at their timestamps. Events become visible to the engine once their
+ * input delay has passed, the engine is updated once per vsync until it stops asking for frames.
+ */
+ReplayResult replayTouchTrace(const std::vector<TouchEvent> &events, const ReplayConfig &config);
+
+/*!
+ * Reads a trace in the text format written by @a writeTouchTrace. One event per line:
+ *
+ *   <time ms> <down|move|up|cancel> <action pointer id> <id>:<x>,<y> [<id>:<x>,<y>]
+ *
+ * Blank lines and lines starting with # are skipped.
+ *
+ * @return false with a description in @a outError if a line couldn't be parsed
+ */
+bool readTouchTrace(std::istream &in, std::vector<TouchEvent> &outEvents, std::string &outError);
+
+void writeTouchTrace(std::ostream &out, const std::vector<TouchEvent> &events);
+
+/*!
+ * A one finger drag along x at a constant speed, sampled like a touch screen.
+ *
+ * @param speed pixels per second
+ * @param sampleHz the touch screen's sampling rate
+ * @param holdAtEndMillis how long the finger rests before lifting, 0 flings
+ */
+std::vector<TouchEvent> makeDragTrace(
+        float speed,
+        int durationMillis,
+        double sampleHz,
+        int holdAtEndMillis);
+
+/*!
+ * Two fingers moving symmetrically apart from @a startSpan to @a endSpan pixels.
+ */
+std::vector<TouchEvent> makePinchTrace(
+        float startSpan,
+        float endSpan,
+        int durationMillis,
+        double sampleHz);
+
+#endif //EARTHZOO_TOOLS_GESTUREREPLAY_H
@@ -0,0 +1,143 @@
+// Replays touch traces through the app's GestureEngine against a simulated display and reports how
+// far the globe trails the finger, with and without prediction.
+//
+//   gesturereplay [--hz 60] [--latency-frames 2] [--input-delay-ms 4] [--frames]
+//                 [--write-trace out.txt]
+//                 (trace.txt | --drag SPEED | --fling SPEED | --pinch)
+//
+// Traces are text, one touch sample per line, see readTouchTrace. --drag, --fling and --pinch
+// synthesize a 120 Hz touch screen instead, --write-trace saves the synthesized events.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "GestureReplay.h"
+
+namespace {
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [--hz N] [--latency-frames N] [--input-delay-ms N] [--frames]\n"
+                 "          [--write-trace out.txt] (trace.txt | --drag SPEED | --fling SPEED |"
+                 " --pinch)\n",
+                 program);
+}
+
+void printResult(const char *label, const ReplayResult &result) {
+    const auto &stats = result.stats;
+    auto frames = static_cast<double>(std::max<uint64_t>(stats.framesWithInput, 1));
+    std::printf("%-14s %6zu frames %6llu samples  touch->photon avg %6.2fms max %6.2fms  "
+                "predicted avg %5.2fms  visual lag avg %6.2fms max %6.2fms (%zu frames)"
+                "  fling frames %llu\n",
+                label,
+                result.frames.size(),
+                static_cast<unsigned long long>(stats.samples),
+                static_cast<double>(stats.totalTouchToPhotonNanos) / frames / 1e6,
+                static_cast<double>(stats.maxTouchToPhotonNanos) / 1e6,
+                static_cast<double>(stats.totalPredictionNanos) / frames / 1e6,
+                result.meanVisualLagNanos / 1e6,
+                static_cast<double>(result.maxVisualLagNanos) / 1e6,
+                result.measuredFrames,
+                static_cast<unsigned long long>(stats.flingFrames));
+}
+
+void printFrames(const ReplayResult &result) {
+    std::printf("%10s %10s %10s %8s %6s %10s\n",
+                "frame ms", "x", "y", "scale", "touch", "lag ms");
+    auto start = result.frames.empty() ? 0 : result.frames.front().frameTimeNanos;
+    for (const auto &frame: result.frames) {
+        std::printf("%10.2f %10.2f %10.2f %8.4f %6s %10.2f\n",
+                    static_cast<double>(frame.frameTimeNanos - start) / 1e6,
+                    frame.shownX,
+                    frame.shownY,
+                    frame.shownDistanceScale,
+                    frame.touching ? "yes" : "no",
+                    frame.visualLagNanos == -1
+                    ? 0.0 : static_cast<double>(frame.visualLagNanos) / 1e6);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    constexpr double kSyntheticSampleHz = 120.0;
+
+    ReplayConfig config;
+    bool printEveryFrame = false;
+    std::string tracePath;
+    std::string writePath;
+    std::vector<TouchEvent> events;
+
+    for (int i = 1; i < argc; ++i) {
+        auto hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--hz") && hasValue) {
+            config.refreshHz = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--latency-frames") && hasValue) {
+            config.presentLatencyFrames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--input-delay-ms") && hasValue) {
+            config.inputDelayNanos = static_cast<int64_t>(std::atof(argv[++i]) * 1e6);
+        } else if (!std::strcmp(argv[i], "--frames")) {
+            printEveryFrame = true;
+        } else if (!std::strcmp(argv[i], "--write-trace") && hasValue) {
+            writePath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--drag") && hasValue) {
+            events = makeDragTrace(
+                    static_cast<float>(std::atof(argv[++i])), 500, kSyntheticSampleHz, 100);
+        } else if (!std::strcmp(argv[i], "--fling") && hasValue) {
+            events = makeDragTrace(
+                    static_cast<float>(std::atof(argv[++i])), 150, kSyntheticSampleHz, 0);
+        } else if (!std::strcmp(argv[i], "--pinch")) {
+            events = makePinchTrace(200.f, 600.f, 400, kSyntheticSampleHz);
+        } else if (argv[i][0] != '-' && tracePath.empty()) {
+            tracePath = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!tracePath.empty()) {
+        std::ifstream in(tracePath);
+        std::string error;
+        if (!in) {
+            std::fprintf(stderr, "Could not open %s\n", tracePath.c_str());
+            return 1;
+        }
+        if (!readTouchTrace(in, events, error)) {
+            std::fprintf(stderr, "%s: %s\n", tracePath.c_str(), error.c_str());
+            return 1;
+        }
+    }
+    if (events.empty() || config.refreshHz <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!writePath.empty()) {
+        std::ofstream out(writePath);
+        writeTouchTrace(out, events);
+    }
+
+    std::printf("%zu touch events at %.0f Hz, present %d frames after vsync, input delay %.1fms\n",
+                events.size(),
+                config.refreshHz,
+                config.presentLatencyFrames,
+                static_cast<double>(config.inputDelayNanos) / 1e6);
+
+    auto withoutPrediction = config;
+    withoutPrediction.prediction = false;
+    auto baseline = replayTouchTrace(events, withoutPrediction);
+    auto predicted = replayTouchTrace(events, config);
+    printResult("no prediction", baseline);
+    printResult("prediction", predicted);
+
+    if (printEveryFrame) {
+        printFrames(predicted);
+    }
+    return 0;
+}
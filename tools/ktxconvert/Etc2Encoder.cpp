@@ -0,0 +1,304 @@
+#include "Etc2Encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace {
+
+//! the intensity modifiers of each codeword table, see the ETC1 spec
+constexpr int kModifierTables[8][2] = {
+        {2, 8},
+        {5, 17},
+        {9, 29},
+        {13, 42},
+        {18, 60},
+        {24, 80},
+        {33, 106},
+        {47, 183}};
+
+//! pixel index values 0-3 select +small, +large, -small, -large
+inline int getModifier(int table, int index) {
+    int magnitude = kModifierTables[table][index & 1];
+    return index & 2 ? -magnitude : magnitude;
+}
+
+inline int clampByte(int value) {
+    return std::clamp(value, 0, 255);
+}
+
+inline int expand4(int value) { return (value << 4) | value; }
+
+inline int expand5(int value) { return (value << 3) | (value >> 2); }
+
+inline int quantize4(int value) { return std::clamp((value * 15 + 127) / 255, 0, 15); }
+
+inline int quantize5(int value) { return std::clamp((value * 31 + 127) / 255, 0, 31); }
+
+/*!
+ * The best table and pixel indices for one half of a block.
+ */
+struct SubblockFit {
+    int table = 0;
+    int indices[8] = {};
+    int64_t error = std::numeric_limits<int64_t>::max();
+};
+
+/*!
+ * One half of a 4x4 block: 8 pixels and where they sit in the block.
+ */
+struct Subblock {
+    int rgb[8][3];
+    int positions[8];
+};
+
+SubblockFit fitSubblock(const Subblock &subblock, const int *base) {
+    SubblockFit best;
+    for (int table = 0; table < 8; ++table) {
+        SubblockFit fit;
+        fit.table = table;
+        fit.error = 0;
+        for (int pixel = 0; pixel < 8; ++pixel) {
+            int64_t bestPixelError = std::numeric_limits<int64_t>::max();
+            for (int index = 0; index < 4; ++index) {
+                int modifier = getModifier(table, index);
+                int64_t error = 0;
+                for (int channel = 0; channel < 3; ++channel) {
+                    int diff = clampByte(base[channel] + modifier) - subblock.rgb[pixel][channel];
+                    error += diff * diff;
+                }
+                if (error < bestPixelError) {
+                    bestPixelError = error;
+                    fit.indices[pixel] = index;
+                }
+            }
+            fit.error += bestPixelError;
+        }
+        if (fit.error < best.error) {
+            best = fit;
+        }
+    }
+    return best;
+}
+
+void averageColor(const Subblock &subblock, int *outRgb) {
+    for (int channel = 0; channel < 3; ++channel) {
+        int sum = 0;
+        for (auto &pixel: subblock.rgb) {
+            sum += pixel[channel];
+        }
+        outRgb[channel] = (sum + 4) / 8;
+    }
+}
+
+void writeBigEndian(uint64_t bits, uint8_t *out) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+}
+
+uint64_t readBigEndian(const uint8_t *in) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits = (bits << 8) | in[i];
+    }
+    return bits;
+}
+
+uint64_t packIndices(const Subblock *subblocks, const SubblockFit *fits) {
+    // Pixel indices are split into an MSB plane (bits 16-31) and an LSB plane (bits 0-15), each
+    // addressed column major
+    uint64_t bits = 0;
+    for (int half = 0; half < 2; ++half) {
+        for (int pixel = 0; pixel < 8; ++pixel) {
+            auto position = subblocks[half].positions[pixel];
+            auto index = static_cast<uint64_t>(fits[half].indices[pixel]);
+            bits |= ((index >> 1) & 1) << (position + 16);
+            bits |= (index & 1) << position;
+        }
+    }
+    return bits;
+}
+
+} // namespace
+
+void Etc2Encoder::encodeBlock(const uint8_t *rgba, uint8_t *outBlock) {
+    int64_t bestError = std::numeric_limits<int64_t>::max();
+    uint64_t bestBits = 0;
+
+    for (int flip = 0; flip < 2; ++flip) {
+        // Without flip the halves are the left and right 2x4 columns, with flip the top and
+        // bottom 4x2 rows
+        Subblock subblocks[2];
+        int counts[2] = {0, 0};
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                int half = flip ? (y >= 2) : (x >= 2);
+                auto &slot = counts[half];
+                for (int channel = 0; channel < 3; ++channel) {
+                    subblocks[half].rgb[slot][channel] = rgba[(y * 4 + x) * 4 + channel];
+                }
+                subblocks[half].positions[slot] = x * 4 + y;
+                slot++;
+            }
+        }
+
+        int averages[2][3];
+        averageColor(subblocks[0], averages[0]);
+        averageColor(subblocks[1], averages[1]);
+
+        // Individual mode: two RGB444 base colours
+        {
+            int quantized[2][3];
+            int expanded[2][3];
+            for (int half = 0; half < 2; ++half) {
+                for (int channel = 0; channel < 3; ++channel) {
+                    quantized[half][channel] = quantize4(averages[half][channel]);
+                    expanded[half][channel] = expand4(quantized[half][channel]);
+                }
+            }
+            SubblockFit fits[2] = {
+                    fitSubblock(subblocks[0], expanded[0]),
+                    fitSubblock(subblocks[1], expanded[1])};
+            auto error = fits[0].error + fits[1].error;
+            if (error < bestError) {
+                uint64_t bits = 0;
+                for (int channel = 0; channel < 3; ++channel) {
+                    bits |= static_cast<uint64_t>(quantized[0][channel]) << (60 - 8 * channel);
+                    bits |= static_cast<uint64_t>(quantized[1][channel]) << (56 - 8 * channel);
+                }
+                bits |= static_cast<uint64_t>(fits[0].table) << 37;
+                bits |= static_cast<uint64_t>(fits[1].table) << 34;
+                bits |= static_cast<uint64_t>(flip) << 32;
+                bits |= packIndices(subblocks, fits);
+                bestError = error;
+                bestBits = bits;
+            }
+        }
+
+        // Differential mode: an RGB555 base colour and a 3 bit signed delta for the second half.
+        // Deltas that don't fit are clamped, which still gives a valid block.
+        {
+            int base[3];
+            int delta[3];
+            int expanded[2][3];
+            for (int channel = 0; channel < 3; ++channel) {
+                base[channel] = quantize5(averages[0][channel]);
+                delta[channel] = std::clamp(quantize5(averages[1][channel]) - base[channel], -4, 3);
+                delta[channel] = std::clamp(base[channel] + delta[channel], 0, 31) - base[channel];
+                expanded[0][channel] = expand5(base[channel]);
+                expanded[1][channel] = expand5(base[channel] + delta[channel]);
+            }
+            SubblockFit fits[2] = {
+                    fitSubblock(subblocks[0], expanded[0]),
+                    fitSubblock(subblocks[1], expanded[1])};
+            auto error = fits[0].error + fits[1].error;
+            if (error < bestError) {
+                uint64_t bits = 0;
+                for (int channel = 0; channel < 3; ++channel) {
+                    bits |= static_cast<uint64_t>(base[channel]) << (59 - 8 * channel);
+                    bits |= static_cast<uint64_t>(delta[channel] & 7) << (56 - 8 * channel);
+                }
+                bits |= static_cast<uint64_t>(fits[0].table) << 37;
+                bits |= static_cast<uint64_t>(fits[1].table) << 34;
+                bits |= uint64_t{1} << 33;
+                bits |= static_cast<uint64_t>(flip) << 32;
+                bits |= packIndices(subblocks, fits);
+                bestError = error;
+                bestBits = bits;
+            }
+        }
+    }
+
+    writeBigEndian(bestBits, outBlock);
+}
+
+void Etc2Encoder::decodeBlock(const uint8_t *block, uint8_t *outRgba) {
+    auto bits = readBigEndian(block);
+    bool differential = (bits >> 33) & 1;
+    bool flip = (bits >> 32) & 1;
+    int tables[2] = {
+            static_cast<int>((bits >> 37) & 7),
+            static_cast<int>((bits >> 34) & 7)};
+
+    int bases[2][3];
+    for (int channel = 0; channel < 3; ++channel) {
+        if (differential) {
+            auto base = static_cast<int>((bits >> (59 - 8 * channel)) & 31);
+            auto delta = static_cast<int>((bits >> (56 - 8 * channel)) & 7);
+            delta = delta >= 4 ? delta - 8 : delta;
+            bases[0][channel] = expand5(base);
+            bases[1][channel] = expand5(base + delta);
+        } else {
+            bases[0][channel] = expand4(static_cast<int>((bits >> (60 - 8 * channel)) & 15));
+            bases[1][channel] = expand4(static_cast<int>((bits >> (56 - 8 * channel)) & 15));
+        }
+    }
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            int half = flip ? (y >= 2) : (x >= 2);
+            int position = x * 4 + y;
+            auto index = static_cast<int>(
+                    (((bits >> (position + 16)) & 1) << 1) | ((bits >> position) & 1));
+            int modifier = getModifier(tables[half], index);
+
+            auto *out = &outRgba[(y * 4 + x) * 4];
+            for (int channel = 0; channel < 3; ++channel) {
+                out[channel] = static_cast<uint8_t>(clampByte(bases[half][channel] + modifier));
+            }
+            out[3] = 255;
+        }
+    }
+}
+
+std::vector<uint8_t> Etc2Encoder::encodeImage(const ImageData &image) {
+    int blocksX = (image.width + 3) / 4;
+    int blocksY = (image.height + 3) / 4;
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * kBlockBytes);
+
+    uint8_t rgba[64];
+    for (int blockY = 0; blockY < blocksY; ++blockY) {
+        for (int blockX = 0; blockX < blocksX; ++blockX) {
+            for (int y = 0; y < 4; ++y) {
+                int sourceY = std::min(blockY * 4 + y, image.height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sourceX = std::min(blockX * 4 + x, image.width - 1);
+                    const auto *pixel = &image.pixels[
+                            (static_cast<size_t>(sourceY) * image.width + sourceX) * 4];
+                    std::copy(pixel, pixel + 4, &rgba[(y * 4 + x) * 4]);
+                }
+            }
+            encodeBlock(rgba, &blocks[(static_cast<size_t>(blockY) * blocksX + blockX) * kBlockBytes]);
+        }
+    }
+    return blocks;
+}
+
+double Etc2Encoder::computePsnr(const ImageData &image, const std::vector<uint8_t> &blocks) {
+    int blocksX = (image.width + 3) / 4;
+    double squaredError = 0.0;
+
+    uint8_t rgba[64];
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            if (x % 4 == 0) {
+                auto blockIndex = static_cast<size_t>(y / 4) * blocksX + x / 4;
+                decodeBlock(&blocks[blockIndex * kBlockBytes], rgba);
+            }
+            const auto *decoded = &rgba[((y % 4) * 4 + x % 4) * 4];
+            const auto *source = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4];
+            for (int channel = 0; channel < 3; ++channel) {
+                double diff = static_cast<double>(decoded[channel]) - source[channel];
+                squaredError += diff * diff;
+            }
+        }
+    }
+
+    auto meanSquaredError = squaredError / (3.0 * image.width * image.height);
+    if (meanSquaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
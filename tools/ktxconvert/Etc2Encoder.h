@@ -0,0 +1,47 @@
+#ifndef EARTHZOO_TOOLS_ETC2ENCODER_H
+#define EARTHZOO_TOOLS_ETC2ENCODER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ImageData.h"
+
+/*!
+ * Encodes RGB images into ETC2 RGB8 blocks. Only the individual and differential modes are used,
+ * which makes the output ETC1 compatible. The T, H and planar modes ETC2 adds would improve a few
+ * blocks but aren't worth the search time for photographic maps.
+ *
+ * Alpha is ignored.
+ */
+class Etc2Encoder {
+public:
+    //! size of one compressed 4x4 block
+    static constexpr int kBlockBytes = 8;
+
+    /*!
+     * Compresses a 4x4 block.
+     * @param rgba 16 RGBA pixels in row major order
+     * @param outBlock receives the 8 byte block
+     */
+    static void encodeBlock(const uint8_t *rgba, uint8_t *outBlock);
+
+    /*!
+     * Decompresses a block written by @a encodeBlock, used to measure the encoding error.
+     * @param block the 8 byte block
+     * @param outRgba receives 16 RGBA pixels in row major order, alpha is 255
+     */
+    static void decodeBlock(const uint8_t *block, uint8_t *outRgba);
+
+    /*!
+     * Compresses a whole image, blocks in row major order. Partial blocks at the right and bottom
+     * edge repeat the last column and row.
+     */
+    static std::vector<uint8_t> encodeImage(const ImageData &image);
+
+    /*!
+     * @return the peak signal to noise ratio of @a blocks against @a image over RGB, in dB
+     */
+    static double computePsnr(const ImageData &image, const std::vector<uint8_t> &blocks);
+};
+
+#endif //EARTHZOO_TOOLS_ETC2ENCODER_H
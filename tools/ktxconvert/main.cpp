@@ -0,0 +1,150 @@
+/*
+ * ktxconvert: turns a PNG into a mipmapped ETC2 RGB8 KTX2 texture for the app.
+ *
+ *   ktxconvert [--srgb] [--no-mips] <input.png> <output.ktx2>
+ *
+ * Name the output "<name>.etc2.ktx2" and put it in app/src/main/assets, TextureAsset picks it up
+ * in place of "<name>.png". ASTC files ("<name>.astc.ktx2") are loaded too, but have to come from
+ * an ASTC encoder such as astcenc.
+ */
+
+#include <png.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Etc2Encoder.h"
+#include "ImageData.h"
+#include "Ktx2.h"
+
+namespace {
+
+bool readPng(const std::string &path, ImageData &outImage) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str())) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    outImage.width = static_cast<int>(png.width);
+    outImage.height = static_cast<int>(png.height);
+    outImage.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, nullptr, outImage.pixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+bool hasTransparency(const ImageData &image) {
+    for (size_t i = 3; i < image.pixels.size(); i += 4) {
+        if (image.pixels[i] != 255) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool writeFile(const std::string &path, const std::vector<uint8_t> &contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(contents.data()),
+               static_cast<std::streamsize>(contents.size()));
+    return static_cast<bool>(file);
+}
+
+int usage() {
+    std::cerr << "usage: ktxconvert [--srgb] [--no-mips] <input.png> <output.ktx2>" << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool srgb = false;
+    bool mips = true;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--srgb") {
+            srgb = true;
+        } else if (argument == "--no-mips") {
+            mips = false;
+        } else if (argument.rfind("--", 0) == 0) {
+            return usage();
+        } else {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.size() != 2) {
+        return usage();
+    }
+
+    ImageData image;
+    if (!readPng(paths[0], image)) {
+        return 1;
+    }
+    if (hasTransparency(image)) {
+        std::cerr << "warning: " << paths[0] << " has transparency, ETC2 RGB8 drops alpha"
+                  << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<ImageData> levels;
+    if (mips) {
+        levels = image.buildMipChain();
+    } else {
+        levels.push_back(std::move(image));
+    }
+
+    std::vector<std::vector<uint8_t>> compressed;
+    size_t compressedBytes = 0;
+    size_t uncompressedBytes = 0;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        auto &source = levels[level];
+        compressed.push_back(Etc2Encoder::encodeImage(source));
+        compressedBytes += compressed.back().size();
+        uncompressedBytes += source.pixels.size();
+
+        if (level == 0) {
+            printf("level 0: %dx%d, PSNR %.2f dB\n",
+                   source.width,
+                   source.height,
+                   Etc2Encoder::computePsnr(source, compressed.back()));
+        }
+    }
+
+    auto format = srgb ? Ktx2Format::Etc2Rgb8Srgb : Ktx2Format::Etc2Rgb8Unorm;
+    auto file = Ktx2::write(format, levels[0].width, levels[0].height, compressed);
+    if (!writeFile(paths[1], file)) {
+        std::cerr << "could not write " << paths[1] << std::endl;
+        return 1;
+    }
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu levels, %zu KiB as RGBA8, %zu KiB as ETC2 (%.1fx smaller), %.2fs\n",
+           levels.size(),
+           uncompressedBytes / 1024,
+           compressedBytes / 1024,
+           static_cast<double>(uncompressedBytes) / static_cast<double>(compressedBytes),
+           seconds);
+
+    // Read the file back so a broken writer never ships an asset the app rejects
+    Ktx2Image parsed;
+    if (!Ktx2::parse(file.data(), file.size(), parsed) || parsed.levels.size() != levels.size()) {
+        std::cerr << "internal error: " << paths[1] << " does not parse" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * meshreport: reports the post-transform vertex cache efficiency of a mesh before and after
+ * MeshOptimizer, the same passes the app runs on its meshes.
+ *
+ *   meshreport [--cache-size N] --sphere <latSegments>x<lonSegments>
+ *   meshreport [--cache-size N] <mesh.obj>
+ *
+ * --sphere generates the globe's UV sphere the way Renderer::createModels does. OBJ files only
+ * contribute their positions and faces, polygons are split into fans.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+namespace {
+
+struct Mesh {
+    size_t vertexCount = 0;
+    std::vector<uint32_t> indices;
+};
+
+/*!
+ * The index buffer of a (latSegments + 1) x (lonSegments + 1) vertex grid in row-major order, the
+ * order the app generated before it optimized its meshes.
+ */
+Mesh makeSphere(int latSegments, int lonSegments) {
+    Mesh mesh;
+    int rowStride = lonSegments + 1;
+    mesh.vertexCount = static_cast<size_t>(latSegments + 1) * rowStride;
+    mesh.indices.reserve(static_cast<size_t>(latSegments) * lonSegments * 6);
+    for (int lat = 0; lat < latSegments; ++lat) {
+        for (int lon = 0; lon < lonSegments; ++lon) {
+            auto topLeft = static_cast<uint32_t>(lat * rowStride + lon);
+            auto topRight = topLeft + 1;
+            auto bottomLeft = static_cast<uint32_t>((lat + 1) * rowStride + lon);
+            auto bottomRight = bottomLeft + 1;
+            mesh.indices.insert(mesh.indices.end(), {topLeft, bottomLeft, topRight});
+            mesh.indices.insert(mesh.indices.end(), {topRight, bottomLeft, bottomRight});
+        }
+    }
+    return mesh;
+}
+
+bool readObj(const std::string &path, Mesh &outMesh) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << path << ": cannot open" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+        if (keyword == "v") {
+            outMesh.vertexCount++;
+        } else if (keyword == "f") {
+            // Each corner is v, v/vt, v//vn or v/vt/vn, only v matters. Negative indices count
+            // back from the last vertex read so far.
+            std::vector<uint32_t> polygon;
+            std::string corner;
+            while (stream >> corner) {
+                long index = std::strtol(corner.c_str(), nullptr, 10);
+                if (index < 0) {
+                    index += static_cast<long>(outMesh.vertexCount) + 1;
+                }
+                if (index < 1 || index > static_cast<long>(outMesh.vertexCount)) {
+                    std::cerr << path << ": bad face index in \"" << line << "\"" << std::endl;
+                    return false;
+                }
+                polygon.push_back(static_cast<uint32_t>(index - 1));
+            }
+            for (size_t i = 2; i < polygon.size(); ++i) {
+                outMesh.indices.insert(
+                        outMesh.indices.end(),
+                        {polygon[0], polygon[i - 1], polygon[i]});
+            }
+        }
+    }
+    return true;
+}
+
+void printStats(const char *label, const VertexCacheStats &stats) {
+    std::printf("%-10s ACMR %.3f  ATVR %.3f  shaded vertices %zu\n",
+                label, stats.acmr, stats.atvr, stats.shadedVertices);
+}
+
+int usage() {
+    std::cerr << "usage: meshreport [--cache-size N] (--sphere LATxLON | mesh.obj)" << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int cacheSize = MeshOptimizer::kDefaultCacheSize;
+    std::string sphere;
+    std::string input;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache-size" && i + 1 < argc) {
+            cacheSize = std::atoi(argv[++i]);
+        } else if (arg == "--sphere" && i + 1 < argc) {
+            sphere = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-' && input.empty()) {
+            input = arg;
+        } else {
+            return usage();
+        }
+    }
+    if (cacheSize < 3 || sphere.empty() == input.empty()) {
+        return usage();
+    }
+
+    Mesh mesh;
+    if (!sphere.empty()) {
+        int latSegments = 0;
+        int lonSegments = 0;
+        if (std::sscanf(sphere.c_str(), "%dx%d", &latSegments, &lonSegments) != 2
+            || latSegments < 1 || lonSegments < 3) {
+            return usage();
+        }
+        mesh = makeSphere(latSegments, lonSegments);
+    } else if (!readObj(input, mesh)) {
+        return 1;
+    }
+
+    std::printf("%zu vertices, %zu triangles, %s indices, FIFO cache of %d\n",
+                mesh.vertexCount, mesh.indices.size() / 3,
+                mesh.vertexCount > 0xffff ? "32-bit" : "16-bit", cacheSize);
+    printStats("original", MeshOptimizer::analyze(mesh.indices, mesh.vertexCount, cacheSize));
+
+    auto start = std::chrono::steady_clock::now();
+    MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertexCount, cacheSize);
+    MeshOptimizer::optimizeVertexFetch(mesh.indices, mesh.vertexCount);
+    auto millis = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    printStats("optimized", MeshOptimizer::analyze(mesh.indices, mesh.vertexCount, cacheSize));
+
+    // The optimized order is tuned for one cache size but shouldn't fall apart on others
+    for (int size : {8, 24, 32}) {
+        if (size != cacheSize) {
+            char label[16];
+            std::snprintf(label, sizeof(label), "  @%d", size);
+            printStats(label, MeshOptimizer::analyze(mesh.indices, mesh.vertexCount, size));
+        }
+    }
+    std::printf("optimized in %.2f ms\n", millis);
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "SyntheticPoints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+//! sites the clustered points gather around
+constexpr int kSiteCount = 2000;
+
+//! the share of points spread over the whole sphere
+constexpr float kUniformShare = 0.3f;
+
+float uniformLatitude(std::mt19937 &random) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    return std::asin(unit(random)) * 180.f / kPi;
+}
+
+} // namespace
+
+std::vector<GeoPoint> generateSyntheticPoints(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::uniform_real_distribution<float> longitude(-180.f, 180.f);
+    std::normal_distribution<float> normal(0.f, 1.f);
+
+    // Spreads from a few hundred metres to a few hundred kilometres
+    struct Site {
+        float latitude;
+        float longitude;
+        float spread;
+    };
+    std::vector<Site> sites(kSiteCount);
+    for (auto &site: sites) {
+        site.latitude = uniformLatitude(random);
+        site.longitude = longitude(random);
+        site.spread = 0.005f * std::pow(600.f, unit(random));
+    }
+    std::uniform_int_distribution<int> pickSite(0, kSiteCount - 1);
+
+    std::vector<GeoPoint> points(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto &point = points[i];
+        point.id = static_cast<uint32_t>(i);
+        if (unit(random) < kUniformShare) {
+            point.latitude = uniformLatitude(random);
+            point.longitude = longitude(random);
+            continue;
+        }
+
+        const auto &site = sites[pickSite(random)];
+        point.latitude = std::clamp(site.latitude + normal(random) * site.spread, -90.f, 90.f);
+        auto stretch = 1.f / std::max(std::cos(point.latitude * kPi / 180.f), 0.01f);
+        auto lon = site.longitude + normal(random) * site.spread * stretch;
+        point.longitude = lon - 360.f * std::floor((lon + 180.f) / 360.f);
+    }
+    return points;
+}
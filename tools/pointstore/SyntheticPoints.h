@@ -0,0 +1,18 @@
+#ifndef EARTHZOO_TOOLS_SYNTHETICPOINTS_H
+#define EARTHZOO_TOOLS_SYNTHETICPOINTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PointStore.h"
+
+/*!
+ * Generates observation-like points: most of them in clusters of very different spread around
+ * random sites, like sightings around reserves and cities, the rest spread evenly over the
+ * sphere. Ids are the points' indices. The same seed gives the same points on every platform the
+ * standard distributions agree on.
+ */
+std::vector<GeoPoint> generateSyntheticPoints(size_t count, uint32_t seed);
+
+#endif //EARTHZOO_TOOLS_SYNTHETICPOINTS_H
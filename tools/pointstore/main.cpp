@@ -0,0 +1,218 @@
+/*
+ * pointstore: builds and inspects the observation point files PointStore reads.
+ *
+ *   pointstore build [--block-size N] [--fanout N] [--max-shift N]
+ *                    (<input.csv> | --synthetic COUNT [--seed N]) <output.ezpts>
+ *   pointstore info <store.ezpts>
+ *   pointstore cap <store.ezpts> LAT LON RADIUS
+ *   pointstore rect <store.ezpts> SOUTH WEST NORTH EAST
+ *
+ * Input files have a "latitude,longitude[,id]" line per point in degrees, lines that don't start
+ * with a number are skipped. Points without an id get their index among the points. Copy the
+ * output to app/src/main/assets, the build keeps .ezpts assets uncompressed so they can be mapped.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "PointStore.h"
+#include "SyntheticPoints.h"
+
+namespace {
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s build [--block-size N] [--fanout N] [--max-shift N]\n"
+                 "                (<input.csv> | --synthetic COUNT [--seed N]) <output.ezpts>\n"
+                 "       %s info <store.ezpts>\n"
+                 "       %s cap <store.ezpts> LAT LON RADIUS\n"
+                 "       %s rect <store.ezpts> SOUTH WEST NORTH EAST\n",
+                 program, program, program, program);
+}
+
+bool readCsv(const std::string &path, std::vector<GeoPoint> &outPoints) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << path << ": can't open" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(input, line)) {
+        auto first = line.find_first_not_of(" \t");
+        if (first == std::string::npos
+            || !(std::isdigit(static_cast<unsigned char>(line[first]))
+                 || line[first] == '-' || line[first] == '+' || line[first] == '.')) {
+            continue;
+        }
+
+        GeoPoint point;
+        point.id = static_cast<uint32_t>(outPoints.size());
+        char *end = nullptr;
+        point.latitude = std::strtof(line.c_str() + first, &end);
+        if (*end != ',') {
+            std::cerr << path << ": malformed line \"" << line << "\"" << std::endl;
+            return false;
+        }
+        point.longitude = std::strtof(end + 1, &end);
+        if (*end == ',') {
+            point.id = static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 10));
+        }
+        outPoints.push_back(point);
+    }
+    return true;
+}
+
+bool writeFile(const std::string &path, const std::vector<uint8_t> &contents) {
+    std::ofstream output(path, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(contents.data()),
+                 static_cast<std::streamsize>(contents.size()));
+    if (!output) {
+        std::cerr << path << ": can't write" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int build(int argc, char **argv) {
+    PointStoreOptions options;
+    size_t syntheticCount = 0;
+    uint32_t seed = 1;
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--block-size" && hasValue) {
+            options.blockCapacity = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--fanout" && hasValue) {
+            options.fanout = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-shift" && hasValue) {
+            options.maxShift = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--synthetic" && hasValue) {
+            syntheticCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && hasValue) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != (syntheticCount > 0 ? 1u : 2u)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<GeoPoint> points;
+    if (syntheticCount > 0) {
+        points = generateSyntheticPoints(syntheticCount, seed);
+    } else if (!readCsv(paths[0], points)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto contents = PointStore::build(points, options);
+    auto milliseconds = elapsedMilliseconds(start);
+    if (!writeFile(paths.back(), contents)) {
+        return 1;
+    }
+    auto perPoint = static_cast<double>(contents.size())
+                    / static_cast<double>(std::max<size_t>(points.size(), 1));
+    std::printf("%s: %zu points in %zu bytes (%.2f per point), built in %.0f ms\n",
+                paths.back().c_str(), points.size(), contents.size(), perPoint, milliseconds);
+    return 0;
+}
+
+/*!
+ * Maps and attaches the store at @a path, printing why it can't.
+ */
+std::unique_ptr<MappedFile> openStore(const std::string &path, PointStore &store) {
+    auto file = MappedFile::open(path);
+    if (!file) {
+        std::cerr << path << ": can't open" << std::endl;
+        return nullptr;
+    }
+    if (!store.attach(file->getData(), file->getSize())) {
+        std::cerr << path << ": not a valid point store" << std::endl;
+        return nullptr;
+    }
+    return file;
+}
+
+int info(const std::string &path) {
+    PointStore store;
+    auto file = openStore(path, store);
+    if (!file) {
+        return 1;
+    }
+    std::printf("%zu points in %zu blocks, %zu levels, %zu bytes\n",
+                store.getPointCount(), store.getBlockCount(), store.getLevelCount(),
+                file->getSize());
+    return 0;
+}
+
+int query(const std::string &path, bool isCap, const std::vector<float> &values) {
+    PointStore store;
+    auto file = openStore(path, store);
+    if (!file) {
+        return 1;
+    }
+
+    std::vector<GeoPoint> points;
+    PointQueryStats stats;
+    auto start = std::chrono::steady_clock::now();
+    if (isCap) {
+        store.queryCap(values[0], values[1], values[2], points, &stats);
+    } else {
+        store.queryRect({values[0], values[1], values[2], values[3]}, points, &stats);
+    }
+    auto milliseconds = elapsedMilliseconds(start);
+
+    for (const auto &point: points) {
+        std::printf("%.6f,%.6f,%u\n", point.latitude, point.longitude, point.id);
+    }
+    std::fprintf(stderr, "%zu points, %zu nodes visited, %zu of %zu blocks decoded, %.3f ms\n",
+                 points.size(), stats.nodesVisited, stats.blocksDecoded, store.getBlockCount(),
+                 milliseconds);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "build") {
+        return build(argc, argv);
+    }
+    if (command == "info" && argc == 3) {
+        return info(argv[2]);
+    }
+
+    auto valueCount = command == "cap" ? 3 : 4;
+    if ((command == "cap" || command == "rect") && argc == 3 + valueCount) {
+        std::vector<float> values;
+        for (int i = 0; i < valueCount; ++i) {
+            values.push_back(std::strtof(argv[3 + i], nullptr));
+        }
+        return query(argv[2], command == "cap", values);
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
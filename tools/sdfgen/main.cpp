@@ -0,0 +1,166 @@
+/*
+ * sdfgen: turns a boundary or coastline mask into the signed distance field the globe shader
+ * draws outlines from.
+ *
+ *   sdfgen [--lines] [--no-wrap] [--scale N] [--channel r|a] [--threshold N]
+ *          <mask.png> <field.png>
+ *
+ * Pixels whose channel (alpha by default) is at least the threshold (128) are inside. With --lines
+ * the mask is drawn lines, like boundaries, and the field's contour is moved onto their centre;
+ * without it the contour is the edge of the shapes, like a coastline. Masks are maps of the whole
+ * globe, so distances wrap around the left and right edges, the antimeridian, unless --no-wrap is
+ * given; keep the width a multiple of the scale for a seamless field. The field is written as an
+ * 8-bit grey PNG at 1/scale (default 4) of the mask's size, see DistanceField. Copy it to
+ * app/src/main/assets.
+ */
+
+#include <png.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DistanceField.h"
+
+namespace {
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [--lines] [--no-wrap] [--scale N] [--channel r|a] [--threshold N]"
+                 " <mask.png> <field.png>\n",
+                 program);
+}
+
+bool readPng(const std::string &path, std::vector<uint8_t> &outPixels, int &outWidth,
+             int &outHeight) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str())) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    outWidth = static_cast<int>(png.width);
+    outHeight = static_cast<int>(png.height);
+    outPixels.resize(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, nullptr, outPixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+bool writeGreyPng(const std::string &path, const std::vector<uint8_t> &pixels, int width,
+                  int height) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = static_cast<png_uint_32>(width);
+    png.height = static_cast<png_uint_32>(height);
+    png.format = PNG_FORMAT_GRAY;
+
+    if (!png_image_write_to_file(&png, path.c_str(), 0, pixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+    return true;
+}
+
+long getFileSize(const std::string &path) {
+    auto *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return -1;
+    }
+    std::fseek(file, 0, SEEK_END);
+    auto size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bool lines = false;
+    bool wrap = true;
+    int scale = 4;
+    int channel = 3;
+    int threshold = 128;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lines") {
+            lines = true;
+        } else if (arg == "--no-wrap") {
+            wrap = false;
+        } else if (arg == "--scale" && hasValue) {
+            scale = std::atoi(argv[++i]);
+        } else if (arg == "--channel" && hasValue) {
+            std::string value = argv[++i];
+            if (value != "r" && value != "a") {
+                printUsage(argv[0]);
+                return 1;
+            }
+            channel = value == "r" ? 0 : 3;
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = std::atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2 || scale < 1 || threshold < 1 || threshold > 255) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> pixels;
+    int width;
+    int height;
+    if (!readPng(paths[0], pixels, width, height)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> inside(static_cast<size_t>(width) * height);
+    size_t insideCount = 0;
+    for (size_t i = 0; i < inside.size(); ++i) {
+        inside[i] = pixels[i * 4 + channel] >= threshold ? 1 : 0;
+        insideCount += inside[i];
+    }
+    if (insideCount == 0) {
+        std::cerr << paths[0] << ": no pixel reaches the threshold" << std::endl;
+        return 1;
+    }
+
+    auto distances = DistanceField::computeSignedDistances(inside, width, height, wrap);
+    auto offset = lines ? DistanceField::estimateHalfStrokeWidth(distances) : 0.f;
+    int fieldWidth;
+    int fieldHeight;
+    auto field = DistanceField::encode(distances, width, height, scale, offset, fieldWidth,
+                                       fieldHeight, wrap);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!writeGreyPng(paths[1], field, fieldWidth, fieldHeight)) {
+        return 1;
+    }
+    std::printf("%s: %dx%d field of a %dx%d mask in %.0f ms", paths[1].c_str(), fieldWidth,
+                fieldHeight, width, height, elapsed.count());
+    if (lines) {
+        std::printf(", strokes %.1f pixels wide", 2.f * offset);
+    }
+    // The app decodes every PNG to RGBA
+    std::printf("\n%ld bytes, the mask takes %ld; %zu bytes as a texture, the mask %zu\n",
+                getFileSize(paths[1]), getFileSize(paths[0]), field.size() * 4, pixels.size());
+    return 0;
+}
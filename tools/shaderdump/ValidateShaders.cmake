@@ -0,0 +1,28 @@
+# Writes out the app's shaders with shaderdump and compiles every stage with glslangValidator.
+#
+#   cmake -DSHADERDUMP=... -DGLSLANG_VALIDATOR=... -DOUTPUT_DIR=... -P ValidateShaders.cmake
+
+file(REMOVE_RECURSE ${OUTPUT_DIR})
+execute_process(COMMAND ${SHADERDUMP} ${OUTPUT_DIR} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "shaderdump failed")
+endif()
+
+file(GLOB stages ${OUTPUT_DIR}/*.vert ${OUTPUT_DIR}/*.frag)
+set(failed "")
+foreach(stage IN LISTS stages)
+    execute_process(COMMAND ${GLSLANG_VALIDATOR} ${stage}
+            RESULT_VARIABLE result
+            OUTPUT_VARIABLE output
+            ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message("${output}")
+        list(APPEND failed ${stage})
+    endif()
+endforeach()
+if(failed)
+    list(JOIN failed "\n  " failedList)
+    message(FATAL_ERROR "Shaders that don't compile:\n  ${failedList}")
+endif()
+list(LENGTH stages count)
+message("${count} shader stages compiled")
@@ -0,0 +1,70 @@
+// Writes out every variant of the shaders the app assembles at run time, the globe's for each way
+// it's drawn and vertex layout and the marker layer's, one file per stage. glslangValidator tells
+// the stage from the extension:
+//
+//   shaderdump <directory>
+//   glslangValidator <directory>/globe_chunked.frag
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "ShaderSources.h"
+
+namespace {
+
+bool writeFile(const std::string &path, const std::string &contents) {
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    if (!file) {
+        std::cerr << path << ": can't be written" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool writeProgram(const std::string &directory, const std::string &name,
+                  const ShaderSources &sources) {
+    auto base = directory + "/" + name;
+    return writeFile(base + ".vert", sources.vertex) && writeFile(base + ".frag", sources.fragment);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+        return 1;
+    }
+    std::string directory = argv[1];
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // The UV sphere's defines come from VertexLayout::getShaderDefines, all it can return
+    struct Variant {
+        const char *name;
+        GlobeMode mode;
+        const char *vertexDefines;
+    };
+    const Variant variants[] = {
+            {"globe_uvsphere", GlobeMode::UvSphere, ""},
+            {"globe_uvsphere_normals", GlobeMode::UvSphere, "#define VERTEX_NORMALS\n"},
+            {"globe_uvsphere_procedural", GlobeMode::UvSphere, "#define PROCEDURAL_SPHERE\n"},
+            {"globe_chunked", GlobeMode::Chunked, ""},
+            {"globe_impostor", GlobeMode::Impostor, ""},
+    };
+    for (const auto &variant: variants) {
+        if (!writeProgram(directory, variant.name,
+                          assembleGlobeShader(variant.mode, variant.vertexDefines))) {
+            return 1;
+        }
+    }
+    if (!writeProgram(directory, "marker", assembleMarkerShader())) {
+        return 1;
+    }
+    std::printf("%zu programs written to %s\n", std::size(variants) + 1, directory.c_str());
+    return 0;
+}
@@ -0,0 +1,317 @@
+// Tests of the cluster hierarchy: the cell keys, that every level accounts for every point, that
+// lookups and point ranges agree with the tree's layout, the zoom dependent selection, building
+// from a point store, and the background builder.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "ClusterBuilder.h"
+#include "ClusterTree.h"
+#include "GeoCoordinates.h"
+#include "PointStore.h"
+#include "SyntheticPoints.h"
+#include "TestHarness.h"
+
+namespace {
+
+//! a camera on the z axis of the globe's model space, looking at its centre
+TileView makeView(float distance) {
+    TileView view;
+    view.cameraPosition[0] = 0.f;
+    view.cameraPosition[1] = 0.f;
+    view.cameraPosition[2] = distance;
+    view.projectionScale = 1000.f;
+    view.halfDiagonalFov = 0.6f;
+    return view;
+}
+
+ClusterTreeOptions makeOptions(int maxLevel) {
+    ClusterTreeOptions options;
+    options.maxLevel = maxLevel;
+    return options;
+}
+
+} // namespace
+
+TEST(cellKeysNestAcrossLevels) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    for (int i = 0; i < 2000; ++i) {
+        auto direction = normalize(Vec3{unit(random), unit(random), unit(random)});
+        auto finest = ClusterTree::getCellKey(direction, ClusterTree::kMaxLevel);
+        for (int level = 0; level < ClusterTree::kMaxLevel; level += 3) {
+            auto cell = ClusterTree::getCellKey(direction, level);
+            CHECK(cell == finest >> (2 * (ClusterTree::kMaxLevel - level)));
+
+            // The cell's centre is within its radius of every point in it. Finer cells are
+            // smaller than a float direction can resolve.
+            if (level <= 20) {
+                auto center = ClusterTree::getCellCenter(level, cell);
+                auto radius = ClusterTree::getCellRadius(level, cell);
+                CHECK(std::acos(std::clamp(dot(center, direction), -1.f, 1.f)) <= radius + 1e-3f);
+                CHECK(ClusterTree::getCellKey(center, level) == cell);
+            }
+        }
+        CHECK(ClusterTree::getCellKey(direction, 0) < 6);
+    }
+}
+
+TEST(everyLevelCountsEveryPoint) {
+    auto points = generateSyntheticPoints(50000, 1);
+    auto tree = ClusterTree::build(points, makeOptions(12));
+    CHECK(tree.getLevelCount() == 13);
+    CHECK(tree.getPointCount() == points.size());
+    for (int level = 0; level < tree.getLevelCount(); ++level) {
+        size_t total = 0;
+        uint64_t previous = 0;
+        for (const auto &cluster: tree.getLevel(level)) {
+            CHECK(cluster.count > 0);
+            CHECK(total == 0 || cluster.cell > previous);
+            total += cluster.count;
+            previous = cluster.cell;
+        }
+        CHECK(total == points.size());
+    }
+    CHECK(tree.getLevel(0).size() == 6);
+
+    std::set<uint32_t> ids;
+    for (size_t i = 0; i < tree.getPointCount(); ++i) {
+        ids.insert(tree.getPoint(i).id);
+    }
+    CHECK(ids.size() == points.size());
+}
+
+TEST(childrenAndPointsMatchTheirCluster) {
+    auto points = generateSyntheticPoints(20000, 2);
+    auto tree = ClusterTree::build(points, makeOptions(10));
+    for (int level = 0; level < tree.getLevelCount(); ++level) {
+        for (uint32_t index = 0; index < tree.getLevel(level).size(); ++index) {
+            ClusterRef ref{level, index};
+            const auto &cluster = tree.get(ref);
+
+            size_t first;
+            auto count = tree.getPointRange(ref, first);
+            CHECK(count == cluster.count);
+            for (auto i = first; i < first + count; i += 97) {
+                auto point = tree.getPoint(i);
+                auto direction = directionFromLatLon(point.latitude, point.longitude);
+                CHECK(ClusterTree::getCellKey(direction, level) == cluster.cell);
+            }
+
+            std::vector<ClusterRef> children;
+            tree.getChildren(ref, children);
+            uint32_t childCount = 0;
+            for (const auto &child: children) {
+                CHECK(tree.get(child).cell >> 2 == cluster.cell);
+                childCount += tree.get(child).count;
+            }
+            auto isFinest = level + 1 == tree.getLevelCount();
+            CHECK(isFinest ? children.empty() : childCount == cluster.count);
+        }
+    }
+}
+
+TEST(centroidIsTheMeanDirection) {
+    std::vector<GeoPoint> points = {{10.f, 20.f, 0}, {10.5f, 20.5f, 1}, {10.2f, 19.9f, 2}};
+    auto tree = ClusterTree::build(points, makeOptions(4));
+    ClusterRef ref;
+    CHECK(tree.findCluster(3, 10.f, 20.f, ref));
+    CHECK(tree.get(ref).count == 3);
+
+    Vec3 sum{0.f, 0.f, 0.f};
+    for (const auto &point: points) {
+        sum = sum + directionFromLatLon(point.latitude, point.longitude);
+    }
+    auto expected = normalize(sum);
+    auto centroid = ClusterTree::getCentroid(tree.get(ref));
+    CHECK(dot(expected, centroid) > 1.f - 1e-6f);
+}
+
+TEST(findClusterMatchesAScan) {
+    auto points = generateSyntheticPoints(20000, 3);
+    auto tree = ClusterTree::build(points, makeOptions(14));
+    std::mt19937 random(4);
+    std::uniform_int_distribution<size_t> pick(0, points.size() - 1);
+    for (int i = 0; i < 500; ++i) {
+        const auto &point = points[pick(random)];
+        auto direction = directionFromLatLon(point.latitude, point.longitude);
+        for (int level = 0; level < tree.getLevelCount(); level += 2) {
+            ClusterRef found;
+            CHECK(tree.findCluster(level, point.latitude, point.longitude, found));
+            const auto &clusters = tree.getLevel(level);
+            auto cell = ClusterTree::getCellKey(direction, level);
+            auto scanned = std::find_if(
+                    clusters.begin(), clusters.end(),
+                    [cell](const PointCluster &cluster) { return cluster.cell == cell; });
+            CHECK(scanned != clusters.end() && found.index == scanned - clusters.begin());
+        }
+    }
+
+    // A tap next to the only point, but in a neighbouring cell, finds nothing
+    auto single = ClusterTree::build({{0.f, 45.5f, 0}}, makeOptions(6));
+    ClusterRef found;
+    CHECK(single.findCluster(6, 0.f, 45.5f, found));
+    CHECK(!single.findCluster(6, 40.f, -100.f, found));
+    CHECK(!single.findCluster(7, 0.f, 45.5f, found));
+}
+
+TEST(expansionLevelSkipsSingleChildChains) {
+    // Two points a few hundred metres apart only split up on a fine level
+    std::vector<GeoPoint> points = {{30.f, 30.f, 0}, {30.f, 30.004f, 1}};
+    auto tree = ClusterTree::build(points, makeOptions(16));
+    ClusterRef top{0, 0};
+    auto level = tree.getExpansionLevel(top);
+    CHECK(level > 8 && level <= 16);
+    ClusterRef before;
+    CHECK(tree.findCluster(level - 1, 30.f, 30.f, before));
+    CHECK(tree.get(before).count == 2);
+    std::vector<ClusterRef> children;
+    tree.getChildren(before, children);
+    CHECK(children.size() == 2);
+
+    auto same = ClusterTree::build({{1.f, 1.f, 0}, {1.f, 1.f, 1}}, makeOptions(5));
+    CHECK(same.getExpansionLevel({0, 0}) == 5);
+}
+
+TEST(closerCamerasSelectFinerLevels) {
+    auto tree = ClusterTree::build(generateSyntheticPoints(10000, 5), makeOptions(16));
+    auto previous = -1;
+    for (float distance: {8.f, 3.f, 1.5f, 1.1f, 1.01f, 1.001f}) {
+        auto level = tree.selectLevel(makeView(distance), 48.f);
+        CHECK(level >= previous);
+        previous = level;
+    }
+    CHECK(previous > tree.selectLevel(makeView(3.f), 48.f));
+    CHECK(tree.selectLevel(makeView(1.0000001f), 1.f) == 16);
+    CHECK(tree.selectLevel(makeView(1000.f), 48.f) == 0);
+}
+
+TEST(selectionOnlyReturnsVisibleClusters) {
+    auto points = generateSyntheticPoints(100000, 6);
+    auto tree = ClusterTree::build(points, makeOptions(12));
+    for (float distance: {3.f, 1.3f}) {
+        auto view = makeView(distance);
+        std::vector<ClusterRef> selected;
+        tree.selectClusters(view, 48.f, selected);
+        CHECK(!selected.empty());
+
+        auto level = tree.selectLevel(view, 48.f);
+        Vec3 camera{0.f, 0.f, distance};
+        auto horizon = std::acos(1.f / distance);
+        std::set<uint32_t> indices;
+        for (const auto &ref: selected) {
+            CHECK(ref.level == level);
+            indices.insert(ref.index);
+            auto center = ClusterTree::getCellCenter(level, tree.get(ref).cell);
+            auto radius = ClusterTree::getCellRadius(level, tree.get(ref).cell);
+            CHECK(std::acos(std::clamp(center.z, -1.f, 1.f)) <= horizon + radius + 1e-4f);
+        }
+        CHECK(indices.size() == selected.size());
+
+        // Every cluster facing the camera near the centre of the view is in
+        for (uint32_t index = 0; index < tree.getLevel(level).size(); ++index) {
+            auto centroid = ClusterTree::getCentroid(tree.getLevel(level)[index]);
+            if (dot(normalize(camera - centroid), normalize(camera)) > std::cos(0.2f)
+                && centroid.z > 0.5f) {
+                CHECK(indices.count(index) == 1);
+            }
+        }
+    }
+}
+
+TEST(emptyTree) {
+    auto tree = ClusterTree::build(std::vector<GeoPoint>());
+    CHECK(tree.getLevelCount() == 0);
+    CHECK(tree.getPointCount() == 0);
+    std::vector<ClusterRef> selected;
+    tree.selectClusters(makeView(3.f), 48.f, selected);
+    CHECK(selected.empty());
+    ClusterRef found;
+    CHECK(!tree.findCluster(0, 0.f, 0.f, found));
+}
+
+TEST(storeAndBatchesClusterLikeTheirPoints) {
+    // Built from the mapped store and a batch, the tree matches one built from the same points
+    auto file = PointStore::build(generateSyntheticPoints(30000, 11));
+    PointStore store;
+    CHECK(store.attach(file.data(), file.size()));
+    auto batch = generateSyntheticPoints(500, 12);
+
+    std::vector<GeoPoint> points;
+    store.queryRect(GeoRect(), points);
+    points.insert(points.end(), batch.begin(), batch.end());
+    auto expected = ClusterTree::build(points, makeOptions(12));
+
+    ClusterPoints source(&store);
+    source.add(batch);
+    CHECK(source.getCount() == points.size());
+    for (size_t i = 0; i < points.size(); i += 101) {
+        CHECK(source.get(i).id == points[i].id);
+        CHECK(source.get(i).latitude == points[i].latitude);
+    }
+    auto tree = ClusterTree::build(source, makeOptions(12));
+    CHECK(tree.getLevelCount() == expected.getLevelCount());
+    for (int level = 0; level < tree.getLevelCount(); ++level) {
+        const auto &clusters = tree.getLevel(level);
+        const auto &expectedClusters = expected.getLevel(level);
+        CHECK(clusters.size() == expectedClusters.size());
+        for (size_t i = 0; i < std::min(clusters.size(), expectedClusters.size()); ++i) {
+            CHECK(clusters[i].cell == expectedClusters[i].cell);
+            CHECK(clusters[i].count == expectedClusters[i].count);
+        }
+    }
+    CHECK(tree.getPointCount() == expected.getPointCount());
+    for (size_t i = 0; i < tree.getPointCount(); i += 37) {
+        CHECK(tree.getPoint(i).id == expected.getPoint(i).id);
+    }
+}
+
+TEST(builderSwapsInNewTrees) {
+    // Outlives the builder and its trees
+    auto file = PointStore::build(generateSyntheticPoints(5000, 20));
+    PointStore store;
+    CHECK(store.attach(file.data(), file.size()));
+
+    int notifications = 0;
+    std::mutex mutex;
+    ClusterBuilder builder(makeOptions(10), [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++notifications;
+    });
+    CHECK(builder.getTree() == nullptr);
+
+    builder.setPoints(generateSyntheticPoints(20000, 7));
+    builder.waitUntilBuilt();
+    auto first = builder.getTree();
+    CHECK(first != nullptr && first->getPointCount() == 20000);
+    auto generation = builder.getGeneration();
+    CHECK(generation >= 1);
+
+    // A burst of changes ends up in one tree, the one held before stays as it was
+    for (int i = 0; i < 10; ++i) {
+        builder.addPoints(generateSyntheticPoints(1000, 8 + i));
+    }
+    builder.waitUntilBuilt();
+    auto second = builder.getTree();
+    CHECK(second->getPointCount() == 30000);
+    CHECK(first->getPointCount() == 20000);
+    CHECK(builder.getGeneration() > generation);
+    CHECK(builder.getGeneration() <= generation + 10);
+
+    // The store replaces every point, the trees built before keep theirs
+    builder.setStore(&store);
+    builder.waitUntilBuilt();
+    CHECK(builder.getTree()->getPointCount() == 5000);
+    CHECK(second->getPointCount() == 30000);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(notifications >= 1);
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,220 @@
+// Tests of the distance fields: the transform against brute force, the sign and the contour of
+// the signed field, what the shader reads back from encoded fields of shapes and lines, and fields
+// that wrap around the antimeridian.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "DistanceField.h"
+#include "TestHarness.h"
+
+namespace {
+
+std::vector<uint8_t> randomSites(int width, int height, int oneIn, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> pick(0, oneIn - 1);
+    std::vector<uint8_t> sites(static_cast<size_t>(width) * height);
+    for (auto &site: sites) {
+        site = pick(random) == 0 ? 1 : 0;
+    }
+    return sites;
+}
+
+float bruteForceSquaredDistance(const std::vector<uint8_t> &sites, int width, int height, int x,
+                                int y, bool wrapX = false) {
+    auto best = 1e30f;
+    for (int sy = 0; sy < height; ++sy) {
+        for (int sx = 0; sx < width; ++sx) {
+            if (sites[static_cast<size_t>(sy) * width + sx]) {
+                auto columns = std::abs(sx - x);
+                auto dx = static_cast<float>(wrapX ? std::min(columns, width - columns) : columns);
+                auto dy = static_cast<float>(sy - y);
+                best = std::min(best, dx * dx + dy * dy);
+            }
+        }
+    }
+    return best;
+}
+
+//! a disc of radius @a radius pixels in the middle of a @a size x @a size mask
+std::vector<uint8_t> makeDisc(int size, float radius) {
+    std::vector<uint8_t> inside(static_cast<size_t>(size) * size);
+    auto centre = static_cast<float>(size) * 0.5f;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            auto dx = static_cast<float>(x) + 0.5f - centre;
+            auto dy = static_cast<float>(y) + 0.5f - centre;
+            inside[static_cast<size_t>(y) * size + x] = dx * dx + dy * dy <= radius * radius;
+        }
+    }
+    return inside;
+}
+
+} // namespace
+
+TEST(squaredDistancesMatchBruteForce) {
+    const int sizes[][3] = {{37, 23, 20}, {64, 64, 300}, {1, 17, 4}, {19, 1, 4}, {40, 30, 2}};
+    for (const auto &size: sizes) {
+        auto width = size[0];
+        auto height = size[1];
+        auto sites = randomSites(width, height, size[2], static_cast<uint32_t>(width * height));
+        sites[0] = 1;
+        auto distances = DistanceField::computeSquaredDistances(sites, width, height);
+        CHECK(distances.size() == sites.size());
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                // Squared distances are whole numbers, exact in float at these sizes
+                CHECK(distances[static_cast<size_t>(y) * width + x]
+                      == bruteForceSquaredDistance(sites, width, height, x, y));
+            }
+        }
+    }
+
+    auto none = DistanceField::computeSquaredDistances(std::vector<uint8_t>(12), 4, 3);
+    for (auto distance: none) {
+        CHECK(distance > 1e18f);
+    }
+}
+
+TEST(wrappedDistancesCrossTheSeam) {
+    const int sizes[][3] = {{37, 23, 20}, {64, 64, 300}, {1, 17, 4}, {19, 1, 4}, {40, 30, 2}};
+    for (const auto &size: sizes) {
+        auto width = size[0];
+        auto height = size[1];
+        auto sites = randomSites(width, height, size[2], static_cast<uint32_t>(width + height));
+        sites[0] = 1;
+        auto distances = DistanceField::computeSquaredDistances(sites, width, height, true);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                CHECK(distances[static_cast<size_t>(y) * width + x]
+                      == bruteForceSquaredDistance(sites, width, height, x, y, true));
+            }
+        }
+    }
+
+    // A line along the left edge: wrapped, the last column is next to it
+    constexpr int kWidth = 64;
+    constexpr int kHeight = 8;
+    std::vector<uint8_t> inside(kWidth * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        inside[y * kWidth] = 1;
+    }
+    auto clamped = DistanceField::computeSignedDistances(inside, kWidth, kHeight);
+    auto wrapped = DistanceField::computeSignedDistances(inside, kWidth, kHeight, true);
+    CHECK(clamped[kWidth - 1] > 50.f);
+    CHECK(std::fabs(wrapped[kWidth - 1] - 0.5f) < 1e-5f);
+
+    // A line on the seam, encoded: the texels on both sides of it are as far from it
+    for (int y = 0; y < kHeight; ++y) {
+        inside[y * kWidth + kWidth - 1] = 1;
+    }
+    wrapped = DistanceField::computeSignedDistances(inside, kWidth, kHeight, true);
+    int fieldWidth;
+    int fieldHeight;
+    auto field = DistanceField::encode(wrapped, kWidth, kHeight, 4, 1.f, fieldWidth, fieldHeight,
+                                       true);
+    CHECK(fieldWidth == kWidth / 4);
+    for (int y = 0; y < fieldHeight; ++y) {
+        auto row = static_cast<size_t>(y) * fieldWidth;
+        CHECK(field[row] == field[row + fieldWidth - 1]);
+        CHECK(DistanceField::decode(field[row]) < 1.f);
+    }
+}
+
+TEST(signedDistancesChangeSignOnPixelEdges) {
+    // A 4 pixel wide bar across the middle of the columns
+    constexpr int kWidth = 16;
+    constexpr int kHeight = 5;
+    std::vector<uint8_t> inside(kWidth * kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 6; x < 10; ++x) {
+            inside[y * kWidth + x] = 1;
+        }
+    }
+    auto distances = DistanceField::computeSignedDistances(inside, kWidth, kHeight);
+    const float row[kWidth] = {5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f, -0.5f, -1.5f,
+                               -1.5f, -0.5f, 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f};
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            CHECK_NEAR(distances[y * kWidth + x], row[x], 1e-6f);
+        }
+    }
+    CHECK_NEAR(DistanceField::estimateHalfStrokeWidth(distances), 2.f, 1e-6f);
+}
+
+TEST(encodingRoundTrips) {
+    CHECK(DistanceField::decode(128) == 0.f);
+    CHECK_NEAR(DistanceField::decode(255), DistanceField::kSpreadTexels, 1e-6f);
+    CHECK_NEAR(DistanceField::decode(1), -DistanceField::kSpreadTexels, 1e-6f);
+
+    std::vector<float> field = {-10.f, -1.f, -0.25f, 0.f, 0.3f, 2.5f, 3.99f, 100.f};
+    int width;
+    int height;
+    auto encoded = DistanceField::encode(field, 8, 1, 1, 0.f, width, height);
+    CHECK(width == 8 && height == 1);
+    auto step = DistanceField::kSpreadTexels / 127.f;
+    for (size_t i = 0; i < field.size(); ++i) {
+        auto clamped = std::fmax(std::fmin(field[i], DistanceField::kSpreadTexels),
+                                 -DistanceField::kSpreadTexels);
+        CHECK(std::fabs(DistanceField::decode(encoded[i]) - clamped) <= step * 0.5f + 1e-6f);
+    }
+}
+
+TEST(downsampledDiscKeepsItsContour) {
+    // The contour survives at a quarter of the resolution, distances are in the small field's
+    // texels
+    constexpr int kSize = 256;
+    constexpr float kRadius = 70.f;
+    constexpr int kScale = 4;
+    auto distances = DistanceField::computeSignedDistances(makeDisc(kSize, kRadius), kSize,
+                                                           kSize);
+    int width;
+    int height;
+    auto encoded = DistanceField::encode(distances, kSize, kSize, kScale, 0.f, width, height);
+    CHECK(width == kSize / kScale && height == kSize / kScale);
+
+    auto centre = static_cast<float>(width) * 0.5f;
+    auto radius = kRadius / kScale;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            auto dx = static_cast<float>(x) + 0.5f - centre;
+            auto dy = static_cast<float>(y) + 0.5f - centre;
+            auto expected = std::sqrt(dx * dx + dy * dy) - radius;
+            if (std::fabs(expected) < DistanceField::kSpreadTexels - 0.5f) {
+                // Rasterizing the disc moves its edge by up to half a mask pixel
+                CHECK_NEAR(DistanceField::decode(encoded[y * width + x]), expected, 0.25f);
+            }
+        }
+    }
+}
+
+TEST(linesAreCentredOnTheirStrokes) {
+    // A diagonal stroke about 5 pixels wide, its centre line is y = x
+    constexpr int kSize = 128;
+    std::vector<uint8_t> inside(kSize * kSize);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            inside[y * kSize + x] = std::abs(x - y) * 0.70710678f <= 2.5f;
+        }
+    }
+    auto distances = DistanceField::computeSignedDistances(inside, kSize, kSize);
+    auto halfWidth = DistanceField::estimateHalfStrokeWidth(distances);
+    CHECK(halfWidth > 2.f && halfWidth < 3.5f);
+
+    constexpr int kScale = 2;
+    int width;
+    int height;
+    auto encoded = DistanceField::encode(distances, kSize, kSize, kScale, halfWidth, width,
+                                         height);
+    for (int i = 4; i < width - 4; ++i) {
+        CHECK(std::fabs(DistanceField::decode(encoded[i * width + i])) < 0.5f);
+        // Farther away it grows about as fast as the distance to the line
+        auto away = DistanceField::decode(encoded[i * width + i + 3]);
+        CHECK(away > 1.5f && away < 2.7f);
+    }
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,235 @@
+// Unit tests for GestureEngine, driven through the replay harness of gesturereplay with synthetic
+// touch screens and displays.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "GestureEngine.h"
+#include "GestureReplay.h"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr int64_t kMillis = 1000000LL;
+
+TouchEvent touch(TouchEvent::Action action, int64_t timeMillis, float x, float y) {
+    TouchEvent event;
+    event.action = action;
+    event.timeNanos = timeMillis * kMillis;
+    event.actionPointerId = action == TouchEvent::Action::Move ? -1 : 0;
+    event.pointerCount = 1;
+    event.pointers[0] = {0, x, y};
+    return event;
+}
+
+float sumDx(const ReplayResult &result) {
+    return result.frames.empty() ? 0.f : result.frames.back().shownX;
+}
+
+} // namespace
+
+TEST(coalescesSamplesIntoOneUpdate) {
+    GestureEngine engine;
+    engine.setPredictionEnabled(false);
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 10.f, 20.f));
+    // Four historical samples and the current one of a single MOVE event
+    for (int i = 1; i <= 5; ++i) {
+        engine.onTouchEvent(touch(TouchEvent::Action::Move, i * 2, 10.f + i * 3.f, 20.f - i));
+    }
+    CHECK(engine.needsFrame());
+
+    auto motion = engine.update(16 * kMillis, 48 * kMillis);
+    CHECK_NEAR(motion.dx, 15.f, 1e-4f);
+    CHECK_NEAR(motion.dy, -5.f, 1e-4f);
+    CHECK(engine.getStats().samples == 6);
+    CHECK(engine.getStats().framesWithInput == 1);
+    CHECK(!engine.needsFrame());
+
+    // Nothing new, nothing moves
+    motion = engine.update(32 * kMillis, 64 * kMillis);
+    CHECK(motion.dx == 0.f && motion.dy == 0.f);
+}
+
+TEST(historicalSamplesDriveTheVelocity) {
+    // The same path delivered as samples every 4ms flings, while a finger that rests before lifting
+    // doesn't
+    auto moving = replayTouchTrace(makeDragTrace(1000.f, 200, 250.0, 0), ReplayConfig());
+    auto resting = replayTouchTrace(makeDragTrace(1000.f, 200, 250.0, 120), ReplayConfig());
+    CHECK(moving.stats.flingFrames > 10);
+    CHECK(resting.stats.flingFrames == 0);
+}
+
+TEST(predictionReducesVisualLag) {
+    auto trace = makeDragTrace(1500.f, 600, 120.0, 100);
+    ReplayConfig config;
+    config.prediction = false;
+    auto baseline = replayTouchTrace(trace, config);
+    config.prediction = true;
+    auto predicted = replayTouchTrace(trace, config);
+
+    CHECK(baseline.measuredFrames > 20);
+    CHECK(predicted.measuredFrames > 20);
+    // The full pipeline is the two frames to the screen plus input delay and sampling, prediction
+    // hides up to kMaxPredictionNanos of it
+    CHECK(baseline.meanVisualLagNanos > 35e6);
+    auto hidden = baseline.meanVisualLagNanos - predicted.meanVisualLagNanos;
+    CHECK_NEAR(hidden, double(GestureEngine::kMaxPredictionNanos), 3e6);
+    CHECK(predicted.meanVisualLagNanos > 0.0);
+
+    // Both end up exactly where the finger stopped, the prediction is taken back
+    CHECK_NEAR(sumDx(baseline), 900.f, 0.5f);
+    CHECK_NEAR(sumDx(predicted), 900.f, 0.5f);
+}
+
+TEST(flingDistanceIsFrameRateIndependent) {
+    auto trace = makeDragTrace(2000.f, 150, 240.0, 0);
+    std::vector<float> distances;
+    for (double hz: {30.0, 60.0, 90.0, 120.0}) {
+        ReplayConfig config;
+        config.refreshHz = hz;
+        auto result = replayTouchTrace(trace, config);
+        CHECK(!result.frames.empty());
+        CHECK(!result.frames.back().touching);
+        distances.push_back(sumDx(result));
+    }
+
+    // Dragged 300px, then flung about v * tau = 650px more
+    for (auto distance: distances) {
+        CHECK_NEAR(distance, distances[1], 2.f);
+        CHECK_NEAR(distance, 300.f + 2000.f * GestureEngine::kFlingTimeConstantSeconds, 10.f);
+    }
+}
+
+TEST(touchCatchesFling) {
+    GestureEngine engine;
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 0.f, 0.f));
+    for (int i = 1; i <= 10; ++i) {
+        engine.onTouchEvent(touch(TouchEvent::Action::Move, i * 8, i * 16.f, 0.f));
+    }
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 88, 176.f, 0.f));
+    CHECK(engine.isFlinging());
+    engine.update(100 * kMillis, 133 * kMillis);
+
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 110, 50.f, 50.f));
+    CHECK(!engine.isFlinging());
+    engine.update(116 * kMillis, 149 * kMillis);
+    CHECK(!engine.needsFrame());
+}
+
+TEST(cancelDoesNotFling) {
+    GestureEngine engine;
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 0.f, 0.f));
+    for (int i = 1; i <= 10; ++i) {
+        engine.onTouchEvent(touch(TouchEvent::Action::Move, i * 8, i * 16.f, 0.f));
+    }
+    auto cancel = touch(TouchEvent::Action::Cancel, 88, 0.f, 0.f);
+    cancel.pointerCount = 0;
+    engine.onTouchEvent(cancel);
+    CHECK(!engine.isFlinging());
+    CHECK(!engine.isTouching());
+}
+
+TEST(pinchScalesDistance) {
+    // Spreading the fingers to three times their distance brings the camera three times closer
+    auto result = replayTouchTrace(makePinchTrace(200.f, 600.f, 300, 120.0), ReplayConfig());
+    CHECK(!result.frames.empty());
+    CHECK_NEAR(result.frames.back().shownDistanceScale, 1.f / 3.f, 1e-3f);
+
+    // The centroid didn't move, so neither does the globe, and a pinch doesn't fling
+    CHECK_NEAR(result.frames.back().shownX, 0.f, 1e-3f);
+    CHECK(result.stats.flingFrames == 0);
+}
+
+TEST(secondFingerDoesNotJump) {
+    GestureEngine engine;
+    engine.setPredictionEnabled(false);
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 100.f, 100.f));
+
+    auto second = touch(TouchEvent::Action::Down, 10, 300.f, 100.f);
+    second.actionPointerId = 1;
+    second.pointers[0].id = 1;
+    second.pointers[1] = {0, 100.f, 100.f};
+    second.pointerCount = 2;
+    engine.onTouchEvent(second);
+
+    auto motion = engine.update(16 * kMillis, 48 * kMillis);
+    CHECK(motion.dx == 0.f && motion.dy == 0.f);
+    CHECK(motion.distanceScale == 1.f);
+}
+
+TEST(shortStillTouchesTap) {
+    GestureEngine engine;
+    float x;
+    float y;
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 100.f, 200.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Move, 40, 104.f, 197.f));
+    CHECK(!engine.consumeTap(x, y));
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 90, 105.f, 198.f));
+    CHECK(engine.needsFrame());
+    CHECK(engine.consumeTap(x, y));
+    CHECK(x == 100.f && y == 200.f);
+    CHECK(!engine.consumeTap(x, y));
+
+    // Too far, too long, or with a second finger it's no tap
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 1000, 100.f, 200.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Move, 1020, 130.f, 200.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Move, 1040, 100.f, 200.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 1050, 100.f, 200.f));
+    CHECK(!engine.consumeTap(x, y));
+
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 5000, 100.f, 200.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 5400, 100.f, 200.f));
+    CHECK(!engine.consumeTap(x, y));
+
+    auto second = touch(TouchEvent::Action::Down, 6010, 100.f, 200.f);
+    second.actionPointerId = 1;
+    second.pointerCount = 2;
+    second.pointers[1] = {1, 300.f, 400.f};
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 6000, 100.f, 200.f));
+    engine.onTouchEvent(second);
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 6050, 100.f, 200.f));
+    CHECK(!engine.consumeTap(x, y));
+}
+
+TEST(touchThatCatchesAFlingDoesNotTap) {
+    GestureEngine engine;
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 0, 0.f, 0.f));
+    for (int i = 1; i <= 10; ++i) {
+        engine.onTouchEvent(touch(TouchEvent::Action::Move, i * 8, i * 20.f, 0.f));
+    }
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 88, 200.f, 0.f));
+    CHECK(engine.isFlinging());
+    engine.onTouchEvent(touch(TouchEvent::Action::Down, 120, 300.f, 0.f));
+    engine.onTouchEvent(touch(TouchEvent::Action::Up, 160, 300.f, 0.f));
+    float x;
+    float y;
+    CHECK(!engine.consumeTap(x, y));
+}
+
+TEST(traceRoundTrip) {
+    auto events = makePinchTrace(100.f, 300.f, 50, 120.0);
+    std::stringstream text;
+    writeTouchTrace(text, events);
+
+    std::vector<TouchEvent> parsed;
+    std::string error;
+    CHECK(readTouchTrace(text, parsed, error));
+    CHECK(parsed.size() == events.size());
+    for (size_t i = 0; i < std::min(parsed.size(), events.size()); ++i) {
+        CHECK(parsed[i].action == events[i].action);
+        CHECK(std::llabs(parsed[i].timeNanos - events[i].timeNanos) < 1000);
+        CHECK(parsed[i].pointerCount == events[i].pointerCount);
+        CHECK_NEAR(parsed[i].pointers[0].x, events[i].pointers[0].x, 1e-3f);
+    }
+
+    std::stringstream bad("# comment\n\n5 hover 0 0:1,2\n");
+    CHECK(!readTouchTrace(bad, parsed, error));
+    CHECK(error.find("line 3") != std::string::npos);
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,180 @@
+// Tests of native picking: the ray-sphere intersection, unprojecting screen points through the
+// renderer's matrices, and the region raster against the polygon test the Kotlin view runs.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Continents.h"
+#include "GeoCoordinates.h"
+#include "GlobePicker.h"
+#include "KotlinRegions.h"
+#include "RegionRaster.h"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+constexpr int kWidth = 1080;
+constexpr int kHeight = 2280;
+
+struct TestView {
+    Mat4 projection;
+    Mat4 view;
+    Mat4 model;
+};
+
+//! the renderer's camera: looking down -z at the globe from @a distance, the globe rotated
+TestView makeView(float distance, float rotationX, float rotationY) {
+    TestView view;
+    view.projection = Mat4::perspective(
+            60.f * kPi / 180.f, float(kWidth) / float(kHeight), 0.1f, 20.f);
+    view.view = Mat4::translation({0.f, 0.f, -distance});
+    view.model = Mat4::rotationY(rotationY) * Mat4::rotationX(rotationX);
+    return view;
+}
+
+GlobePicker makePicker(const TestView &view) {
+    GlobePicker picker;
+    picker.setView(view.projection, view.view, view.model, kWidth, kHeight);
+    return picker;
+}
+
+//! where @a position of the globe's model space is drawn, in pixels from the top left
+bool project(const TestView &view, const Vec3 &position, float &outX, float &outY) {
+    auto ndc = (view.projection * view.view * view.model).projectPoint(position);
+    outX = (ndc.x + 1.f) * 0.5f * kWidth;
+    outY = (1.f - ndc.y) * 0.5f * kHeight;
+    return ndc.z > -1.f && ndc.z < 1.f;
+}
+
+} // namespace
+
+TEST(raysHitTheUnitSphere) {
+    float distance;
+    CHECK(GlobePicker::intersectUnitSphere({0.f, 0.f, 3.f}, {0.f, 0.f, -1.f}, distance));
+    CHECK_NEAR(distance, 2.f, 1e-6f);
+
+    // Grazing, missing, pointing away, and from inside
+    CHECK(GlobePicker::intersectUnitSphere({1.f, 0.f, 3.f}, {0.f, 0.f, -1.f}, distance));
+    CHECK_NEAR(distance, 3.f, 1e-3f);
+    CHECK(!GlobePicker::intersectUnitSphere({1.01f, 0.f, 3.f}, {0.f, 0.f, -1.f}, distance));
+    CHECK(!GlobePicker::intersectUnitSphere({0.f, 0.f, 3.f}, {0.f, 0.f, 1.f}, distance));
+    CHECK(GlobePicker::intersectUnitSphere({0.f, 0.f, 0.5f}, {0.f, 0.f, 1.f}, distance));
+    CHECK_NEAR(distance, 0.5f, 1e-6f);
+
+    auto direction = normalize(Vec3{0.3f, -0.2f, -1.f});
+    CHECK(GlobePicker::intersectUnitSphere({0.f, 0.f, 2.5f}, direction, distance));
+    CHECK_NEAR(length(Vec3{0.f, 0.f, 2.5f} + direction * distance), 1.f, 1e-5f);
+}
+
+TEST(centreOfTheScreenIsBelowTheCamera) {
+    auto view = makeView(3.f, 0.f, 0.f);
+    auto picker = makePicker(view);
+    GlobePick pick;
+    CHECK(picker.pick(kWidth * 0.5f, kHeight * 0.5f, pick));
+    CHECK_NEAR(pick.position.x, 0.f, 1e-4f);
+    CHECK_NEAR(pick.position.y, 0.f, 1e-4f);
+    CHECK_NEAR(pick.position.z, 1.f, 1e-4f);
+    CHECK_NEAR(pick.distance, 1.9f, 1e-3f);
+
+    // The globe is about 1400 pixels across from there, the corners are space
+    CHECK(!picker.pick(0.f, 0.f, pick));
+    CHECK(!picker.pick(kWidth * 0.5f, 10.f, pick));
+    CHECK(!GlobePicker().pick(0.f, 0.f, pick));
+}
+
+TEST(picksWhatWasDrawnThere) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    auto tested = 0;
+    for (int i = 0; i < 200; ++i) {
+        auto view = makeView(1.2f + (unit(random) + 1.f) * 3.f, unit(random) * 1.3f,
+                             unit(random) * kPi);
+        auto picker = makePicker(view);
+        auto camera = view.model.transposed().transformVector(
+                {0.f, 0.f, view.view[3].z * -1.f});
+
+        for (int j = 0; j < 20; ++j) {
+            auto latitude = unit(random) * 89.f;
+            auto longitude = unit(random) * 180.f;
+            auto position = directionFromLatLon(latitude, longitude);
+
+            // Only places facing the camera, not too close to the limb
+            if (dot(position, normalize(camera - position)) < 0.2f) {
+                continue;
+            }
+            float x;
+            float y;
+            if (!project(view, position, x, y) || x < 0.f || y < 0.f || x > kWidth
+                || y > kHeight) {
+                continue;
+            }
+            GlobePick pick;
+            CHECK(picker.pick(x, y, pick));
+            CHECK(length(pick.position - position) < 5e-4f);
+            CHECK_NEAR(pick.latitude, latitude, 0.02f);
+            ++tested;
+        }
+    }
+    CHECK(tested > 500);
+}
+
+TEST(rasterMatchesThePolygonTest) {
+    const auto &outlines = getContinentOutlines();
+    auto raster = RegionRaster::bake(outlines, 720, 360);
+    CHECK(raster.getWidth() == 720 && raster.getHeight() == 360);
+
+    // Exactly at the centres of the cells, where the raster was sampled
+    size_t regionCells = 0;
+    for (int y = 0; y < raster.getHeight(); ++y) {
+        for (int x = 0; x < raster.getWidth(); ++x) {
+            auto u = (static_cast<float>(x) + 0.5f) / static_cast<float>(raster.getWidth());
+            auto v = (static_cast<float>(y) + 0.5f) / static_cast<float>(raster.getHeight());
+            auto expected = kotlin::scanRegions(outlines, u, v);
+            CHECK(raster.getRegionAt(u, v) == expected);
+            regionCells += expected != RegionRaster::kNoRegion ? 1 : 0;
+        }
+    }
+    CHECK(regionCells > 10000);
+}
+
+TEST(rasterLooksUpLatitudeAndLongitude) {
+    auto raster = RegionRaster::bake(getContinentOutlines(), 1024, 512);
+    CHECK(raster.getRegion(5.f, 20.f) == static_cast<uint16_t>(Continent::Africa));
+    CHECK(raster.getRegion(-25.f, 134.f) == static_cast<uint16_t>(Continent::Australia));
+    CHECK(raster.getRegion(0.f, -140.f) == RegionRaster::kNoRegion);
+
+    // Longitudes wrap, latitudes past the poles clamp
+    CHECK(raster.getRegion(5.f, 20.f + 360.f) == raster.getRegion(5.f, 20.f));
+    CHECK(raster.getRegion(100.f, 0.f) == raster.getRegion(89.9f, 0.f));
+    CHECK(raster.getRegionAt(-0.25f, 0.5f) == raster.getRegionAt(0.75f, 0.5f));
+
+    CHECK(getContinentName(static_cast<uint16_t>(Continent::Europe)) != nullptr);
+    CHECK(getContinentName(RegionRaster::kNoRegion) == nullptr);
+    CHECK(RegionRaster().getRegion(0.f, 0.f) == RegionRaster::kNoRegion);
+}
+
+TEST(pickingFindsTheRegion) {
+    auto raster = RegionRaster::bake(getContinentOutlines(), 1024, 512);
+
+    // Turn the globe so Africa faces the camera, the model matrix takes it to +z
+    auto target = directionFromLatLon(5.f, 20.f);
+    auto rotationY = std::atan2(target.x, target.z);
+    auto view = makeView(3.f, 0.f, -rotationY);
+    auto facing = view.model.transformVector(target);
+    CHECK(facing.z > 0.99f);
+
+    auto picker = makePicker(view);
+    picker.setRegions(&raster);
+    GlobePick pick;
+    float x;
+    float y;
+    CHECK(project(view, target, x, y));
+    CHECK(picker.pick(x, y, pick));
+    CHECK(pick.region == static_cast<uint16_t>(Continent::Africa));
+}
+
+int main() {
+    return testing::runTests();
+}
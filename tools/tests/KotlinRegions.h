@@ -0,0 +1,49 @@
+#ifndef EARTHZOO_TOOLS_KOTLINREGIONS_H
+#define EARTHZOO_TOOLS_KOTLINREGIONS_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "RegionRaster.h"
+
+// The polygon test InteractiveEarthView runs in Kotlin, the reference native picking and region
+// classification are checked against. Keep it in step with Continent.contains there.
+
+namespace kotlin {
+
+//! InteractiveEarthView's Continent.contains
+inline bool containsPoint(const RegionOutline &outline, float u, float v) {
+    auto result = false;
+    auto count = outline.points.size() / 2;
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        auto ui = outline.points[2 * i];
+        auto vi = outline.points[2 * i + 1];
+        auto uj = outline.points[2 * j];
+        auto vj = outline.points[2 * j + 1];
+        if ((vi > v) != (vj > v)) {
+            auto denominator = vj - vi;
+            if (std::fabs(denominator) > 0.00001f) {
+                auto crossing = ui + (v - vi) / denominator * (uj - ui);
+                if (u < crossing) {
+                    result = !result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+//! @return the first outline containing (u, v), like the view's tap handler picks a continent
+inline uint16_t scanRegions(const std::vector<RegionOutline> &outlines, float u, float v) {
+    for (const auto &outline: outlines) {
+        if (containsPoint(outline, u, v)) {
+            return outline.id;
+        }
+    }
+    return RegionRaster::kNoRegion;
+}
+
+} // namespace kotlin
+
+#endif //EARTHZOO_TOOLS_KOTLINREGIONS_H
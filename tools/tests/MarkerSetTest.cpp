@@ -0,0 +1,179 @@
+// CPU correctness tests of the marker layer: the geographic mapping, the instance packing, the
+// horizon test the vertex shader runs and the incremental upload ranges.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "GeoCoordinates.h"
+#include "MarkerSet.h"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr float kPi = 3.14159265358979323846f;
+
+using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+Ranges consume(MarkerSet &markers) {
+    Ranges ranges;
+    markers.consumeChanges([&ranges](size_t first, size_t count) {
+        ranges.emplace_back(first, count);
+    });
+    return ranges;
+}
+
+Marker randomMarker(std::mt19937 &random) {
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    Marker marker;
+    marker.latitude = std::asin(unit(random) * 2.f - 1.f) * 180.f / kPi;
+    marker.longitude = unit(random) * 360.f - 180.f;
+    return marker;
+}
+
+} // namespace
+
+TEST(directionsFollowTheImagery) {
+    // The globe's fragment shader turns a direction into texture coordinates like this, the map's
+    // top left is (0, 0)
+    for (float latitude = -85.f; latitude <= 85.f; latitude += 17.f) {
+        for (float longitude = -175.f; longitude <= 175.f; longitude += 35.f) {
+            auto direction = directionFromLatLon(latitude, longitude);
+            CHECK_NEAR(length(direction), 1.f, 1e-6f);
+
+            auto u = std::atan2(direction.z, direction.x) / (2.f * kPi);
+            u -= std::floor(u);
+            auto v = 1.f - std::acos(direction.y) / kPi;
+            CHECK_NEAR(u, (longitude + 180.f) / 360.f, 1e-5f);
+            CHECK_NEAR(v, (90.f - latitude) / 180.f, 1e-5f);
+        }
+    }
+}
+
+TEST(latLonRoundTrips) {
+    for (float latitude = -90.f; latitude <= 90.f; latitude += 7.5f) {
+        for (float longitude = -179.f; longitude <= 179.f; longitude += 11.f) {
+            float outLatitude;
+            float outLongitude;
+            auto direction = directionFromLatLon(latitude, longitude);
+            latLonFromDirection(direction, outLatitude, outLongitude);
+            CHECK_NEAR(outLatitude, latitude, 1e-3f);
+            if (std::fabs(latitude) < 90.f) {
+                CHECK_NEAR(outLongitude, longitude, 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(packedDirectionsStayClose) {
+    std::mt19937 random(1u);
+    float worst = 0.f;
+    for (int i = 0; i < 100000; ++i) {
+        auto marker = randomMarker(random);
+        auto exact = directionFromLatLon(marker.latitude, marker.longitude);
+        auto packed = MarkerSet::unpackDirection(MarkerSet::pack(marker));
+        worst = std::max(worst, length(packed - exact));
+    }
+
+    // Half a snorm16 step on each axis
+    CHECK(worst < 3e-5f);
+}
+
+TEST(packsAttributes) {
+    Marker marker;
+    marker.size = 12.25f;
+    marker.color = 0x11223344u;
+    marker.atlasIndex = 200;
+    marker.flags = kMarkerHighlighted;
+    auto instance = MarkerSet::pack(marker);
+    CHECK(instance.size == 196);
+    CHECK(instance.color[0] == 0x11 && instance.color[1] == 0x22);
+    CHECK(instance.color[2] == 0x33 && instance.color[3] == 0x44);
+    CHECK(instance.atlasIndex == kMarkerAtlasSize - 1);
+    CHECK(instance.flags == kMarkerHighlighted);
+}
+
+TEST(horizonTestMatchesTheSphere) {
+    // From distance d the visible cap is the part with dot(p, camera) > 1, (1 - 1 / d) / 2 of the
+    // sphere's area
+    std::mt19937 random(2u);
+    MarkerSet markers;
+    for (int i = 0; i < 100000; ++i) {
+        markers.add(randomMarker(random));
+    }
+
+    Vec3 camera = normalize(Vec3{0.3f, -0.5f, 0.8f}) * 3.f;
+    auto fraction = static_cast<float>(markers.countVisible(camera)) / 100000.f;
+    CHECK_NEAR(fraction, 1.f / 3.f, 0.01f);
+
+    // Away from the horizon the quantized test agrees with the exact one
+    int disagreements = 0;
+    for (uint32_t i = 0; i < markers.size(); ++i) {
+        const auto &marker = markers.get(i);
+        auto exact = directionFromLatLon(marker.latitude, marker.longitude);
+        auto margin = dot(exact, camera) - 1.f;
+        if (std::fabs(margin) > 1e-3f
+            && MarkerSet::isVisible(markers.getInstances()[i], camera) != (margin > 0.f)) {
+            disagreements++;
+        }
+    }
+    CHECK(disagreements == 0);
+}
+
+TEST(markerUnderTheCameraIsVisibleAndItsAntipodeIsNot) {
+    Marker marker;
+    marker.latitude = 40.f;
+    marker.longitude = -74.f;
+    auto camera = directionFromLatLon(40.f, -74.f) * 1.2f;
+    CHECK(MarkerSet::isVisible(MarkerSet::pack(marker), camera));
+    CHECK(!MarkerSet::isVisible(MarkerSet::pack(marker), -camera));
+
+    marker.flags = kMarkerHidden;
+    CHECK(!MarkerSet::isVisible(MarkerSet::pack(marker), camera));
+}
+
+TEST(onlyChangedPagesAreUploaded) {
+    constexpr size_t kPage = MarkerSet::kPageSize;
+    std::mt19937 random(3u);
+    MarkerSet markers;
+    for (size_t i = 0; i < 5 * kPage + 10; ++i) {
+        markers.add(randomMarker(random));
+    }
+    CHECK(markers.hasChanges());
+    CHECK((consume(markers) == Ranges{{0, 5 * kPage + 10}}));
+    CHECK(!markers.hasChanges());
+    CHECK(consume(markers).empty());
+
+    // Two pages apart stay apart, neighbouring pages merge, the last page stops at the end
+    markers.set(kPage + 5, randomMarker(random));
+    markers.setFlags(3 * kPage + 1, kMarkerHidden);
+    markers.setFlags(4 * kPage, kMarkerHighlighted);
+    markers.set(5 * kPage + 3, randomMarker(random));
+    CHECK((consume(markers) == Ranges{{kPage, kPage}, {3 * kPage, 2 * kPage + 10}}));
+
+    // Setting the flags it already has changes nothing
+    markers.setFlags(3 * kPage + 1, kMarkerHidden);
+    CHECK(!markers.hasChanges());
+
+    markers.add(randomMarker(random));
+    CHECK((consume(markers) == Ranges{{5 * kPage, 11}}));
+}
+
+TEST(clearStartsOver) {
+    std::mt19937 random(4u);
+    MarkerSet markers;
+    markers.add(randomMarker(random));
+    consume(markers);
+    markers.clear();
+    CHECK(markers.size() == 0);
+    CHECK(markers.hasChanges());
+    CHECK(consume(markers).empty());
+    CHECK(markers.add(randomMarker(random)) == 0);
+    CHECK((consume(markers) == Ranges{{0, 1}}));
+}
+
+int main() {
+    return testing::runTests();
+}
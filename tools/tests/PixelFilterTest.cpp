@@ -0,0 +1,151 @@
+// Tests of the overlay pixel filter: the outline filter against the loop InteractiveEarthView ran
+// in Kotlin, generic ranges and maps, row tails and strides, and images split over threads.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "PixelFilter.h"
+#include "TestHarness.h"
+
+namespace {
+
+//! InteractiveEarthView's Kotlin loop on one pixel: opaque enough pure black stays, the rest goes
+uint32_t keepOutline(uint32_t pixel, uint32_t minAlpha) {
+    auto red = pixel & 0xFFu;
+    auto green = (pixel >> 8) & 0xFFu;
+    auto blue = (pixel >> 16) & 0xFFu;
+    auto alpha = pixel >> 24;
+    auto isPureBlack = red == 0 && green == 0 && blue == 0;
+    return isPureBlack && alpha >= minAlpha ? packRgba(0, 0, 0, 255) : 0u;
+}
+
+/*!
+ * Random pixels, a good share of them black with a random alpha so the outline filter's range is
+ * hit from both sides
+ */
+std::vector<uint32_t> randomPixels(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint32_t> any;
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint32_t> pixels(count);
+    for (auto &pixel: pixels) {
+        switch (kind(random)) {
+            case 0:
+                pixel = packRgba(0, 0, 0, static_cast<uint8_t>(byte(random)));
+                break;
+            case 1:
+                pixel = packRgba(0, 0, 0, static_cast<uint8_t>(240 + byte(random) % 16));
+                break;
+            case 2:
+                // One channel just off black
+                pixel = packRgba(0, 0, 0, 255) | 1u << (8 * (byte(random) % 3));
+                break;
+            default:
+                pixel = any(random);
+                break;
+        }
+    }
+    return pixels;
+}
+
+} // namespace
+
+TEST(outlineFilterMatchesTheKotlinLoop) {
+    for (int minAlpha: {0, 1, 250, 255}) {
+        auto filter = PixelFilter::makeOutlineFilter(static_cast<uint8_t>(minAlpha));
+        auto pixels = randomPixels(10007, 1);
+        auto filtered = pixels;
+        filter.applyRow(filtered.data(), filtered.size());
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            CHECK(filtered[i] == keepOutline(pixels[i], static_cast<uint32_t>(minAlpha)));
+            CHECK(filter.apply(pixels[i]) == filtered[i]);
+        }
+    }
+
+    auto filter = PixelFilter::makeOutlineFilter(250);
+    CHECK(filter.apply(packRgba(0, 0, 0, 250)) == packRgba(0, 0, 0, 255));
+    CHECK(filter.apply(packRgba(0, 0, 0, 249)) == 0u);
+    CHECK(filter.apply(packRgba(0, 1, 0, 255)) == 0u);
+    CHECK(filter.apply(packRgba(255, 255, 255, 255)) == 0u);
+}
+
+TEST(rangesAndMapsAreGeneric) {
+    // Bright red pixels become blue, keeping their alpha, everything else is left alone
+    PixelRange reds;
+    reds.low = packRgba(200, 0, 0, 0);
+    reds.high = packRgba(255, 60, 60, 255);
+    PixelFilter filter(reds, {0xFF000000u, packRgba(0, 0, 255, 0)}, PixelMap::unchanged());
+    CHECK(filter.matches(packRgba(200, 60, 0, 10)));
+    CHECK(!filter.matches(packRgba(199, 0, 0, 255)));
+    CHECK(!filter.matches(packRgba(255, 61, 0, 255)));
+
+    std::vector<uint32_t> row = {packRgba(220, 10, 20, 128), packRgba(10, 10, 10, 255),
+                                 packRgba(255, 60, 60, 255), packRgba(255, 255, 255, 0),
+                                 packRgba(230, 0, 0, 7)};
+    filter.applyRow(row.data(), row.size());
+    CHECK(row[0] == packRgba(0, 0, 255, 128));
+    CHECK(row[1] == packRgba(10, 10, 10, 255));
+    CHECK(row[2] == packRgba(0, 0, 255, 255));
+    CHECK(row[3] == packRgba(255, 255, 255, 0));
+    CHECK(row[4] == packRgba(0, 0, 255, 7));
+
+    // The full range with the default maps leaves every pixel alone
+    PixelFilter identity(PixelRange(), PixelMap::unchanged(), PixelMap::unchanged());
+    auto pixels = randomPixels(1000, 2);
+    auto filtered = pixels;
+    identity.applyRow(filtered.data(), filtered.size());
+    CHECK(filtered == pixels);
+}
+
+TEST(rowTailsAreFiltered) {
+    // Rows of every length around the kernel's width, so the scalar tail runs too
+    auto filter = PixelFilter::makeOutlineFilter(250);
+    auto pixels = randomPixels(64, 3);
+    for (size_t count = 0; count <= 17; ++count) {
+        auto filtered = pixels;
+        filter.applyRow(filtered.data() + 1, count);
+        CHECK(filtered[0] == pixels[0]);
+        for (size_t i = 1; i <= count; ++i) {
+            CHECK(filtered[i] == filter.apply(pixels[i]));
+        }
+        CHECK(std::equal(filtered.begin() + 1 + count, filtered.end(),
+                         pixels.begin() + 1 + count));
+    }
+}
+
+TEST(imagesKeepTheirPaddingAndSplitOverThreads) {
+    // An odd width in rows padded to 16 bytes, like Android pads some bitmaps
+    constexpr uint32_t kWidth = 1001;
+    constexpr uint32_t kHeight = 517;
+    constexpr size_t kStride = (kWidth * 4 + 15) / 16 * 16;
+    auto pixels = randomPixels(kStride / 4 * kHeight, 4);
+    auto filter = PixelFilter::makeOutlineFilter(250);
+
+    std::vector<uint32_t> expected = pixels;
+    for (uint32_t row = 0; row < kHeight; ++row) {
+        for (uint32_t column = 0; column < kWidth; ++column) {
+            auto &pixel = expected[row * kStride / 4 + column];
+            pixel = keepOutline(pixel, 250);
+        }
+    }
+
+    for (int threads: {1, 2, 3, 8, 1000}) {
+        auto filtered = pixels;
+        filter.applyImage(filtered.data(), kWidth, kHeight, kStride, threads);
+        CHECK(filtered == expected);
+    }
+
+    // Images too small to split, and empty ones
+    auto filtered = pixels;
+    filter.applyImage(filtered.data(), 3, 2, kStride, 8);
+    CHECK(filtered[0] == expected[0] && filtered[2] == expected[2] && filtered[3] == pixels[3]);
+    CHECK(filtered[kStride / 4 + 2] == expected[kStride / 4 + 2]);
+    filter.applyImage(nullptr, 0, 0, 0);
+    filter.applyImage(filtered.data(), kWidth, 0, kStride);
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,292 @@
+// Tests of the point store: the grid and the Hilbert order, the file format and its validation,
+// and that queries find exactly the points a scan over the stored positions would.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "MappedFile.h"
+#include "PointStore.h"
+#include "TestHarness.h"
+
+namespace {
+
+constexpr double kDegreesToRadians = 3.14159265358979323846 / 180.0;
+
+std::vector<GeoPoint> randomPoints(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::normal_distribution<float> near(0.f, 2.f);
+    std::vector<GeoPoint> points(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto &point = points[i];
+        point.id = static_cast<uint32_t>(i);
+        if (i % 2 == 0) {
+            point.latitude = static_cast<float>(std::asin(unit(random)) / kDegreesToRadians);
+            point.longitude = unit(random) * 180.f;
+        } else {
+            // Half of them crowd around the antimeridian near New Zealand
+            point.latitude = std::clamp(-40.f + near(random), -90.f, 90.f);
+            auto longitude = 178.f + near(random);
+            point.longitude = longitude > 180.f ? longitude - 360.f : longitude;
+        }
+    }
+    return points;
+}
+
+double getDistanceDegrees(float latitude1, float longitude1, float latitude2, float longitude2) {
+    auto phi1 = latitude1 * kDegreesToRadians;
+    auto phi2 = latitude2 * kDegreesToRadians;
+    auto sinHalfLatitude = std::sin((phi2 - phi1) * 0.5);
+    auto sinHalfLongitude = std::sin((longitude2 - longitude1) * kDegreesToRadians * 0.5);
+    auto haversine = sinHalfLatitude * sinHalfLatitude
+                     + std::cos(phi1) * std::cos(phi2) * sinHalfLongitude * sinHalfLongitude;
+    return 2.0 * std::asin(std::sqrt(std::min(haversine, 1.0))) / kDegreesToRadians;
+}
+
+bool isInRect(const GeoPoint &point, const GeoRect &rect, float margin) {
+    if (point.latitude < rect.south - margin || point.latitude > rect.north + margin) {
+        return false;
+    }
+    auto offset = std::fmod(point.longitude - rect.west + margin + 720.f, 360.f);
+    auto width = rect.east - rect.west;
+    if (width < 0.f) {
+        width += 360.f;
+    }
+    return offset <= width + 2.f * margin;
+}
+
+std::set<uint32_t> getIds(const std::vector<GeoPoint> &points) {
+    std::set<uint32_t> ids;
+    for (const auto &point: points) {
+        ids.insert(point.id);
+    }
+    return ids;
+}
+
+/*!
+ * Checks @a found against a scan of @a stored, the points as the store holds them. Points within
+ * @a margin of the region's edge may go either way, rounding decides.
+ */
+template<typename Inside>
+void checkAgainstScan(const std::vector<GeoPoint> &stored, const std::vector<GeoPoint> &found,
+                      Inside inside, float margin) {
+    auto ids = getIds(found);
+    CHECK(ids.size() == found.size());
+    for (const auto &point: stored) {
+        if (inside(point, -margin)) {
+            CHECK(ids.count(point.id) == 1);
+        } else if (!inside(point, margin)) {
+            CHECK(ids.count(point.id) == 0);
+        }
+    }
+}
+
+struct TestStore {
+    std::vector<uint8_t> file;
+    PointStore store;
+
+    //! every point as the store decodes it, in file order
+    std::vector<GeoPoint> stored;
+
+    explicit TestStore(const std::vector<GeoPoint> &points,
+                       const PointStoreOptions &options = PointStoreOptions()) :
+            file(PointStore::build(points, options)) {
+        CHECK(store.attach(file.data(), file.size()));
+        store.queryRect(GeoRect(), stored);
+    }
+};
+
+} // namespace
+
+TEST(hilbertOrderVisitsNeighbours) {
+    // The top bits of the key order the cells of a coarse grid along its own Hilbert curve
+    constexpr int kBits = 4;
+    constexpr uint32_t kSide = 1u << kBits;
+    std::vector<std::pair<uint64_t, uint32_t>> cells;
+    for (uint32_t y = 0; y < kSide; ++y) {
+        for (uint32_t x = 0; x < kSide; ++x) {
+            auto key = PointStore::getHilbertKey(x << (32 - kBits), y << (32 - kBits));
+            cells.emplace_back(key, y * kSide + x);
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+    for (size_t i = 1; i < cells.size(); ++i) {
+        auto cell = static_cast<int>(cells[i].second);
+        auto previous = static_cast<int>(cells[i - 1].second);
+        auto dx = cell % static_cast<int>(kSide) - previous % static_cast<int>(kSide);
+        auto dy = cell / static_cast<int>(kSide) - previous / static_cast<int>(kSide);
+        CHECK(std::abs(dx) + std::abs(dy) == 1);
+    }
+    CHECK(PointStore::getHilbertKey(0, 0) == 0);
+}
+
+TEST(gridRoundTrips) {
+    for (double longitude = -180.0; longitude < 180.0; longitude += 0.37) {
+        auto x = PointStore::quantizeLongitude(longitude);
+        auto back = PointStore::dequantizeLongitude(x);
+        CHECK(back <= longitude && longitude - back < 1e-7);
+    }
+    CHECK(PointStore::quantizeLongitude(180.0) == 0);
+    CHECK(PointStore::quantizeLongitude(-540.0) == 0);
+    CHECK(PointStore::quantizeLongitude(190.0) == PointStore::quantizeLongitude(-170.0));
+
+    CHECK(PointStore::quantizeLatitude(-90.0) == 0);
+    CHECK(PointStore::quantizeLatitude(90.0) == UINT32_MAX);
+    CHECK(PointStore::quantizeLatitude(100.0) == UINT32_MAX);
+    for (double latitude = -90.0; latitude <= 90.0; latitude += 0.41) {
+        auto back = PointStore::dequantizeLatitude(PointStore::quantizeLatitude(latitude));
+        CHECK(std::fabs(back - latitude) < 1e-7);
+    }
+}
+
+TEST(storedPointsKeepTheirPosition) {
+    auto points = randomPoints(50000, 1);
+    PointStoreOptions options;
+    options.blockCapacity = 256;
+    TestStore test(points, options);
+    CHECK(test.store.getPointCount() == points.size());
+    CHECK(test.stored.size() == points.size());
+    CHECK(test.store.getBlockCount() >= points.size() / 256);
+
+    // 2^10 grid units are 9e-5 degrees of longitude
+    for (const auto &point: test.stored) {
+        const auto &original = points[point.id];
+        CHECK_NEAR(point.latitude, original.latitude, 1e-4f);
+        auto longitudeError = std::fabs(point.longitude - original.longitude);
+        CHECK(std::min(longitudeError, 360.f - longitudeError) < 1e-4f);
+    }
+}
+
+TEST(capQueriesMatchAScan) {
+    auto points = randomPoints(40000, 2);
+    PointStoreOptions options;
+    options.blockCapacity = 64;
+    options.fanout = 4;
+    TestStore test(points, options);
+
+    // Ordinary, across the antimeridian, over a pole, tiny, and the whole globe
+    const float caps[][3] = {
+            {48.f, 11.f, 20.f},
+            {-40.f, 179.5f, 1.5f},
+            {-41.f, -179.f, 0.3f},
+            {80.f, 30.f, 15.f},
+            {-88.f, 0.f, 5.f},
+            {10.f, 10.f, 0.001f},
+            {0.f, 0.f, 180.f},
+    };
+    for (const auto &cap: caps) {
+        std::vector<GeoPoint> found;
+        PointQueryStats stats;
+        test.store.queryCap(cap[0], cap[1], cap[2], found, &stats);
+        CHECK(stats.pointsTested >= found.size());
+        checkAgainstScan(test.stored, found, [&cap](const GeoPoint &point, float margin) {
+            return getDistanceDegrees(cap[0], cap[1], point.latitude, point.longitude)
+                   <= cap[2] + margin;
+        }, 1e-4f);
+    }
+}
+
+TEST(rectQueriesMatchAScan) {
+    auto points = randomPoints(40000, 3);
+    PointStoreOptions options;
+    options.blockCapacity = 64;
+    options.fanout = 4;
+    TestStore test(points, options);
+
+    const GeoRect rects[] = {
+            {-10.f, -20.f, 30.f, 40.f},
+            {-45.f, 175.f, -35.f, -176.f},
+            {-50.f, 179.9f, -30.f, 179.95f},
+            {60.f, -180.f, 90.f, 180.f},
+            {-90.f, 100.f, 90.f, 99.f},
+    };
+    for (const auto &rect: rects) {
+        std::vector<GeoPoint> found;
+        test.store.queryRect(rect, found);
+        checkAgainstScan(test.stored, found, [&rect](const GeoPoint &point, float margin) {
+            return isInRect(point, rect, margin);
+        }, 1e-4f);
+    }
+}
+
+TEST(smallQueriesOnlyDecodeNearbyBlocks) {
+    auto points = randomPoints(100000, 4);
+    TestStore test(points);
+
+    std::vector<GeoPoint> found;
+    PointQueryStats stats;
+    test.store.queryCap(-40.f, 178.f, 0.5f, found, &stats);
+    CHECK(!found.empty());
+    CHECK(stats.blocksDecoded * 10 < test.store.getBlockCount());
+    CHECK(stats.pointsTested < found.size() * 10);
+}
+
+TEST(emptyStore) {
+    auto file = PointStore::build({});
+    PointStore store;
+    CHECK(store.attach(file.data(), file.size()));
+    CHECK(store.getPointCount() == 0);
+    CHECK(store.getLevelCount() == 0);
+    std::vector<GeoPoint> found;
+    CHECK(store.queryCap(0.f, 0.f, 180.f, found) == 0);
+}
+
+TEST(rejectsMalformedFiles) {
+    auto file = PointStore::build(randomPoints(5000, 5));
+    PointStore store;
+    CHECK(!store.attach(file.data(), file.size() - 4));
+    CHECK(!store.attach(file.data(), 16));
+
+    auto badMagic = file;
+    badMagic[0] = 'X';
+    CHECK(!store.attach(badMagic.data(), badMagic.size()));
+
+    auto newer = file;
+    newer[8] = PointStore::kVersion + 1;
+    CHECK(!store.attach(newer.data(), newer.size()));
+
+    // The root's children pointing past the end of their level
+    auto badNode = file;
+    uint64_t nodeOffset;
+    memcpy(&nodeOffset, badNode.data() + 32, sizeof(nodeOffset));
+    uint32_t first = 1u << 30;
+    memcpy(badNode.data() + nodeOffset + 16, &first, sizeof(first));
+    CHECK(!store.attach(badNode.data(), badNode.size()));
+    CHECK(store.getPointCount() == 0);
+
+    CHECK(store.attach(file.data(), file.size()));
+    CHECK(store.getPointCount() == 5000);
+}
+
+TEST(readsThroughAMappedFile) {
+    auto points = randomPoints(10000, 6);
+    auto contents = PointStore::build(points);
+    auto path = std::string("pointstore_test.ezpts");
+    {
+        std::ofstream output(path, std::ios::binary);
+        output.write(reinterpret_cast<const char *>(contents.data()),
+                     static_cast<std::streamsize>(contents.size()));
+    }
+
+    auto file = MappedFile::open(path);
+    CHECK(file != nullptr);
+    if (file) {
+        CHECK(file->getSize() == contents.size());
+        PointStore store;
+        CHECK(store.attach(file->getData(), file->getSize()));
+        std::vector<GeoPoint> found;
+        CHECK(store.queryRect(GeoRect(), found) == points.size());
+    }
+    std::remove(path.c_str());
+    CHECK(MappedFile::open(path) == nullptr);
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,207 @@
+// Tests of the batch region classifier: the same answers as the polygon test the Kotlin view runs,
+// outlines and points across the antimeridian, and batches split over threads.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Continents.h"
+#include "KotlinRegions.h"
+#include "RegionClassifier.h"
+#include "TestHarness.h"
+
+namespace {
+
+//! points spread evenly over the map, as (latitude, longitude) pairs
+std::vector<float> randomLatLon(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> latitude(-90.f, 90.f);
+    std::uniform_real_distribution<float> longitude(-180.f, 180.f);
+    std::vector<float> latLon(2 * count);
+    for (size_t i = 0; i < count; ++i) {
+        latLon[2 * i] = latitude(random);
+        latLon[2 * i + 1] = longitude(random);
+    }
+    return latLon;
+}
+
+/*!
+ * Stars with a random number of spikes all over the map, overlapping each other, so cells get
+ * many outlines and more than one group of them.
+ */
+std::vector<RegionOutline> randomStars(int count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> centre(0.1f, 0.9f);
+    std::uniform_real_distribution<float> radius(0.01f, 0.08f);
+    std::uniform_int_distribution<int> spikes(3, 12);
+    std::vector<RegionOutline> stars;
+    for (int i = 0; i < count; ++i) {
+        RegionOutline star;
+        star.id = static_cast<uint16_t>(i + 1);
+        auto u = centre(random);
+        auto v = centre(random);
+        auto outer = radius(random);
+        auto corners = 2 * spikes(random);
+        for (int corner = 0; corner < corners; ++corner) {
+            auto angle = 6.2831853f * static_cast<float>(corner) / static_cast<float>(corners);
+            auto distance = corner % 2 == 0 ? outer : outer * 0.4f;
+            star.points.push_back(u + distance * std::cos(angle));
+            star.points.push_back(v + distance * std::sin(angle));
+        }
+        stars.push_back(std::move(star));
+    }
+    return stars;
+}
+
+/*!
+ * Checks @a classifier against the Kotlin test for every point, but those that close to an edge
+ * the two round differently: where the scan changes its answer within a step of the point.
+ */
+void checkAgainstScan(const RegionClassifier &classifier,
+                      const std::vector<RegionOutline> &outlines,
+                      const std::vector<float> &latLon) {
+    constexpr float kStep = 1e-4f;
+    auto count = latLon.size() / 2;
+    std::vector<uint16_t> regions(count);
+    classifier.classify(latLon.data(), count, regions.data());
+    size_t checked = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto u = (latLon[2 * i + 1] + 180.f) / 360.f;
+        auto v = (90.f - latLon[2 * i]) / 180.f;
+        auto expected = kotlin::scanRegions(outlines, u, v);
+        if (kotlin::scanRegions(outlines, u - kStep, v) != expected
+            || kotlin::scanRegions(outlines, u + kStep, v) != expected
+            || kotlin::scanRegions(outlines, u, v - kStep) != expected
+            || kotlin::scanRegions(outlines, u, v + kStep) != expected) {
+            continue;
+        }
+        CHECK(regions[i] == expected);
+        checked++;
+    }
+    CHECK(checked > count * 9 / 10);
+}
+
+} // namespace
+
+TEST(continentsMatchTheKotlinTest) {
+    const auto &outlines = getContinentOutlines();
+    RegionClassifier classifier(outlines);
+    CHECK(classifier.getIndexedEdgeCount() > 0);
+    checkAgainstScan(classifier, outlines, randomLatLon(50000, 1));
+
+    // On the coarsest and on a fine grid alike
+    RegionClassifierOptions options;
+    options.columns = 1;
+    options.rows = 1;
+    checkAgainstScan(RegionClassifier(outlines, options), outlines, randomLatLon(20000, 2));
+    options.columns = 360;
+    options.rows = 180;
+    checkAgainstScan(RegionClassifier(outlines, options), outlines, randomLatLon(20000, 3));
+}
+
+TEST(overlappingOutlinesMatchTheKotlinTest) {
+    // More outlines than one group holds: the first outline containing a point still wins
+    auto stars = randomStars(200, 4);
+    RegionClassifierOptions options;
+    options.columns = 16;
+    options.rows = 8;
+    checkAgainstScan(RegionClassifier(stars, options), stars, randomLatLon(20000, 5));
+    checkAgainstScan(RegionClassifier(stars), stars, randomLatLon(20000, 6));
+}
+
+TEST(outlinesCrossTheAntimeridian) {
+    // From 162 E over the antimeridian to 162 W, between 18 N and 18 S
+    std::vector<RegionOutline> outlines = {
+            {3, {0.95f, 0.4f, 0.05f, 0.4f, 0.05f, 0.6f, 0.95f, 0.6f}},
+    };
+    RegionClassifier classifier(outlines);
+    CHECK(classifier.classify(0.f, 170.f) == 3);
+    CHECK(classifier.classify(0.f, -170.f) == 3);
+    CHECK(classifier.classify(10.f, 179.99f) == 3);
+    CHECK(classifier.classify(-10.f, -180.f) == 3);
+    CHECK(classifier.classify(0.f, 0.f) == RegionRaster::kNoRegion);
+    CHECK(classifier.classify(0.f, 150.f) == RegionRaster::kNoRegion);
+    CHECK(classifier.classify(0.f, -150.f) == RegionRaster::kNoRegion);
+    CHECK(classifier.classify(30.f, 180.f) == RegionRaster::kNoRegion);
+}
+
+TEST(longitudesWrap) {
+    RegionClassifier classifier(getContinentOutlines());
+    auto africa = static_cast<uint16_t>(Continent::Africa);
+    CHECK(classifier.classify(5.f, 20.f) == africa);
+    CHECK(classifier.classify(5.f, 380.f) == africa);
+    CHECK(classifier.classify(5.f, -340.f) == africa);
+    CHECK(classifier.classify(5.f, 740.f) == africa);
+
+    // Latitudes past the poles are clamped onto them
+    CHECK(classifier.classify(-95.f, 0.f) == classifier.classify(-90.f, 0.f));
+}
+
+TEST(batchesMatchSinglePoints) {
+    RegionClassifier classifier(getContinentOutlines());
+    auto latLon = randomLatLon(100003, 7);
+    auto count = latLon.size() / 2;
+    std::vector<uint16_t> single(count);
+    for (size_t i = 0; i < count; ++i) {
+        single[i] = classifier.classify(latLon[2 * i], latLon[2 * i + 1]);
+    }
+
+    for (int threads: {1, 2, 3, 8, 64}) {
+        std::vector<uint16_t> batch(count, 0xFFFF);
+        classifier.classify(latLon.data(), count, batch.data(), threads);
+        CHECK(batch == single);
+    }
+
+    // Batches too small to split, down to a partial block of the kernel
+    for (size_t size: {size_t(1), size_t(3), size_t(5), size_t(1000)}) {
+        std::vector<uint16_t> batch(size, 0xFFFF);
+        classifier.classify(latLon.data(), size, batch.data(), 8);
+        CHECK(std::equal(batch.begin(), batch.end(), single.begin()));
+    }
+}
+
+TEST(nonFiniteCoordinatesAreInNoRegion) {
+    // They come unchecked from Java, none may index a cell
+    RegionClassifier classifier(getContinentOutlines());
+    auto nan = std::numeric_limits<float>::quiet_NaN();
+    auto infinity = std::numeric_limits<float>::infinity();
+    const float points[][2] = {{nan, 20.f}, {5.f, nan}, {infinity, 20.f}, {5.f, -infinity},
+                               {-infinity, infinity}, {nan, nan}};
+    for (const auto &point: points) {
+        CHECK(classifier.classify(point[0], point[1]) == RegionRaster::kNoRegion);
+    }
+
+    // Mixed into a batch with points on land, which keep their region
+    auto africa = static_cast<uint16_t>(Continent::Africa);
+    std::vector<float> latLon;
+    for (int i = 0; i < 1000; ++i) {
+        const auto &point = points[i % 6];
+        latLon.insert(latLon.end(), {point[0], point[1], 5.f, 20.f});
+    }
+    std::vector<uint16_t> regions(latLon.size() / 2, 0xFFFF);
+    classifier.classify(latLon.data(), regions.size(), regions.data(), 2);
+    for (size_t i = 0; i < regions.size(); ++i) {
+        CHECK(regions[i] == (i % 2 == 0 ? RegionRaster::kNoRegion : africa));
+    }
+}
+
+TEST(emptyInputs) {
+    RegionClassifier classifier(getContinentOutlines());
+    classifier.classify(nullptr, 0, nullptr);
+
+    RegionClassifier nothing({});
+    CHECK(nothing.getIndexedEdgeCount() == 0);
+    CHECK(nothing.classify(0.f, 0.f) == RegionRaster::kNoRegion);
+
+    // Degenerate outlines are ignored
+    RegionClassifier degenerate({{1, {0.5f, 0.5f, 0.6f, 0.5f}}, {2, {0.1f, 0.5f, 0.9f, 0.5f,
+                                                                     0.5f, 0.5f}}});
+    CHECK(degenerate.getIndexedEdgeCount() == 0);
+    CHECK(degenerate.classify(0.f, 0.f) == RegionRaster::kNoRegion);
+}
+
+int main() {
+    return testing::runTests();
+}
@@ -0,0 +1,120 @@
+// Unit tests for the sort keys and pass order of RenderQueue.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "RenderQueue.h"
+#include "TestHarness.h"
+
+namespace {
+
+//! runs the queue and returns the passes it began, in order
+std::vector<std::string> execute(RenderQueue &queue) {
+    std::vector<std::string> log;
+    queue.execute([&log](RenderPass pass) {
+        log.push_back("pass " + std::to_string(static_cast<int>(pass)));
+    });
+    return log;
+}
+
+void submitNamed(
+        RenderQueue &queue,
+        std::vector<std::string> &log,
+        const char *name,
+        RenderPass pass,
+        uint32_t program,
+        uint32_t texture,
+        float depth) {
+    queue.submit(pass, program, texture, depth, [&log, name]() { log.push_back(name); });
+}
+
+} // namespace
+
+TEST(passesComeInOrder) {
+    for (auto depth: {0.f, 1.f, 1e30f}) {
+        auto opaque = RenderQueue::makeSortKey(RenderPass::Opaque, 0x3FFF, 0xFFFF, 1e30f);
+        auto coverage = RenderQueue::makeSortKey(RenderPass::Coverage, 0, 0, depth);
+        auto transparent = RenderQueue::makeSortKey(RenderPass::Transparent, 0, 0, 1e30f);
+        CHECK(opaque < coverage);
+        CHECK(coverage < transparent);
+    }
+}
+
+TEST(opaqueGroupsByStateThenFrontToBack) {
+    auto near = RenderQueue::makeSortKey(RenderPass::Opaque, 1, 2, 1.f);
+    auto far = RenderQueue::makeSortKey(RenderPass::Opaque, 1, 2, 10.f);
+    auto otherTexture = RenderQueue::makeSortKey(RenderPass::Opaque, 1, 3, 0.5f);
+    auto otherProgram = RenderQueue::makeSortKey(RenderPass::Opaque, 2, 1, 0.5f);
+    CHECK(near < far);
+    CHECK(far < otherTexture);
+    CHECK(otherTexture < otherProgram);
+}
+
+TEST(transparentIsBackToFrontBeforeState) {
+    auto far = RenderQueue::makeSortKey(RenderPass::Transparent, 9, 9, 10.f);
+    auto near = RenderQueue::makeSortKey(RenderPass::Transparent, 1, 1, 1.f);
+    auto nearOtherState = RenderQueue::makeSortKey(RenderPass::Transparent, 2, 1, 1.f);
+    CHECK(far < near);
+    CHECK(near < nearOtherState);
+}
+
+TEST(negativeAndNanDepthsCountAsZero) {
+    auto zero = RenderQueue::makeSortKey(RenderPass::Opaque, 1, 1, 0.f);
+    CHECK(RenderQueue::makeSortKey(RenderPass::Opaque, 1, 1, -5.f) == zero);
+    CHECK(RenderQueue::makeSortKey(RenderPass::Opaque, 1, 1, std::nanf("")) == zero);
+    CHECK(zero < RenderQueue::makeSortKey(RenderPass::Opaque, 1, 1, 1e-30f));
+}
+
+TEST(executeSortsAndBeginsEachPassOnce) {
+    RenderQueue queue;
+    std::vector<std::string> log;
+    submitNamed(queue, log, "overlay far", RenderPass::Transparent, 1, 1, 20.f);
+    submitNamed(queue, log, "globe far", RenderPass::Opaque, 1, 1, 9.f);
+    submitNamed(queue, log, "overlay near", RenderPass::Transparent, 1, 1, 2.f);
+    submitNamed(queue, log, "globe near", RenderPass::Opaque, 1, 1, 3.f);
+    submitNamed(queue, log, "limb", RenderPass::Coverage, 1, 1, 3.f);
+    CHECK(queue.getSize() == 5);
+
+    queue.execute([&log](RenderPass pass) {
+        log.push_back("pass " + std::to_string(static_cast<int>(pass)));
+    });
+
+    std::vector<std::string> expected{
+            "pass 0", "globe near", "globe far",
+            "pass 1", "limb",
+            "pass 2", "overlay far", "overlay near"};
+    CHECK(log == expected);
+    CHECK(queue.getSize() == 0);
+}
+
+TEST(equalKeysKeepSubmissionOrder) {
+    RenderQueue queue;
+    std::vector<std::string> log;
+    for (const char *name: {"a", "b", "c", "d"}) {
+        submitNamed(queue, log, name, RenderPass::Opaque, 4, 4, 1.f);
+    }
+    auto passes = execute(queue);
+    CHECK(passes.size() == 1);
+    CHECK((log == std::vector<std::string>{"a", "b", "c", "d"}));
+}
+
+TEST(emptyQueueBeginsNoPass) {
+    RenderQueue queue;
+    CHECK(execute(queue).empty());
+}
+
+TEST(passStates) {
+    CHECK(!getPassState(RenderPass::Opaque).blend);
+    CHECK(getPassState(RenderPass::Opaque).cullBackFaces);
+    CHECK(getPassState(RenderPass::Opaque).depthWrite);
+    CHECK(getPassState(RenderPass::Coverage).blend);
+    CHECK(getPassState(RenderPass::Coverage).depthWrite);
+    CHECK(getPassState(RenderPass::Transparent).blend);
+    CHECK(!getPassState(RenderPass::Transparent).depthWrite);
+    CHECK(!getPassState(RenderPass::Transparent).frontToBack);
+}
+
+int main() {
+    return testing::runTests();
+}
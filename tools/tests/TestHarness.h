@@ -0,0 +1,77 @@
+#ifndef EARTHZOO_TOOLS_TESTHARNESS_H
+#define EARTHZOO_TOOLS_TESTHARNESS_H
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+// Just enough of a test framework for the native sources shared with the app. Each test binary
+// registers its cases with TEST and returns runTests() from main, ctest only looks at the exit
+// code.
+
+namespace testing {
+
+struct TestCase {
+    const char *name;
+    std::function<void()> body;
+};
+
+inline std::vector<TestCase> &getTests() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline int &getFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+struct Registrar {
+    Registrar(const char *name, std::function<void()> body) {
+        getTests().push_back({name, std::move(body)});
+    }
+};
+
+inline void fail(const char *file, int line, const char *message) {
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message);
+    ++getFailureCount();
+}
+
+inline int runTests() {
+    for (const auto &test: getTests()) {
+        auto failuresBefore = getFailureCount();
+        test.body();
+        auto passed = getFailureCount() == failuresBefore;
+        std::printf("%s %s\n", passed ? "[ OK ]" : "[FAIL]", test.name);
+    }
+    std::printf("%zu tests, %d failed checks\n", getTests().size(), getFailureCount());
+    return getFailureCount() == 0 ? 0 : 1;
+}
+
+} // namespace testing
+
+#define TEST(name) \
+    static void name(); \
+    static testing::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            testing::fail(__FILE__, __LINE__, "CHECK(" #condition ") failed"); \
+        } \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        auto checkActual = (actual); \
+        auto checkExpected = (expected); \
+        if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) { \
+            std::fprintf(stderr, "  %s = %g, expected %g\n", #actual, \
+                         double(checkActual), double(checkExpected)); \
+            testing::fail(__FILE__, __LINE__, "CHECK_NEAR(" #actual ", " #expected ") failed"); \
+        } \
+    } while (false)
+
+#endif //EARTHZOO_TOOLS_TESTHARNESS_H
@@ -0,0 +1,238 @@
+// Unit tests for VectorMath. Built once with the platform's SIMD kernels and once with
+// EARTHZOO_MATH_SCALAR, so both paths are held to the same results.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TestHarness.h"
+#include "VectorMath.h"
+
+namespace {
+
+constexpr float kTolerance = 1e-5f;
+constexpr float kPi = 3.14159265f;
+
+void checkNear(const Vec3 &actual, const Vec3 &expected, float tolerance = kTolerance) {
+    CHECK_NEAR(actual.x, expected.x, tolerance);
+    CHECK_NEAR(actual.y, expected.y, tolerance);
+    CHECK_NEAR(actual.z, expected.z, tolerance);
+}
+
+void checkNear(const Vec4 &actual, const Vec4 &expected, float tolerance = kTolerance) {
+    CHECK_NEAR(actual.x, expected.x, tolerance);
+    CHECK_NEAR(actual.y, expected.y, tolerance);
+    CHECK_NEAR(actual.z, expected.z, tolerance);
+    CHECK_NEAR(actual.w, expected.w, tolerance);
+}
+
+void checkNear(const Mat4 &actual, const Mat4 &expected, float tolerance = kTolerance) {
+    for (int i = 0; i < 4; ++i) {
+        checkNear(actual[i], expected[i], tolerance);
+    }
+}
+
+//! the textbook row-times-column product on the raw column-major floats
+Mat4 referenceMultiply(const Mat4 &lhs, const Mat4 &rhs) {
+    Mat4 result;
+    float *out = &result.columns[0].x;
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row) {
+            auto sum = 0.f;
+            for (int k = 0; k < 4; ++k) {
+                sum += lhs.data()[k * 4 + row] * rhs.data()[column * 4 + k];
+            }
+            out[column * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+Mat4 randomAffine(std::mt19937 &random) {
+    std::uniform_real_distribution<float> angle(-kPi, kPi);
+    std::uniform_real_distribution<float> offset(-10.f, 10.f);
+    auto axis = normalize({offset(random), offset(random), offset(random)});
+    return Mat4::translation({offset(random), offset(random), offset(random)})
+           * Mat4::rotation(Quat::fromAxisAngle(axis, angle(random)))
+           * Mat4::scale({1.5f, 0.5f, 2.f});
+}
+
+} // namespace
+
+// Compile-time evaluation is part of the interface, constants can be built without startup cost
+static_assert(sizeof(Vec3) == 16 && alignof(Vec3) == 16, "Vec3 is padded to a SIMD lane");
+static_assert(sizeof(Mat4) == 64 && alignof(Mat4) == 16, "Mat4 is four aligned columns");
+static_assert(cross(Vec3(1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f)) == Vec3(0.f, 0.f, 1.f), "cross");
+static_assert(dot(Vec3(1.f, 2.f, 3.f), Vec3(4.f, 5.f, 6.f)) == 32.f, "dot");
+static_assert(Mat4::translation({1.f, 2.f, 3.f}).columns[3] == Vec4(1.f, 2.f, 3.f, 1.f),
+              "translation");
+static_assert(Mat4() == Mat4::identity(), "default is identity");
+
+TEST(vec3Arithmetic) {
+    Vec3 a(1.f, 2.f, 3.f);
+    Vec3 b(-2.f, 0.5f, 4.f);
+    checkNear(a + b, {-1.f, 2.5f, 7.f});
+    checkNear(a - b, {3.f, 1.5f, -1.f});
+    checkNear(2.f * a, {2.f, 4.f, 6.f});
+    checkNear(-a / 2.f, {-0.5f, -1.f, -1.5f});
+    CHECK_NEAR(length(Vec3(3.f, 4.f, 0.f)), 5.f, kTolerance);
+    checkNear(normalize({0.f, 0.f, -7.f}), {0.f, 0.f, -1.f});
+    CHECK(normalize(Vec3()) == Vec3());
+
+    auto c = cross(a, b);
+    CHECK_NEAR(dot(c, a), 0.f, kTolerance);
+    CHECK_NEAR(dot(c, b), 0.f, kTolerance);
+}
+
+TEST(vec4Arithmetic) {
+    Vec4 a(1.f, 2.f, 3.f, 4.f);
+    Vec4 b(0.5f, -1.f, 2.f, -4.f);
+    checkNear(a + b, {1.5f, 1.f, 5.f, 0.f});
+    checkNear(a - b, {0.5f, 3.f, 1.f, 8.f});
+    checkNear(a * -2.f, {-2.f, -4.f, -6.f, -8.f});
+    CHECK_NEAR(dot(a, b), -11.5f, kTolerance);
+    checkNear(a.xyz(), {1.f, 2.f, 3.f});
+}
+
+TEST(rotationsMatchTheirAxes) {
+    // Counter-clockwise looking down the axis towards the origin
+    auto quarter = kPi * 0.5f;
+    checkNear(Mat4::rotationX(quarter).transformVector({0.f, 1.f, 0.f}), {0.f, 0.f, 1.f});
+    checkNear(Mat4::rotationY(quarter).transformVector({0.f, 0.f, 1.f}), {1.f, 0.f, 0.f});
+    checkNear(Mat4::rotationZ(quarter).transformVector({1.f, 0.f, 0.f}), {0.f, 1.f, 0.f});
+
+    checkNear(Mat4::rotation(Quat::fromAxisAngle({1.f, 0.f, 0.f}, 0.7f)), Mat4::rotationX(0.7f));
+    checkNear(Mat4::rotation(Quat::fromAxisAngle({0.f, 1.f, 0.f}, -1.3f)), Mat4::rotationY(-1.3f));
+    checkNear(Mat4::rotation(Quat::fromAxisAngle({0.f, 0.f, 1.f}, 2.1f)), Mat4::rotationZ(2.1f));
+}
+
+TEST(quaternions) {
+    auto axis = normalize({1.f, -2.f, 0.5f});
+    auto q = Quat::fromAxisAngle(axis, 1.1f);
+    auto r = Quat::fromAxisAngle(normalize({0.f, 1.f, 1.f}), -0.4f);
+    Vec3 v(0.3f, 4.f, -2.f);
+
+    checkNear(q.rotate(v), Mat4::rotation(q).transformVector(v));
+    checkNear((q * r).rotate(v), q.rotate(r.rotate(v)));
+    checkNear(q.conjugate().rotate(q.rotate(v)), v);
+    checkNear(q.rotate(axis), axis);
+
+    // Ends are exact, the middle is half the angle, and q and -q take the same path
+    auto slerpStart = Quat::slerp(Quat(), q, 0.f);
+    checkNear(Vec4(slerpStart.x, slerpStart.y, slerpStart.z, slerpStart.w), {0.f, 0.f, 0.f, 1.f});
+    auto half = Quat::fromAxisAngle(axis, 0.55f);
+    auto slerpHalf = Quat::slerp(Quat(), q, 0.5f);
+    checkNear(slerpHalf.rotate(v), half.rotate(v));
+    Quat negated(-q.x, -q.y, -q.z, -q.w);
+    checkNear(Quat::slerp(Quat(), negated, 0.5f).rotate(v), half.rotate(v));
+}
+
+TEST(multiplyMatchesReference) {
+    std::mt19937 random(7);
+    for (int i = 0; i < 100; ++i) {
+        auto a = randomAffine(random);
+        auto b = randomAffine(random);
+        checkNear(a * b, referenceMultiply(a, b), 1e-4f);
+    }
+    auto m = randomAffine(random);
+    CHECK(m * Mat4() == m);
+    CHECK(Mat4() * m == m);
+}
+
+TEST(transformsAgreeWithMultiply) {
+    std::mt19937 random(11);
+    auto m = randomAffine(random);
+    Vec3 p(1.f, -2.f, 3.f);
+    checkNear(m.transformPoint(p), (m * Vec4(p, 1.f)).xyz(), 1e-4f);
+    checkNear(m.transformVector(p), (m * Vec4(p, 0.f)).xyz(), 1e-4f);
+    checkNear(Mat4::translation({5.f, 0.f, 0.f}).transformVector(p), p);
+}
+
+TEST(inverse) {
+    std::mt19937 random(3);
+    for (int i = 0; i < 50; ++i) {
+        auto m = randomAffine(random);
+        checkNear(m * m.inverted(), Mat4(), 1e-4f);
+        checkNear(m.inverted() * m, Mat4(), 1e-4f);
+    }
+
+    auto projection = Mat4::perspective(1.f, 1.5f, 0.1f, 100.f);
+    checkNear(projection * projection.inverted(), Mat4(), 1e-4f);
+
+    auto singular = Mat4::scale({1.f, 0.f, 1.f}).inverted();
+    CHECK(std::isnan(singular[0].x));
+
+    auto rotation = Mat4::rotationY(0.8f) * Mat4::rotationX(-0.3f);
+    checkNear(rotation.transposed(), rotation.inverted());
+}
+
+TEST(projections) {
+    auto near = 0.1f;
+    auto far = 100.f;
+    auto perspective = Mat4::perspective(kPi * 0.5f, 2.f, near, far);
+    checkNear(perspective.projectPoint({0.f, 0.f, -near}), {0.f, 0.f, -1.f}, 1e-4f);
+    checkNear(perspective.projectPoint({0.f, 0.f, -far}), {0.f, 0.f, 1.f}, 1e-4f);
+    // With a 90 degree field of view the top edge is at y = -z, the side at x = -2z
+    CHECK_NEAR(perspective.projectPoint({0.f, 5.f, -5.f}).y, 1.f, 1e-5f);
+    CHECK_NEAR(perspective.projectPoint({10.f, 0.f, -5.f}).x, 1.f, 1e-5f);
+
+    auto orthographic = Mat4::orthographic(2.f, 1.5f, near, far);
+    checkNear(orthographic.projectPoint({3.f, -2.f, -near}), {1.f, -1.f, -1.f}, 1e-5f);
+    checkNear(orthographic.projectPoint({0.f, 0.f, -far}), {0.f, 0.f, 1.f}, 1e-5f);
+}
+
+TEST(lookAt) {
+    Vec3 eye(0.f, 2.f, 5.f);
+    Vec3 target(1.f, 0.f, -1.f);
+    auto view = Mat4::lookAt(eye, target, {0.f, 1.f, 0.f});
+
+    checkNear(view.transformPoint(eye), {});
+    auto toTarget = view.transformPoint(target);
+    CHECK_NEAR(toTarget.x, 0.f, 1e-5f);
+    CHECK_NEAR(toTarget.y, 0.f, 1e-5f);
+    CHECK_NEAR(toTarget.z, -length(target - eye), 1e-5f);
+
+    // The same camera as the renderer's, looking down -z from (0, 0, 3)
+    checkNear(Mat4::lookAt({0.f, 0.f, 3.f}, {}, {0.f, 1.f, 0.f}),
+              Mat4::translation({0.f, 0.f, -3.f}));
+}
+
+TEST(batchTransforms) {
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> coordinate(-100.f, 100.f);
+    auto m = randomAffine(random);
+
+    // An odd count so nothing depends on a multiple of the lane width
+    std::vector<Vec3> points(1001);
+    std::vector<Vec4> vectors(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        points[i] = {coordinate(random), coordinate(random), coordinate(random)};
+        vectors[i] = Vec4(points[i], i % 2 ? 1.f : 0.f);
+    }
+
+    std::vector<Vec3> transformedPoints(points.size());
+    m.transformPoints(points.data(), transformedPoints.data(), points.size());
+    std::vector<Vec4> transformedVectors(vectors.size());
+    m.transformVectors(vectors.data(), transformedVectors.data(), vectors.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        checkNear(transformedPoints[i], m.transformPoint(points[i]), 1e-3f);
+        CHECK(transformedPoints[i].padding == 0.f);
+        checkNear(transformedVectors[i], m * vectors[i], 1e-3f);
+    }
+
+    // In place
+    auto inPlace = points;
+    m.transformPoints(inPlace.data(), inPlace.data(), inPlace.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        checkNear(inPlace[i], transformedPoints[i], 0.f);
+    }
+    m.transformVectors(vectors.data(), vectors.data(), vectors.size());
+    for (size_t i = 0; i < vectors.size(); ++i) {
+        checkNear(vectors[i], transformedVectors[i], 0.f);
+    }
+}
+
+int main() {
+    std::printf("VectorMath backend: %s\n", getVectorMathBackend());
+    return testing::runTests();
+}
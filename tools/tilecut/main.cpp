@@ -0,0 +1,214 @@
+/*
+ * tilecut: cuts an equirectangular PNG into the imagery pyramid TileCache streams.
+ *
+ *   tilecut [--tile-size N] [--levels N] <input.png> <output-dir>
+ *
+ * Level z gets 2^(z+1) x 2^z tiles written to "<output-dir>/<z>/<x>_<y>.png", plus a
+ * "<output-dir>/manifest". By default there are as many levels as it takes for the finest one to
+ * match the input's resolution. Copy the output to app/src/main/assets/tiles.
+ */
+
+#include <png.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ImageData.h"
+#include "TilePyramid.h"
+
+namespace {
+
+bool readPng(const std::string &path, ImageData &outImage) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_file(&png, path.c_str())) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+
+    png.format = PNG_FORMAT_RGBA;
+    outImage.width = static_cast<int>(png.width);
+    outImage.height = static_cast<int>(png.height);
+    outImage.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    if (!png_image_finish_read(&png, nullptr, outImage.pixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        png_image_free(&png);
+        return false;
+    }
+    return true;
+}
+
+bool writePng(const std::string &path, const ImageData &image) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = static_cast<png_uint_32>(image.width);
+    png.height = static_cast<png_uint_32>(image.height);
+    png.format = PNG_FORMAT_RGBA;
+
+    if (!png_image_write_to_file(&png, path.c_str(), 0, image.pixels.data(), 0, nullptr)) {
+        std::cerr << path << ": " << png.message << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool makeDirectory(const std::string &path) {
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+/*!
+ * Bilinear resize, good enough when the target is close to the source size. Larger reductions
+ * happen through ImageData::downsample.
+ */
+ImageData resize(const ImageData &source, int width, int height) {
+    ImageData result;
+    result.width = width;
+    result.height = height;
+    result.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    auto scaleX = static_cast<float>(source.width) / static_cast<float>(width);
+    auto scaleY = static_cast<float>(source.height) / static_cast<float>(height);
+    for (int y = 0; y < height; ++y) {
+        auto sourceY = std::clamp((static_cast<float>(y) + 0.5f) * scaleY - 0.5f,
+                                  0.f, static_cast<float>(source.height - 1));
+        auto y0 = static_cast<int>(sourceY);
+        auto y1 = std::min(y0 + 1, source.height - 1);
+        auto fy = sourceY - static_cast<float>(y0);
+
+        for (int x = 0; x < width; ++x) {
+            auto sourceX = std::clamp((static_cast<float>(x) + 0.5f) * scaleX - 0.5f,
+                                      0.f, static_cast<float>(source.width - 1));
+            auto x0 = static_cast<int>(sourceX);
+            auto x1 = std::min(x0 + 1, source.width - 1);
+            auto fx = sourceX - static_cast<float>(x0);
+
+            auto texel = [&source](int tx, int ty, int channel) {
+                return static_cast<float>(
+                        source.pixels[(static_cast<size_t>(ty) * source.width + tx) * 4 + channel]);
+            };
+            auto *out = &result.pixels[(static_cast<size_t>(y) * width + x) * 4];
+            for (int channel = 0; channel < 4; ++channel) {
+                auto top = texel(x0, y0, channel) * (1.f - fx) + texel(x1, y0, channel) * fx;
+                auto bottom = texel(x0, y1, channel) * (1.f - fx) + texel(x1, y1, channel) * fx;
+                out[channel] = static_cast<uint8_t>(top * (1.f - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+    return result;
+}
+
+ImageData crop(const ImageData &source, int left, int top, int size) {
+    ImageData result;
+    result.width = size;
+    result.height = size;
+    result.pixels.resize(static_cast<size_t>(size) * size * 4);
+    for (int y = 0; y < size; ++y) {
+        const auto *row = &source.pixels[
+                ((static_cast<size_t>(top) + y) * source.width + left) * 4];
+        std::copy(row, row + size * 4, &result.pixels[static_cast<size_t>(y) * size * 4]);
+    }
+    return result;
+}
+
+int usage() {
+    std::cerr << "usage: tilecut [--tile-size N] [--levels N] <input.png> <output-dir>"
+              << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int tileSize = 256;
+    int levels = 0;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--tile-size" && i + 1 < argc) {
+            tileSize = std::atoi(argv[++i]);
+        } else if (argument == "--levels" && i + 1 < argc) {
+            levels = std::atoi(argv[++i]);
+        } else if (argument.rfind("--", 0) == 0) {
+            return usage();
+        } else {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.size() != 2 || tileSize < 16 || (tileSize & (tileSize - 1)) != 0) {
+        return usage();
+    }
+
+    ImageData source;
+    if (!readPng(paths[0], source)) {
+        return 1;
+    }
+
+    if (levels <= 0) {
+        // Enough levels for the finest one to be at least as sharp as the input
+        levels = 1;
+        while (TilePyramid::getTileCountX(levels - 1) * tileSize < source.width) {
+            levels++;
+        }
+    }
+    auto maxLevel = levels - 1;
+
+    auto level = resize(
+            source,
+            TilePyramid::getTileCountX(maxLevel) * tileSize,
+            TilePyramid::getTileCountY(maxLevel) * tileSize);
+
+    auto &outputDirectory = paths[1];
+    if (!makeDirectory(outputDirectory)) {
+        std::cerr << "could not create " << outputDirectory << std::endl;
+        return 1;
+    }
+
+    size_t tileCount = 0;
+    for (int z = maxLevel; z >= 0; --z) {
+        auto levelDirectory = outputDirectory + "/" + std::to_string(z);
+        if (!makeDirectory(levelDirectory)) {
+            std::cerr << "could not create " << levelDirectory << std::endl;
+            return 1;
+        }
+
+        for (int y = 0; y < TilePyramid::getTileCountY(z); ++y) {
+            for (int x = 0; x < TilePyramid::getTileCountX(z); ++x) {
+                auto tile = crop(level, x * tileSize, y * tileSize, tileSize);
+                auto path = levelDirectory + "/" + std::to_string(x) + "_" + std::to_string(y)
+                            + ".png";
+                if (!writePng(path, tile)) {
+                    return 1;
+                }
+                tileCount++;
+            }
+        }
+
+        if (z > 0) {
+            level = level.downsample();
+        }
+    }
+
+    std::ofstream manifest(outputDirectory + "/manifest");
+    manifest << "levels " << levels << "\n"
+             << "tileSize " << tileSize << "\n";
+    if (!manifest) {
+        std::cerr << "could not write the manifest" << std::endl;
+        return 1;
+    }
+
+    printf("%d levels, %zu tiles of %dpx\n", levels, tileCount, tileSize);
+    return 0;
+}